@@ -19,6 +19,8 @@
 */
 
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 
 #include "ch.h"
 #include "hal.h"
@@ -50,6 +52,57 @@ static void cmd_mem(BaseSequentialStream *chp, int argc, char *argv[]) {
   chprintf(chp, "heap free total  : %u bytes\r\n", size);
 }
 
+#if CH_DBG_HEAP_PROFILING
+static void cmd_heap(BaseSequentialStream *chp, int argc, char *argv[]) {
+  static uint8_t buf[CH_HEAP_PROFILE_DUMP_SIZE];
+  ch_heap_profile_t hp;
+  unsigned i;
+  size_t n;
+
+  if ((argc > 1) ||
+      ((argc == 1) && (strcmp(argv[0], "dump") != 0) &&
+                      (strcmp(argv[0], "reset") != 0))) {
+    chprintf(chp, "Usage: heap [dump|reset]\r\n");
+    return;
+  }
+  if (argc == 1) {
+    if (strcmp(argv[0], "reset") == 0) {
+      chHeapResetPeak(NULL);
+      return;
+    }
+    /* Hex dump of the binary profile, it can be decoded using the
+       heapreport.py tool.*/
+    n = chHeapProfileDump(NULL, buf, sizeof buf);
+    for (i = 0; i < n; i++)
+      chprintf(chp, (i % 16) == 15 || (i == n - 1) ? "%.2x\r\n" : "%.2x",
+               buf[i]);
+    return;
+  }
+  chHeapGetProfile(NULL, &hp);
+  chprintf(chp, "heap used        : %u bytes\r\n", hp.hp_used);
+  chprintf(chp, "heap peak        : %u bytes\r\n", hp.hp_peak);
+  chprintf(chp, "heap free total  : %u bytes\r\n", hp.hp_free);
+  chprintf(chp, "heap fragments   : %u\r\n", hp.hp_fragments);
+  chprintf(chp, "largest free     : %u bytes\r\n", hp.hp_largest);
+  chprintf(chp, "free blocks histogram:\r\n");
+  for (i = 0; i < CH_HEAP_HISTOGRAM_BINS - 1; i++)
+    chprintf(chp, "  %6u..%6u %u\r\n",
+             i == 0 ? 0 : 16U << i, (32U << i) - 1, hp.hp_histogram[i]);
+  chprintf(chp, "  %6u..       %u\r\n", 16U << i, hp.hp_histogram[i]);
+  chprintf(chp, "call sites:\r\n");
+  chprintf(chp, "    addr      bytes blocks allocs\r\n");
+  for (i = 0; i < CH_HEAP_PROFILE_SITES; i++) {
+    ch_heap_site_t *sp = &dbg_heap_sites[i];
+
+    if (sp->hs_allocs == 0)
+      continue;
+    chprintf(chp, "%.8lx %10lu %6lu %6lu\r\n",
+             (unsigned long)sp->hs_caller, (uint32_t)sp->hs_bytes,
+             (uint32_t)sp->hs_count, (uint32_t)sp->hs_allocs);
+  }
+}
+#endif
+
 static void cmd_threads(BaseSequentialStream *chp, int argc, char *argv[]) {
   static const char *states[] = {THD_STATE_NAMES};
   Thread *tp;
@@ -63,13 +116,350 @@ static void cmd_threads(BaseSequentialStream *chp, int argc, char *argv[]) {
   tp = chRegFirstThread();
   do {
     chprintf(chp, "%.8lx %.8lx %4lu %4lu %9s %lu\r\n",
-            (uint32_t)tp, (uint32_t)tp->p_ctx.esp,
+            (unsigned long)tp, (unsigned long)tp->p_ctx.esp,
             (uint32_t)tp->p_prio, (uint32_t)(tp->p_refs - 1),
             states[tp->p_state], (uint32_t)tp->p_time);
     tp = chRegNextThread(tp);
   } while (tp != NULL);
 }
 
+#if CH_DBG_FILL_THREADS
+static void cmd_stacks(BaseSequentialStream *chp, int argc, char *argv[]) {
+  Thread *tp;
+  size_t size, used;
+
+  (void)argv;
+  if (argc > 0) {
+    chprintf(chp, "Usage: stacks\r\n");
+    return;
+  }
+  chprintf(chp, "    addr     size     peak  suggest name\r\n");
+  tp = chRegFirstThread();
+  do {
+    used = chRegGetStackUsage(tp, &size);
+    if (size == 0)
+      chprintf(chp, "%.8lx        -        -        - %s\r\n",
+               (unsigned long)tp, tp->p_name ? tp->p_name : "");
+    else
+      /* Suggested size, peak usage plus a 25% margin.*/
+      chprintf(chp, "%.8lx %8lu %8lu %8lu %s\r\n",
+               (unsigned long)tp, (uint32_t)size, (uint32_t)used,
+               (uint32_t)MEM_ALIGN_NEXT(used + used / 4),
+               tp->p_name ? tp->p_name : "");
+    tp = chRegNextThread(tp);
+  } while (tp != NULL);
+}
+#endif
+
+#if CH_DBG_CPU_ACCOUNTING
+#define TOP_MAX_THREADS     32
+
+/*
+ * CPU usage over a window, the cumulative counters are sampled at the start
+ * and at the end of the window.
+ */
+static void cmd_top(BaseSequentialStream *chp, int argc, char *argv[]) {
+  static Thread *threads[TOP_MAX_THREADS];
+  static uint64_t tbase[TOP_MAX_THREADS], sbase[CH_ACCT_IRQ_SOURCES];
+  uint64_t cycles, total, idle, isr;
+  ch_acct_source_t *sp;
+  Thread *tp;
+  unsigned i, n, secs = 1;
+
+  if ((argc > 1) || ((argc == 1) && ((secs = atoi(argv[0])) == 0))) {
+    chprintf(chp, "Usage: top [seconds]\r\n");
+    return;
+  }
+
+  /* Start of the window.*/
+  n = 0;
+  tp = chRegFirstThread();
+  do {
+    if (n < TOP_MAX_THREADS) {
+      chSysLock();
+      chDbgAcctUpdateI();
+      threads[n] = tp;
+      tbase[n++] = chDbgAcctGetThreadCyclesI(tp);
+      chSysUnlock();
+    }
+    tp = chRegNextThread(tp);
+  } while (tp != NULL);
+  chSysLock();
+  for (i = 0; i < CH_ACCT_IRQ_SOURCES; i++)
+    sbase[i] = i < chDbgAcctGetSourcesI() ? chDbgAcctGetSourceI(i)->is_cycles
+                                          : 0;
+  chSysUnlock();
+
+  chThdSleepSeconds(secs);
+
+  /* End of the window, the thread deltas are computed in place.*/
+  total = idle = isr = 0;
+  tp = chRegFirstThread();
+  do {
+    chSysLock();
+    chDbgAcctUpdateI();
+    cycles = chDbgAcctGetThreadCyclesI(tp);
+    chSysUnlock();
+    for (i = 0; (i < n) && (threads[i] != tp); i++)
+      ;
+    if ((i == n) && (n < TOP_MAX_THREADS)) {
+      /* Thread created during the window.*/
+      threads[n++] = tp;
+      tbase[i] = 0;
+    }
+    if (i < n) {
+      tbase[i] = cycles >= tbase[i] ? cycles - tbase[i] : cycles;
+      total += tbase[i];
+      if (tp->p_prio == IDLEPRIO)
+        idle += tbase[i];
+    }
+    tp = chRegNextThread(tp);
+  } while (tp != NULL);
+  chSysLock();
+  for (i = 0; i < chDbgAcctGetSourcesI(); i++) {
+    sbase[i] = chDbgAcctGetSourceI(i)->is_cycles - sbase[i];
+    isr += sbase[i];
+  }
+  chSysUnlock();
+  total += isr;
+  if (total == 0)
+    total = 1;
+
+  /* Percentages in tenths.*/
+  chprintf(chp, "    addr prio   cpu%% name\r\n");
+  tp = chRegFirstThread();
+  do {
+    for (i = 0; (i < n) && (threads[i] != tp); i++)
+      ;
+    if (i < n) {
+      cycles = tbase[i] * 1000 / total;
+      chprintf(chp, "%.8lx %4lu %4lu.%lu %s\r\n",
+               (unsigned long)tp, (uint32_t)tp->p_prio,
+               (uint32_t)(cycles / 10), (uint32_t)(cycles % 10),
+               tp->p_name ? tp->p_name : "");
+    }
+    tp = chRegNextThread(tp);
+  } while (tp != NULL);
+  chprintf(chp, "  source    count   cpu%%\r\n");
+  for (i = 0; i < chDbgAcctGetSourcesI(); i++) {
+    sp = chDbgAcctGetSourceI(i);
+    cycles = sbase[i] * 1000 / total;
+    chprintf(chp, "%8lu %8lu %4lu.%lu\r\n",
+             (uint32_t)sp->is_id, (uint32_t)sp->is_count,
+             (uint32_t)(cycles / 10), (uint32_t)(cycles % 10));
+  }
+  idle = idle * 1000 / total;
+  isr = isr * 1000 / total;
+  chprintf(chp, "idle %lu.%lu%%, interrupts %lu.%lu%% over %u seconds\r\n",
+           (uint32_t)(idle / 10), (uint32_t)(idle % 10),
+           (uint32_t)(isr / 10), (uint32_t)(isr % 10), secs);
+}
+#endif
+
+#if CH_DBG_CRITICAL_MONITOR
+static void print_crit(BaseSequentialStream *chp, const char *level,
+                       ch_crit_stats_t *csp) {
+  unsigned i;
+
+  chprintf(chp, "%s level sections : %lu\r\n", level, csp->cs_count);
+  if (csp->cs_count == 0)
+    return;
+  chprintf(chp, "  average        : %lu cycles\r\n",
+           (uint32_t)(csp->cs_total / csp->cs_count));
+  chprintf(chp, "  longest        : %lu cycles\r\n", csp->cs_max);
+  chprintf(chp, "  entered at     : %.8lx\r\n",
+           (unsigned long)csp->cs_max_lock);
+  chprintf(chp, "  left at        : %.8lx\r\n",
+           (unsigned long)csp->cs_max_unlock);
+  for (i = 0; i < CH_CRIT_HISTOGRAM_BINS; i++)
+    if (csp->cs_histogram[i] != 0)
+      chprintf(chp, "  < 2^%-2u cycles  : %lu\r\n", i + 1,
+               csp->cs_histogram[i]);
+}
+
+static void cmd_crit(BaseSequentialStream *chp, int argc, char *argv[]) {
+  ch_crit_stats_t thd, isr;
+
+  if ((argc > 1) || ((argc == 1) && (strcmp(argv[0], "reset") != 0))) {
+    chprintf(chp, "Usage: crit [reset]\r\n");
+    return;
+  }
+  if (argc == 1) {
+    chDbgCritResetStats();
+    return;
+  }
+  /* The addresses can be resolved using addr2line.*/
+  chDbgCritGetStats(&thd, &isr);
+  print_crit(chp, "thread", &thd);
+  print_crit(chp, "ISR", &isr);
+}
+#endif
+
+#if CH_DBG_SYNC_PROFILING
+#define SYNC_TOP            10
+
+static void cmd_sync(BaseSequentialStream *chp, int argc, char *argv[]) {
+  static const char *types[] = {"?", "sem", "bsem", "mutex"};
+  static ch_sync_profile_t top[SYNC_TOP];
+  ch_sync_profile_t *pp;
+  unsigned i, n;
+
+  (void)argv;
+  if (argc > 0) {
+    chprintf(chp, "Usage: sync\r\n");
+    return;
+  }
+  /* Times are in free running counter cycles.*/
+  chprintf(chp, "type      acquired contended  avg wait  max wait  max hold "
+                "boosts name\r\n");
+  n = chSyncProfGetTop(top, SYNC_TOP);
+  for (i = 0; i < n; i++) {
+    pp = &top[i];
+    chprintf(chp, "%-5s %12lu %9lu %9lu %9lu %9lu %6lu %s\r\n",
+             types[pp->sp_type], pp->sp_acquisitions, pp->sp_contended,
+             pp->sp_contended ? (uint32_t)(pp->sp_wait_total /
+                                           pp->sp_contended) : 0,
+             pp->sp_wait_max, pp->sp_hold_max, pp->sp_boosts,
+             pp->sp_name ? pp->sp_name : "");
+  }
+}
+#endif
+
+#if CH_DBG_STATISTICS
+#define KSTAT_MAX_THREADS   32
+
+/*
+ * Kernel counters rates over a window, two snapshots are taken at the start
+ * and at the end of the window.
+ */
+static void cmd_kstat(BaseSequentialStream *chp, int argc, char *argv[]) {
+  static Thread *threads[KSTAT_MAX_THREADS];
+  static uint32_t wbase[KSTAT_MAX_THREADS];
+  ch_kernel_stats_t ks0, ks1;
+  systime_t start, ms;
+  Thread *tp;
+  unsigned i, n, secs = 1;
+
+  if ((argc > 1) || ((argc == 1) && ((secs = atoi(argv[0])) == 0))) {
+    chprintf(chp, "Usage: kstat [seconds]\r\n");
+    return;
+  }
+
+  /* Start of the window.*/
+  n = 0;
+  tp = chRegFirstThread();
+  do {
+    if (n < KSTAT_MAX_THREADS) {
+      chSysLock();
+      threads[n] = tp;
+      wbase[n++] = chStatsGetThreadWakeupsI(tp);
+      chSysUnlock();
+    }
+    tp = chRegNextThread(tp);
+  } while (tp != NULL);
+  start = chTimeNow();
+  chStatsGetSnapshot(&ks0);
+
+  chThdSleepSeconds(secs);
+
+  /* End of the window, rates are computed on the elapsed milliseconds.*/
+  chStatsGetSnapshot(&ks1);
+  ms = (systime_t)((uint64_t)(chTimeNow() - start) * 1000 / CH_FREQUENCY);
+  if (ms == 0)
+    ms = 1;
+#define RATE(d) ((uint32_t)((uint64_t)(d) * 1000 / ms))
+  chprintf(chp, "switch/s preempt/s  yield/s    isr/s     vt/s ready max\r\n");
+  chprintf(chp, "%8lu %9lu %8lu %8lu %8lu %5lu %3lu\r\n",
+           RATE(ks1.ks_switches - ks0.ks_switches),
+           RATE(ks1.ks_preemptions - ks0.ks_preemptions),
+           RATE(ks1.ks_yields - ks0.ks_yields),
+           RATE(ks1.ks_isr - ks0.ks_isr),
+           RATE(ks1.ks_vt - ks0.ks_vt),
+           (uint32_t)ks1.ks_ready, (uint32_t)ks1.ks_ready_max);
+  chprintf(chp, "    addr prio wakeup/s name\r\n");
+  tp = chRegFirstThread();
+  do {
+    for (i = 0; (i < n) && (threads[i] != tp); i++)
+      ;
+    chprintf(chp, "%.8lx %4lu %8lu %s\r\n",
+             (unsigned long)tp, (uint32_t)tp->p_prio,
+             RATE(chStatsGetThreadWakeupsI(tp) - (i < n ? wbase[i] : 0)),
+             tp->p_name ? tp->p_name : "");
+    tp = chRegNextThread(tp);
+  } while (tp != NULL);
+#undef RATE
+}
+#endif
+
+#if CH_DBG_PROFILER
+/*
+ * Stream writing the data as hexadecimal text on the shell stream, used
+ * for the profiler dump that is decoded on the host by chprof.py.
+ */
+static BaseSequentialStream *hex_chp;
+static unsigned hex_col;
+
+static size_t hex_writes(void *ip, const uint8_t *bp, size_t n) {
+  size_t i;
+
+  (void)ip;
+  for (i = 0; i < n; i++) {
+    chprintf(hex_chp, "%.2x", bp[i]);
+    if (++hex_col == 32) {
+      chprintf(hex_chp, "\r\n");
+      hex_col = 0;
+    }
+  }
+  return n;
+}
+
+static size_t hex_reads(void *ip, uint8_t *bp, size_t n) {
+
+  (void)ip;
+  (void)bp;
+  (void)n;
+  return 0;
+}
+
+static msg_t hex_put(void *ip, uint8_t b) {
+
+  hex_writes(ip, &b, 1);
+  return RDY_OK;
+}
+
+static msg_t hex_get(void *ip) {
+
+  (void)ip;
+  return RDY_RESET;
+}
+
+static const struct BaseSequentialStreamVMT hex_vmt = {
+  hex_writes, hex_reads, hex_put, hex_get
+};
+
+static void cmd_prof(BaseSequentialStream *chp, int argc, char *argv[]) {
+  BaseSequentialStream hex = {&hex_vmt};
+
+  if (argc != 1) {
+    chprintf(chp, "Usage: prof start|stop|dump\r\n");
+    return;
+  }
+  if (strcmp(argv[0], "start") == 0)
+    chDbgProfStart();
+  else if (strcmp(argv[0], "stop") == 0)
+    chDbgProfStop();
+  else if (strcmp(argv[0], "dump") == 0) {
+    hex_chp = chp;
+    hex_col = 0;
+    chDbgProfDump(&hex);
+    if (hex_col > 0)
+      chprintf(chp, "\r\n");
+  }
+  else
+    chprintf(chp, "Usage: prof start|stop|dump\r\n");
+}
+#endif
+
 static void cmd_test(BaseSequentialStream *chp, int argc, char *argv[]) {
   Thread *tp;
 
@@ -87,10 +477,87 @@ static void cmd_test(BaseSequentialStream *chp, int argc, char *argv[]) {
   chThdWait(tp);
 }
 
+/*
+ * Parses the benchmarks harness arguments, shared by the "bench" command
+ * and by the unattended mode.
+ */
+static bool_t bench_parse(struct testbmkconfig *cfgp, int argc, char *argv[]) {
+  int i = 0;
+
+  cfgp->select = NULL;
+  cfgp->repeat = 5;
+  cfgp->format = TEST_BMK_FORMAT_JSON;
+  if ((i < argc) && (strcmp(argv[i], "json") == 0))
+    i++;
+  else if ((i < argc) && (strcmp(argv[i], "csv") == 0)) {
+    cfgp->format = TEST_BMK_FORMAT_CSV;
+    i++;
+  }
+  if (i < argc) {
+    if (strspn(argv[i], "0123456789") != strlen(argv[i]))
+      return FALSE;
+    cfgp->repeat = (unsigned)atoi(argv[i++]);
+    if ((cfgp->repeat == 0) || (cfgp->repeat > TEST_BMK_MAX_REPEAT))
+      return FALSE;
+  }
+  if (i < argc) {
+    if (strspn(argv[i], "0123456789,-") != strlen(argv[i]))
+      return FALSE;
+    cfgp->select = argv[i++];
+  }
+  return i == argc;
+}
+
+#define BENCH_USAGE "Usage: bench [list | [json|csv] [repeat [selection]]]"
+
+static void cmd_bench(BaseSequentialStream *chp, int argc, char *argv[]) {
+  struct testbmkconfig cfg;
+  Thread *tp;
+
+  if ((argc == 1) && (strcmp(argv[0], "list") == 0)) {
+    TestBenchmarksList(chp);
+    return;
+  }
+  if (!bench_parse(&cfg, argc, argv)) {
+    chprintf(chp, BENCH_USAGE "\r\n");
+    return;
+  }
+  cfg.chp = chp;
+  tp = chThdCreateFromHeap(NULL, TEST_WA_SIZE, chThdGetPriority(),
+                           TestBenchmarks, &cfg);
+  if (tp == NULL) {
+    chprintf(chp, "out of memory\r\n");
+    return;
+  }
+  chThdWait(tp);
+}
+
 static const ShellCommand commands[] = {
   {"mem", cmd_mem},
+#if CH_DBG_HEAP_PROFILING
+  {"heap", cmd_heap},
+#endif
   {"threads", cmd_threads},
+#if CH_DBG_FILL_THREADS
+  {"stacks", cmd_stacks},
+#endif
+#if CH_DBG_CPU_ACCOUNTING
+  {"top", cmd_top},
+#endif
+#if CH_DBG_CRITICAL_MONITOR
+  {"crit", cmd_crit},
+#endif
+#if CH_DBG_SYNC_PROFILING
+  {"sync", cmd_sync},
+#endif
+#if CH_DBG_STATISTICS
+  {"kstat", cmd_kstat},
+#endif
+#if CH_DBG_PROFILER
+  {"prof", cmd_prof},
+#endif
   {"test", cmd_test},
+  {"bench", cmd_bench},
   {NULL, NULL}
 };
 
@@ -201,10 +668,46 @@ static evhandler_t fhandlers[] = {
   sd2_handler
 };
 
+/*
+ * Stream writing on a file, used by the unattended mode.
+ */
+static FILE *bench_file;
+
+static size_t file_writes(void *ip, const uint8_t *bp, size_t n) {
+
+  (void)ip;
+  return fwrite(bp, 1, n, bench_file);
+}
+
+static size_t file_reads(void *ip, uint8_t *bp, size_t n) {
+
+  (void)ip;
+  (void)bp;
+  (void)n;
+  return 0;
+}
+
+static msg_t file_put(void *ip, uint8_t b) {
+
+  (void)ip;
+  fputc(b, bench_file);
+  return RDY_OK;
+}
+
+static msg_t file_get(void *ip) {
+
+  (void)ip;
+  return RDY_RESET;
+}
+
+static const struct BaseSequentialStreamVMT file_vmt = {
+  file_writes, file_reads, file_put, file_get
+};
+
 /*------------------------------------------------------------------------*
  * Simulator main.                                                        *
  *------------------------------------------------------------------------*/
-int main(void) {
+int main(int argc, char *argv[]) {
   EventListener tel;
 
   /*
@@ -217,6 +720,47 @@ int main(void) {
   halInit();
   chSysInit();
 
+  /*
+   * Unattended mode, "ch bench [-o file] [arguments]" runs the benchmarks
+   * harness with the results written on the specified file, or on the
+   * standard output, then exits. The exit code is non-zero on failure.
+   */
+  if ((argc > 1) && (strcmp(argv[1], "bench") == 0)) {
+    BaseSequentialStream out = {&file_vmt};
+    struct testbmkconfig cfg;
+    const char *name = NULL;
+    msg_t failed;
+
+    argc -= 2;
+    argv += 2;
+    if ((argc >= 2) && (strcmp(argv[0], "-o") == 0)) {
+      name = argv[1];
+      argc -= 2;
+      argv += 2;
+    }
+    if ((argc == 1) && (strcmp(argv[0], "list") == 0))
+      cfg.repeat = 0;
+    else if (!bench_parse(&cfg, argc, argv)) {
+      fprintf(stderr, "Usage: ch bench [-o file] "
+                      "[list | [json|csv] [repeat [selection]]]\n");
+      return 2;
+    }
+    bench_file = stdout;
+    if ((name != NULL) && ((bench_file = fopen(name, "wb")) == NULL)) {
+      perror(name);
+      return 2;
+    }
+    failed = FALSE;
+    if (cfg.repeat == 0)
+      TestBenchmarksList(&out);
+    else {
+      cfg.chp = &out;
+      failed = TestBenchmarks(&cfg);
+    }
+    fclose(bench_file);
+    return failed ? 1 : 0;
+  }
+
   /*
    * Serial ports (simulated) initialization.
    */
@@ -75,7 +75,7 @@
  * @note    Requires @p CH_USE_MEMCORE.
  */
 #if !defined(CH_MEMCORE_SIZE) || defined(__DOXYGEN__)
-#define CH_MEMCORE_SIZE                 0x20000
+#define CH_MEMCORE_SIZE                 0x40000
 #endif
 
 /**
@@ -236,6 +236,18 @@
 #define CH_USE_EVENTS_TIMEOUT           TRUE
 #endif
 
+/**
+ * @brief   Topics APIs.
+ * @details If enabled then the publish/subscribe topics APIs are included
+ *          in the kernel.
+ *
+ * @note    The default is @p TRUE.
+ * @note    Requires @p CH_USE_EVENTS.
+ */
+#if !defined(CH_USE_TOPICS) || defined(__DOXYGEN__)
+#define CH_USE_TOPICS                   TRUE
+#endif
+
 /**
  * @brief   Synchronous Messages APIs.
  * @details If enabled then the synchronous messages APIs are included
@@ -271,6 +283,30 @@
 #define CH_USE_MAILBOXES                TRUE
 #endif
 
+/**
+ * @brief   Priority mailboxes APIs.
+ * @details If enabled then the priority mailboxes APIs are included in the
+ *          kernel.
+ *
+ * @note    The default is @p TRUE.
+ * @note    Requires @p CH_USE_SEMAPHORES.
+ */
+#if !defined(CH_USE_PRIO_MAILBOXES) || defined(__DOXYGEN__)
+#define CH_USE_PRIO_MAILBOXES           TRUE
+#endif
+
+/**
+ * @brief   Objects FIFOs APIs.
+ * @details If enabled then the objects FIFOs APIs are included in the
+ *          kernel.
+ *
+ * @note    The default is @p TRUE.
+ * @note    Requires @p CH_USE_MAILBOXES and @p CH_USE_MEMPOOLS.
+ */
+#if !defined(CH_USE_OBJFIFOS) || defined(__DOXYGEN__)
+#define CH_USE_OBJFIFOS                 TRUE
+#endif
+
 /**
  * @brief   I/O Queues APIs.
  * @details If enabled then the I/O queues APIs are included in the kernel.
@@ -281,6 +317,18 @@
 #define CH_USE_QUEUES                   TRUE
 #endif
 
+/**
+ * @brief   Ring Buffers APIs.
+ * @details If enabled then the lock-free ring buffers APIs are included
+ *          in the kernel.
+ *
+ * @note    The default is @p TRUE.
+ * @note    Requires @p CH_USE_SEMAPHORES.
+ */
+#if !defined(CH_USE_RINGS) || defined(__DOXYGEN__)
+#define CH_USE_RINGS                    TRUE
+#endif
+
 /**
  * @brief   Core Memory Manager APIs.
  * @details If enabled then the core memory manager APIs are included
@@ -331,6 +379,32 @@
 #define CH_USE_MEMPOOLS                 TRUE
 #endif
 
+/**
+ * @brief   Lock-free Memory Pools.
+ * @details If enabled then the memory pools free objects lists are
+ *          lock-free stacks and the pool objects can be allocated and
+ *          freed from any context without entering a critical zone.
+ *
+ * @note    The default is @p FALSE.
+ * @note    Requires @p CH_USE_MEMPOOLS.
+ * @note    The port must support the exclusive access primitives or a
+ *          double word compare and swap.
+ */
+#if !defined(CH_USE_MEMPOOLS_LOCKFREE) || defined(__DOXYGEN__)
+#define CH_USE_MEMPOOLS_LOCKFREE        FALSE
+#endif
+
+/**
+ * @brief   Memory Arenas Allocator APIs.
+ * @details If enabled then the memory arenas allocator APIs are included
+ *          in the kernel.
+ *
+ * @note    The default is @p TRUE.
+ */
+#if !defined(CH_USE_ARENAS) || defined(__DOXYGEN__)
+#define CH_USE_ARENAS                   TRUE
+#endif
+
 /**
  * @brief   Dynamic Threads APIs.
  * @details If enabled then the dynamic threads creation APIs are included
@@ -389,8 +463,10 @@
 
 /**
  * @brief   Debug option, trace buffer.
- * @details If enabled then the context switch circular trace buffer is
- *          activated.
+ * @details If enabled then the kernel events circular trace buffer is
+ *          activated. The recorded events classes are selected by
+ *          @p CH_TRACE_MASK, the buffer can be dumped using
+ *          @p chDbgTraceDump().
  *
  * @note    The default is @p FALSE.
  */
@@ -424,6 +500,19 @@
 #define CH_DBG_FILL_THREADS             FALSE
 #endif
 
+/**
+ * @brief   Debug option, threads stack usage report.
+ * @details If enabled then the peak stack usage of each thread is measured
+ *          when the thread terminates and reported through the
+ *          @p THREAD_STACK_REPORT_HOOK() hook.
+ *
+ * @note    The default is @p FALSE.
+ * @note    Requires @p CH_USE_REGISTRY and @p CH_DBG_FILL_THREADS.
+ */
+#if !defined(CH_DBG_STACK_EXIT_REPORT) || defined(__DOXYGEN__)
+#define CH_DBG_STACK_EXIT_REPORT        FALSE
+#endif
+
 /**
  * @brief   Debug option, threads profiling.
  * @details If enabled then a field is added to the @p Thread structure that
@@ -437,6 +526,87 @@
 #define CH_DBG_THREADS_PROFILING        TRUE
 #endif
 
+/**
+ * @brief   Debug option, heap profiling.
+ * @details If enabled then the heap allocator keeps track of the allocated
+ *          memory, each block is attributed to the call site that allocated
+ *          it, the fragmentation of the free space can be inspected.
+ *
+ * @note    The default is @p FALSE.
+ * @note    Requires @p CH_USE_HEAP and it is not compatible with
+ *          @p CH_USE_MALLOC_HEAP.
+ */
+#if !defined(CH_DBG_HEAP_PROFILING) || defined(__DOXYGEN__)
+#define CH_DBG_HEAP_PROFILING           FALSE
+#endif
+
+/**
+ * @brief   Debug option, CPU accounting.
+ * @details If enabled then the time spent by each thread and by each
+ *          interrupt source is measured using the port free running
+ *          counter, the time spent in interrupt handlers is not charged to
+ *          the interrupted threads.
+ *
+ * @note    The default is @p FALSE.
+ * @note    Requires a port supporting @p PORT_SUPPORTS_RT_COUNTER.
+ */
+#if !defined(CH_DBG_CPU_ACCOUNTING) || defined(__DOXYGEN__)
+#define CH_DBG_CPU_ACCOUNTING           FALSE
+#endif
+
+/**
+ * @brief   Debug option, critical sections monitor.
+ * @details If enabled then the duration of the kernel critical sections is
+ *          measured using the port free running counter, the longest
+ *          sections and their code addresses are recorded separately for
+ *          the thread and ISR levels together with a durations histogram.
+ *
+ * @note    The default is @p FALSE.
+ * @note    Requires a port supporting @p PORT_SUPPORTS_RT_COUNTER.
+ */
+#if !defined(CH_DBG_CRITICAL_MONITOR) || defined(__DOXYGEN__)
+#define CH_DBG_CRITICAL_MONITOR         FALSE
+#endif
+
+/**
+ * @brief   Debug option, synchronization objects profiling.
+ * @details If enabled then semaphores and mutexes keep contention
+ *          statistics measured using the port free running counter, objects
+ *          can be registered with a name in order to be inspected.
+ *
+ * @note    The default is @p FALSE.
+ * @note    Requires a port supporting @p PORT_SUPPORTS_RT_COUNTER.
+ */
+#if !defined(CH_DBG_SYNC_PROFILING) || defined(__DOXYGEN__)
+#define CH_DBG_SYNC_PROFILING           FALSE
+#endif
+
+/**
+ * @brief   Debug option, kernel statistics.
+ * @details If enabled then the kernel keeps counters of context switches,
+ *          preemptions, yields, IRQ handlers entries, virtual timers
+ *          expirations, ready list depth and threads wakeups.
+ *
+ * @note    The default is @p FALSE.
+ */
+#if !defined(CH_DBG_STATISTICS) || defined(__DOXYGEN__)
+#define CH_DBG_STATISTICS               FALSE
+#endif
+
+/**
+ * @brief   Debug option, sampling profiler.
+ * @details If enabled then the interrupted program counter and the current
+ *          thread are periodically sampled in a circular buffer, the
+ *          buffer can be dumped and symbolized on the host.
+ *
+ * @note    The default is @p FALSE.
+ * @note    Requires a port supporting @p PORT_SUPPORTS_PROF_SAMPLER or
+ *          @p PORT_SUPPORTS_IRQ_PC.
+ */
+#if !defined(CH_DBG_PROFILER) || defined(__DOXYGEN__)
+#define CH_DBG_PROFILER                 FALSE
+#endif
+
 /** @} */
 
 /*===========================================================================*/
@@ -482,6 +652,22 @@
 }
 #endif
 
+/**
+ * @brief   Threads stack usage report hook.
+ * @details This hook is invoked by @p chThdExitS() with the working area
+ *          size and the peak stack usage of the terminating thread.
+ *
+ * @note    It is inserted into lock zone.
+ * @note    It is also invoked when the threads simply return in order to
+ *          terminate.
+ * @note    It is only invoked if @p CH_DBG_STACK_EXIT_REPORT is enabled.
+ */
+#if !defined(THREAD_STACK_REPORT_HOOK) || defined(__DOXYGEN__)
+#define THREAD_STACK_REPORT_HOOK(tp, size, used) {                          \
+  /* Stack usage report code here.*/                                        \
+}
+#endif
+
 /**
  * @brief   Context switch hook.
  * @details This hook is invoked just before switching between threads.
@@ -0,0 +1,298 @@
+/*
+    ChibiOS/RT - Copyright (C) 2006,2007,2008,2009,2010,
+                 2011,2012,2013 Giovanni Di Sirio.
+
+    This file is part of ChibiOS/RT.
+
+    ChibiOS/RT is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    ChibiOS/RT is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * @file    bqueues.h
+ * @brief   Buffers queues macros and structures.
+ *
+ * @addtogroup BQUEUES
+ * @{
+ */
+
+#ifndef _BQUEUES_H_
+#define _BQUEUES_H_
+
+#if CH_USE_QUEUES || defined(__DOXYGEN__)
+
+/*===========================================================================*/
+/* Driver constants.                                                         */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Driver pre-compile time settings.                                         */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Derived constants and error checks.                                       */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Driver data structures and types.                                         */
+/*===========================================================================*/
+
+/**
+ * @brief   Type of a buffers queue structure.
+ */
+typedef struct BuffersQueue BuffersQueue;
+
+/**
+ * @brief   Buffers queue notification callback type.
+ */
+typedef void (*bqnotify_t)(BuffersQueue *bqp);
+
+/**
+ * @brief   Structure representing a buffers queue.
+ * @details A buffers queue is a ring of fixed capacity buffers, each buffer
+ *          carries the length of the data it contains. The producer side
+ *          fills empty buffers in place and posts them, the consumer side
+ *          processes full buffers in place and releases them.
+ */
+struct BuffersQueue {
+  /**
+   * @brief   Queue of waiting threads.
+   */
+  ThreadsQueue              waiting;
+  /**
+   * @brief   Number of full buffers, including the one currently being
+   *          processed by the consumer.
+   */
+  size_t                    bcounter;
+  /**
+   * @brief   Number of buffers.
+   */
+  size_t                    bn;
+  /**
+   * @brief   Capacity of each buffer.
+   */
+  size_t                    bsize;
+  /**
+   * @brief   Pointer to the buffers memory.
+   */
+  uint8_t                   *buffers;
+  /**
+   * @brief   Pointer to the first location after the buffers memory.
+   */
+  uint8_t                   *top;
+  /**
+   * @brief   Buffer to be filled by the producer.
+   */
+  uint8_t                   *bwrptr;
+  /**
+   * @brief   Buffer to be processed by the consumer.
+   */
+  uint8_t                   *brdptr;
+  /**
+   * @brief   Read position inside the current full buffer or @p NULL.
+   * @note    Only used by the stream read functions.
+   */
+  uint8_t                   *ptr;
+  /**
+   * @brief   Pointer to the end of the data in the current full buffer.
+   * @note    Only used by the stream read functions.
+   */
+  uint8_t                   *end;
+  /**
+   * @brief   Write position inside the current empty buffer or @p NULL.
+   * @note    Only used by the stream write functions.
+   */
+  uint8_t                   *wptr;
+  /**
+   * @brief   Resets counter.
+   * @note    Used by the stream functions in order to detect a reset
+   *          performed while copying data outside the critical zone.
+   */
+  size_t                    resets;
+  /**
+   * @brief   Full buffer posted notification callback.
+   */
+  bqnotify_t                pnotify;
+  /**
+   * @brief   Empty buffer released notification callback.
+   */
+  bqnotify_t                cnotify;
+  /**
+   * @brief   Application defined field.
+   */
+  void                      *link;
+};
+
+/**
+ * @brief   @p BuffersChannel specific methods.
+ */
+#define _buffers_channel_methods                                            \
+  _base_channel_methods
+
+/**
+ * @brief   @p BuffersChannel specific data.
+ */
+#define _buffers_channel_data                                               \
+  _base_channel_data                                                        \
+  /* Queue of the buffers read from the channel.*/                          \
+  BuffersQueue              *ibqp;                                          \
+  /* Queue of the buffers written to the channel.*/                         \
+  BuffersQueue              *obqp;
+
+/**
+ * @extends BaseChannelVMT
+ *
+ * @brief   @p BuffersChannel virtual methods table.
+ */
+struct BuffersChannelVMT {
+  _buffers_channel_methods
+};
+
+/**
+ * @extends BaseChannel
+ *
+ * @brief   Buffers channel object.
+ * @details This object exposes a pair of buffers queues as a
+ *          @p BaseChannel so the existing stream users can access them.
+ */
+typedef struct {
+  /** @brief Virtual Methods Table.*/
+  const struct BuffersChannelVMT *vmt;
+  _buffers_channel_data
+} BuffersChannel;
+
+/*===========================================================================*/
+/* Driver macros.                                                            */
+/*===========================================================================*/
+
+/**
+ * @name    Macro Functions
+ * @{
+ */
+/**
+ * @brief   Computes the size of a buffers queue buffer.
+ * @details Each buffer is prefixed by its data length and padded to keep
+ *          the following buffer aligned.
+ *
+ * @param[in] n         number of buffers
+ * @param[in] size      capacity of each buffer
+ * @return              The required buffer size in bytes.
+ */
+#define BQ_BUFFERS_SIZE(n, size)                                            \
+  ((n) * (sizeof (size_t) +                                                 \
+          (((size) + sizeof (size_t) - 1) & ~(sizeof (size_t) - 1))))
+
+/**
+ * @brief   Returns the capacity of the buffers.
+ *
+ * @param[in] bqp       pointer to a @p BuffersQueue structure
+ * @return              The capacity of each buffer.
+ *
+ * @special
+ */
+#define bqGetBufferSize(bqp) ((bqp)->bsize)
+
+/**
+ * @brief   Returns the number of full buffers.
+ *
+ * @param[in] bqp       pointer to a @p BuffersQueue structure
+ * @return              The number of full buffers.
+ *
+ * @iclass
+ */
+#define bqGetFullI(bqp) ((bqp)->bcounter)
+
+/**
+ * @brief   Returns the number of empty buffers.
+ *
+ * @param[in] bqp       pointer to a @p BuffersQueue structure
+ * @return              The number of empty buffers.
+ *
+ * @iclass
+ */
+#define bqGetEmptyI(bqp) ((bqp)->bn - (bqp)->bcounter)
+
+/**
+ * @brief   Evaluates to @p TRUE if the buffers queue has no full buffers.
+ *
+ * @param[in] bqp       pointer to a @p BuffersQueue structure
+ * @return              The queue status.
+ * @retval FALSE        if the queue contains full buffers.
+ * @retval TRUE         if the queue is empty.
+ *
+ * @iclass
+ */
+#define bqIsEmptyI(bqp) ((bool_t)(bqGetFullI(bqp) == 0))
+
+/**
+ * @brief   Evaluates to @p TRUE if the buffers queue has no empty buffers.
+ *
+ * @param[in] bqp       pointer to a @p BuffersQueue structure
+ * @return              The queue status.
+ * @retval FALSE        if the queue contains empty buffers.
+ * @retval TRUE         if the queue is full.
+ *
+ * @iclass
+ */
+#define bqIsFullI(bqp) ((bool_t)(bqGetEmptyI(bqp) == 0))
+
+/**
+ * @brief   Returns the buffers queue application-defined link.
+ * @note    This function can be called in any context.
+ *
+ * @param[in] bqp       pointer to a @p BuffersQueue structure
+ * @return              The application-defined link.
+ *
+ * @special
+ */
+#define bqGetLink(bqp) ((bqp)->link)
+/** @} */
+
+/*===========================================================================*/
+/* External declarations.                                                    */
+/*===========================================================================*/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+  void bqObjectInit(BuffersQueue *bqp, uint8_t *bp, size_t size, size_t n,
+                    bqnotify_t pnfy, bqnotify_t cnfy, void *link);
+  void bqResetI(BuffersQueue *bqp);
+  uint8_t *bqGetEmptyBufferI(BuffersQueue *bqp);
+  msg_t bqGetEmptyBufferTimeout(BuffersQueue *bqp, uint8_t **bufp,
+                                systime_t time);
+  void bqPostFullBufferI(BuffersQueue *bqp, size_t size);
+  void bqPostFullBuffer(BuffersQueue *bqp, size_t size);
+  uint8_t *bqGetFullBufferI(BuffersQueue *bqp, size_t *sizep);
+  msg_t bqGetFullBufferTimeout(BuffersQueue *bqp, uint8_t **bufp,
+                               size_t *sizep, systime_t time);
+  void bqReleaseEmptyBufferI(BuffersQueue *bqp);
+  void bqReleaseEmptyBuffer(BuffersQueue *bqp);
+  msg_t bqGetTimeout(BuffersQueue *bqp, systime_t time);
+  size_t bqReadTimeout(BuffersQueue *bqp, uint8_t *bp,
+                       size_t n, systime_t time);
+  msg_t bqPutTimeout(BuffersQueue *bqp, uint8_t b, systime_t time);
+  size_t bqWriteTimeout(BuffersQueue *bqp, const uint8_t *bp,
+                        size_t n, systime_t time);
+  void bqFlush(BuffersQueue *bqp);
+  void bcObjectInit(BuffersChannel *bcp, BuffersQueue *ibqp,
+                    BuffersQueue *obqp);
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CH_USE_QUEUES */
+
+#endif /* _BQUEUES_H_ */
+
+/** @} */
@@ -40,6 +40,7 @@
 #include "io_block.h"
 
 /* Shared headers.*/
+#include "bqueues.h"
 #include "mmcsd.h"
 
 /* Layered drivers.*/
@@ -306,6 +306,7 @@ extern "C" {
   void sdStart(SerialDriver *sdp, const SerialConfig *config);
   void sdStop(SerialDriver *sdp);
   void sdIncomingDataI(SerialDriver *sdp, uint8_t b);
+  size_t sdIncomingDataBlockI(SerialDriver *sdp, const uint8_t *bp, size_t n);
   msg_t sdRequestDataI(SerialDriver *sdp);
 #ifdef __cplusplus
 }
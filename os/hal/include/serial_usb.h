@@ -45,13 +45,24 @@
  */
 /**
  * @brief   Serial over USB buffers size.
- * @details Configuration parameter, the buffer size must be a multiple of
- *          the USB data endpoint maximum packet size.
- * @note    The default is 256 bytes for both the transmission and receive
+ * @details Configuration parameter, the size of each buffer, it must be a
+ *          multiple of the USB data endpoint maximum packet size.
+ * @note    The default is 64 bytes for both the transmission and receive
  *          buffers.
  */
 #if !defined(SERIAL_USB_BUFFERS_SIZE) || defined(__DOXYGEN__)
-#define SERIAL_USB_BUFFERS_SIZE     256
+#define SERIAL_USB_BUFFERS_SIZE     64
+#endif
+
+/**
+ * @brief   Serial over USB number of buffers.
+ * @details Configuration parameter, the number of buffers in each
+ *          direction.
+ * @note    The default is 4 buffers for both the transmission and receive
+ *          sides.
+ */
+#if !defined(SERIAL_USB_BUFFERS_NUMBER) || defined(__DOXYGEN__)
+#define SERIAL_USB_BUFFERS_NUMBER   4
 #endif
 /** @} */
 
@@ -101,14 +112,18 @@ typedef struct {
   _base_asynchronous_channel_data                                           \
   /* Driver state.*/                                                        \
   sdustate_t                state;                                          \
-  /* Input queue.*/                                                         \
-  InputQueue                iqueue;                                         \
-  /* Output queue.*/                                                        \
-  OutputQueue               oqueue;                                         \
-  /* Input buffer.*/                                                        \
-  uint8_t                   ib[SERIAL_USB_BUFFERS_SIZE];                    \
-  /* Output buffer.*/                                                       \
-  uint8_t                   ob[SERIAL_USB_BUFFERS_SIZE];                    \
+  /* Input buffers queue.*/                                                 \
+  BuffersQueue              ibqueue;                                        \
+  /* Output buffers queue.*/                                                \
+  BuffersQueue              obqueue;                                        \
+  /* Input buffers, the array of size_t keeps them aligned.*/               \
+  size_t                    ib[BQ_BUFFERS_SIZE(SERIAL_USB_BUFFERS_NUMBER,   \
+                                               SERIAL_USB_BUFFERS_SIZE) /   \
+                               sizeof (size_t)];                            \
+  /* Output buffers, the array of size_t keeps them aligned.*/              \
+  size_t                    ob[BQ_BUFFERS_SIZE(SERIAL_USB_BUFFERS_NUMBER,   \
+                                               SERIAL_USB_BUFFERS_SIZE) /   \
+                               sizeof (size_t)];                            \
   /* End of the mandatory fields.*/                                         \
   /* Current configuration data.*/                                          \
   const SerialUSBConfig     *config;
@@ -72,22 +72,38 @@ void hal_lld_init(void) {
 
 /**
  * @brief Interrupt simulation.
+ * @details The simulated interrupts are masked while the sources are
+ *          served, with a preemptive simulator port this function is also
+ *          invoked by the host signal handler.
+ * @note    The IRQ prologue is only entered for the sources actually
+ *          served, the polls are not accounted in the kernel statistics.
  */
 void ChkIntSources(void) {
   struct timeval tv;
 
+  port_lock();
 #if HAL_USE_SERIAL
   if (sd_lld_interrupt_pending()) {
     dbg_check_lock();
     if (chSchIsPreemptionRequired())
       chSchDoReschedule();
     dbg_check_unlock();
+    port_unlock();
     return;
   }
 #endif
 
   gettimeofday(&tv, NULL);
   if (timercmp(&tv, &nextcnt, >=)) {
+#if SIM_USE_PREEMPTION
+    struct timeval lag;
+
+    /* Host stall, the missed ticks are dropped.*/
+    timersub(&tv, &nextcnt, &lag);
+    if ((lag.tv_sec > 0) ||
+        (lag.tv_usec >= SIM_MAX_TICKS_LAG * tick.tv_usec))
+      nextcnt = tv;
+#endif
     timeradd(&nextcnt, &tick, &nextcnt);
 
     CH_IRQ_PROLOGUE();
@@ -103,6 +119,7 @@ void ChkIntSources(void) {
       chSchDoReschedule();
     dbg_check_unlock();
   }
+  port_unlock();
 }
 
 /** @} */
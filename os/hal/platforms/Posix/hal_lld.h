@@ -54,6 +54,19 @@
 /* Driver pre-compile time settings.                                         */
 /*===========================================================================*/
 
+/**
+ * @brief   Maximum system ticks lag recovered by the preemptive simulator.
+ * @details When the host does not run the simulator for longer than this
+ *          number of ticks the missed ticks are dropped instead of being
+ *          served at once, they would be charged to the interrupted thread
+ *          all together.
+ * @note    Only used with @p SIM_USE_PREEMPTION enabled, the cooperative
+ *          simulator serves a single tick for each poll.
+ */
+#if !defined(SIM_MAX_TICKS_LAG) || defined(__DOXYGEN__)
+#define SIM_MAX_TICKS_LAG   2
+#endif
+
 /*===========================================================================*/
 /* Derived constants and error checks.                                       */
 /*===========================================================================*/
@@ -31,6 +31,7 @@
 #include <string.h>
 #include <unistd.h>
 #include <errno.h>
+#include <poll.h>
 #include <sys/ioctl.h>
 
 #include "ch.h"
@@ -107,6 +108,26 @@ abort:
   exit(1);
 }
 
+/*
+ * Checks the host socket of a serial driver for pending events, the check
+ * does not involve the kernel so the simulated interrupt is only entered
+ * when a source actually fires.
+ */
+static bool_t srcint(SerialDriver *sdp) {
+  struct pollfd pfd;
+
+  if (sdp->com_data == INVALID_SOCKET) {
+    pfd.fd = sdp->com_listen;
+    pfd.events = POLLIN;
+  }
+  else {
+    pfd.fd = sdp->com_data;
+    pfd.events = chOQIsEmptyI(&sdp->oqueue) ? POLLIN : POLLIN | POLLOUT;
+  }
+  pfd.revents = 0;
+  return poll(&pfd, 1, 0) > 0;
+}
+
 static bool_t connint(SerialDriver *sdp) {
 
   if (sdp->com_data == INVALID_SOCKET) {
@@ -137,7 +158,6 @@ abort:
 static bool_t inint(SerialDriver *sdp) {
 
   if (sdp->com_data != INVALID_SOCKET) {
-    int i;
     uint8_t data[32];
 
     /*
@@ -159,11 +179,9 @@ static bool_t inint(SerialDriver *sdp) {
       sdp->com_data = INVALID_SOCKET;
       return FALSE;
     }
-    for (i = 0; i < n; i++) {
-      chSysLockFromIsr();
-      sdIncomingDataI(sdp, data[i]);
-      chSysUnlockFromIsr();
-    }
+    chSysLockFromIsr();
+    sdIncomingDataBlockI(sdp, data, (size_t)n);
+    chSysUnlockFromIsr();
     return TRUE;
   }
   return FALSE;
@@ -173,18 +191,18 @@ static bool_t outint(SerialDriver *sdp) {
 
   if (sdp->com_data != INVALID_SOCKET) {
     int n;
-    uint8_t data[1];
+    size_t size;
+    uint8_t *bp;
 
     /*
-     * Input.
+     * Output, the data is sent directly from the queue buffer.
      */
     chSysLockFromIsr();
-    n = sdRequestDataI(sdp);
+    size = chOQGetReadSpanI(&sdp->oqueue, &bp);
     chSysUnlockFromIsr();
-    if (n < 0)
+    if (size == 0)
       return FALSE;
-    data[0] = (uint8_t)n;
-    n = send(sdp->com_data, data, sizeof(data), 0);
+    n = send(sdp->com_data, (void *)bp, size, 0);
     switch (n) {
     case 0:
       close(sdp->com_data);
@@ -200,6 +218,11 @@ static bool_t outint(SerialDriver *sdp) {
       sdp->com_data = INVALID_SOCKET;
       return FALSE;
     }
+    chSysLockFromIsr();
+    chOQReadCommitI(&sdp->oqueue, (size_t)n);
+    if (chOQIsEmptyI(&sdp->oqueue))
+      chnAddFlagsI(sdp, CHN_OUTPUT_EMPTY);
+    chSysUnlockFromIsr();
     return TRUE;
   }
   return FALSE;
@@ -266,9 +289,21 @@ void sd_lld_stop(SerialDriver *sdp) {
   (void)sdp;
 }
 
+/**
+ * @brief   Serial interrupt simulation.
+ * @details The simulated interrupt is entered only if the host sockets have
+ *          pending events.
+ *
+ * @return              The interrupt status.
+ * @retval FALSE        if no source has been served.
+ * @retval TRUE         if a source has been served.
+ */
 bool_t sd_lld_interrupt_pending(void) {
   bool_t b;
 
+  if (!srcint(&SD1) && !srcint(&SD2))
+    return FALSE;
+
   CH_IRQ_PROLOGUE();
 
   b =  connint(&SD1) || connint(&SD2) ||
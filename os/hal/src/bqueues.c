@@ -0,0 +1,861 @@
+/*
+    ChibiOS/RT - Copyright (C) 2006,2007,2008,2009,2010,
+                 2011,2012,2013 Giovanni Di Sirio.
+
+    This file is part of ChibiOS/RT.
+
+    ChibiOS/RT is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    ChibiOS/RT is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * @file    bqueues.c
+ * @brief   Buffers queues code.
+ *
+ * @addtogroup BQUEUES
+ * @details Buffers queues allow the zero-copy exchange of variable length
+ *          packets between a producer and a consumer, one of the sides is
+ *          usually an interrupt handler.<br>
+ *          The queue is a ring of buffers of fixed capacity, the producer
+ *          gets an empty buffer, fills it in place and posts it with the
+ *          length of its content, the consumer gets a full buffer,
+ *          processes it in place and releases it. Both sides have
+ *          non-blocking I-class functions and blocking functions with
+ *          timeout.<br>
+ *          Stream functions are also provided, they copy data in and out
+ *          of the buffers and are used to implement the @p BuffersChannel
+ *          object, a @p BaseChannel accessing a pair of buffers queues.
+ *          The stream writes accumulate data into the current empty
+ *          buffer, the buffer is posted when full, when the consumer has
+ *          no full buffers left or on @p bqFlush().
+ * @pre     In order to use the buffers queues the @p CH_USE_QUEUES option
+ *          must be enabled in @p chconf.h.
+ * @note    There must be a single producer and a single consumer.
+ * @note    The stream functions and the buffer functions must not be mixed
+ *          on the same side of a queue.
+ * @{
+ */
+
+#include <string.h>
+
+#include "ch.h"
+#include "hal.h"
+
+#if CH_USE_QUEUES || defined(__DOXYGEN__)
+
+/*===========================================================================*/
+/* Driver local definitions.                                                 */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Driver exported variables.                                                */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Driver local variables and types.                                         */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Driver local functions.                                                   */
+/*===========================================================================*/
+
+/**
+ * @brief   Puts the invoking thread into the queue's threads queue.
+ *
+ * @param[in] bqp       pointer to a @p BuffersQueue structure
+ * @param[in] time      the number of ticks before the operation timeouts,
+ *                      the following special values are allowed:
+ *                      - @a TIME_IMMEDIATE immediate timeout.
+ *                      - @a TIME_INFINITE no timeout.
+ *                      .
+ * @return              A message specifying how the invoking thread has been
+ *                      released from threads queue.
+ * @retval Q_OK         is the normal exit, thread signaled.
+ * @retval Q_RESET      if the queue has been reset.
+ * @retval Q_TIMEOUT    if the queue operation timed out.
+ */
+static msg_t bqwait(BuffersQueue *bqp, systime_t time) {
+
+  if (TIME_IMMEDIATE == time)
+    return Q_TIMEOUT;
+  currp->p_u.wtobjp = bqp;
+  queue_insert(currp, &bqp->waiting);
+  return chSchGoSleepTimeoutS(THD_STATE_WTQUEUE, time);
+}
+
+/**
+ * @brief   Wakes up all the threads waiting on a buffers queue.
+ *
+ * @param[in] bqp       pointer to a @p BuffersQueue structure
+ * @param[in] msg       the wakeup message
+ */
+static void bqwakeup(BuffersQueue *bqp, msg_t msg) {
+
+  while (notempty(&bqp->waiting))
+    chSchReadyI(fifo_remove(&bqp->waiting))->p_u.rdymsg = msg;
+}
+
+/**
+ * @brief   Returns the buffer following the specified one in the ring.
+ *
+ * @param[in] bqp       pointer to a @p BuffersQueue structure
+ * @param[in] p         pointer to a buffer, length field included
+ * @return              The pointer to the next buffer.
+ */
+static uint8_t *bqnext(BuffersQueue *bqp, uint8_t *p) {
+
+  p += BQ_BUFFERS_SIZE(1, bqp->bsize);
+  return p >= bqp->top ? bqp->buffers : p;
+}
+
+/**
+ * @brief   Waits for an empty buffer.
+ *
+ * @param[in] bqp       pointer to a @p BuffersQueue structure
+ * @param[out] bufp     pointer to the variable receiving the buffer pointer
+ * @param[in] time      the number of ticks before the operation timeouts
+ * @return              The operation status.
+ * @retval Q_OK         if an empty buffer is available.
+ * @retval Q_TIMEOUT    if the specified time expired.
+ * @retval Q_RESET      if the queue has been reset.
+ */
+static msg_t bqgetemptys(BuffersQueue *bqp, uint8_t **bufp, systime_t time) {
+
+  while (bqIsFullI(bqp)) {
+    msg_t msg;
+
+    if ((msg = bqwait(bqp, time)) != Q_OK)
+      return msg;
+  }
+  *bufp = bqp->bwrptr + sizeof (size_t);
+  return Q_OK;
+}
+
+/**
+ * @brief   Waits for a full buffer.
+ *
+ * @param[in] bqp       pointer to a @p BuffersQueue structure
+ * @param[out] bufp     pointer to the variable receiving the buffer pointer
+ * @param[out] sizep    pointer to the variable receiving the data size
+ * @param[in] time      the number of ticks before the operation timeouts
+ * @return              The operation status.
+ * @retval Q_OK         if a full buffer is available.
+ * @retval Q_TIMEOUT    if the specified time expired.
+ * @retval Q_RESET      if the queue has been reset.
+ */
+static msg_t bqgetfulls(BuffersQueue *bqp, uint8_t **bufp, size_t *sizep,
+                        systime_t time) {
+
+  while (bqIsEmptyI(bqp)) {
+    msg_t msg;
+
+    if ((msg = bqwait(bqp, time)) != Q_OK)
+      return msg;
+  }
+  *sizep = *(size_t *)bqp->brdptr;
+  *bufp = bqp->brdptr + sizeof (size_t);
+  return Q_OK;
+}
+
+/**
+ * @brief   Posts a full buffer from thread context.
+ *
+ * @param[in] bqp       pointer to a @p BuffersQueue structure
+ * @param[in] size      size of the data in the buffer
+ */
+static void bqpostfulls(BuffersQueue *bqp, size_t size) {
+
+  bqPostFullBufferI(bqp, size);
+  if (bqp->pnotify)
+    bqp->pnotify(bqp);
+  chSchRescheduleS();
+}
+
+/**
+ * @brief   Returns the end of the current empty buffer.
+ *
+ * @param[in] bqp       pointer to a @p BuffersQueue structure
+ * @return              The pointer to the first location after the buffer.
+ */
+static uint8_t *bqwrend(BuffersQueue *bqp) {
+
+  return bqp->bwrptr + sizeof (size_t) + bqp->bsize;
+}
+
+/**
+ * @brief   Makes sure there is a current empty buffer for the stream writes.
+ *
+ * @param[in] bqp       pointer to a @p BuffersQueue structure
+ * @param[in] time      the number of ticks before the operation timeouts
+ * @return              The operation status.
+ * @retval Q_OK         if there is a current empty buffer.
+ * @retval Q_TIMEOUT    if the specified time expired.
+ * @retval Q_RESET      if the queue has been reset.
+ */
+static msg_t bqfills(BuffersQueue *bqp, systime_t time) {
+  uint8_t *buf;
+  msg_t msg;
+
+  if (bqp->wptr != NULL)
+    return Q_OK;
+  if ((msg = bqgetemptys(bqp, &buf, time)) != Q_OK)
+    return msg;
+  bqp->wptr = buf;
+  return Q_OK;
+}
+
+/**
+ * @brief   Posts the current stream buffer if it contains data.
+ *
+ * @param[in] bqp       pointer to a @p BuffersQueue structure
+ * @return              The operation result.
+ * @retval FALSE        if there was no data to be posted.
+ * @retval TRUE         if the buffer has been posted.
+ */
+static bool_t bqflushi(BuffersQueue *bqp) {
+  size_t size;
+
+  if (bqp->wptr == NULL)
+    return FALSE;
+  size = (size_t)(bqp->wptr - (bqp->bwrptr + sizeof (size_t)));
+  if (size == 0)
+    return FALSE;
+  bqp->wptr = NULL;
+  bqPostFullBufferI(bqp, size);
+  return TRUE;
+}
+
+/**
+ * @brief   Posts the current stream buffer from thread context.
+ * @details The buffer is posted if full or if the consumer has no full
+ *          buffers left, else the data is accumulated and the buffer is
+ *          posted when the consumer releases its last full buffer.
+ *
+ * @param[in] bqp       pointer to a @p BuffersQueue structure
+ * @param[in] force     posts the buffer regardless of the consumer state
+ */
+static void bqflushs(BuffersQueue *bqp, bool_t force) {
+
+  if (force || bqIsEmptyI(bqp) || (bqp->wptr >= bqwrend(bqp))) {
+    if (bqflushi(bqp)) {
+      if (bqp->pnotify)
+        bqp->pnotify(bqp);
+      chSchRescheduleS();
+    }
+  }
+}
+
+/**
+ * @brief   Releases an empty buffer from thread context.
+ *
+ * @param[in] bqp       pointer to a @p BuffersQueue structure
+ */
+static void bqreleaseemptys(BuffersQueue *bqp) {
+
+  bqReleaseEmptyBufferI(bqp);
+  if (bqp->cnotify)
+    bqp->cnotify(bqp);
+  chSchRescheduleS();
+}
+
+/**
+ * @brief   Makes sure there is a current full buffer for the stream reads.
+ *
+ * @param[in] bqp       pointer to a @p BuffersQueue structure
+ * @param[in] time      the number of ticks before the operation timeouts
+ * @return              The operation status.
+ * @retval Q_OK         if there is a current full buffer.
+ * @retval Q_TIMEOUT    if the specified time expired.
+ * @retval Q_RESET      if the queue has been reset.
+ */
+static msg_t bqfetchs(BuffersQueue *bqp, systime_t time) {
+  uint8_t *buf;
+  size_t size;
+  msg_t msg;
+
+  if (bqp->ptr != NULL)
+    return Q_OK;
+  if ((msg = bqgetfulls(bqp, &buf, &size, time)) != Q_OK)
+    return msg;
+  bqp->ptr = buf;
+  bqp->end = buf + size;
+  return Q_OK;
+}
+
+/*
+ * Buffers channel interface implementation.
+ */
+
+static size_t write(void *ip, const uint8_t *bp, size_t n) {
+
+  return bqWriteTimeout(((BuffersChannel *)ip)->obqp, bp, n, TIME_INFINITE);
+}
+
+static size_t read(void *ip, uint8_t *bp, size_t n) {
+
+  return bqReadTimeout(((BuffersChannel *)ip)->ibqp, bp, n, TIME_INFINITE);
+}
+
+static msg_t put(void *ip, uint8_t b) {
+
+  return bqPutTimeout(((BuffersChannel *)ip)->obqp, b, TIME_INFINITE);
+}
+
+static msg_t get(void *ip) {
+
+  return bqGetTimeout(((BuffersChannel *)ip)->ibqp, TIME_INFINITE);
+}
+
+static msg_t putt(void *ip, uint8_t b, systime_t time) {
+
+  return bqPutTimeout(((BuffersChannel *)ip)->obqp, b, time);
+}
+
+static msg_t gett(void *ip, systime_t time) {
+
+  return bqGetTimeout(((BuffersChannel *)ip)->ibqp, time);
+}
+
+static size_t writet(void *ip, const uint8_t *bp, size_t n, systime_t time) {
+
+  return bqWriteTimeout(((BuffersChannel *)ip)->obqp, bp, n, time);
+}
+
+static size_t readt(void *ip, uint8_t *bp, size_t n, systime_t time) {
+
+  return bqReadTimeout(((BuffersChannel *)ip)->ibqp, bp, n, time);
+}
+
+static const struct BuffersChannelVMT vmt = {
+  write, read, put, get,
+  putt, gett, writet, readt
+};
+
+/*===========================================================================*/
+/* Driver exported functions.                                                */
+/*===========================================================================*/
+
+/**
+ * @brief   Initializes a buffers queue.
+ * @note    The buffers queue is initialized with all the buffers empty.
+ *
+ * @param[out] bqp      pointer to a @p BuffersQueue structure
+ * @param[in] bp        pointer to the buffers memory, its size must be
+ *                      @p BQ_BUFFERS_SIZE(n, size) bytes and it must be
+ *                      aligned for a @p size_t
+ * @param[in] size      capacity of each buffer
+ * @param[in] n         number of buffers
+ * @param[in] pnfy      callback invoked when a full buffer is posted from
+ *                      thread context, the value can be @p NULL
+ * @param[in] cnfy      callback invoked when an empty buffer is released
+ *                      from thread context, the value can be @p NULL
+ * @param[in] link      application defined pointer
+ *
+ * @init
+ */
+void bqObjectInit(BuffersQueue *bqp, uint8_t *bp, size_t size, size_t n,
+                  bqnotify_t pnfy, bqnotify_t cnfy, void *link) {
+
+  chDbgCheck((bqp != NULL) && (bp != NULL) && (size > 0) && (n > 0),
+             "bqObjectInit");
+
+  queue_init(&bqp->waiting);
+  bqp->bcounter = 0;
+  bqp->bn       = n;
+  bqp->bsize    = size;
+  bqp->buffers  = bp;
+  bqp->top      = bp + BQ_BUFFERS_SIZE(n, size);
+  bqp->bwrptr   = bp;
+  bqp->brdptr   = bp;
+  bqp->ptr      = NULL;
+  bqp->end      = NULL;
+  bqp->wptr     = NULL;
+  bqp->resets   = 0;
+  bqp->pnotify  = pnfy;
+  bqp->cnotify  = cnfy;
+  bqp->link     = link;
+}
+
+/**
+ * @brief   Resets a buffers queue.
+ * @details All the data in the buffers queue is lost, the waiting threads
+ *          are resumed with @p Q_RESET as message.
+ * @note    A buffer obtained before the reset must not be posted or
+ *          released after the reset.
+ * @note    This function does not reschedule so a call to a rescheduling
+ *          function must be performed before unlocking the kernel.
+ *
+ * @param[in] bqp       pointer to a @p BuffersQueue structure
+ *
+ * @iclass
+ */
+void bqResetI(BuffersQueue *bqp) {
+
+  chDbgCheckClassI();
+  chDbgCheck(bqp != NULL, "bqResetI");
+
+  bqp->bcounter = 0;
+  bqp->bwrptr   = bqp->buffers;
+  bqp->brdptr   = bqp->buffers;
+  bqp->ptr      = NULL;
+  bqp->end      = NULL;
+  bqp->wptr     = NULL;
+  bqp->resets++;
+  bqwakeup(bqp, Q_RESET);
+}
+
+/**
+ * @brief   Gets the next empty buffer.
+ * @details The buffer is not removed from the queue, the same buffer is
+ *          returned until it is posted using @p bqPostFullBufferI().
+ *
+ * @param[in] bqp       pointer to a @p BuffersQueue structure
+ * @return              The pointer to the empty buffer.
+ * @retval NULL         if all the buffers are full.
+ *
+ * @iclass
+ */
+uint8_t *bqGetEmptyBufferI(BuffersQueue *bqp) {
+
+  chDbgCheckClassI();
+  chDbgCheck(bqp != NULL, "bqGetEmptyBufferI");
+
+  if (bqIsFullI(bqp))
+    return NULL;
+  return bqp->bwrptr + sizeof (size_t);
+}
+
+/**
+ * @brief   Gets the next empty buffer with timeout.
+ * @details If all the buffers are full then the calling thread is suspended
+ *          until a buffer is released or a timeout occurs.
+ *
+ * @param[in] bqp       pointer to a @p BuffersQueue structure
+ * @param[out] bufp     pointer to the variable receiving the buffer pointer
+ * @param[in] time      the number of ticks before the operation timeouts,
+ *                      the following special values are allowed:
+ *                      - @a TIME_IMMEDIATE immediate timeout.
+ *                      - @a TIME_INFINITE no timeout.
+ *                      .
+ * @return              The operation status.
+ * @retval Q_OK         if an empty buffer has been obtained.
+ * @retval Q_TIMEOUT    if the specified time expired.
+ * @retval Q_RESET      if the queue has been reset.
+ *
+ * @api
+ */
+msg_t bqGetEmptyBufferTimeout(BuffersQueue *bqp, uint8_t **bufp,
+                              systime_t time) {
+  msg_t msg;
+
+  chDbgCheck((bqp != NULL) && (bufp != NULL), "bqGetEmptyBufferTimeout");
+
+  chSysLock();
+  msg = bqgetemptys(bqp, bufp, time);
+  chSysUnlock();
+  return msg;
+}
+
+/**
+ * @brief   Posts the current empty buffer as a full buffer.
+ * @details The buffer previously obtained using @p bqGetEmptyBufferI() or
+ *          @p bqGetEmptyBufferTimeout() is inserted in the queue, a thread
+ *          waiting for a full buffer is resumed.
+ * @note    This function does not reschedule so a call to a rescheduling
+ *          function must be performed before unlocking the kernel.
+ *
+ * @param[in] bqp       pointer to a @p BuffersQueue structure
+ * @param[in] size      size of the data in the buffer, it must be greater
+ *                      than zero and not greater than the buffers capacity
+ *
+ * @iclass
+ */
+void bqPostFullBufferI(BuffersQueue *bqp, size_t size) {
+
+  chDbgCheckClassI();
+  chDbgCheck((bqp != NULL) && (size > 0) && (size <= bqp->bsize),
+             "bqPostFullBufferI");
+  chDbgAssert(!bqIsFullI(bqp),
+              "bqPostFullBufferI(), #1", "queue full");
+
+  *(size_t *)bqp->bwrptr = size;
+  bqp->bwrptr = bqnext(bqp, bqp->bwrptr);
+  bqp->bcounter++;
+  bqwakeup(bqp, Q_OK);
+}
+
+/**
+ * @brief   Posts the current empty buffer as a full buffer.
+ * @details The buffer previously obtained using @p bqGetEmptyBufferI() or
+ *          @p bqGetEmptyBufferTimeout() is inserted in the queue, a thread
+ *          waiting for a full buffer is resumed and the post notification
+ *          callback is invoked.
+ *
+ * @param[in] bqp       pointer to a @p BuffersQueue structure
+ * @param[in] size      size of the data in the buffer, it must be greater
+ *                      than zero and not greater than the buffers capacity
+ *
+ * @api
+ */
+void bqPostFullBuffer(BuffersQueue *bqp, size_t size) {
+
+  chSysLock();
+  bqpostfulls(bqp, size);
+  chSysUnlock();
+}
+
+/**
+ * @brief   Gets the next full buffer.
+ * @details The buffer is not removed from the queue, the same buffer is
+ *          returned until it is released using @p bqReleaseEmptyBufferI().
+ *
+ * @param[in] bqp       pointer to a @p BuffersQueue structure
+ * @param[out] sizep    pointer to the variable receiving the data size
+ * @return              The pointer to the full buffer.
+ * @retval NULL         if there are no full buffers.
+ *
+ * @iclass
+ */
+uint8_t *bqGetFullBufferI(BuffersQueue *bqp, size_t *sizep) {
+
+  chDbgCheckClassI();
+  chDbgCheck((bqp != NULL) && (sizep != NULL), "bqGetFullBufferI");
+
+  if (bqIsEmptyI(bqp))
+    return NULL;
+  *sizep = *(size_t *)bqp->brdptr;
+  return bqp->brdptr + sizeof (size_t);
+}
+
+/**
+ * @brief   Gets the next full buffer with timeout.
+ * @details If there are no full buffers then the calling thread is
+ *          suspended until a buffer is posted or a timeout occurs.
+ *
+ * @param[in] bqp       pointer to a @p BuffersQueue structure
+ * @param[out] bufp     pointer to the variable receiving the buffer pointer
+ * @param[out] sizep    pointer to the variable receiving the data size
+ * @param[in] time      the number of ticks before the operation timeouts,
+ *                      the following special values are allowed:
+ *                      - @a TIME_IMMEDIATE immediate timeout.
+ *                      - @a TIME_INFINITE no timeout.
+ *                      .
+ * @return              The operation status.
+ * @retval Q_OK         if a full buffer has been obtained.
+ * @retval Q_TIMEOUT    if the specified time expired.
+ * @retval Q_RESET      if the queue has been reset.
+ *
+ * @api
+ */
+msg_t bqGetFullBufferTimeout(BuffersQueue *bqp, uint8_t **bufp,
+                             size_t *sizep, systime_t time) {
+  msg_t msg;
+
+  chDbgCheck((bqp != NULL) && (bufp != NULL) && (sizep != NULL),
+             "bqGetFullBufferTimeout");
+
+  chSysLock();
+  msg = bqgetfulls(bqp, bufp, sizep, time);
+  chSysUnlock();
+  return msg;
+}
+
+/**
+ * @brief   Releases the current full buffer.
+ * @details The buffer previously obtained using @p bqGetFullBufferI() or
+ *          @p bqGetFullBufferTimeout() is returned to the queue as an empty
+ *          buffer, a thread waiting for an empty buffer is resumed. If it
+ *          was the last full buffer then a buffer partially filled by the
+ *          stream write functions is posted.
+ * @note    This function does not reschedule so a call to a rescheduling
+ *          function must be performed before unlocking the kernel.
+ *
+ * @param[in] bqp       pointer to a @p BuffersQueue structure
+ *
+ * @iclass
+ */
+void bqReleaseEmptyBufferI(BuffersQueue *bqp) {
+
+  chDbgCheckClassI();
+  chDbgCheck(bqp != NULL, "bqReleaseEmptyBufferI");
+  chDbgAssert(!bqIsEmptyI(bqp),
+              "bqReleaseEmptyBufferI(), #1", "queue empty");
+
+  bqp->brdptr = bqnext(bqp, bqp->brdptr);
+  bqp->bcounter--;
+  bqp->ptr = NULL;
+  bqwakeup(bqp, Q_OK);
+
+  /* The consumer is idle, the pending stream data is posted.*/
+  if (bqIsEmptyI(bqp))
+    (void)bqflushi(bqp);
+}
+
+/**
+ * @brief   Releases the current full buffer.
+ * @details The buffer previously obtained using @p bqGetFullBufferI() or
+ *          @p bqGetFullBufferTimeout() is returned to the queue as an empty
+ *          buffer, a thread waiting for an empty buffer is resumed and the
+ *          release notification callback is invoked.
+ *
+ * @param[in] bqp       pointer to a @p BuffersQueue structure
+ *
+ * @api
+ */
+void bqReleaseEmptyBuffer(BuffersQueue *bqp) {
+
+  chSysLock();
+  bqreleaseemptys(bqp);
+  chSysUnlock();
+}
+
+/**
+ * @brief   Buffers queue read with timeout.
+ * @details This function reads a byte value from the full buffers. If there
+ *          are no full buffers then the calling thread is suspended until
+ *          a buffer is posted or a timeout occurs. A buffer is released
+ *          when all its data has been read.
+ *
+ * @param[in] bqp       pointer to a @p BuffersQueue structure
+ * @param[in] time      the number of ticks before the operation timeouts,
+ *                      the following special values are allowed:
+ *                      - @a TIME_IMMEDIATE immediate timeout.
+ *                      - @a TIME_INFINITE no timeout.
+ *                      .
+ * @return              A byte value from the queue.
+ * @retval Q_TIMEOUT    if the specified time expired.
+ * @retval Q_RESET      if the queue has been reset.
+ *
+ * @api
+ */
+msg_t bqGetTimeout(BuffersQueue *bqp, systime_t time) {
+  msg_t msg;
+
+  chDbgCheck(bqp != NULL, "bqGetTimeout");
+
+  chSysLock();
+  if ((msg = bqfetchs(bqp, time)) == Q_OK) {
+    msg = *bqp->ptr++;
+    if (bqp->ptr >= bqp->end)
+      bqreleaseemptys(bqp);
+  }
+  chSysUnlock();
+  return msg;
+}
+
+/**
+ * @brief   Buffers queue read with timeout.
+ * @details The function reads data from the full buffers into a linear
+ *          buffer, buffers are released as soon as all their data has been
+ *          read. The operation completes when the specified amount of data
+ *          has been transferred or after the specified timeout or if the
+ *          queue has been reset.
+ * @note    The function is not atomic, if you need atomicity it is
+ *          suggested to use a semaphore or a mutex for mutual exclusion.
+ * @note    The data is copied outside of the critical zone.
+ *
+ * @param[in] bqp       pointer to a @p BuffersQueue structure
+ * @param[out] bp       pointer to the data buffer
+ * @param[in] n         the maximum amount of data to be transferred, the
+ *                      value 0 is reserved
+ * @param[in] time      the number of ticks before the operation timeouts,
+ *                      the following special values are allowed:
+ *                      - @a TIME_IMMEDIATE immediate timeout.
+ *                      - @a TIME_INFINITE no timeout.
+ *                      .
+ * @return              The number of bytes effectively transferred.
+ *
+ * @api
+ */
+size_t bqReadTimeout(BuffersQueue *bqp, uint8_t *bp,
+                     size_t n, systime_t time) {
+  size_t r = 0;
+
+  chDbgCheck((bqp != NULL) && (bp != NULL) && (n > 0), "bqReadTimeout");
+
+  chSysLock();
+  while (n > 0) {
+    uint8_t *p;
+    size_t m;
+
+    if (bqfetchs(bqp, time) != Q_OK)
+      break;
+
+    /* The current buffer belongs to the consumer so it can be copied
+       outside the critical zone.*/
+    p = bqp->ptr;
+    m = (size_t)(bqp->end - p);
+    if (m > n)
+      m = n;
+    chSysUnlock();
+    memcpy(bp, p, m);
+    chSysLock();
+
+    /* The queue could have been reset during the copy.*/
+    if (bqp->ptr != p)
+      break;
+    bqp->ptr += m;
+    bp += m;
+    n -= m;
+    r += m;
+    if (bqp->ptr >= bqp->end)
+      bqreleaseemptys(bqp);
+  }
+  chSysUnlock();
+  return r;
+}
+
+/**
+ * @brief   Buffers queue write with timeout.
+ * @details This function writes a byte value into the current empty buffer,
+ *          the buffer is posted when full or if the consumer has no full
+ *          buffers left. If all the buffers are full then the calling
+ *          thread is suspended until a buffer is released or a timeout
+ *          occurs.
+ *
+ * @param[in] bqp       pointer to a @p BuffersQueue structure
+ * @param[in] b         the byte value to be written
+ * @param[in] time      the number of ticks before the operation timeouts,
+ *                      the following special values are allowed:
+ *                      - @a TIME_IMMEDIATE immediate timeout.
+ *                      - @a TIME_INFINITE no timeout.
+ *                      .
+ * @return              The operation status.
+ * @retval Q_OK         if the operation succeeded.
+ * @retval Q_TIMEOUT    if the specified time expired.
+ * @retval Q_RESET      if the queue has been reset.
+ *
+ * @api
+ */
+msg_t bqPutTimeout(BuffersQueue *bqp, uint8_t b, systime_t time) {
+  msg_t msg;
+
+  chDbgCheck(bqp != NULL, "bqPutTimeout");
+
+  chSysLock();
+  if ((msg = bqfills(bqp, time)) == Q_OK) {
+    *bqp->wptr++ = b;
+    bqflushs(bqp, FALSE);
+  }
+  chSysUnlock();
+  return msg;
+}
+
+/**
+ * @brief   Buffers queue write with timeout.
+ * @details The function writes data from a linear buffer into empty
+ *          buffers, each buffer is posted when full, the last partially
+ *          filled buffer is posted if the consumer has no full buffers
+ *          left, else it is kept for the following writes. The operation
+ *          completes when the specified amount of data has been transferred
+ *          or after the specified timeout or if the queue has been reset.
+ * @note    The function is not atomic, if you need atomicity it is
+ *          suggested to use a semaphore or a mutex for mutual exclusion.
+ * @note    The data is copied outside of the critical zone.
+ *
+ * @param[in] bqp       pointer to a @p BuffersQueue structure
+ * @param[in] bp        pointer to the data buffer
+ * @param[in] n         the maximum amount of data to be transferred, the
+ *                      value 0 is reserved
+ * @param[in] time      the number of ticks before the operation timeouts,
+ *                      the following special values are allowed:
+ *                      - @a TIME_IMMEDIATE immediate timeout.
+ *                      - @a TIME_INFINITE no timeout.
+ *                      .
+ * @return              The number of bytes effectively transferred.
+ *
+ * @api
+ */
+size_t bqWriteTimeout(BuffersQueue *bqp, const uint8_t *bp,
+                      size_t n, systime_t time) {
+  size_t w = 0;
+
+  chDbgCheck((bqp != NULL) && (bp != NULL) && (n > 0), "bqWriteTimeout");
+
+  chSysLock();
+  while (n > 0) {
+    uint8_t *p;
+    size_t m, resets;
+
+    if (bqfills(bqp, time) != Q_OK)
+      break;
+
+    /* The empty buffer belongs to the producer so it can be filled
+       outside the critical zone, it is detached during the copy so the
+       consumer cannot post it.*/
+    p = bqp->wptr;
+    m = (size_t)(bqwrend(bqp) - p);
+    if (m > n)
+      m = n;
+    bqp->wptr = NULL;
+    resets = bqp->resets;
+    chSysUnlock();
+    memcpy(p, bp, m);
+    chSysLock();
+
+    /* The queue could have been reset during the copy.*/
+    if (bqp->resets != resets)
+      break;
+    bqp->wptr = p + m;
+    bp += m;
+    n -= m;
+    w += m;
+    bqflushs(bqp, FALSE);
+  }
+  chSysUnlock();
+  return w;
+}
+
+/**
+ * @brief   Flushes the stream writes.
+ * @details The current empty buffer, if partially filled by the stream
+ *          write functions, is posted.
+ *
+ * @param[in] bqp       pointer to a @p BuffersQueue structure
+ *
+ * @api
+ */
+void bqFlush(BuffersQueue *bqp) {
+
+  chDbgCheck(bqp != NULL, "bqFlush");
+
+  chSysLock();
+  bqflushs(bqp, TRUE);
+  chSysUnlock();
+}
+
+/**
+ * @brief   Initializes a buffers channel object.
+ * @details The channel reads from the full buffers of @p ibqp and writes
+ *          into the empty buffers of @p obqp using the stream functions.
+ *
+ * @param[out] bcp      pointer to a @p BuffersChannel object
+ * @param[in] ibqp      queue of the buffers read from the channel
+ * @param[in] obqp      queue of the buffers written to the channel
+ *
+ * @init
+ */
+void bcObjectInit(BuffersChannel *bcp, BuffersQueue *ibqp,
+                  BuffersQueue *obqp) {
+
+  chDbgCheck((bcp != NULL) && (ibqp != NULL) && (obqp != NULL),
+             "bcObjectInit");
+
+  bcp->vmt  = &vmt;
+  bcp->ibqp = ibqp;
+  bcp->obqp = obqp;
+}
+
+#endif /* CH_USE_QUEUES */
+
+/** @} */
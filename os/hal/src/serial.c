@@ -214,6 +214,38 @@ void sdIncomingDataI(SerialDriver *sdp, uint8_t b) {
     chnAddFlagsI(sdp, SD_OVERRUN_ERROR);
 }
 
+/**
+ * @brief   Handles a block of incoming data.
+ * @details This function must be called from the input interrupt service
+ *          routine of drivers receiving data in blocks, for example from an
+ *          hardware FIFO, in order to enqueue the data and generate the
+ *          related events. The whole block is enqueued in a single
+ *          critical zone.
+ * @note    The incoming data event is only generated when the input queue
+ *          becomes non-empty.
+ *
+ * @param[in] sdp       pointer to a @p SerialDriver structure
+ * @param[in] bp        pointer to the received data
+ * @param[in] n         number of received bytes
+ * @return              The number of bytes enqueued, if less than @p n
+ *                      then an overrun error has been signaled.
+ *
+ * @iclass
+ */
+size_t sdIncomingDataBlockI(SerialDriver *sdp, const uint8_t *bp, size_t n) {
+  size_t done;
+
+  chDbgCheckClassI();
+  chDbgCheck((sdp != NULL) && (bp != NULL), "sdIncomingDataBlockI");
+
+  if (chIQIsEmptyI(&sdp->iqueue) && (n > 0))
+    chnAddFlagsI(sdp, CHN_INPUT_AVAILABLE);
+  done = chIQWriteI(&sdp->iqueue, bp, n);
+  if (done < n)
+    chnAddFlagsI(sdp, SD_OVERRUN_ERROR);
+  return done;
+}
+
 /**
  * @brief   Handles outgoing data.
  * @details Must be called from the output interrupt service routine in order
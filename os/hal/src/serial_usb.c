@@ -63,44 +63,44 @@ static cdc_linecoding_t linecoding = {
 
 static size_t write(void *ip, const uint8_t *bp, size_t n) {
 
-  return chOQWriteTimeout(&((SerialUSBDriver *)ip)->oqueue, bp,
-                          n, TIME_INFINITE);
+  return bqWriteTimeout(&((SerialUSBDriver *)ip)->obqueue, bp,
+                        n, TIME_INFINITE);
 }
 
 static size_t read(void *ip, uint8_t *bp, size_t n) {
 
-  return chIQReadTimeout(&((SerialUSBDriver *)ip)->iqueue, bp,
-                         n, TIME_INFINITE);
+  return bqReadTimeout(&((SerialUSBDriver *)ip)->ibqueue, bp,
+                       n, TIME_INFINITE);
 }
 
 static msg_t put(void *ip, uint8_t b) {
 
-  return chOQPutTimeout(&((SerialUSBDriver *)ip)->oqueue, b, TIME_INFINITE);
+  return bqPutTimeout(&((SerialUSBDriver *)ip)->obqueue, b, TIME_INFINITE);
 }
 
 static msg_t get(void *ip) {
 
-  return chIQGetTimeout(&((SerialUSBDriver *)ip)->iqueue, TIME_INFINITE);
+  return bqGetTimeout(&((SerialUSBDriver *)ip)->ibqueue, TIME_INFINITE);
 }
 
 static msg_t putt(void *ip, uint8_t b, systime_t timeout) {
 
-  return chOQPutTimeout(&((SerialUSBDriver *)ip)->oqueue, b, timeout);
+  return bqPutTimeout(&((SerialUSBDriver *)ip)->obqueue, b, timeout);
 }
 
 static msg_t gett(void *ip, systime_t timeout) {
 
-  return chIQGetTimeout(&((SerialUSBDriver *)ip)->iqueue, timeout);
+  return bqGetTimeout(&((SerialUSBDriver *)ip)->ibqueue, timeout);
 }
 
 static size_t writet(void *ip, const uint8_t *bp, size_t n, systime_t time) {
 
-  return chOQWriteTimeout(&((SerialUSBDriver *)ip)->oqueue, bp, n, time);
+  return bqWriteTimeout(&((SerialUSBDriver *)ip)->obqueue, bp, n, time);
 }
 
 static size_t readt(void *ip, uint8_t *bp, size_t n, systime_t time) {
 
-  return chIQReadTimeout(&((SerialUSBDriver *)ip)->iqueue, bp, n, time);
+  return bqReadTimeout(&((SerialUSBDriver *)ip)->ibqueue, bp, n, time);
 }
 
 static const struct SerialUSBDriverVMT vmt = {
@@ -109,29 +109,25 @@ static const struct SerialUSBDriverVMT vmt = {
 };
 
 /**
- * @brief   Notification of data removed from the input queue.
+ * @brief   Notification of a buffer released by the input buffers queue.
  */
-static void inotify(GenericQueue *qp) {
-  size_t n, maxsize;
-  SerialUSBDriver *sdup = chQGetLink(qp);
+static void ibnotify(BuffersQueue *bqp) {
+  uint8_t *buf;
+  SerialUSBDriver *sdup = bqGetLink(bqp);
 
   /* If the USB driver is not in the appropriate state then transactions
      must not be started.*/
   if (usbGetDriverStateI(sdup->config->usbp) != USB_ACTIVE)
     return;
 
-  /* If there is in the queue enough space to hold at least one packet and
-     a transaction is not yet started then a new transaction is started for
-     the available space.*/
-  maxsize = sdup->config->usbp->epc[USB_CDC_DATA_AVAILABLE_EP]->out_maxsize;
+  /* If there is an empty buffer and a transaction is not yet started then
+     a new transaction is started directly into the buffer.*/
   if (!usbGetReceiveStatusI(sdup->config->usbp, USB_CDC_DATA_AVAILABLE_EP) &&
-      ((n = chIQGetEmptyI(&sdup->iqueue)) >= maxsize)) {
+      ((buf = bqGetEmptyBufferI(&sdup->ibqueue)) != NULL)) {
     chSysUnlock();
 
-    n = (n / maxsize) * maxsize;
-    usbPrepareQueuedReceive(sdup->config->usbp,
-                            USB_CDC_DATA_AVAILABLE_EP,
-                            &sdup->iqueue, n);
+    usbPrepareReceive(sdup->config->usbp, USB_CDC_DATA_AVAILABLE_EP,
+                      buf, SERIAL_USB_BUFFERS_SIZE);
 
     chSysLock();
     usbStartReceiveI(sdup->config->usbp, USB_CDC_DATA_AVAILABLE_EP);
@@ -139,11 +135,12 @@ static void inotify(GenericQueue *qp) {
 }
 
 /**
- * @brief   Notification of data inserted into the output queue.
+ * @brief   Notification of a buffer posted into the output buffers queue.
  */
-static void onotify(GenericQueue *qp) {
+static void obnotify(BuffersQueue *bqp) {
+  uint8_t *buf;
   size_t n;
-  SerialUSBDriver *sdup = chQGetLink(qp);
+  SerialUSBDriver *sdup = bqGetLink(bqp);
 
   /* If the USB driver is not in the appropriate state then transactions
      must not be started.*/
@@ -151,14 +148,12 @@ static void onotify(GenericQueue *qp) {
     return;
 
   /* If there is not an ongoing transaction and the output queue contains
-     data then a new transaction is started.*/
+     a full buffer then a new transaction is started from the buffer.*/
   if (!usbGetTransmitStatusI(sdup->config->usbp, USB_CDC_DATA_REQUEST_EP) &&
-      ((n = chOQGetFullI(&sdup->oqueue)) > 0)) {
+      ((buf = bqGetFullBufferI(&sdup->obqueue, &n)) != NULL)) {
     chSysUnlock();
 
-    usbPrepareQueuedTransmit(sdup->config->usbp,
-                             USB_CDC_DATA_REQUEST_EP,
-                             &sdup->oqueue, n);
+    usbPrepareTransmit(sdup->config->usbp, USB_CDC_DATA_REQUEST_EP, buf, n);
 
     chSysLock();
     usbStartTransmitI(sdup->config->usbp, USB_CDC_DATA_REQUEST_EP);
@@ -193,8 +188,12 @@ void sduObjectInit(SerialUSBDriver *sdup) {
   sdup->vmt = &vmt;
   chEvtInit(&sdup->event);
   sdup->state = SDU_STOP;
-  chIQInit(&sdup->iqueue, sdup->ib, SERIAL_USB_BUFFERS_SIZE, inotify, sdup);
-  chOQInit(&sdup->oqueue, sdup->ob, SERIAL_USB_BUFFERS_SIZE, onotify, sdup);
+  bqObjectInit(&sdup->ibqueue, (uint8_t *)sdup->ib,
+               SERIAL_USB_BUFFERS_SIZE, SERIAL_USB_BUFFERS_NUMBER,
+               NULL, ibnotify, sdup);
+  bqObjectInit(&sdup->obqueue, (uint8_t *)sdup->ob,
+               SERIAL_USB_BUFFERS_SIZE, SERIAL_USB_BUFFERS_NUMBER,
+               obnotify, NULL, sdup);
 }
 
 /**
@@ -250,13 +249,14 @@ void sduStop(SerialUSBDriver *sdup) {
 void sduConfigureHookI(USBDriver *usbp) {
   SerialUSBDriver *sdup = usbp->param;
 
-  chIQResetI(&sdup->iqueue);
-  chOQResetI(&sdup->oqueue);
+  bqResetI(&sdup->ibqueue);
+  bqResetI(&sdup->obqueue);
   chnAddFlagsI(sdup, CHN_CONNECTED);
 
   /* Starts the first OUT transaction immediately.*/
-  usbPrepareQueuedReceive(usbp, USB_CDC_DATA_AVAILABLE_EP, &sdup->iqueue,
-                          usbp->epc[USB_CDC_DATA_AVAILABLE_EP]->out_maxsize);
+  usbPrepareReceive(usbp, USB_CDC_DATA_AVAILABLE_EP,
+                    bqGetEmptyBufferI(&sdup->ibqueue),
+                    SERIAL_USB_BUFFERS_SIZE);
   usbStartReceiveI(usbp, USB_CDC_DATA_AVAILABLE_EP);
 }
 
@@ -305,34 +305,38 @@ bool_t sduRequestsHook(USBDriver *usbp) {
  * @param[in] ep        endpoint number
  */
 void sduDataTransmitted(USBDriver *usbp, usbep_t ep) {
-  size_t n;
+  uint8_t *buf;
+  size_t n, txsize;
   SerialUSBDriver *sdup = usbp->param;
 
-  (void)ep;
-
   chSysLockFromIsr();
   chnAddFlagsI(sdup, CHN_OUTPUT_EMPTY);
 
-  if ((n = chOQGetFullI(&sdup->oqueue)) > 0) {
+  /* The transmitted buffer, if any, is returned to the queue. A zero sized
+     transaction does not use a buffer and a transaction started before a
+     reset of the queue has no buffer to return.*/
+  txsize = usbp->epc[ep]->in_state->txsize;
+  if ((txsize > 0) && !bqIsEmptyI(&sdup->obqueue))
+    bqReleaseEmptyBufferI(&sdup->obqueue);
+
+  if ((buf = bqGetFullBufferI(&sdup->obqueue, &n)) != NULL) {
     /* The endpoint cannot be busy, we are in the context of the callback,
        so it is safe to transmit without a check.*/
     chSysUnlockFromIsr();
 
-    usbPrepareQueuedTransmit(usbp, ep, &sdup->oqueue, n);
+    usbPrepareTransmit(usbp, ep, buf, n);
 
     chSysLockFromIsr();
     usbStartTransmitI(usbp, ep);
   }
-  else if ((usbp->epc[ep]->in_state->txsize > 0) &&
-           !(usbp->epc[ep]->in_state->txsize &
-             (usbp->epc[ep]->in_maxsize - 1))) {
+  else if ((txsize > 0) && !(txsize & (usbp->epc[ep]->in_maxsize - 1))) {
     /* Transmit zero sized packet in case the last one has maximum allowed
        size. Otherwise the recipient may expect more data coming soon and
        not return buffered data to app. See section 5.8.3 Bulk Transfer
        Packet Size Constraints of the USB Specification document.*/
     chSysUnlockFromIsr();
 
-    usbPrepareQueuedTransmit(usbp, ep, &sdup->oqueue, 0);
+    usbPrepareTransmit(usbp, ep, NULL, 0);
 
     chSysLockFromIsr();
     usbStartTransmitI(usbp, ep);
@@ -350,24 +354,27 @@ void sduDataTransmitted(USBDriver *usbp, usbep_t ep) {
  * @param[in] ep        endpoint number
  */
 void sduDataReceived(USBDriver *usbp, usbep_t ep) {
-  size_t n, maxsize;
+  uint8_t *buf;
+  size_t n;
   SerialUSBDriver *sdup = usbp->param;
 
-  (void)ep;
-
   chSysLockFromIsr();
-  chnAddFlagsI(sdup, CHN_INPUT_AVAILABLE);
 
-  /* Writes to the input queue can only happen when there is enough space
-     to hold at least one packet.*/
-  maxsize = usbp->epc[USB_CDC_DATA_AVAILABLE_EP]->out_maxsize;
-  if ((n = chIQGetEmptyI(&sdup->iqueue)) >= maxsize) {
+  /* The buffer is posted in place, a zero sized packet leaves the buffer
+     empty and it is reused for the next transaction.*/
+  if ((n = usbGetReceiveTransactionSizeI(usbp, ep)) > 0) {
+    bqPostFullBufferI(&sdup->ibqueue, n);
+    chnAddFlagsI(sdup, CHN_INPUT_AVAILABLE);
+  }
+
+  /* The next transaction is started if there is an empty buffer, else it
+     is restarted when the application releases a buffer.*/
+  if ((buf = bqGetEmptyBufferI(&sdup->ibqueue)) != NULL) {
     /* The endpoint cannot be busy, we are in the context of the callback,
        so a packet is in the buffer for sure.*/
     chSysUnlockFromIsr();
 
-    n = (n / maxsize) * maxsize;
-    usbPrepareQueuedReceive(usbp, ep, &sdup->iqueue, n);
+    usbPrepareReceive(usbp, ep, buf, SERIAL_USB_BUFFERS_SIZE);
 
     chSysLockFromIsr();
     usbStartReceiveI(usbp, ep);
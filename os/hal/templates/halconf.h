@@ -332,14 +332,25 @@
 
 /**
  * @brief   Serial over USB buffers size.
- * @details Configuration parameter, the buffer size must be a multiple of
- *          the USB data endpoint maximum packet size.
+ * @details Configuration parameter, the size of each buffer, it must be a
+ *          multiple of the USB data endpoint maximum packet size.
  * @note    The default is 64 bytes for both the transmission and receive
  *          buffers.
  */
 #if !defined(SERIAL_USB_BUFFERS_SIZE) || defined(__DOXYGEN__)
 #define SERIAL_USB_BUFFERS_SIZE     64
 #endif
+
+/**
+ * @brief   Serial over USB number of buffers.
+ * @details Configuration parameter, the number of buffers in each
+ *          direction.
+ * @note    The default is 4 buffers for both the transmission and receive
+ *          sides.
+ */
+#if !defined(SERIAL_USB_BUFFERS_NUMBER) || defined(__DOXYGEN__)
+#define SERIAL_USB_BUFFERS_NUMBER   4
+#endif
 /** @} */
 
 /*===========================================================================*/
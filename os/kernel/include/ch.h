@@ -107,21 +107,28 @@
 #include "chsys.h"
 #include "chvt.h"
 #include "chschd.h"
+#include "chstats.h"
+#include "chsyncprof.h"
 #include "chsem.h"
 #include "chbsem.h"
 #include "chmtx.h"
 #include "chcond.h"
 #include "chevents.h"
+#include "chtopics.h"
 #include "chmsg.h"
 #include "chmboxes.h"
+#include "chpmboxes.h"
 #include "chmemcore.h"
 #include "chheap.h"
 #include "chmempools.h"
+#include "charena.h"
+#include "chobjfifos.h"
 #include "chthreads.h"
 #include "chdynamic.h"
 #include "chregistry.h"
 #include "chinline.h"
 #include "chqueues.h"
+#include "chrings.h"
 #include "chstreams.h"
 #include "chfiles.h"
 #include "chdebug.h"
@@ -0,0 +1,164 @@
+/*
+    ChibiOS/RT - Copyright (C) 2006,2007,2008,2009,2010,
+                 2011,2012,2013 Giovanni Di Sirio.
+
+    This file is part of ChibiOS/RT.
+
+    ChibiOS/RT is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    ChibiOS/RT is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * @file    charena.h
+ * @brief   Memory Arenas macros and structures.
+ *
+ * @addtogroup arenas
+ * @{
+ */
+
+#ifndef _CHARENA_H_
+#define _CHARENA_H_
+
+#if CH_USE_ARENAS || defined(__DOXYGEN__)
+
+/**
+ * @name    Arena flags
+ * @{
+ */
+#define ARENA_HEAP          1       /**< @brief Blocks are taken from a
+                                         Memory Heap.                       */
+/** @} */
+
+/**
+ * @brief   Memory arena block header.
+ */
+union arena_header {
+  stkalign_t align;
+  struct {
+    union arena_header  *next;      /**< @brief Older block in the chain or
+                                                next spare block.           */
+    uint8_t             *limit;     /**< @brief Block end address.          */
+    bool_t              owned;      /**< @brief Block allocated by the
+                                                arena itself.               */
+  } h;
+};
+
+/**
+ * @brief   Memory arena mark.
+ * @details A mark is an opaque position inside an arena, everything
+ *          allocated after the mark is released by @p chArenaRelease().
+ */
+typedef void *arenamark_t;
+
+/**
+ * @brief   Structure describing a memory arena.
+ */
+typedef struct memory_arena {
+  uint8_t               *ma_free;   /**< @brief Allocation pointer into the
+                                                current block.              */
+  uint8_t               *ma_limit;  /**< @brief Limit of the current
+                                                block.                      */
+  union arena_header    *ma_current;/**< @brief Current block, head of the
+                                                chain.                      */
+  union arena_header    *ma_spare;  /**< @brief Released blocks kept for
+                                                reuse.                      */
+  size_t                ma_size;    /**< @brief Default block size.         */
+  memgetfunc_t          ma_provider;/**< @brief Memory blocks provider for
+                                                this arena.                 */
+#if CH_USE_HEAP || defined(__DOXYGEN__)
+  MemoryHeap            *ma_heapp;  /**< @brief Heap the blocks are taken
+                                                from.                       */
+#endif
+  uint8_t               ma_flags;   /**< @brief Arena flags.                */
+} MemoryArena;
+
+/**
+ * @brief   Data part of a static memory arena initializer.
+ * @details This macro should be used when statically initializing a
+ *          memory arena that is part of a bigger structure.
+ *
+ * @param[in] name      the name of the memory arena variable
+ * @param[in] size      default size of the blocks obtained from the provider
+ * @param[in] provider  memory provider function for the memory arena or
+ *                      @p NULL if the arena is not allowed to grow
+ *                      automatically
+ */
+#if CH_USE_HEAP || defined(__DOXYGEN__)
+#define _MEMORYARENA_DATA(name, size, provider)                             \
+  {NULL, NULL, NULL, NULL, MEM_ALIGN_NEXT(size), provider, NULL, 0}
+#else
+#define _MEMORYARENA_DATA(name, size, provider)                             \
+  {NULL, NULL, NULL, NULL, MEM_ALIGN_NEXT(size), provider, 0}
+#endif
+
+/**
+ * @brief   Static memory arena initializer.
+ * @details Statically initialized memory arenas require no explicit
+ *          initialization using @p chArenaInit().
+ *
+ * @param[in] name      the name of the memory arena variable
+ * @param[in] size      default size of the blocks obtained from the provider
+ * @param[in] provider  memory provider function for the memory arena or
+ *                      @p NULL if the arena is not allowed to grow
+ *                      automatically
+ */
+#define MEMORYARENA_DECL(name, size, provider)                              \
+  MemoryArena name = _MEMORYARENA_DATA(name, size, provider)
+
+/**
+ * @name    Macro Functions
+ * @{
+ */
+/**
+ * @brief   Releases all the objects allocated in an arena.
+ *
+ * @param[in] ap        pointer to a @p MemoryArena structure
+ *
+ * @api
+ */
+#define chArenaReset(ap) chArenaRelease(ap, NULL)
+
+/**
+ * @brief   Returns the default arena of the current thread.
+ *
+ * @return              Pointer to the thread default arena.
+ * @retval NULL         if the thread has no default arena.
+ *
+ * @api
+ */
+#define chArenaGetDefault() (currp->p_arena)
+/** @} */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+  void chArenaInit(MemoryArena *ap, size_t size, memgetfunc_t provider);
+#if CH_USE_HEAP
+  void chArenaInitHeap(MemoryArena *ap, size_t size, MemoryHeap *heapp);
+#endif
+  void chArenaLoadBuffer(MemoryArena *ap, void *buf, size_t size);
+  void *chArenaAlloc(MemoryArena *ap, size_t size);
+  arenamark_t chArenaGetMark(MemoryArena *ap);
+  void chArenaRelease(MemoryArena *ap, arenamark_t mark);
+  void chArenaTrim(MemoryArena *ap);
+  size_t chArenaStatus(MemoryArena *ap, size_t *sizep);
+  MemoryArena *chArenaSetDefault(MemoryArena *ap);
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CH_USE_ARENAS */
+
+#endif /* _CHARENA_H_ */
+
+/** @} */
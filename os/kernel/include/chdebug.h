@@ -52,6 +52,104 @@
 #define CH_TRACE_BUFFER_SIZE        64
 #endif
 
+/**
+ * @brief   Classes of events recorded in the trace buffer.
+ * @details Events of the classes not in the mask are not recorded and the
+ *          related trace code is not compiled.
+ */
+#ifndef CH_TRACE_MASK
+#define CH_TRACE_MASK               CH_TRACE_ALL
+#endif
+
+/**
+ * @brief   Trace timestamp source.
+ * @details The default is the port cycle counter if the port provides one,
+ *          else the system time.
+ */
+#ifndef CH_TRACE_TIMESTAMP
+#if PORT_SUPPORTS_RT_COUNTER || defined(__DOXYGEN__)
+#define CH_TRACE_TIMESTAMP()        port_rt_get_counter_value()
+#else
+#define CH_TRACE_TIMESTAMP()        ((uint32_t)chTimeNow())
+#endif
+#endif
+
+/**
+ * @brief   Trace timestamp frequency.
+ * @details It is stored in the trace dumps in order to convert timestamps
+ *          into time, zero means unknown.
+ */
+#ifndef CH_TRACE_TIMESTAMP_FREQUENCY
+#if PORT_SUPPORTS_RT_COUNTER || defined(__DOXYGEN__)
+#if defined(PORT_RT_COUNTER_FREQUENCY) || defined(__DOXYGEN__)
+#define CH_TRACE_TIMESTAMP_FREQUENCY PORT_RT_COUNTER_FREQUENCY
+#else
+#define CH_TRACE_TIMESTAMP_FREQUENCY 0
+#endif
+#else
+#define CH_TRACE_TIMESTAMP_FREQUENCY CH_FREQUENCY
+#endif
+#endif
+
+/**
+ * @brief   Interrupt sources accounted separately.
+ * @details Interrupt sources beyond this number share the last accounting
+ *          record.
+ */
+#ifndef CH_ACCT_IRQ_SOURCES
+#define CH_ACCT_IRQ_SOURCES         8
+#endif
+
+/**
+ * @brief   Maximum accounted interrupts nesting.
+ * @details Interrupts nested deeper are accounted to the interrupt they
+ *          preempted.
+ */
+#ifndef CH_ACCT_IRQ_NESTING
+#define CH_ACCT_IRQ_NESTING         4
+#endif
+
+/**
+ * @brief   Critical sections durations histogram bins.
+ * @details Bin zero counts the sections shorter than two counter cycles,
+ *          bin N the sections lasting 2^N to 2^(N+1)-1 cycles, the last
+ *          bin also counts all the longer sections.
+ */
+#ifndef CH_CRIT_HISTOGRAM_BINS
+#define CH_CRIT_HISTOGRAM_BINS      24
+#endif
+
+/**
+ * @brief   Code address of the critical sections boundaries.
+ * @details It is invoked from within the lock and unlock hooks, the
+ *          default returns the address inside the function that entered
+ *          or left the critical section.
+ */
+#ifndef CH_CRIT_CALLER
+#if defined(__GNUC__) || defined(__DOXYGEN__)
+#define CH_CRIT_CALLER()            __builtin_return_address(0)
+#else
+#define CH_CRIT_CALLER()            NULL
+#endif
+#endif
+
+/**
+ * @brief   Sampling profiler buffer entries.
+ */
+#ifndef CH_PROF_BUFFER_SIZE
+#define CH_PROF_BUFFER_SIZE         1024
+#endif
+
+/**
+ * @brief   Sampling profiler frequency.
+ * @details Used by the ports having their own sampling timer, in the other
+ *          ports the samples are taken by the system tick handler at
+ *          @p CH_FREQUENCY.
+ */
+#ifndef CH_PROF_FREQUENCY
+#define CH_PROF_FREQUENCY           1000
+#endif
+
 /**
  * @brief   Fill value for thread stack area in debug mode.
  */
@@ -82,10 +180,19 @@
 #define dbg_check_disable()
 #define dbg_check_suspend()
 #define dbg_check_enable()
+#if CH_DBG_CRITICAL_MONITOR
+/* The monitor hooks are called directly when the state checker is
+   disabled.*/
+#define dbg_check_lock()            dbg_crit_lock()
+#define dbg_check_unlock()          dbg_crit_unlock()
+#define dbg_check_lock_from_isr()   dbg_crit_lock_from_isr()
+#define dbg_check_unlock_from_isr() dbg_crit_unlock_from_isr()
+#else
 #define dbg_check_lock()
 #define dbg_check_unlock()
 #define dbg_check_lock_from_isr()
 #define dbg_check_unlock_from_isr()
+#endif
 #define dbg_check_enter_isr()
 #define dbg_check_leave_isr()
 #define chDbgCheckClassI();
@@ -99,37 +206,337 @@
 /* Trace related structures and macros.                                      */
 /*===========================================================================*/
 
+/**
+ * @name    Trace event classes
+ * @{
+ */
+#define CH_TRACE_SWITCH             (1U << 0)   /**< @brief Context switches.*/
+#define CH_TRACE_ISR                (1U << 1)   /**< @brief ISRs enter/leave.*/
+#define CH_TRACE_SEM                (1U << 2)   /**< @brief Semaphores.     */
+#define CH_TRACE_MTX                (1U << 3)   /**< @brief Mutexes.        */
+#define CH_TRACE_MSG                (1U << 4)   /**< @brief Messages.       */
+#define CH_TRACE_VT                 (1U << 5)   /**< @brief Timer callbacks.*/
+#define CH_TRACE_USER               (1U << 6)   /**< @brief User markers.   */
+#define CH_TRACE_ALL                0x7FU       /**< @brief All the classes.*/
+/** @} */
+
+/**
+ * @name    Trace event types
+ * @{
+ */
+#define CH_TRACE_TYPE_SWITCH        1   /**< @brief Context switch.         */
+#define CH_TRACE_TYPE_ISR_ENTER     2   /**< @brief ISR enter.              */
+#define CH_TRACE_TYPE_ISR_LEAVE     3   /**< @brief ISR leave.              */
+#define CH_TRACE_TYPE_SEM_WAIT      4   /**< @brief Semaphore wait.         */
+#define CH_TRACE_TYPE_SEM_SIGNAL    5   /**< @brief Semaphore signal.       */
+#define CH_TRACE_TYPE_MTX_LOCK      6   /**< @brief Mutex lock.             */
+#define CH_TRACE_TYPE_MTX_UNLOCK    7   /**< @brief Mutex unlock.           */
+#define CH_TRACE_TYPE_MSG_SEND      8   /**< @brief Message send.           */
+#define CH_TRACE_TYPE_MSG_RELEASE   9   /**< @brief Message release.        */
+#define CH_TRACE_TYPE_VT_CALLBACK   10  /**< @brief Timer callback.         */
+#define CH_TRACE_TYPE_USER          11  /**< @brief User marker.            */
+/** @} */
+
+/**
+ * @brief   Trace dump magic number.
+ */
+#define CH_TRACE_MAGIC              0x52544843
+
+/**
+ * @brief   Trace dump format version.
+ */
+#define CH_TRACE_VERSION            1
+
+/**
+ * @brief   Size of the thread and marker names in trace dumps.
+ */
+#define CH_TRACE_NAME_SIZE          16
+
 #if CH_DBG_ENABLE_TRACE || defined(__DOXYGEN__)
 /**
  * @brief   Trace buffer record.
+ * @details The meaning of the object and argument fields depends on the
+ *          event type:
+ *          - <b>Switch</b>: object where the switched out thread is going
+ *            to sleep and the switched out thread.
+ *          - <b>ISR</b>: unused.
+ *          - <b>Semaphore, Mutex</b>: the synchronization object.
+ *          - <b>Message</b>: the destination thread and the message.
+ *          - <b>Timer callback</b>: the callback function and its
+ *            parameter.
+ *          - <b>User</b>: the marker name and a user parameter.
+ *          .
  */
 typedef struct {
-  systime_t             se_time;    /**< @brief Time of the switch event.   */
-  Thread                *se_tp;     /**< @brief Switched in thread.         */
-  void                  *se_wtobjp; /**< @brief Object where going to sleep.*/
-  uint8_t               se_state;   /**< @brief Switched out thread state.  */
-} ch_swc_event_t;
+  uint32_t              te_time;    /**< @brief Event timestamp.            */
+  uint8_t               te_type;    /**< @brief Event type.                 */
+  uint8_t               te_state;   /**< @brief Switched out thread state.  */
+  Thread                *te_tp;     /**< @brief Current thread, switched in
+                                                thread for switch events.   */
+  void                  *te_objp;   /**< @brief Event object.               */
+  void                  *te_arg;    /**< @brief Event argument.             */
+} ch_trace_event_t;
 
 /**
  * @brief   Trace buffer header.
  */
 typedef struct {
   unsigned              tb_size;    /**< @brief Trace buffer size (entries).*/
-  ch_swc_event_t        *tb_ptr;    /**< @brief Pointer to the buffer front.*/
+  ch_trace_event_t      *tb_ptr;    /**< @brief Pointer to the buffer front.*/
+  uint32_t              tb_count;   /**< @brief Recorded events counter.    */
+  bool_t                tb_frozen;  /**< @brief Recording suspended.        */
+  unsigned              tb_window;  /**< @brief Events to be recorded before
+                                                freezing, zero if no
+                                                trigger is pending.         */
   /** @brief Ring buffer.*/
-  ch_swc_event_t        tb_buffer[CH_TRACE_BUFFER_SIZE];
+  ch_trace_event_t      tb_buffer[CH_TRACE_BUFFER_SIZE];
 } ch_trace_buffer_t;
 
 #if !defined(__DOXYGEN__)
 extern ch_trace_buffer_t dbg_trace_buffer;
 #endif
 
+/**
+ * @brief   Records an event of the specified class.
+ * @details The event is recorded only if its class is enabled in
+ *          @p CH_TRACE_MASK.
+ * @note    Must be invoked from within a lock zone.
+ *
+ * @notapi
+ */
+#define dbg_trace_event(class, type, objp, arg) {                           \
+  if ((CH_TRACE_MASK & (class)) != 0)                                       \
+    dbg_trace_write(type, (void *)(objp), (void *)(arg));                   \
+}
+
+/**
+ * @brief   Records an ISR enter event.
+ * @note    Invoked from @p CH_IRQ_PROLOGUE() outside the lock zone.
+ *
+ * @notapi
+ */
+#define dbg_trace_isr_enter() {                                             \
+  if ((CH_TRACE_MASK & CH_TRACE_ISR) != 0)                                  \
+    dbg_trace_isr(CH_TRACE_TYPE_ISR_ENTER);                                 \
+}
+
+/**
+ * @brief   Records an ISR leave event.
+ * @note    Invoked from @p CH_IRQ_EPILOGUE() outside the lock zone.
+ *
+ * @notapi
+ */
+#define dbg_trace_isr_leave() {                                             \
+  if ((CH_TRACE_MASK & CH_TRACE_ISR) != 0)                                  \
+    dbg_trace_isr(CH_TRACE_TYPE_ISR_LEAVE);                                 \
+}
 #endif /* CH_DBG_ENABLE_TRACE */
 
 #if !CH_DBG_ENABLE_TRACE
-/* When the trace feature is disabled this function is replaced by an empty
-   macro.*/
+/* When the trace feature is disabled these functions are replaced by empty
+   macros.*/
 #define dbg_trace(otp)
+#define dbg_trace_event(class, type, objp, arg)
+#define dbg_trace_isr_enter()
+#define dbg_trace_isr_leave()
+#endif
+
+/*===========================================================================*/
+/* CPU accounting related structures and macros.                             */
+/*===========================================================================*/
+
+#if CH_DBG_CPU_ACCOUNTING || defined(__DOXYGEN__)
+#if !PORT_SUPPORTS_RT_COUNTER
+#error "CH_DBG_CPU_ACCOUNTING requires a port free running counter"
+#endif
+
+/**
+ * @brief   Interrupt source accounting record.
+ */
+typedef struct {
+  uint32_t              is_id;      /**< @brief Source identifier.          */
+  uint32_t              is_count;   /**< @brief Served interrupts.          */
+  uint64_t              is_cycles;  /**< @brief Consumed counter cycles.    */
+} ch_acct_source_t;
+
+/**
+ * @brief   CPU accounting state.
+ * @details The counter cycles elapsed since @p ac_last are charged to the
+ *          running thread when a context switch or an interrupt occurs, the
+ *          cycles spent in an interrupt handler are charged to its source
+ *          when the handler returns or is preempted.
+ */
+typedef struct {
+  uint32_t              ac_last;    /**< @brief Counter value at the last
+                                                charge.                     */
+  unsigned              ac_nesting; /**< @brief Interrupts nesting level.   */
+  unsigned              ac_nsources;/**< @brief Used source records.        */
+  /** @brief Sources of the interrupts being served.*/
+  ch_acct_source_t      *ac_stack[CH_ACCT_IRQ_NESTING];
+  /** @brief Interrupt sources records.*/
+  ch_acct_source_t      ac_sources[CH_ACCT_IRQ_SOURCES];
+} ch_cpu_acct_t;
+
+#if !defined(__DOXYGEN__)
+extern ch_cpu_acct_t dbg_cpu_acct;
+#endif
+
+/**
+ * @name    Macro Functions
+ * @{
+ */
+/**
+ * @brief   Returns the counter cycles consumed by a thread.
+ * @note    The value is updated on context switches, invoke
+ *          @p chDbgAcctUpdateI() before reading the value of the current
+ *          thread.
+ *
+ * @param[in] tp        pointer to the thread
+ * @return              The consumed cycles.
+ *
+ * @iclass
+ */
+#define chDbgAcctGetThreadCyclesI(tp) ((tp)->p_cycles)
+
+/**
+ * @brief   Returns the number of interrupt sources records in use.
+ *
+ * @iclass
+ */
+#define chDbgAcctGetSourcesI() (dbg_cpu_acct.ac_nsources)
+
+/**
+ * @brief   Returns an interrupt source accounting record.
+ *
+ * @param[in] n         the record index, it must be lower than the value
+ *                      returned by @p chDbgAcctGetSourcesI()
+ * @return              Pointer to the @p ch_acct_source_t record.
+ *
+ * @iclass
+ */
+#define chDbgAcctGetSourceI(n) (&dbg_cpu_acct.ac_sources[n])
+/** @} */
+#endif /* CH_DBG_CPU_ACCOUNTING */
+
+#if !CH_DBG_CPU_ACCOUNTING
+/* When the accounting is disabled the hooks are replaced by empty macros.*/
+#define dbg_acct_switch(otp)
+#define dbg_acct_isr_enter()
+#define dbg_acct_isr_leave()
+#endif
+
+/*===========================================================================*/
+/* Critical sections monitor related structures and macros.                  */
+/*===========================================================================*/
+
+#if CH_DBG_CRITICAL_MONITOR || defined(__DOXYGEN__)
+#if !PORT_SUPPORTS_RT_COUNTER
+#error "CH_DBG_CRITICAL_MONITOR requires a port free running counter"
+#endif
+
+/**
+ * @brief   Critical sections statistics.
+ * @note    Durations are expressed in free running counter cycles.
+ */
+typedef struct {
+  uint32_t              cs_count;   /**< @brief Measured sections.          */
+  uint32_t              cs_max;     /**< @brief Longest section duration.   */
+  void                  *cs_max_lock;
+                                    /**< @brief Code address where the
+                                                longest section was
+                                                entered.                    */
+  void                  *cs_max_unlock;
+                                    /**< @brief Code address where the
+                                                longest section was left.   */
+  uint64_t              cs_total;   /**< @brief Sum of the durations.       */
+  /** @brief Durations histogram.*/
+  uint32_t              cs_histogram[CH_CRIT_HISTOGRAM_BINS];
+} ch_crit_stats_t;
+
+/**
+ * @brief   Critical sections monitor state.
+ */
+typedef struct {
+  ch_crit_stats_t       cm_thread;  /**< @brief Thread level sections.      */
+  ch_crit_stats_t       cm_isr;     /**< @brief ISR level sections.         */
+  uint32_t              cm_start;   /**< @brief Current section start.      */
+  void                  *cm_lock;   /**< @brief Current section entry
+                                                code address.               */
+} ch_crit_monitor_t;
+
+#if !defined(__DOXYGEN__)
+extern ch_crit_monitor_t dbg_crit_monitor;
+#endif
+#endif /* CH_DBG_CRITICAL_MONITOR */
+
+/*===========================================================================*/
+/* Sampling profiler related structures and macros.                          */
+/*===========================================================================*/
+
+/**
+ * @brief   Profiler dump magic number.
+ */
+#define CH_PROF_MAGIC               0x46504843
+
+/**
+ * @brief   Profiler dump format version.
+ */
+#define CH_PROF_VERSION             1
+
+#if CH_DBG_PROFILER || defined(__DOXYGEN__)
+#if !PORT_SUPPORTS_PROF_SAMPLER && !PORT_SUPPORTS_IRQ_PC
+#error "CH_DBG_PROFILER requires a port sampler or the interrupted PC"
+#endif
+
+#if PORT_SUPPORTS_PROF_SAMPLER && (CH_PROF_FREQUENCY <= 0)
+#error "invalid CH_PROF_FREQUENCY value"
+#endif
+
+/**
+ * @brief   Profiler sample.
+ */
+typedef struct {
+  void                  *ps_pc;     /**< @brief Interrupted program
+                                                counter.                    */
+  Thread                *ps_tp;     /**< @brief Current thread.             */
+} ch_prof_sample_t;
+
+/**
+ * @brief   Profiler buffer.
+ * @note    The fields are volatile because, in the simulators, the samples
+ *          are written by an host signal handler.
+ */
+typedef struct {
+  volatile bool_t       pb_enabled; /**< @brief Sampling enabled.           */
+  volatile uint32_t     pb_count;   /**< @brief Samples taken in the
+                                                session, it can exceed the
+                                                buffer size.                */
+  ch_prof_sample_t * volatile pb_ptr;
+                                    /**< @brief Pointer to the buffer front.*/
+  /** @brief Circular samples buffer.*/
+  ch_prof_sample_t      pb_buffer[CH_PROF_BUFFER_SIZE];
+} ch_prof_buffer_t;
+
+#if !defined(__DOXYGEN__)
+extern ch_prof_buffer_t dbg_prof_buffer;
+#endif
+
+/**
+ * @brief   Samples the interrupted thread from the system tick handler.
+ * @details Ports having their own sampler do not sample on the tick.
+ *
+ * @notapi
+ */
+#if !PORT_SUPPORTS_PROF_SAMPLER || defined(__DOXYGEN__)
+#define dbg_prof_tick() dbg_prof_sample(port_get_irq_pc())
+#else
+#define dbg_prof_tick()
+#endif
+#endif /* CH_DBG_PROFILER */
+
+#if !CH_DBG_PROFILER
+/* When the profiler is disabled the hook is replaced by an empty macro.*/
+#define dbg_prof_tick()
 #endif
 
 /*===========================================================================*/
@@ -233,6 +640,35 @@ extern "C" {
 #if CH_DBG_ENABLE_TRACE || defined(__DOXYGEN__)
   void _trace_init(void);
   void dbg_trace(Thread *otp);
+  void dbg_trace_write(uint8_t type, void *objp, void *arg);
+  void dbg_trace_isr(uint8_t type);
+  void chDbgTraceMarkerI(const char *name, void *arg);
+  void chDbgTraceMarker(const char *name, void *arg);
+  void chDbgTraceSuspendI(void);
+  void chDbgTraceResumeI(void);
+  void chDbgTraceTriggerI(unsigned n);
+  void chDbgTraceDump(BaseSequentialStream *chp);
+#endif
+#if CH_DBG_CRITICAL_MONITOR || defined(__DOXYGEN__)
+  void dbg_crit_lock(void);
+  void dbg_crit_unlock(void);
+  void dbg_crit_lock_from_isr(void);
+  void dbg_crit_unlock_from_isr(void);
+  void chDbgCritGetStats(ch_crit_stats_t *thdp, ch_crit_stats_t *isrp);
+  void chDbgCritResetStats(void);
+#endif
+#if CH_DBG_CPU_ACCOUNTING || defined(__DOXYGEN__)
+  void _acct_init(void);
+  void dbg_acct_switch(Thread *otp);
+  void dbg_acct_isr_enter(void);
+  void dbg_acct_isr_leave(void);
+  void chDbgAcctUpdateI(void);
+#endif
+#if CH_DBG_PROFILER || defined(__DOXYGEN__)
+  void dbg_prof_sample(void *pc);
+  void chDbgProfStart(void);
+  void chDbgProfStop(void);
+  void chDbgProfDump(BaseSequentialStream *chp);
 #endif
 #if CH_DBG_ENABLED
   extern const char *dbg_panic_msg;
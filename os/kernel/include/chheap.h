@@ -42,8 +42,88 @@
 #error "CH_USE_HEAP requires CH_USE_MUTEXES and/or CH_USE_SEMAPHORES"
 #endif
 
+#if CH_DBG_HEAP_PROFILING && CH_USE_MALLOC_HEAP
+#error "CH_DBG_HEAP_PROFILING not compatible with CH_USE_MALLOC_HEAP"
+#endif
+
+/*===========================================================================*/
+/**
+ * @name    Heap profiler related settings
+ * @{
+ */
+/*===========================================================================*/
+
+/**
+ * @brief   Number of call sites tracked by the heap profiler.
+ * @note    The last entry collects the allocations performed by the call
+ *          sites not fitting the table.
+ */
+#ifndef CH_HEAP_PROFILE_SITES
+#define CH_HEAP_PROFILE_SITES       16
+#endif
+
+/**
+ * @brief   Number of bins of the free blocks size histogram.
+ * @details The bin @p n counts the free blocks whose size is in the range
+ *          from 2^(n+4) to 2^(n+5)-1 bytes, the first bin also counts the
+ *          smaller blocks and the last bin the bigger ones.
+ */
+#ifndef CH_HEAP_HISTOGRAM_BINS
+#define CH_HEAP_HISTOGRAM_BINS      8
+#endif
+
+/** @} */
+
 typedef struct memory_heap MemoryHeap;
 
+#if CH_DBG_HEAP_PROFILING || defined(__DOXYGEN__)
+/**
+ * @brief   Heap profiler call site record.
+ */
+typedef struct {
+  void                  *hs_caller; /**< @brief Call site address or
+                                                @p NULL.                    */
+  size_t                hs_bytes;   /**< @brief Live allocated bytes.       */
+  size_t                hs_count;   /**< @brief Live allocated blocks.      */
+  size_t                hs_allocs;  /**< @brief Total allocations.          */
+} ch_heap_site_t;
+
+/**
+ * @brief   Heap profile.
+ */
+typedef struct {
+  size_t                hp_used;    /**< @brief Allocated bytes.            */
+  size_t                hp_peak;    /**< @brief Allocated bytes high-water
+                                                mark.                       */
+  size_t                hp_free;    /**< @brief Total free bytes.           */
+  size_t                hp_fragments;/**< @brief Number of free blocks.     */
+  size_t                hp_largest; /**< @brief Largest free block size.    */
+  /** @brief Free blocks size histogram.*/
+  size_t                hp_histogram[CH_HEAP_HISTOGRAM_BINS];
+} ch_heap_profile_t;
+
+/**
+ * @brief   Heap profile dump magic number.
+ */
+#define CH_HEAP_PROFILE_MAGIC       0x50414548
+
+/**
+ * @brief   Heap profile dump format version.
+ */
+#define CH_HEAP_PROFILE_VERSION     1
+
+/**
+ * @brief   Maximum size of a heap profile dump.
+ */
+#define CH_HEAP_PROFILE_DUMP_SIZE                                           \
+  (36 + (4 * CH_HEAP_HISTOGRAM_BINS) +                                      \
+   (CH_HEAP_PROFILE_SITES * (sizeof(void *) + 12)))
+
+#if !defined(__DOXYGEN__)
+extern ch_heap_site_t dbg_heap_sites[CH_HEAP_PROFILE_SITES];
+#endif
+#endif /* CH_DBG_HEAP_PROFILING */
+
 /**
  * @brief   Memory heap block header.
  */
@@ -55,6 +135,9 @@ union heap_header {
       MemoryHeap        *heap;      /**< @brief Block owner heap.           */
     } u;                            /**< @brief Overlapped fields.          */
     size_t              size;       /**< @brief Size of the memory block.   */
+#if CH_DBG_HEAP_PROFILING || defined(__DOXYGEN__)
+    ch_heap_site_t      *site;      /**< @brief Allocating call site.       */
+#endif
   } h;
 };
 
@@ -70,6 +153,11 @@ struct memory_heap {
 #else
   Semaphore             h_sem;      /**< @brief Heap access semaphore.      */
 #endif
+#if CH_DBG_HEAP_PROFILING || defined(__DOXYGEN__)
+  size_t                h_used;     /**< @brief Allocated bytes.            */
+  size_t                h_peak;     /**< @brief Allocated bytes high-water
+                                                mark.                       */
+#endif
 };
 
 #ifdef __cplusplus
@@ -82,6 +170,11 @@ extern "C" {
   void *chHeapAlloc(MemoryHeap *heapp, size_t size);
   void chHeapFree(void *p);
   size_t chHeapStatus(MemoryHeap *heapp, size_t *sizep);
+#if CH_DBG_HEAP_PROFILING
+  void chHeapGetProfile(MemoryHeap *heapp, ch_heap_profile_t *hpp);
+  void chHeapResetPeak(MemoryHeap *heapp);
+  size_t chHeapProfileDump(MemoryHeap *heapp, uint8_t *buf, size_t size);
+#endif
 #ifdef __cplusplus
 }
 #endif
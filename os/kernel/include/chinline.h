@@ -84,4 +84,13 @@ static INLINE Thread *list_remove(ThreadsList *tlp) {
 }
 #endif /* CH_OPTIMIZE_SPEED */
 
+/* Copy through volatile pointers, the compiler cannot move it across the
+   accesses to the volatile indexes of the lock-free buffers.*/
+static INLINE void volatile_copy(volatile uint8_t *dp,
+                                 const volatile uint8_t *sp, size_t n) {
+
+  while (n--)
+    *dp++ = *sp++;
+}
+
 #endif /* _CHINLINE_H_ */
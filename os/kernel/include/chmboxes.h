@@ -65,9 +65,15 @@ extern "C" {
   msg_t chMBPostAhead(Mailbox *mbp, msg_t msg, systime_t timeout);
   msg_t chMBPostAheadS(Mailbox *mbp, msg_t msg, systime_t timeout);
   msg_t chMBPostAheadI(Mailbox *mbp, msg_t msg);
+  cnt_t chMBPostN(Mailbox *mbp, const msg_t *msgs, cnt_t n, systime_t time);
+  cnt_t chMBPostNS(Mailbox *mbp, const msg_t *msgs, cnt_t n, systime_t time);
+  cnt_t chMBPostNI(Mailbox *mbp, const msg_t *msgs, cnt_t n);
   msg_t chMBFetch(Mailbox *mbp, msg_t *msgp, systime_t timeout);
   msg_t chMBFetchS(Mailbox *mbp, msg_t *msgp, systime_t timeout);
   msg_t chMBFetchI(Mailbox *mbp, msg_t *msgp);
+  cnt_t chMBFetchN(Mailbox *mbp, msg_t *msgs, cnt_t n, systime_t time);
+  cnt_t chMBFetchNS(Mailbox *mbp, msg_t *msgs, cnt_t n, systime_t time);
+  cnt_t chMBFetchNI(Mailbox *mbp, msg_t *msgs, cnt_t n);
 #ifdef __cplusplus
 }
 #endif
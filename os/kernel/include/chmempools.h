@@ -31,6 +31,22 @@
 
 #if CH_USE_MEMPOOLS || defined(__DOXYGEN__)
 
+/*
+ * Module dependencies check.
+ */
+#if CH_USE_MEMPOOLS_LOCKFREE && !PORT_SUPPORTS_LLSC && !PORT_SUPPORTS_DWCAS
+#error "CH_USE_MEMPOOLS_LOCKFREE not supported by this port"
+#endif
+
+/**
+ * @brief   Lock-free pools implemented using a tagged pointer.
+ * @details Exclusive access primitives are preferred when available because
+ *          they are immune to the ABA problem, else the free objects list
+ *          head is a tagged pointer updated by a double word compare and
+ *          swap.
+ */
+#define CH_MEMPOOLS_TAGGED  (CH_USE_MEMPOOLS_LOCKFREE && !PORT_SUPPORTS_LLSC)
+
 /**
  * @brief   Memory pool free object header.
  */
@@ -43,7 +59,12 @@ struct pool_header {
  * @brief   Memory pool descriptor.
  */
 typedef struct {
+#if !CH_MEMPOOLS_TAGGED || defined(__DOXYGEN__)
   struct pool_header    *mp_next;       /**< @brief Pointer to the header.  */
+#else
+  volatile port_tagged_t mp_head;       /**< @brief Tagged pointer to the
+                                                    header.                 */
+#endif
   size_t                mp_object_size; /**< @brief Memory pool objects
                                                     size.                   */
   memgetfunc_t          mp_provider;    /**< @brief Memory blocks provider for
@@ -59,8 +80,13 @@ typedef struct {
  * @param[in] size      size of the memory pool contained objects
  * @param[in] provider  memory provider function for the memory pool
  */
+#if !CH_MEMPOOLS_TAGGED || defined(__DOXYGEN__)
 #define _MEMORYPOOL_DATA(name, size, provider)                              \
   {NULL, size, provider}
+#else
+#define _MEMORYPOOL_DATA(name, size, provider)                              \
+  {{NULL, 0}, size, provider}
+#endif
 
 /**
  * @brief Static memory pool initializer in hungry mode.
@@ -75,6 +101,44 @@ typedef struct {
 #define MEMORYPOOL_DECL(name, size, provider)                               \
   MemoryPool name = _MEMORYPOOL_DATA(name, size, provider)
 
+#if CH_USE_SEMAPHORES || defined(__DOXYGEN__)
+/**
+ * @brief   Guarded memory pool descriptor.
+ * @details A guarded memory pool is a memory pool with a counting semaphore
+ *          that keeps track of the available objects, allocations can block
+ *          until an object is returned to the pool.
+ */
+typedef struct {
+  Semaphore             gmp_sem;        /**< @brief Counter of the available
+                                                    objects.                */
+  MemoryPool            gmp_pool;       /**< @brief The memory pool.        */
+  cnt_t                 gmp_min;        /**< @brief Minimum number of free
+                                                    objects ever reached.   */
+} GuardedMemoryPool;
+
+/**
+ * @brief   Data part of a static guarded memory pool initializer.
+ * @details This macro should be used when statically initializing a
+ *          guarded memory pool that is part of a bigger structure.
+ *
+ * @param[in] name      the name of the guarded memory pool variable
+ * @param[in] size      size of the guarded memory pool contained objects
+ */
+#define _GUARDEDMEMORYPOOL_DATA(name, size)                                 \
+  {_SEMAPHORE_DATA(name.gmp_sem, 0), _MEMORYPOOL_DATA(NULL, size, NULL), 0}
+
+/**
+ * @brief   Static guarded memory pool initializer.
+ * @details Statically initialized guarded memory pools require no explicit
+ *          initialization using @p chGuardedPoolInit().
+ *
+ * @param[in] name      the name of the guarded memory pool variable
+ * @param[in] size      size of the guarded memory pool contained objects
+ */
+#define GUARDEDMEMORYPOOL_DECL(name, size)                                  \
+  GuardedMemoryPool name = _GUARDEDMEMORYPOOL_DATA(name, size)
+#endif /* CH_USE_SEMAPHORES */
+
 /**
  * @name    Macro Functions
  * @{
@@ -112,6 +176,43 @@ typedef struct {
  * @iclass
  */
 #define chPoolAddI(mp, objp) chPoolFreeI(mp, objp)
+
+#if CH_USE_SEMAPHORES || defined(__DOXYGEN__)
+/**
+ * @brief   Allocates an object from a guarded memory pool.
+ * @pre     The guarded memory pool must be already been initialized.
+ *
+ * @param[in] gmp       pointer to a @p GuardedMemoryPool structure
+ * @return              The pointer to the allocated object.
+ *
+ * @api
+ */
+#define chGuardedPoolAlloc(gmp) chGuardedPoolAllocTimeout(gmp, TIME_INFINITE)
+
+/**
+ * @brief   Returns the number of free objects in a guarded memory pool.
+ *
+ * @param[in] gmp       pointer to a @p GuardedMemoryPool structure
+ * @return              The number of available objects.
+ *
+ * @iclass
+ */
+#define chGuardedPoolGetFreeI(gmp) chSemGetCounterI(&(gmp)->gmp_sem)
+
+/**
+ * @brief   Returns the minimum number of free objects ever reached.
+ * @details The returned value is the difference between the number of
+ *          objects added to the pool and the maximum number of objects
+ *          simultaneously allocated, it is useful in order to size the
+ *          pool.
+ *
+ * @param[in] gmp       pointer to a @p GuardedMemoryPool structure
+ * @return              The minimum number of free objects.
+ *
+ * @api
+ */
+#define chGuardedPoolGetMinFree(gmp) ((gmp)->gmp_min)
+#endif /* CH_USE_SEMAPHORES */
 /** @} */
 
 #ifdef __cplusplus
@@ -123,6 +224,17 @@ extern "C" {
   void *chPoolAlloc(MemoryPool *mp);
   void chPoolFreeI(MemoryPool *mp, void *objp);
   void chPoolFree(MemoryPool *mp, void *objp);
+#if CH_USE_SEMAPHORES
+  void chGuardedPoolInit(GuardedMemoryPool *gmp, size_t size);
+  void chGuardedPoolLoadArray(GuardedMemoryPool *gmp, void *p, size_t n);
+  void *chGuardedPoolAllocI(GuardedMemoryPool *gmp);
+  void *chGuardedPoolAllocTimeoutS(GuardedMemoryPool *gmp, systime_t time);
+  void *chGuardedPoolAllocTimeout(GuardedMemoryPool *gmp, systime_t time);
+  void chGuardedPoolFreeI(GuardedMemoryPool *gmp, void *objp);
+  void chGuardedPoolFree(GuardedMemoryPool *gmp, void *objp);
+  void chGuardedPoolAddI(GuardedMemoryPool *gmp, void *objp);
+  void chGuardedPoolAdd(GuardedMemoryPool *gmp, void *objp);
+#endif
 #ifdef __cplusplus
 }
 #endif
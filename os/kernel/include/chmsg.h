@@ -65,7 +65,13 @@
  *
  * @sclass
  */
-#define chMsgReleaseS(tp, msg) chSchWakeupS(tp, msg)
+#define chMsgReleaseS(tp, msg) do {                                         \
+  Thread *_tp = (tp);                                                       \
+  msg_t _msg = (msg);                                                       \
+  dbg_trace_event(CH_TRACE_MSG, CH_TRACE_TYPE_MSG_RELEASE,                  \
+                  _tp, (intptr_t)_msg);                                     \
+  chSchWakeupS(_tp, _msg);                                                  \
+} while (0)
 /** @} */
 
 #ifdef __cplusplus
@@ -41,6 +41,9 @@ typedef struct Mutex {
                                                 @p NULL.                    */
   struct Mutex          *m_next;    /**< @brief Next @p Mutex into an
                                                 owner-list or @p NULL.      */
+#if CH_DBG_SYNC_PROFILING || defined(__DOXYGEN__)
+  ch_sync_profile_t     m_prof;     /**< @brief Contention profile.         */
+#endif
 } Mutex;
 
 #ifdef __cplusplus
@@ -65,7 +68,12 @@ extern "C" {
  *
  * @param[in] name      the name of the mutex variable
  */
+#if !CH_DBG_SYNC_PROFILING
 #define _MUTEX_DATA(name) {_THREADSQUEUE_DATA(name.m_queue), NULL, NULL}
+#else
+#define _MUTEX_DATA(name) {_THREADSQUEUE_DATA(name.m_queue), NULL, NULL,    \
+                           _SYNC_PROFILE_DATA}
+#endif
 
 /**
  * @brief   Static mutex initializer.
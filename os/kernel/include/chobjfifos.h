@@ -0,0 +1,149 @@
+/*
+    ChibiOS/RT - Copyright (C) 2006,2007,2008,2009,2010,
+                 2011,2012,2013 Giovanni Di Sirio.
+
+    This file is part of ChibiOS/RT.
+
+    ChibiOS/RT is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    ChibiOS/RT is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * @file    chobjfifos.h
+ * @brief   Objects FIFOs macros and structures.
+ *
+ * @addtogroup objfifos
+ * @{
+ */
+
+#ifndef _CHOBJFIFOS_H_
+#define _CHOBJFIFOS_H_
+
+#if CH_USE_OBJFIFOS || defined(__DOXYGEN__)
+
+/*
+ * Module dependencies check.
+ */
+#if !CH_USE_MAILBOXES
+#error "CH_USE_OBJFIFOS requires CH_USE_MAILBOXES"
+#endif
+
+#if !CH_USE_MEMPOOLS
+#error "CH_USE_OBJFIFOS requires CH_USE_MEMPOOLS"
+#endif
+
+/**
+ * @brief   Structure representing an objects FIFO.
+ */
+typedef struct {
+  GuardedMemoryPool     of_free;        /**< @brief Pool of the free
+                                                    objects.                */
+  Mailbox               of_mbx;         /**< @brief Mailbox of the posted
+                                                    objects.                */
+} ObjectsFifo;
+
+/**
+ * @brief   Storage of an objects FIFO.
+ * @details This macro declares a structure containing both the objects
+ *          and the messages buffers of an objects FIFO, the objects are
+ *          aligned in order to contain a pointer.
+ *
+ * @param[in] name      the name of the storage variable
+ * @param[in] type      the type of the objects
+ * @param[in] n         the number of objects
+ */
+#define OBJECTSFIFO_STORAGE(name, type, n)                                  \
+  struct {                                                                  \
+    union {                                                                 \
+      type              obj;                                                \
+      void              *align;                                             \
+    }                   objs[n];                                            \
+    msg_t               msgs[n];                                            \
+  } name
+
+/**
+ * @name    Macro Functions
+ * @{
+ */
+/**
+ * @brief   Initializes an objects FIFO on a storage variable.
+ *
+ * @param[out] ofp      pointer to an @p ObjectsFifo structure
+ * @param[in] sp        pointer to a storage variable declared using
+ *                      @p OBJECTSFIFO_STORAGE()
+ *
+ * @init
+ */
+#define chFifoInitStorage(ofp, sp)                                          \
+  chFifoInit(ofp, sizeof((sp)->objs[0]),                                    \
+             sizeof((sp)->objs) / sizeof((sp)->objs[0]),                    \
+             (sp)->objs, (sp)->msgs)
+
+/**
+ * @brief   Allocates a free object.
+ * @details The calling thread waits until an object is available.
+ *
+ * @param[in] ofp       pointer to an @p ObjectsFifo structure
+ * @return              The pointer to the allocated object.
+ *
+ * @api
+ */
+#define chFifoAlloc(ofp) chFifoAllocTimeout(ofp, TIME_INFINITE)
+
+/**
+ * @brief   Returns the number of objects posted in the FIFO.
+ *
+ * @param[in] ofp       pointer to an @p ObjectsFifo structure
+ * @return              The number of posted objects.
+ *
+ * @iclass
+ */
+#define chFifoGetUsedCountI(ofp) chMBGetUsedCountI(&(ofp)->of_mbx)
+
+/**
+ * @brief   Returns the number of free objects in the FIFO.
+ *
+ * @param[in] ofp       pointer to an @p ObjectsFifo structure
+ * @return              The number of objects that can be allocated.
+ *
+ * @iclass
+ */
+#define chFifoGetFreeCountI(ofp) chGuardedPoolGetFreeI(&(ofp)->of_free)
+/** @} */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+  void chFifoInit(ObjectsFifo *ofp, size_t objsize, size_t objn,
+                  void *objbuf, msg_t *msgbuf);
+  void *chFifoAllocI(ObjectsFifo *ofp);
+  void *chFifoAllocTimeoutS(ObjectsFifo *ofp, systime_t time);
+  void *chFifoAllocTimeout(ObjectsFifo *ofp, systime_t time);
+  void chFifoFreeI(ObjectsFifo *ofp, void *objp);
+  void chFifoFree(ObjectsFifo *ofp, void *objp);
+  void chFifoPostI(ObjectsFifo *ofp, void *objp);
+  void chFifoPostS(ObjectsFifo *ofp, void *objp);
+  void chFifoPost(ObjectsFifo *ofp, void *objp);
+  msg_t chFifoFetchI(ObjectsFifo *ofp, void **objpp);
+  msg_t chFifoFetchTimeoutS(ObjectsFifo *ofp, void **objpp, systime_t time);
+  msg_t chFifoFetchTimeout(ObjectsFifo *ofp, void **objpp, systime_t time);
+  void *chFifoPeekI(ObjectsFifo *ofp);
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CH_USE_OBJFIFOS */
+
+#endif /* _CHOBJFIFOS_H_ */
+
+/** @} */
@@ -0,0 +1,211 @@
+/*
+    ChibiOS/RT - Copyright (C) 2006,2007,2008,2009,2010,
+                 2011,2012,2013 Giovanni Di Sirio.
+
+    This file is part of ChibiOS/RT.
+
+    ChibiOS/RT is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    ChibiOS/RT is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * @file    chpmboxes.h
+ * @brief   Priority mailboxes macros and structures.
+ *
+ * @addtogroup pmailboxes
+ * @{
+ */
+
+#ifndef _CHPMBOXES_H_
+#define _CHPMBOXES_H_
+
+#if CH_USE_PRIO_MAILBOXES || defined(__DOXYGEN__)
+
+/*
+ * Module dependencies check.
+ */
+#if !CH_USE_SEMAPHORES
+#error "CH_USE_PRIO_MAILBOXES requires CH_USE_SEMAPHORES"
+#endif
+
+/**
+ * @brief   Maximum number of lanes in a priority mailbox.
+ */
+#define PMB_MAX_LANES           32
+
+/**
+ * @brief   Type of a lanes bitmap.
+ */
+typedef uint32_t lanemap_t;
+
+/**
+ * @brief   Structure representing a priority mailbox lane.
+ * @details A lane is a circular buffer of messages with its own capacity.
+ */
+typedef struct {
+  msg_t                 *ml_buffer;     /**< @brief Pointer to the lane
+                                                    buffer.                 */
+  msg_t                 *ml_top;        /**< @brief Pointer to the location
+                                                    after the buffer.       */
+  msg_t                 *ml_wrptr;      /**< @brief Write pointer.          */
+  msg_t                 *ml_rdptr;      /**< @brief Read pointer.           */
+  cnt_t                 ml_cnt;         /**< @brief Number of messages in
+                                                    the lane.               */
+  Semaphore             ml_emptysem;    /**< @brief Empty counter
+                                                    @p Semaphore.           */
+} MailboxLane;
+
+/**
+ * @brief   Structure representing a priority mailbox object.
+ */
+typedef struct {
+  MailboxLane           *pmb_lanes;     /**< @brief Pointer to the lanes
+                                                    array.                  */
+  cnt_t                 pmb_n;          /**< @brief Number of lanes.        */
+  lanemap_t             pmb_map;        /**< @brief Bitmap of the non-empty
+                                                    lanes.                  */
+  Semaphore             pmb_fullsem;    /**< @brief Full counter
+                                                    @p Semaphore.           */
+} PriorityMailbox;
+
+/**
+ * @name    Macro Functions
+ * @{
+ */
+/**
+ * @brief   Returns the number of lanes of a priority mailbox.
+ *
+ * @param[in] pmbp      the pointer to an initialized @p PriorityMailbox
+ *                      object
+ * @return              The number of lanes.
+ *
+ * @iclass
+ */
+#define chPMBGetLanesI(pmbp) ((pmbp)->pmb_n)
+
+/**
+ * @brief   Returns the number of messages queued in a priority mailbox.
+ * @note    The returned value can be less than zero when there are waiting
+ *          threads on the internal semaphore.
+ *
+ * @param[in] pmbp      the pointer to an initialized @p PriorityMailbox
+ *                      object
+ * @return              The number of queued messages in all lanes.
+ *
+ * @iclass
+ */
+#define chPMBGetUsedCountI(pmbp) chSemGetCounterI(&(pmbp)->pmb_fullsem)
+
+/**
+ * @brief   Returns the number of messages queued in a lane.
+ *
+ * @param[in] pmbp      the pointer to an initialized @p PriorityMailbox
+ *                      object
+ * @param[in] prio      the lane priority
+ * @return              The number of messages queued in the lane.
+ *
+ * @iclass
+ */
+#define chPMBGetLaneUsedCountI(pmbp, prio)                                  \
+  ((pmbp)->pmb_lanes[prio].ml_cnt)
+
+/**
+ * @brief   Returns the number of free message slots in a lane.
+ * @note    The returned value can be less than zero when there are waiting
+ *          threads on the internal semaphore.
+ *
+ * @param[in] pmbp      the pointer to an initialized @p PriorityMailbox
+ *                      object
+ * @param[in] prio      the lane priority
+ * @return              The number of empty message slots in the lane.
+ *
+ * @iclass
+ */
+#define chPMBGetLaneFreeCountI(pmbp, prio)                                  \
+  chSemGetCounterI(&(pmbp)->pmb_lanes[prio].ml_emptysem)
+/** @} */
+
+/**
+ * @brief   Data part of a static mailbox lane initializer.
+ * @details This macro should be used when statically initializing the
+ *          lanes array of a priority mailbox.
+ *
+ * @param[in] name      the name of the lane variable
+ * @param[in] buffer    pointer to the lane buffer area
+ * @param[in] size      size of the lane buffer area
+ */
+#define _MAILBOX_LANE_DATA(name, buffer, size) {                            \
+  (msg_t *)(buffer),                                                        \
+  (msg_t *)(buffer) + size,                                                 \
+  (msg_t *)(buffer),                                                        \
+  (msg_t *)(buffer),                                                        \
+  0,                                                                        \
+  _SEMAPHORE_DATA(name.ml_emptysem, size),                                  \
+}
+
+/**
+ * @brief   Data part of a static priority mailbox initializer.
+ * @details This macro should be used when statically initializing a
+ *          priority mailbox that is part of a bigger structure.
+ *
+ * @param[in] name      the name of the priority mailbox variable
+ * @param[in] lanes     pointer to an array of statically initialized
+ *                      @p MailboxLane objects
+ * @param[in] n         number of lanes
+ */
+#define _PRIORITY_MAILBOX_DATA(name, lanes, n) {                            \
+  (MailboxLane *)(lanes),                                                   \
+  n,                                                                        \
+  0,                                                                        \
+  _SEMAPHORE_DATA(name.pmb_fullsem, 0),                                     \
+}
+
+/**
+ * @brief   Static priority mailbox initializer.
+ * @details Statically initialized priority mailboxes require no explicit
+ *          initialization using @p chPMBInit().
+ *
+ * @param[in] name      the name of the priority mailbox variable
+ * @param[in] lanes     pointer to an array of statically initialized
+ *                      @p MailboxLane objects
+ * @param[in] n         number of lanes
+ */
+#define PRIORITY_MAILBOX_DECL(name, lanes, n)                               \
+  PriorityMailbox name = _PRIORITY_MAILBOX_DATA(name, lanes, n)
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+  void chPMBLaneInit(MailboxLane *mlp, msg_t *buf, cnt_t n);
+  void chPMBInit(PriorityMailbox *pmbp, MailboxLane *lanes, cnt_t n);
+  void chPMBResetI(PriorityMailbox *pmbp);
+  void chPMBReset(PriorityMailbox *pmbp);
+  msg_t chPMBPost(PriorityMailbox *pmbp, msg_t msg, cnt_t prio,
+                  systime_t time);
+  msg_t chPMBPostS(PriorityMailbox *pmbp, msg_t msg, cnt_t prio,
+                   systime_t time);
+  msg_t chPMBPostI(PriorityMailbox *pmbp, msg_t msg, cnt_t prio);
+  msg_t chPMBFetch(PriorityMailbox *pmbp, msg_t *msgp, cnt_t *priop,
+                   systime_t time);
+  msg_t chPMBFetchS(PriorityMailbox *pmbp, msg_t *msgp, cnt_t *priop,
+                    systime_t time);
+  msg_t chPMBFetchI(PriorityMailbox *pmbp, msg_t *msgp, cnt_t *priop);
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CH_USE_PRIO_MAILBOXES */
+
+#endif /* _CHPMBOXES_H_ */
+
+/** @} */
@@ -348,6 +348,11 @@ extern "C" {
                 void *link);
   void chIQResetI(InputQueue *iqp);
   msg_t chIQPutI(InputQueue *iqp, uint8_t b);
+  size_t chIQWriteI(InputQueue *iqp, const uint8_t *bp, size_t n);
+  size_t chIQGetReadSpanI(InputQueue *iqp, uint8_t **bpp);
+  void chIQReadCommitS(InputQueue *iqp, size_t n);
+  size_t chIQGetWriteSpanI(InputQueue *iqp, uint8_t **bpp);
+  void chIQWriteCommitI(InputQueue *iqp, size_t n);
   msg_t chIQGetTimeout(InputQueue *iqp, systime_t time);
   size_t chIQReadTimeout(InputQueue *iqp, uint8_t *bp,
                          size_t n, systime_t time);
@@ -357,6 +362,11 @@ extern "C" {
   void chOQResetI(OutputQueue *oqp);
   msg_t chOQPutTimeout(OutputQueue *oqp, uint8_t b, systime_t time);
   msg_t chOQGetI(OutputQueue *oqp);
+  size_t chOQReadI(OutputQueue *oqp, uint8_t *bp, size_t n);
+  size_t chOQGetWriteSpanI(OutputQueue *oqp, uint8_t **bpp);
+  void chOQWriteCommitS(OutputQueue *oqp, size_t n);
+  size_t chOQGetReadSpanI(OutputQueue *oqp, uint8_t **bpp);
+  void chOQReadCommitI(OutputQueue *oqp, size_t n);
   size_t chOQWriteTimeout(OutputQueue *oqp, const uint8_t *bp,
                           size_t n, systime_t time);
 #ifdef __cplusplus
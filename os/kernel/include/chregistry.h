@@ -29,6 +29,10 @@
 #ifndef _CHREGISTRY_H_
 #define _CHREGISTRY_H_
 
+#if CH_DBG_STACK_EXIT_REPORT && (!CH_USE_REGISTRY || !CH_DBG_FILL_THREADS)
+#error "CH_DBG_STACK_EXIT_REPORT requires CH_USE_REGISTRY and CH_DBG_FILL_THREADS"
+#endif
+
 #if CH_USE_REGISTRY || defined(__DOXYGEN__)
 
 /**
@@ -119,6 +123,9 @@ extern "C" {
   extern ROMCONST chdebug_t ch_debug;
   Thread *chRegFirstThread(void);
   Thread *chRegNextThread(Thread *tp);
+#if CH_DBG_FILL_THREADS
+  size_t chRegGetStackUsage(Thread *tp, size_t *sizep);
+#endif
 #ifdef __cplusplus
 }
 #endif
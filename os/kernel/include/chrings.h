@@ -0,0 +1,164 @@
+/*
+    ChibiOS/RT - Copyright (C) 2006,2007,2008,2009,2010,
+                 2011,2012,2013 Giovanni Di Sirio.
+
+    This file is part of ChibiOS/RT.
+
+    ChibiOS/RT is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    ChibiOS/RT is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * @file    chrings.h
+ * @brief   Ring Buffers macros and structures.
+ *
+ * @addtogroup rings
+ * @{
+ */
+
+#ifndef _CHRINGS_H_
+#define _CHRINGS_H_
+
+#if CH_USE_RINGS || defined(__DOXYGEN__)
+
+/*
+ * Module dependencies check.
+ */
+#if !CH_USE_SEMAPHORES
+#error "CH_USE_RINGS requires CH_USE_SEMAPHORES"
+#endif
+
+/**
+ * @name    Ring buffer functions returned status value
+ * @{
+ */
+#define RING_OK         RDY_OK      /**< @brief Operation successful.       */
+#define RING_TIMEOUT    RDY_TIMEOUT /**< @brief Timeout condition.          */
+#define RING_RESET      RDY_RESET   /**< @brief Buffer has been reset.      */
+#define RING_FULL       -4          /**< @brief Buffer full.                */
+/** @} */
+
+/**
+ * @brief   Structure representing a ring buffer.
+ * @note    The indexes are free running, the number of records in the
+ *          buffer is always the difference between the head and the tail
+ *          indexes.
+ */
+typedef struct {
+  volatile size_t       rb_head;    /**< @brief Producer index, written
+                                                only by the producer.       */
+  volatile size_t       rb_tail;    /**< @brief Consumer index, written
+                                                only by the consumer.       */
+  size_t                rb_mask;    /**< @brief Number of records minus
+                                                one.                        */
+  size_t                rb_recsize; /**< @brief Size of a record.           */
+  uint8_t               *rb_buffer; /**< @brief Pointer to the records
+                                                buffer.                     */
+  BinarySemaphore       rb_sem;     /**< @brief Data available semaphore.   */
+} RingBuffer;
+
+/**
+ * @name    Macro Functions
+ * @{
+ */
+/**
+ * @brief   Returns the number of records in a ring buffer.
+ * @note    This function can be called in any context, the value is only
+ *          a snapshot because the buffer can be accessed concurrently.
+ *
+ * @param[in] rbp       pointer to a @p RingBuffer structure
+ * @return              The number of records in the buffer.
+ *
+ * @special
+ */
+#define chRingGetUsed(rbp) ((size_t)((rbp)->rb_head - (rbp)->rb_tail))
+
+/**
+ * @brief   Returns the number of empty slots in a ring buffer.
+ * @note    This function can be called in any context, the value is only
+ *          a snapshot because the buffer can be accessed concurrently.
+ *
+ * @param[in] rbp       pointer to a @p RingBuffer structure
+ * @return              The number of empty slots in the buffer.
+ *
+ * @special
+ */
+#define chRingGetEmpty(rbp) ((rbp)->rb_mask + 1 - chRingGetUsed(rbp))
+
+/**
+ * @brief   Byte ring buffer read.
+ * @details This function reads a byte value from a byte ring buffer. If the
+ *          buffer is empty then the calling thread is suspended until a byte
+ *          arrives in the buffer.
+ *
+ * @param[in] rbp       pointer to a @p RingBuffer structure
+ * @return              A byte value from the buffer.
+ * @retval RING_RESET   if the buffer has been reset.
+ *
+ * @api
+ */
+#define chRingGet(rbp) chRingGetTimeout(rbp, TIME_INFINITE)
+/** @} */
+
+/**
+ * @brief   Data part of a static ring buffer initializer.
+ * @details This macro should be used when statically initializing a
+ *          ring buffer that is part of a bigger structure.
+ *
+ * @param[in] name      the name of the ring buffer variable
+ * @param[in] buffer    pointer to the records buffer
+ * @param[in] recsize   size of a record
+ * @param[in] n         number of records, it must be a power of two
+ */
+#define _RINGBUFFER_DATA(name, buffer, recsize, n) {                        \
+  0,                                                                        \
+  0,                                                                        \
+  (n) - 1,                                                                  \
+  (recsize),                                                                \
+  (uint8_t *)(buffer),                                                      \
+  _BSEMAPHORE_DATA(name.rb_sem, TRUE)                                       \
+}
+
+/**
+ * @brief   Static ring buffer initializer.
+ * @details Statically initialized ring buffers require no explicit
+ *          initialization using @p chRingInit().
+ *
+ * @param[in] name      the name of the ring buffer variable
+ * @param[in] buffer    pointer to the records buffer
+ * @param[in] recsize   size of a record
+ * @param[in] n         number of records, it must be a power of two
+ */
+#define RINGBUFFER_DECL(name, buffer, recsize, n)                           \
+  RingBuffer name = _RINGBUFFER_DATA(name, buffer, recsize, n)
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+  void chRingInit(RingBuffer *rbp, void *buffer, size_t recsize, size_t n);
+  void chRingResetI(RingBuffer *rbp);
+  msg_t chRingPutI(RingBuffer *rbp, uint8_t b);
+  msg_t chRingPutFromIsr(RingBuffer *rbp, uint8_t b);
+  msg_t chRingGetTimeout(RingBuffer *rbp, systime_t time);
+  msg_t chRingPutRecordI(RingBuffer *rbp, const void *recp);
+  msg_t chRingPutRecordFromIsr(RingBuffer *rbp, const void *recp);
+  msg_t chRingGetRecordTimeout(RingBuffer *rbp, void *recp, systime_t time);
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CH_USE_RINGS */
+
+#endif /* _CHRINGS_H_ */
+
+/** @} */
@@ -199,8 +199,10 @@ extern "C" {
  */
 #if !defined(PORT_OPTIMIZED_DOYIELDS) || defined(__DOXYGEN__)
 #define chSchDoYieldS() {                                                   \
-  if (chSchCanYieldS())                                                     \
+  if (chSchCanYieldS()) {                                                   \
+    stats_yield();                                                          \
     chSchDoRescheduleBehind();                                              \
+  }                                                                         \
 }
 #endif /* !defined(PORT_OPTIMIZED_DOYIELDS) */
 
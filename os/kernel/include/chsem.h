@@ -38,6 +38,9 @@ typedef struct Semaphore {
   ThreadsQueue          s_queue;    /**< @brief Queue of the threads sleeping
                                                 on this semaphore.          */
   cnt_t                 s_cnt;      /**< @brief The semaphore counter.      */
+#if CH_DBG_SYNC_PROFILING || defined(__DOXYGEN__)
+  ch_sync_profile_t     s_prof;     /**< @brief Contention profile.         */
+#endif
 } Semaphore;
 
 #ifdef __cplusplus
@@ -69,7 +72,12 @@ extern "C" {
  * @param[in] n         the counter initial value, this value must be
  *                      non-negative
  */
+#if !CH_DBG_SYNC_PROFILING
 #define _SEMAPHORE_DATA(name, n) {_THREADSQUEUE_DATA(name.s_queue), n}
+#else
+#define _SEMAPHORE_DATA(name, n) {_THREADSQUEUE_DATA(name.s_queue), n,     \
+                                  _SYNC_PROFILE_DATA}
+#endif
 
 /**
  * @brief   Static semaphore initializer.
@@ -0,0 +1,171 @@
+/*
+    ChibiOS/RT - Copyright (C) 2006,2007,2008,2009,2010,
+                 2011,2012,2013 Giovanni Di Sirio.
+
+    This file is part of ChibiOS/RT.
+
+    ChibiOS/RT is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    ChibiOS/RT is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * @file    chstats.h
+ * @brief   Kernel statistics macros and structures.
+ *
+ * @addtogroup statistics
+ * @{
+ */
+
+#ifndef _CHSTATS_H_
+#define _CHSTATS_H_
+
+#if CH_DBG_STATISTICS || defined(__DOXYGEN__)
+
+/**
+ * @brief   Kernel statistics.
+ * @note    All the counters can overflow, rates must be computed as
+ *          differences between snapshots.
+ */
+typedef struct {
+  uint32_t              ks_switches;/**< @brief Context switches.           */
+  uint32_t              ks_preemptions;
+                                    /**< @brief Context switches caused by
+                                                a preemption.               */
+  uint32_t              ks_yields;  /**< @brief Context switches caused by
+                                                a yield.                    */
+  uint32_t              ks_isr;     /**< @brief Served IRQs.                */
+  uint32_t              ks_vt;      /**< @brief Virtual timers expirations. */
+  cnt_t                 ks_ready;   /**< @brief Threads in the ready list.  */
+  cnt_t                 ks_ready_max;
+                                    /**< @brief Ready list depth
+                                                high-water mark.            */
+  bool_t                ks_yielding;/**< @brief A yield is in progress.     */
+} ch_kernel_stats_t;
+
+/**
+ * @name    Macro Functions
+ * @{
+ */
+/**
+ * @brief   Returns the number of times a thread has been made ready.
+ * @details The counter is increased each time the thread leaves a sleeping
+ *          state, preemptions and priority changes are not accounted.
+ *
+ * @param[in] tp        pointer to the thread
+ *
+ * @iclass
+ */
+#define chStatsGetThreadWakeupsI(tp) ((tp)->p_wakeups)
+/** @} */
+
+/**
+ * @name    Statistics hooks
+ * @note    Must be invoked from within a lock zone, except
+ *          @p stats_isr().
+ * @{
+ */
+/**
+ * @brief   Accounts a context switch.
+ * @details The switch is a preemption or a yield if the outgoing thread
+ *          is still ready, else it is a voluntary suspension.
+ *
+ * @notapi
+ */
+#define stats_switch(otp) {                                                 \
+  kernel_stats.ks_switches++;                                               \
+  if ((otp)->p_state == THD_STATE_READY) {                                  \
+    if (kernel_stats.ks_yielding)                                           \
+      kernel_stats.ks_yields++;                                             \
+    else                                                                    \
+      kernel_stats.ks_preemptions++;                                        \
+  }                                                                         \
+  kernel_stats.ks_yielding = FALSE;                                         \
+}
+
+/**
+ * @brief   Marks the following context switch as a yield.
+ *
+ * @notapi
+ */
+#define stats_yield() (kernel_stats.ks_yielding = TRUE)
+
+/**
+ * @brief   Accounts an IRQ handler entry.
+ * @note    Invoked by @p CH_IRQ_PROLOGUE(), ports polling their interrupt
+ *          sources must enter the prologue only when a source is served
+ *          or the polls would be accounted as interrupts.
+ *
+ * @notapi
+ */
+#define stats_isr() _stats_isr()
+
+/**
+ * @brief   Accounts a virtual timer expiration.
+ *
+ * @notapi
+ */
+#define stats_vt() (kernel_stats.ks_vt++)
+
+/**
+ * @brief   Accounts a thread insertion in the ready list.
+ * @note    Must be invoked before the thread state is changed to
+ *          @p THD_STATE_READY.
+ *
+ * @notapi
+ */
+#define stats_ready_insert(tp) {                                            \
+  if (((tp)->p_state != THD_STATE_CURRENT) &&                               \
+      ((tp)->p_state != THD_STATE_READY))                                   \
+    (tp)->p_wakeups++;                                                      \
+  if (++kernel_stats.ks_ready > kernel_stats.ks_ready_max)                  \
+    kernel_stats.ks_ready_max = kernel_stats.ks_ready;                      \
+}
+
+/**
+ * @brief   Accounts a thread removal from the ready list.
+ *
+ * @notapi
+ */
+#define stats_ready_remove() (kernel_stats.ks_ready--)
+/** @} */
+
+#if !defined(__DOXYGEN__)
+extern ch_kernel_stats_t kernel_stats;
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+  void _stats_init(void);
+  void _stats_isr(void);
+  void chStatsGetSnapshot(ch_kernel_stats_t *ksp);
+  void chStatsResetReadyMax(void);
+#ifdef __cplusplus
+}
+#endif
+
+#else /* !CH_DBG_STATISTICS */
+
+/* When the statistics are disabled the hooks are replaced by empty macros.*/
+#define stats_switch(otp)
+#define stats_yield()
+#define stats_isr()
+#define stats_vt()
+#define stats_ready_insert(tp)
+#define stats_ready_remove()
+
+#endif /* !CH_DBG_STATISTICS */
+
+#endif /* _CHSTATS_H_ */
+
+/** @} */
@@ -0,0 +1,204 @@
+/*
+    ChibiOS/RT - Copyright (C) 2006,2007,2008,2009,2010,
+                 2011,2012,2013 Giovanni Di Sirio.
+
+    This file is part of ChibiOS/RT.
+
+    ChibiOS/RT is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    ChibiOS/RT is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * @file    chsyncprof.h
+ * @brief   Synchronization objects profiling macros and structures.
+ *
+ * @addtogroup sync_profiling
+ * @{
+ */
+
+#ifndef _CHSYNCPROF_H_
+#define _CHSYNCPROF_H_
+
+#if CH_DBG_SYNC_PROFILING || defined(__DOXYGEN__)
+
+/*
+ * Module dependencies check.
+ */
+#if !PORT_SUPPORTS_RT_COUNTER
+#error "CH_DBG_SYNC_PROFILING requires a port free running counter"
+#endif
+
+/**
+ * @name    Profiled objects types
+ * @{
+ */
+#define CH_SYNC_SEMAPHORE       1   /**< @brief Counting semaphore.         */
+#define CH_SYNC_BSEMAPHORE      2   /**< @brief Binary semaphore.           */
+#define CH_SYNC_MUTEX           3   /**< @brief Mutex.                      */
+/** @} */
+
+/**
+ * @brief   Synchronization object profile.
+ * @details Profiles are embedded in the semaphores and mutexes, times are
+ *          expressed in free running counter cycles.
+ */
+typedef struct ch_sync_profile {
+  struct ch_sync_profile *sp_next;  /**< @brief Next registered profile.    */
+  const char            *sp_name;   /**< @brief Object name or @p NULL.     */
+  uint8_t               sp_type;    /**< @brief Object type.                */
+  uint32_t              sp_acquisitions;
+                                    /**< @brief Wait or lock operations.    */
+  uint32_t              sp_contended;
+                                    /**< @brief Operations that had to
+                                                wait.                       */
+  uint32_t              sp_boosts;  /**< @brief Priority inheritance
+                                                boosts, mutexes only.       */
+  uint32_t              sp_wait_max;/**< @brief Longest wait.               */
+  uint64_t              sp_wait_total;
+                                    /**< @brief Sum of the waits.           */
+  uint32_t              sp_hold_max;/**< @brief Longest ownership, mutexes
+                                                only.                       */
+  uint32_t              sp_hold_start;
+                                    /**< @brief Current ownership start.    */
+} ch_sync_profile_t;
+
+/**
+ * @brief   Data part of a static profile initializer.
+ */
+#define _SYNC_PROFILE_DATA {NULL, NULL, 0, 0, 0, 0, 0, 0, 0, 0}
+
+/**
+ * @name    Macro Functions
+ * @{
+ */
+/**
+ * @brief   Registers a semaphore for profiling.
+ *
+ * @param[in] sp        pointer to a @p Semaphore structure
+ * @param[in] name      the object name or @p NULL
+ *
+ * @api
+ */
+#define chSemRegister(sp, name)                                             \
+  chSyncProfRegister(&(sp)->s_prof, CH_SYNC_SEMAPHORE, name)
+
+/**
+ * @brief   Registers a binary semaphore for profiling.
+ *
+ * @param[in] bsp       pointer to a @p BinarySemaphore structure
+ * @param[in] name      the object name or @p NULL
+ *
+ * @api
+ */
+#define chBSemRegister(bsp, name)                                           \
+  chSyncProfRegister(&(bsp)->bs_sem.s_prof, CH_SYNC_BSEMAPHORE, name)
+
+/**
+ * @brief   Registers a mutex for profiling.
+ *
+ * @param[in] mp        pointer to a @p Mutex structure
+ * @param[in] name      the object name or @p NULL
+ *
+ * @api
+ */
+#define chMtxRegister(mp, name)                                             \
+  chSyncProfRegister(&(mp)->m_prof, CH_SYNC_MUTEX, name)
+/** @} */
+
+/**
+ * @name    Profiling hooks
+ * @note    Must be invoked from within a lock zone.
+ * @{
+ */
+/**
+ * @brief   Initializes an object profile.
+ *
+ * @notapi
+ */
+#define sync_prof_init(pp) _sync_prof_init(pp)
+
+/**
+ * @brief   Accounts a wait or lock operation.
+ *
+ * @notapi
+ */
+#define sync_prof_acquire(pp) ((pp)->sp_acquisitions++)
+
+/**
+ * @brief   Marks the start of a wait of the current thread.
+ *
+ * @notapi
+ */
+#define sync_prof_wait_start() (currp->p_wtstart = port_rt_get_counter_value())
+
+/**
+ * @brief   Marks the end of a wait of the current thread.
+ *
+ * @notapi
+ */
+#define sync_prof_wait_end(pp) _sync_prof_wait_end(pp)
+
+/**
+ * @brief   Accounts a priority inheritance boost.
+ *
+ * @notapi
+ */
+#define sync_prof_boost(pp) ((pp)->sp_boosts++)
+
+/**
+ * @brief   Marks the start of a mutex ownership.
+ *
+ * @notapi
+ */
+#define sync_prof_hold_start(pp)                                            \
+  ((pp)->sp_hold_start = port_rt_get_counter_value())
+
+/**
+ * @brief   Marks the end of a mutex ownership.
+ *
+ * @notapi
+ */
+#define sync_prof_hold_end(pp) _sync_prof_hold_end(pp)
+/** @} */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+  void _sync_prof_init(ch_sync_profile_t *pp);
+  void _sync_prof_wait_end(ch_sync_profile_t *pp);
+  void _sync_prof_hold_end(ch_sync_profile_t *pp);
+  void chSyncProfRegister(ch_sync_profile_t *pp, uint8_t type,
+                          const char *name);
+  void chSyncProfUnregister(ch_sync_profile_t *pp);
+  void chSyncProfReset(ch_sync_profile_t *pp);
+  unsigned chSyncProfGetTop(ch_sync_profile_t *pa, unsigned n);
+#ifdef __cplusplus
+}
+#endif
+
+#else /* !CH_DBG_SYNC_PROFILING */
+
+/* When the profiling is disabled the hooks are replaced by empty macros.*/
+#define sync_prof_init(pp)
+#define sync_prof_acquire(pp)
+#define sync_prof_wait_start()
+#define sync_prof_wait_end(pp)
+#define sync_prof_boost(pp)
+#define sync_prof_hold_start(pp)
+#define sync_prof_hold_end(pp)
+
+#endif /* !CH_DBG_SYNC_PROFILING */
+
+#endif /* _CHSYNCPROF_H_ */
+
+/** @} */
@@ -80,6 +80,8 @@
  */
 #define chSysSwitch(ntp, otp) {                                             \
   dbg_trace(otp);                                                           \
+  dbg_acct_switch(otp);                                                     \
+  stats_switch(otp);                                                        \
   THREAD_CONTEXT_SWITCH_HOOK(ntp, otp);                                     \
   port_switch(ntp, otp);                                                    \
 }
@@ -195,7 +197,10 @@
  */
 #define CH_IRQ_PROLOGUE()                                                   \
   PORT_IRQ_PROLOGUE();                                                      \
-  dbg_check_enter_isr();
+  dbg_check_enter_isr();                                                    \
+  stats_isr();                                                              \
+  dbg_acct_isr_enter();                                                     \
+  dbg_trace_isr_enter();
 
 /**
  * @brief   IRQ handler exit code.
@@ -206,6 +211,8 @@
  * @special
  */
 #define CH_IRQ_EPILOGUE()                                                   \
+  dbg_trace_isr_leave();                                                    \
+  dbg_acct_isr_leave();                                                     \
   dbg_check_leave_isr();                                                    \
   PORT_IRQ_EPILOGUE();
 
@@ -107,6 +107,12 @@ struct Thread {
    * @brief Thread stack boundary.
    */
   stkalign_t            *p_stklimit;
+#endif
+#if CH_DBG_FILL_THREADS || defined(__DOXYGEN__)
+  /**
+   * @brief Thread working area size or zero if not known.
+   */
+  size_t                p_wasize;
 #endif
   /**
    * @brief Current thread state.
@@ -134,6 +140,26 @@ struct Thread {
    * @note  This field can overflow.
    */
   volatile systime_t    p_time;
+#endif
+#if CH_DBG_CPU_ACCOUNTING || defined(__DOXYGEN__)
+  /**
+   * @brief Thread consumed time in free running counter cycles, the time
+   *        spent in interrupt handlers is not included.
+   */
+  uint64_t              p_cycles;
+#endif
+#if CH_DBG_SYNC_PROFILING || defined(__DOXYGEN__)
+  /**
+   * @brief Start time of the current wait on a semaphore or mutex.
+   */
+  uint32_t              p_wtstart;
+#endif
+#if CH_DBG_STATISTICS || defined(__DOXYGEN__)
+  /**
+   * @brief Number of times the thread has been made ready.
+   * @note  This field can overflow.
+   */
+  uint32_t              p_wakeups;
 #endif
   /**
    * @brief State-specific fields.
@@ -210,6 +236,12 @@ struct Thread {
    */
   void                  *p_mpool;
 #endif
+#if CH_USE_ARENAS || defined(__DOXYGEN__)
+  /**
+   * @brief Thread default memory arena or @p NULL.
+   */
+  MemoryArena           *p_arena;
+#endif
 #if defined(THREAD_EXT_FIELDS)
   /* Extra fields defined in chconf.h.*/
   THREAD_EXT_FIELDS
@@ -0,0 +1,203 @@
+/*
+    ChibiOS/RT - Copyright (C) 2006,2007,2008,2009,2010,
+                 2011,2012,2013 Giovanni Di Sirio.
+
+    This file is part of ChibiOS/RT.
+
+    ChibiOS/RT is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    ChibiOS/RT is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * @file    chtopics.h
+ * @brief   Topics macros and structures.
+ *
+ * @addtogroup topics
+ * @{
+ */
+
+#ifndef _CHTOPICS_H_
+#define _CHTOPICS_H_
+
+#if CH_USE_TOPICS || defined(__DOXYGEN__)
+
+/*
+ * Module dependencies check.
+ */
+#if !CH_USE_EVENTS
+#error "CH_USE_TOPICS requires CH_USE_EVENTS"
+#endif
+
+/**
+ * @brief   Subscription depth of a latest-value subscriber.
+ */
+#define TOPIC_LATEST            0
+
+/**
+ * @brief   Event flag broadcast on each publish.
+ */
+#define TOPIC_PUBLISHED         ((flagsmask_t)1)
+
+/**
+ * @brief   Structure representing a topic.
+ */
+typedef struct {
+  uint8_t               *t_buffer;      /**< @brief Pointer to the messages
+                                                    buffer.                 */
+  size_t                t_size;         /**< @brief Size of a message.      */
+  uint32_t              t_mask;         /**< @brief Number of message slots
+                                                    minus one.              */
+  volatile uint32_t     t_begin;        /**< @brief Number of started
+                                                    publishes.              */
+  volatile uint32_t     t_end;          /**< @brief Number of completed
+                                                    publishes.              */
+  systime_t             t_last;         /**< @brief Time of the last
+                                                    publish.                */
+  EventSource           t_es;           /**< @brief Publish event source.   */
+} Topic;
+
+/**
+ * @brief   Structure representing a topic subscriber.
+ */
+typedef struct {
+  Topic                 *s_topic;       /**< @brief Subscribed topic.       */
+  EventListener         s_el;           /**< @brief Publish event
+                                                    listener.               */
+  uint32_t              s_next;         /**< @brief Number of the next
+                                                    message to be read.     */
+  uint32_t              s_depth;        /**< @brief Subscription depth or
+                                                    @p TOPIC_LATEST.        */
+  uint32_t              s_received;     /**< @brief Received messages
+                                                    counter.                */
+  uint32_t              s_dropped;      /**< @brief Dropped messages
+                                                    counter.                */
+} TopicSubscriber;
+
+/**
+ * @name    Macro Functions
+ * @{
+ */
+/**
+ * @brief   Returns the number of messages published on a topic.
+ * @note    The counter wraps around, the publish rate is obtained by
+ *          sampling it at known intervals.
+ *
+ * @param[in] tp        pointer to a @p Topic structure
+ * @return              The number of published messages.
+ *
+ * @special
+ */
+#define chTopicGetPublished(tp) ((tp)->t_end)
+
+/**
+ * @brief   Returns the system time of the last publish on a topic.
+ *
+ * @param[in] tp        pointer to a @p Topic structure
+ * @return              The system time of the last publish.
+ *
+ * @special
+ */
+#define chTopicGetLastTime(tp) ((tp)->t_last)
+
+/**
+ * @brief   Returns the number of messages read by a subscriber.
+ *
+ * @param[in] sp        pointer to a @p TopicSubscriber structure
+ * @return              The number of received messages.
+ *
+ * @special
+ */
+#define chTopicGetReceived(sp) ((sp)->s_received)
+
+/**
+ * @brief   Returns the number of messages lost by a subscriber.
+ * @details A message is lost when it is overwritten before the subscriber
+ *          reads it, for latest-value subscribers this happens for every
+ *          message published between two reads except the last one.
+ *
+ * @param[in] sp        pointer to a @p TopicSubscriber structure
+ * @return              The number of dropped messages.
+ *
+ * @special
+ */
+#define chTopicGetDropped(sp) ((sp)->s_dropped)
+
+/**
+ * @brief   Returns the number of unread messages of a subscriber.
+ * @note    The returned value can be larger than the subscription depth,
+ *          the excess messages are dropped by the next read.
+ *
+ * @param[in] sp        pointer to a @p TopicSubscriber structure
+ * @return              The number of messages published and not yet read.
+ *
+ * @special
+ */
+#define chTopicGetPending(sp) ((sp)->s_topic->t_end - (sp)->s_next)
+/** @} */
+
+/**
+ * @brief   Data part of a static topic initializer.
+ * @details This macro should be used when statically initializing a
+ *          topic that is part of a bigger structure.
+ *
+ * @param[in] name      the name of the topic variable
+ * @param[in] buffer    pointer to the messages buffer, it must be able to
+ *                      contain @p depth messages
+ * @param[in] size      size of a message
+ * @param[in] depth     number of message slots, must be a power of two
+ */
+#define _TOPIC_DATA(name, buffer, size, depth) {                            \
+  (uint8_t *)(buffer),                                                      \
+  size,                                                                     \
+  (depth) - 1,                                                              \
+  0,                                                                        \
+  0,                                                                        \
+  0,                                                                        \
+  _EVENTSOURCE_DATA(name.t_es)                                              \
+}
+
+/**
+ * @brief   Static topic initializer.
+ * @details Statically initialized topics require no explicit
+ *          initialization using @p chTopicInit().
+ *
+ * @param[in] name      the name of the topic variable
+ * @param[in] buffer    pointer to the messages buffer, it must be able to
+ *                      contain @p depth messages
+ * @param[in] size      size of a message
+ * @param[in] depth     number of message slots, must be a power of two
+ */
+#define TOPIC_DECL(name, buffer, size, depth)                               \
+  Topic name = _TOPIC_DATA(name, buffer, size, depth)
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+  void chTopicInit(Topic *tp, void *buffer, size_t size, size_t depth);
+  void chTopicPublishI(Topic *tp, const void *msgp);
+  void chTopicPublish(Topic *tp, const void *msgp);
+  void chTopicSubscribe(Topic *tp, TopicSubscriber *sp,
+                        eventmask_t mask, size_t depth);
+  void chTopicUnsubscribe(TopicSubscriber *sp);
+  msg_t chTopicReceive(TopicSubscriber *sp, void *msgp);
+  msg_t chTopicReceiveTimeout(TopicSubscriber *sp, void *msgp,
+                              systime_t time);
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CH_USE_TOPICS */
+
+#endif /* _CHTOPICS_H_ */
+
+/** @} */
@@ -138,6 +138,9 @@ typedef struct {
       vtp->vt_func = (vtfunc_t)NULL;                                        \
       vtp->vt_next->vt_prev = (void *)&vtlist;                              \
       (&vtlist)->vt_next = vtp->vt_next;                                    \
+      stats_vt();                                                           \
+      dbg_trace_event(CH_TRACE_VT, CH_TRACE_TYPE_VT_CALLBACK,               \
+                      fn, vtp->vt_par);                                     \
       chSysUnlockFromIsr();                                                 \
       fn(vtp->vt_par);                                                      \
       chSysLockFromIsr();                                                   \
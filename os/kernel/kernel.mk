@@ -2,6 +2,8 @@
 # from this list, you can disable parts of the kernel by editing chconf.h.
 KERNSRC = ${CHIBIOS}/os/kernel/src/chsys.c \
           ${CHIBIOS}/os/kernel/src/chdebug.c \
+          ${CHIBIOS}/os/kernel/src/chstats.c \
+          ${CHIBIOS}/os/kernel/src/chsyncprof.c \
           ${CHIBIOS}/os/kernel/src/chlists.c \
           ${CHIBIOS}/os/kernel/src/chvt.c \
           ${CHIBIOS}/os/kernel/src/chschd.c \
@@ -12,12 +14,17 @@ KERNSRC = ${CHIBIOS}/os/kernel/src/chsys.c \
           ${CHIBIOS}/os/kernel/src/chmtx.c \
           ${CHIBIOS}/os/kernel/src/chcond.c \
           ${CHIBIOS}/os/kernel/src/chevents.c \
+          ${CHIBIOS}/os/kernel/src/chtopics.c \
           ${CHIBIOS}/os/kernel/src/chmsg.c \
           ${CHIBIOS}/os/kernel/src/chmboxes.c \
+          ${CHIBIOS}/os/kernel/src/chpmboxes.c \
+          ${CHIBIOS}/os/kernel/src/chobjfifos.c \
           ${CHIBIOS}/os/kernel/src/chqueues.c \
+          ${CHIBIOS}/os/kernel/src/chrings.c \
           ${CHIBIOS}/os/kernel/src/chmemcore.c \
           ${CHIBIOS}/os/kernel/src/chheap.c \
-          ${CHIBIOS}/os/kernel/src/chmempools.c
+          ${CHIBIOS}/os/kernel/src/chmempools.c \
+          ${CHIBIOS}/os/kernel/src/charena.c
 
 # Required include directories
 KERNINC = ${CHIBIOS}/os/kernel/include
@@ -0,0 +1,364 @@
+/*
+    ChibiOS/RT - Copyright (C) 2006,2007,2008,2009,2010,
+                 2011,2012,2013 Giovanni Di Sirio.
+
+    This file is part of ChibiOS/RT.
+
+    ChibiOS/RT is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    ChibiOS/RT is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * @file    charena.c
+ * @brief   Memory Arenas code.
+ *
+ * @addtogroup arenas
+ * @details Memory Arenas related APIs and services.
+ *          <h2>Operation mode</h2>
+ *          A Memory Arena allocates objects by simply advancing a pointer
+ *          inside a memory block, objects are not freed individually but
+ *          all together by releasing the arena to a previously taken
+ *          mark. This makes arenas ideal for transient objects having a
+ *          common lifetime, for example all the objects allocated while
+ *          serving a request.<br>
+ *          Blocks are obtained from a Memory Heap, from a provider function
+ *          like @p chCoreAlloc() or are loaded as static buffers, when the
+ *          current block is exhausted a new one is chained. Released blocks
+ *          are kept in the arena and reused by successive allocations,
+ *          @p chArenaTrim() returns them to the heap.<br>
+ *          Optionally each thread can have a default arena, the arena APIs
+ *          use it when a @p NULL arena pointer is specified.
+ * @note    Arenas are not protected against concurrent access, an arena is
+ *          meant to be used by a single thread at time.
+ * @pre     In order to use the memory arenas APIs the @p CH_USE_ARENAS
+ *          option must be enabled in @p chconf.h.
+ * @{
+ */
+
+#include "ch.h"
+
+#if CH_USE_ARENAS || defined(__DOXYGEN__)
+
+/*
+ * Returns a block to the owner allocator, static and core blocks cannot be
+ * returned so they are kept as spare blocks.
+ */
+static bool_t arena_return(MemoryArena *ap, union arena_header *bp) {
+
+#if CH_USE_HEAP
+  if (bp->h.owned && (ap->ma_flags & ARENA_HEAP)) {
+    chHeapFree(bp);
+    return TRUE;
+  }
+#else
+  (void)ap;
+  (void)bp;
+#endif
+  return FALSE;
+}
+
+/*
+ * Makes available a block having at least the specified free space, a spare
+ * block is used if possible else a new block is obtained from the heap or
+ * the provider.
+ */
+static bool_t arena_grow(MemoryArena *ap, size_t size) {
+  union arena_header *bp, **bpp;
+
+  /* Searching for a spare block big enough.*/
+  bpp = &ap->ma_spare;
+  while ((bp = *bpp) != NULL) {
+    if ((size_t)(bp->h.limit - (uint8_t *)(bp + 1)) >= size) {
+      *bpp = bp->h.next;
+      break;
+    }
+    bpp = &bp->h.next;
+  }
+
+  if (bp == NULL) {
+    /* No suitable spare block, getting a new one.*/
+    if (size < ap->ma_size)
+      size = ap->ma_size;
+    size += sizeof(union arena_header);
+#if CH_USE_HEAP
+    if (ap->ma_flags & ARENA_HEAP)
+      bp = chHeapAlloc(ap->ma_heapp, size);
+    else
+#endif
+    if (ap->ma_provider != NULL)
+      bp = ap->ma_provider(size);
+    if (bp == NULL)
+      return FALSE;
+    bp->h.limit = (uint8_t *)bp + size;
+    bp->h.owned = TRUE;
+  }
+
+  /* The new block becomes the head of the chain.*/
+  bp->h.next = ap->ma_current;
+  ap->ma_current = bp;
+  ap->ma_free = (uint8_t *)(bp + 1);
+  ap->ma_limit = bp->h.limit;
+  return TRUE;
+}
+
+/**
+ * @brief   Initializes an empty memory arena.
+ * @note    Without a provider the arena can only use the memory loaded
+ *          using @p chArenaLoadBuffer().
+ *
+ * @param[out] ap       pointer to a @p MemoryArena structure
+ * @param[in] size      default size of the blocks obtained from the provider,
+ *                      bigger blocks are obtained when an allocation does
+ *                      not fit the default size
+ * @param[in] provider  memory provider function for the memory arena or
+ *                      @p NULL if the arena is not allowed to grow
+ *                      automatically
+ *
+ * @init
+ */
+void chArenaInit(MemoryArena *ap, size_t size, memgetfunc_t provider) {
+
+  chDbgCheck(ap != NULL, "chArenaInit");
+
+  ap->ma_free = NULL;
+  ap->ma_limit = NULL;
+  ap->ma_current = NULL;
+  ap->ma_spare = NULL;
+  ap->ma_size = MEM_ALIGN_NEXT(size);
+  ap->ma_provider = provider;
+#if CH_USE_HEAP
+  ap->ma_heapp = NULL;
+#endif
+  ap->ma_flags = 0;
+}
+
+#if CH_USE_HEAP || defined(__DOXYGEN__)
+/**
+ * @brief   Initializes an empty memory arena taking blocks from a heap.
+ * @details Blocks are returned to the heap by @p chArenaTrim().
+ *
+ * @param[out] ap       pointer to a @p MemoryArena structure
+ * @param[in] size      default size of the blocks obtained from the heap,
+ *                      bigger blocks are obtained when an allocation does
+ *                      not fit the default size
+ * @param[in] heapp     pointer to a heap descriptor or @p NULL in order to
+ *                      use the default heap
+ *
+ * @init
+ */
+void chArenaInitHeap(MemoryArena *ap, size_t size, MemoryHeap *heapp) {
+
+  chArenaInit(ap, size, NULL);
+  ap->ma_heapp = heapp;
+  ap->ma_flags = ARENA_HEAP;
+}
+#endif /* CH_USE_HEAP */
+
+/**
+ * @brief   Loads a static buffer into a memory arena.
+ * @details The buffer becomes a spare block of the arena and is used
+ *          before asking for more memory.
+ * @pre     The buffer base must be aligned to the @p stkalign_t type size.
+ *
+ * @param[in] ap        pointer to a @p MemoryArena structure
+ * @param[in] buf       pointer to the buffer
+ * @param[in] size      size of the buffer
+ *
+ * @api
+ */
+void chArenaLoadBuffer(MemoryArena *ap, void *buf, size_t size) {
+  union arena_header *bp = buf;
+
+  chDbgCheck((ap != NULL) && MEM_IS_ALIGNED(buf) &&
+             (size > sizeof(union arena_header)), "chArenaLoadBuffer");
+
+  bp->h.limit = (uint8_t *)buf + MEM_ALIGN_PREV(size);
+  bp->h.owned = FALSE;
+  bp->h.next = ap->ma_spare;
+  ap->ma_spare = bp;
+}
+
+/**
+ * @brief   Allocates an object from a memory arena.
+ * @details The allocated object is guaranteed to be properly aligned for a
+ *          pointer data type (@p stkalign_t).
+ *
+ * @param[in] ap        pointer to a @p MemoryArena structure or @p NULL in
+ *                      order to use the current thread default arena
+ * @param[in] size      the size of the object to be allocated
+ * @return              A pointer to the allocated object.
+ * @retval NULL         if the object cannot be allocated.
+ *
+ * @api
+ */
+void *chArenaAlloc(MemoryArena *ap, size_t size) {
+  void *p;
+
+  if (ap == NULL)
+    ap = currp->p_arena;
+
+  chDbgCheck(ap != NULL, "chArenaAlloc");
+
+  size = MEM_ALIGN_NEXT(size);
+  if (size > (size_t)(ap->ma_limit - ap->ma_free)) {
+    if (!arena_grow(ap, size))
+      return NULL;
+  }
+  p = ap->ma_free;
+  ap->ma_free += size;
+  return p;
+}
+
+/**
+ * @brief   Returns a mark for the current arena position.
+ * @details The mark can be later passed to @p chArenaRelease() in order to
+ *          free all the objects allocated after this call in a single
+ *          operation.
+ *
+ * @param[in] ap        pointer to a @p MemoryArena structure or @p NULL in
+ *                      order to use the current thread default arena
+ * @return              The arena mark.
+ *
+ * @api
+ */
+arenamark_t chArenaGetMark(MemoryArena *ap) {
+
+  if (ap == NULL)
+    ap = currp->p_arena;
+
+  chDbgCheck(ap != NULL, "chArenaGetMark");
+
+  return (arenamark_t)ap->ma_free;
+}
+
+/**
+ * @brief   Releases the objects allocated after a mark.
+ * @details The blocks chained after the mark was taken are moved in the
+ *          spare list for reuse.
+ * @pre     The mark must have been obtained from the same arena using
+ *          @p chArenaGetMark() and must not have been already invalidated
+ *          by releasing the arena to an older mark.
+ *
+ * @param[in] ap        pointer to a @p MemoryArena structure or @p NULL in
+ *                      order to use the current thread default arena
+ * @param[in] mark      the arena mark, @p NULL releases all the objects
+ *
+ * @api
+ */
+void chArenaRelease(MemoryArena *ap, arenamark_t mark) {
+  union arena_header *bp;
+
+  if (ap == NULL)
+    ap = currp->p_arena;
+
+  chDbgCheck(ap != NULL, "chArenaRelease");
+
+  while ((bp = ap->ma_current) != NULL) {
+    if (((uint8_t *)mark >= (uint8_t *)(bp + 1)) &&
+        ((uint8_t *)mark <= bp->h.limit)) {
+      ap->ma_free = mark;
+      return;
+    }
+    ap->ma_current = bp->h.next;
+    bp->h.next = ap->ma_spare;
+    ap->ma_spare = bp;
+    if (ap->ma_current != NULL)
+      ap->ma_limit = ap->ma_current->h.limit;
+  }
+
+  chDbgAssert(mark == NULL, "chArenaRelease(), #1", "invalid mark");
+
+  ap->ma_free = NULL;
+  ap->ma_limit = NULL;
+}
+
+/**
+ * @brief   Returns the spare blocks to the heap.
+ * @note    Static buffers and blocks obtained from a provider are not
+ *          returned and stay in the spare list.
+ *
+ * @param[in] ap        pointer to a @p MemoryArena structure or @p NULL in
+ *                      order to use the current thread default arena
+ *
+ * @api
+ */
+void chArenaTrim(MemoryArena *ap) {
+  union arena_header *bp, **bpp;
+
+  if (ap == NULL)
+    ap = currp->p_arena;
+
+  chDbgCheck(ap != NULL, "chArenaTrim");
+
+  bpp = &ap->ma_spare;
+  while ((bp = *bpp) != NULL) {
+    *bpp = bp->h.next;
+    if (!arena_return(ap, bp)) {
+      bp->h.next = *bpp;
+      *bpp = bp;
+      bpp = &bp->h.next;
+    }
+  }
+}
+
+/**
+ * @brief   Reports the arena status.
+ * @note    This function is meant to be used in the test suite, it should
+ *          not be really useful for the application code.
+ *
+ * @param[in] ap        pointer to a @p MemoryArena structure or @p NULL in
+ *                      order to use the current thread default arena
+ * @param[in] sizep     pointer to a variable that will receive the space
+ *                      allocated in the current block or @p NULL
+ * @return              The number of blocks in the chain.
+ *
+ * @api
+ */
+size_t chArenaStatus(MemoryArena *ap, size_t *sizep) {
+  union arena_header *bp;
+  size_t n;
+
+  if (ap == NULL)
+    ap = currp->p_arena;
+
+  chDbgCheck(ap != NULL, "chArenaStatus");
+
+  for (n = 0, bp = ap->ma_current; bp != NULL; n++, bp = bp->h.next)
+    ;
+  if (sizep != NULL)
+    *sizep = ap->ma_current != NULL ?
+             (size_t)(ap->ma_free - (uint8_t *)(ap->ma_current + 1)) : 0;
+  return n;
+}
+
+/**
+ * @brief   Sets the default arena of the current thread.
+ * @details The default arena is used by the arena APIs when a @p NULL
+ *          arena pointer is specified.
+ *
+ * @param[in] ap        pointer to a @p MemoryArena structure or @p NULL
+ * @return              The previous default arena.
+ *
+ * @api
+ */
+MemoryArena *chArenaSetDefault(MemoryArena *ap) {
+  MemoryArena *oldap;
+
+  oldap = currp->p_arena;
+  currp->p_arena = ap;
+  return oldap;
+}
+
+#endif /* CH_USE_ARENAS */
+
+/** @} */
@@ -39,6 +39,8 @@
  *            - SV#11, misplaced S-class function.
  *            .
  *          - Trace buffer.
+ *          - Threads and interrupts CPU accounting.
+ *          - Critical sections duration monitor.
  *          - Parameters check.
  *          - Kernel assertions.
  *          - Kernel panics.
@@ -50,6 +52,138 @@
 
 #include "ch.h"
 
+/*===========================================================================*/
+/* Critical sections monitor related code and variables.                     */
+/*===========================================================================*/
+
+#if CH_DBG_CRITICAL_MONITOR || defined(__DOXYGEN__)
+/**
+ * @brief   Critical sections monitor state.
+ */
+ch_crit_monitor_t dbg_crit_monitor;
+
+/**
+ * @brief   Marks the start of a critical section.
+ *
+ * @param[in] caller    code address entering the critical section
+ *
+ * @notapi
+ */
+static void crit_enter(void *caller) {
+
+  dbg_crit_monitor.cm_lock = caller;
+  dbg_crit_monitor.cm_start = port_rt_get_counter_value();
+}
+
+/**
+ * @brief   Marks the end of a critical section and updates the statistics.
+ *
+ * @param[out] csp      statistics to be updated
+ * @param[in] caller    code address leaving the critical section
+ *
+ * @notapi
+ */
+static void crit_leave(ch_crit_stats_t *csp, void *caller) {
+  uint32_t d = port_rt_get_counter_value() - dbg_crit_monitor.cm_start;
+  uint32_t n = d >> 1;
+  unsigned i;
+
+  csp->cs_count++;
+  csp->cs_total += d;
+  if (d > csp->cs_max) {
+    csp->cs_max = d;
+    csp->cs_max_lock = dbg_crit_monitor.cm_lock;
+    csp->cs_max_unlock = caller;
+  }
+  for (i = 0; (n != 0) && (i < CH_CRIT_HISTOGRAM_BINS - 1); i++)
+    n >>= 1;
+  csp->cs_histogram[i]++;
+}
+
+/**
+ * @brief   Monitor hook for @p chSysLock().
+ *
+ * @notapi
+ */
+void dbg_crit_lock(void) {
+
+  crit_enter(CH_CRIT_CALLER());
+}
+
+/**
+ * @brief   Monitor hook for @p chSysUnlock().
+ *
+ * @notapi
+ */
+void dbg_crit_unlock(void) {
+
+  crit_leave(&dbg_crit_monitor.cm_thread, CH_CRIT_CALLER());
+}
+
+/**
+ * @brief   Monitor hook for @p chSysLockFromIsr().
+ *
+ * @notapi
+ */
+void dbg_crit_lock_from_isr(void) {
+
+  crit_enter(CH_CRIT_CALLER());
+}
+
+/**
+ * @brief   Monitor hook for @p chSysUnlockFromIsr().
+ *
+ * @notapi
+ */
+void dbg_crit_unlock_from_isr(void) {
+
+  crit_leave(&dbg_crit_monitor.cm_isr, CH_CRIT_CALLER());
+}
+
+/**
+ * @brief   Returns the critical sections statistics.
+ * @note    A critical section entered before a context switch and left by
+ *          another thread is measured as a single section, this is the
+ *          actual interval with interrupts masked.
+ *
+ * @param[out] thdp     statistics of the sections entered at thread level,
+ *                      can be @p NULL
+ * @param[out] isrp     statistics of the sections entered from ISRs, can
+ *                      be @p NULL
+ *
+ * @api
+ */
+void chDbgCritGetStats(ch_crit_stats_t *thdp, ch_crit_stats_t *isrp) {
+
+  chSysLock();
+  if (thdp != NULL)
+    *thdp = dbg_crit_monitor.cm_thread;
+  if (isrp != NULL)
+    *isrp = dbg_crit_monitor.cm_isr;
+  chSysUnlock();
+}
+
+/**
+ * @brief   Resets the critical sections statistics.
+ *
+ * @api
+ */
+void chDbgCritResetStats(void) {
+  unsigned i;
+
+  chSysLock();
+  dbg_crit_monitor.cm_thread.cs_count = 0;
+  dbg_crit_monitor.cm_thread.cs_max = 0;
+  dbg_crit_monitor.cm_thread.cs_max_lock = NULL;
+  dbg_crit_monitor.cm_thread.cs_max_unlock = NULL;
+  dbg_crit_monitor.cm_thread.cs_total = 0;
+  for (i = 0; i < CH_CRIT_HISTOGRAM_BINS; i++)
+    dbg_crit_monitor.cm_thread.cs_histogram[i] = 0;
+  dbg_crit_monitor.cm_isr = dbg_crit_monitor.cm_thread;
+  chSysUnlock();
+}
+#endif /* CH_DBG_CRITICAL_MONITOR */
+
 /*===========================================================================*/
 /* System state checker related code and variables.                          */
 /*===========================================================================*/
@@ -109,6 +243,9 @@ void dbg_check_lock(void) {
   if ((dbg_isr_cnt != 0) || (dbg_lock_cnt != 0))
     chDbgPanic("SV#4");
   dbg_enter_lock();
+#if CH_DBG_CRITICAL_MONITOR
+  crit_enter(CH_CRIT_CALLER());
+#endif
 }
 
 /**
@@ -121,6 +258,9 @@ void dbg_check_unlock(void) {
   if ((dbg_isr_cnt != 0) || (dbg_lock_cnt <= 0))
     chDbgPanic("SV#5");
   dbg_leave_lock();
+#if CH_DBG_CRITICAL_MONITOR
+  crit_leave(&dbg_crit_monitor.cm_thread, CH_CRIT_CALLER());
+#endif
 }
 
 /**
@@ -133,6 +273,9 @@ void dbg_check_lock_from_isr(void) {
   if ((dbg_isr_cnt <= 0) || (dbg_lock_cnt != 0))
     chDbgPanic("SV#6");
   dbg_enter_lock();
+#if CH_DBG_CRITICAL_MONITOR
+  crit_enter(CH_CRIT_CALLER());
+#endif
 }
 
 /**
@@ -145,6 +288,9 @@ void dbg_check_unlock_from_isr(void) {
   if ((dbg_isr_cnt <= 0) || (dbg_lock_cnt <= 0))
     chDbgPanic("SV#7");
   dbg_leave_lock();
+#if CH_DBG_CRITICAL_MONITOR
+  crit_leave(&dbg_crit_monitor.cm_isr, CH_CRIT_CALLER());
+#endif
 }
 
 /**
@@ -205,6 +351,90 @@ void chDbgCheckClassS(void) {
 
 #endif /* CH_DBG_SYSTEM_STATE_CHECK */
 
+/*===========================================================================*/
+/* Dump related code, shared by the trace and the sampling profiler.         */
+/*===========================================================================*/
+
+#if CH_DBG_ENABLE_TRACE || CH_DBG_PROFILER || defined(__DOXYGEN__)
+/**
+ * @brief   Writes a 32 bits value on the stream in native endianness.
+ */
+static void dump_u32(BaseSequentialStream *chp, uint32_t v) {
+
+  chSequentialStreamWrite(chp, (const uint8_t *)&v, sizeof v);
+}
+
+/**
+ * @brief   Writes a pointer on the stream in native endianness.
+ */
+static void dump_ptr(BaseSequentialStream *chp, const void *p) {
+
+  chSequentialStreamWrite(chp, (const uint8_t *)&p, sizeof p);
+}
+
+/**
+ * @brief   Writes a name field on the stream.
+ * @details The name is truncated or zero padded to @p CH_TRACE_NAME_SIZE.
+ */
+static void dump_name(BaseSequentialStream *chp, const char *name) {
+  uint8_t buf[CH_TRACE_NAME_SIZE];
+  unsigned i = 0;
+
+  if (name != NULL)
+    while ((i < CH_TRACE_NAME_SIZE) && (name[i] != '\0')) {
+      buf[i] = (uint8_t)name[i];
+      i++;
+    }
+  while (i < CH_TRACE_NAME_SIZE)
+    buf[i++] = 0;
+  chSequentialStreamWrite(chp, buf, CH_TRACE_NAME_SIZE);
+}
+
+/**
+ * @brief   Counts the threads in the registry.
+ */
+static uint32_t dump_count_threads(void) {
+  uint32_t n = 0;
+
+#if CH_USE_REGISTRY
+  Thread *tp = chRegFirstThread();
+  do {
+    n++;
+    tp = chRegNextThread(tp);
+  } while (tp != NULL);
+#endif
+  return n;
+}
+
+/**
+ * @brief   Writes the threads table on the stream.
+ * @details Pointer and name of the first @p n threads in the registry, the
+ *          table is empty if the registry is disabled.
+ */
+static void dump_threads(BaseSequentialStream *chp, uint32_t n) {
+
+#if CH_USE_REGISTRY
+  Thread *tp = chRegFirstThread();
+  while (n-- > 0) {
+    /* Threads terminated after the count are dumped as empty entries.*/
+    dump_ptr(chp, tp);
+    dump_name(chp, tp != NULL ? tp->p_name : NULL);
+    if (tp != NULL)
+      tp = chRegNextThread(tp);
+  }
+#if CH_USE_DYNAMIC
+  /* Threads created after the count are not listed, releasing the
+     reference of the last one.*/
+  if (tp != NULL)
+    chThdRelease(tp);
+#endif
+#else
+  (void)chp;
+  (void)n;
+#endif
+}
+#endif /* CH_DBG_ENABLE_TRACE || CH_DBG_PROFILER */
+
 /*===========================================================================*/
 /* Trace related code and variables.                                         */
 /*===========================================================================*/
@@ -215,6 +445,35 @@ void chDbgCheckClassS(void) {
  */
 ch_trace_buffer_t dbg_trace_buffer;
 
+/**
+ * @brief   Allocates the next record in the trace buffer.
+ * @details The record type, timestamp and current thread are filled.
+ *
+ * @param[in] type      the event type
+ * @return              The pointer to the record.
+ * @retval NULL         if the recording is suspended.
+ *
+ * @notapi
+ */
+static ch_trace_event_t *trace_next(uint8_t type) {
+  ch_trace_event_t *tep;
+
+  if (dbg_trace_buffer.tb_frozen)
+    return NULL;
+  tep = dbg_trace_buffer.tb_ptr;
+  if (++dbg_trace_buffer.tb_ptr >=
+      &dbg_trace_buffer.tb_buffer[CH_TRACE_BUFFER_SIZE])
+    dbg_trace_buffer.tb_ptr = &dbg_trace_buffer.tb_buffer[0];
+  dbg_trace_buffer.tb_count++;
+  if ((dbg_trace_buffer.tb_window > 0) && (--dbg_trace_buffer.tb_window == 0))
+    dbg_trace_buffer.tb_frozen = TRUE;
+  tep->te_time  = CH_TRACE_TIMESTAMP();
+  tep->te_type  = type;
+  tep->te_state = 0;
+  tep->te_tp    = currp;
+  return tep;
+}
+
 /**
  * @brief   Trace circular buffer subsystem initialization.
  * @note    Internal use only.
@@ -223,6 +482,9 @@ void _trace_init(void) {
 
   dbg_trace_buffer.tb_size = CH_TRACE_BUFFER_SIZE;
   dbg_trace_buffer.tb_ptr = &dbg_trace_buffer.tb_buffer[0];
+  dbg_trace_buffer.tb_count = 0;
+  dbg_trace_buffer.tb_frozen = FALSE;
+  dbg_trace_buffer.tb_window = 0;
 }
 
 /**
@@ -233,17 +495,484 @@ void _trace_init(void) {
  * @notapi
  */
 void dbg_trace(Thread *otp) {
+  ch_trace_event_t *tep;
+
+  if ((CH_TRACE_MASK & CH_TRACE_SWITCH) == 0)
+    return;
+  tep = trace_next(CH_TRACE_TYPE_SWITCH);
+  if (tep != NULL) {
+    tep->te_state = (uint8_t)otp->p_state;
+    tep->te_objp  = otp->p_u.wtobjp;
+    tep->te_arg   = otp;
+  }
+}
 
-  dbg_trace_buffer.tb_ptr->se_time   = chTimeNow();
-  dbg_trace_buffer.tb_ptr->se_tp     = currp;
-  dbg_trace_buffer.tb_ptr->se_wtobjp = otp->p_u.wtobjp;
-  dbg_trace_buffer.tb_ptr->se_state  = (uint8_t)otp->p_state;
-  if (++dbg_trace_buffer.tb_ptr >=
-      &dbg_trace_buffer.tb_buffer[CH_TRACE_BUFFER_SIZE])
-    dbg_trace_buffer.tb_ptr = &dbg_trace_buffer.tb_buffer[0];
+/**
+ * @brief   Inserts in the circular debug trace buffer a generic record.
+ * @note    Use the @p dbg_trace_event() macro in order to have the event
+ *          filtered by class at compile time.
+ *
+ * @param[in] type      the event type
+ * @param[in] objp      the event object
+ * @param[in] arg       the event argument
+ *
+ * @notapi
+ */
+void dbg_trace_write(uint8_t type, void *objp, void *arg) {
+  ch_trace_event_t *tep;
+
+  tep = trace_next(type);
+  if (tep != NULL) {
+    tep->te_objp = objp;
+    tep->te_arg  = arg;
+  }
+}
+
+/**
+ * @brief   Inserts in the circular debug trace buffer an ISR record.
+ * @details The record is written in its own lock zone because the IRQ
+ *          prologue and epilogue are outside any critical zone.
+ *
+ * @param[in] type      the event type
+ *
+ * @notapi
+ */
+void dbg_trace_isr(uint8_t type) {
+
+  port_lock_from_isr();
+  dbg_trace_write(type, NULL, NULL);
+  port_unlock_from_isr();
+}
+
+/**
+ * @brief   Inserts an user marker in the trace buffer.
+ * @note    Markers are recorded only if the @p CH_TRACE_USER class is
+ *          enabled in @p CH_TRACE_MASK.
+ *
+ * @param[in] name      the marker name, only the first
+ *                      @p CH_TRACE_NAME_SIZE characters are dumped
+ * @param[in] arg       an user parameter
+ *
+ * @iclass
+ */
+void chDbgTraceMarkerI(const char *name, void *arg) {
+
+  chDbgCheckClassI();
+
+  dbg_trace_event(CH_TRACE_USER, CH_TRACE_TYPE_USER, name, arg);
+}
+
+/**
+ * @brief   Inserts an user marker in the trace buffer.
+ * @note    Markers are recorded only if the @p CH_TRACE_USER class is
+ *          enabled in @p CH_TRACE_MASK.
+ *
+ * @param[in] name      the marker name, only the first
+ *                      @p CH_TRACE_NAME_SIZE characters are dumped
+ * @param[in] arg       an user parameter
+ *
+ * @api
+ */
+void chDbgTraceMarker(const char *name, void *arg) {
+
+  chSysLock();
+  chDbgTraceMarkerI(name, arg);
+  chSysUnlock();
+}
+
+/**
+ * @brief   Suspends the trace recording.
+ *
+ * @iclass
+ */
+void chDbgTraceSuspendI(void) {
+
+  chDbgCheckClassI();
+
+  dbg_trace_buffer.tb_frozen = TRUE;
+}
+
+/**
+ * @brief   Resumes the trace recording.
+ * @details Any pending trigger is cancelled.
+ *
+ * @iclass
+ */
+void chDbgTraceResumeI(void) {
+
+  chDbgCheckClassI();
+
+  dbg_trace_buffer.tb_window = 0;
+  dbg_trace_buffer.tb_frozen = FALSE;
+}
+
+/**
+ * @brief   Arms the trace trigger.
+ * @details The recording is suspended after @p n further events, this way
+ *          the buffer contains the events around the trigger point. The
+ *          trigger is typically invoked when an anomaly is detected.
+ * @note    The trace buffer is also frozen by @p chDbgPanic().
+ *
+ * @param[in] n         number of events to be recorded after the trigger,
+ *                      zero freezes the trace immediately
+ *
+ * @iclass
+ */
+void chDbgTraceTriggerI(unsigned n) {
+
+  chDbgCheckClassI();
+
+  if (dbg_trace_buffer.tb_frozen)
+    return;
+  if (n == 0)
+    dbg_trace_buffer.tb_frozen = TRUE;
+  else if ((dbg_trace_buffer.tb_window == 0) ||
+           (n < dbg_trace_buffer.tb_window))
+    dbg_trace_buffer.tb_window = n;
+}
+
+/**
+ * @brief   Dumps the trace buffer on a stream.
+ * @details The dump is a binary image meant to be decoded by the
+ *          @p tools/trace/chtrace2json.py script, all the fields are in
+ *          the target native endianness:
+ *          - Header: magic, version (byte), pointer size (byte), two
+ *            padding bytes, timestamp frequency, threads number, events
+ *            number (32 bits fields).
+ *          - Threads table: pointer and name of each thread in the
+ *            registry, the table is empty if the registry is disabled.
+ *          - Events, oldest first: timestamp (32 bits), type (byte),
+ *            state (byte), two padding bytes, thread, object and argument
+ *            pointers. User markers are followed by their name.
+ *          .
+ * @note    The recording is suspended during the dump, the previous
+ *          state is restored after.
+ * @note    The names are read during the dump, markers and threads names
+ *          must be static strings.
+ *
+ * @param[in] chp       pointer to a @p BaseSequentialStream implementation
+ *
+ * @api
+ */
+void chDbgTraceDump(BaseSequentialStream *chp) {
+  ch_trace_event_t *tep;
+  uint32_t n, nthreads;
+  uint8_t hdr[4];
+  bool_t frozen;
+
+  chDbgCheck(chp != NULL, "chDbgTraceDump");
+
+  chSysLock();
+  frozen = dbg_trace_buffer.tb_frozen;
+  dbg_trace_buffer.tb_frozen = TRUE;
+  chSysUnlock();
+
+  nthreads = dump_count_threads();
+  n = dbg_trace_buffer.tb_count < CH_TRACE_BUFFER_SIZE ?
+      dbg_trace_buffer.tb_count : CH_TRACE_BUFFER_SIZE;
+
+  dump_u32(chp, CH_TRACE_MAGIC);
+  hdr[0] = CH_TRACE_VERSION;
+  hdr[1] = sizeof (void *);
+  hdr[2] = hdr[3] = 0;
+  chSequentialStreamWrite(chp, hdr, sizeof hdr);
+  dump_u32(chp, CH_TRACE_TIMESTAMP_FREQUENCY);
+  dump_u32(chp, nthreads);
+  dump_u32(chp, n);
+
+  dump_threads(chp, nthreads);
+
+  tep = dbg_trace_buffer.tb_ptr - n;
+  if (tep < &dbg_trace_buffer.tb_buffer[0])
+    tep += CH_TRACE_BUFFER_SIZE;
+  while (n-- > 0) {
+    dump_u32(chp, tep->te_time);
+    hdr[0] = tep->te_type;
+    hdr[1] = tep->te_state;
+    chSequentialStreamWrite(chp, hdr, sizeof hdr);
+    dump_ptr(chp, tep->te_tp);
+    dump_ptr(chp, tep->te_objp);
+    dump_ptr(chp, tep->te_arg);
+    if (tep->te_type == CH_TRACE_TYPE_USER)
+      dump_name(chp, (const char *)tep->te_objp);
+    if (++tep >= &dbg_trace_buffer.tb_buffer[CH_TRACE_BUFFER_SIZE])
+      tep = &dbg_trace_buffer.tb_buffer[0];
+  }
+
+  chSysLock();
+  dbg_trace_buffer.tb_frozen = frozen;
+  chSysUnlock();
 }
 #endif /* CH_DBG_ENABLE_TRACE */
 
+/*===========================================================================*/
+/* CPU accounting related code and variables.                                */
+/*===========================================================================*/
+
+#if CH_DBG_CPU_ACCOUNTING || defined(__DOXYGEN__)
+/**
+ * @brief   CPU accounting state.
+ */
+ch_cpu_acct_t dbg_cpu_acct;
+
+/**
+ * @brief   Charges the cycles elapsed since the last charge.
+ * @details The cycles are charged to the interrupt being served, if any,
+ *          else to the current thread.
+ *
+ * @param[in] now       current counter value
+ *
+ * @notapi
+ */
+static void acct_charge(uint32_t now) {
+  uint32_t delta = now - dbg_cpu_acct.ac_last;
+
+  dbg_cpu_acct.ac_last = now;
+  if (dbg_cpu_acct.ac_nesting == 0)
+    currp->p_cycles += delta;
+  else if (dbg_cpu_acct.ac_nesting <= CH_ACCT_IRQ_NESTING)
+    dbg_cpu_acct.ac_stack[dbg_cpu_acct.ac_nesting - 1]->is_cycles += delta;
+  else
+    dbg_cpu_acct.ac_stack[CH_ACCT_IRQ_NESTING - 1]->is_cycles += delta;
+}
+
+/**
+ * @brief   CPU accounting initialization.
+ * @note    Internal use only.
+ */
+void _acct_init(void) {
+
+  dbg_cpu_acct.ac_last = port_rt_get_counter_value();
+  dbg_cpu_acct.ac_nesting = 0;
+  dbg_cpu_acct.ac_nsources = 0;
+}
+
+/**
+ * @brief   Charges the thread being switched out.
+ *
+ * @param[in] otp       the thread being switched out
+ *
+ * @notapi
+ */
+void dbg_acct_switch(Thread *otp) {
+  uint32_t now = port_rt_get_counter_value();
+
+  otp->p_cycles += now - dbg_cpu_acct.ac_last;
+  dbg_cpu_acct.ac_last = now;
+}
+
+/**
+ * @brief   Accounts an interrupt handler entry.
+ * @details The interrupted thread or interrupt handler is charged and the
+ *          source of the new interrupt becomes the charged entity. The
+ *          source is identified using @p port_get_irq_source() if the port
+ *          supports it, else all the interrupts share a single record.
+ *
+ * @notapi
+ */
+void dbg_acct_isr_enter(void) {
+  ch_acct_source_t *sp;
+  unsigned i;
+#if PORT_SUPPORTS_IRQ_SOURCE
+  uint32_t id = port_get_irq_source();
+#else
+  uint32_t id = 0;
+#endif
+
+  port_lock_from_isr();
+  acct_charge(port_rt_get_counter_value());
+  for (i = 0; i < dbg_cpu_acct.ac_nsources; i++)
+    if (dbg_cpu_acct.ac_sources[i].is_id == id)
+      break;
+  if (i == dbg_cpu_acct.ac_nsources) {
+    if (i < CH_ACCT_IRQ_SOURCES) {
+      dbg_cpu_acct.ac_sources[i].is_id = id;
+      dbg_cpu_acct.ac_nsources++;
+    }
+    else
+      i = CH_ACCT_IRQ_SOURCES - 1;
+  }
+  sp = &dbg_cpu_acct.ac_sources[i];
+  sp->is_count++;
+  if (dbg_cpu_acct.ac_nesting < CH_ACCT_IRQ_NESTING)
+    dbg_cpu_acct.ac_stack[dbg_cpu_acct.ac_nesting] = sp;
+  dbg_cpu_acct.ac_nesting++;
+  port_unlock_from_isr();
+}
+
+/**
+ * @brief   Accounts an interrupt handler exit.
+ *
+ * @notapi
+ */
+void dbg_acct_isr_leave(void) {
+
+  port_lock_from_isr();
+  acct_charge(port_rt_get_counter_value());
+  dbg_cpu_acct.ac_nesting--;
+  port_unlock_from_isr();
+}
+
+/**
+ * @brief   Charges the current thread with the cycles elapsed since the
+ *          last accounting point.
+ * @details This function is meant to be invoked before reading the
+ *          accounting data, this way the current thread figures are up to
+ *          date.
+ *
+ * @iclass
+ */
+void chDbgAcctUpdateI(void) {
+
+  chDbgCheckClassI();
+
+  acct_charge(port_rt_get_counter_value());
+}
+#endif /* CH_DBG_CPU_ACCOUNTING */
+
+/*===========================================================================*/
+/* Sampling profiler related code and variables.                             */
+/*===========================================================================*/
+
+#if CH_DBG_PROFILER || defined(__DOXYGEN__)
+/**
+ * @brief   Sampling profiler buffer.
+ */
+ch_prof_buffer_t dbg_prof_buffer;
+
+/**
+ * @brief   Records a sample.
+ * @details The sample is the interrupted program counter and the current
+ *          thread, the oldest sample is overwritten when the buffer is
+ *          full.
+ * @note    This function does not use the kernel lock, it is invoked
+ *          either from the system tick handler or from the port sampler
+ *          that, in the simulators, is an host signal handler.
+ *
+ * @param[in] pc        the interrupted program counter
+ *
+ * @notapi
+ */
+void dbg_prof_sample(void *pc) {
+  ch_prof_sample_t *psp;
+
+  if (!dbg_prof_buffer.pb_enabled)
+    return;
+  psp = dbg_prof_buffer.pb_ptr;
+  psp->ps_pc = pc;
+  psp->ps_tp = currp;
+  if (++psp >= &dbg_prof_buffer.pb_buffer[CH_PROF_BUFFER_SIZE])
+    psp = &dbg_prof_buffer.pb_buffer[0];
+  dbg_prof_buffer.pb_ptr = psp;
+  dbg_prof_buffer.pb_count++;
+}
+
+/**
+ * @brief   Starts a profiling session.
+ * @details The samples of the previous session are discarded.
+ *
+ * @api
+ */
+void chDbgProfStart(void) {
+
+  chSysLock();
+  dbg_prof_buffer.pb_enabled = FALSE;
+  dbg_prof_buffer.pb_ptr = &dbg_prof_buffer.pb_buffer[0];
+  dbg_prof_buffer.pb_count = 0;
+  dbg_prof_buffer.pb_enabled = TRUE;
+  chSysUnlock();
+#if PORT_SUPPORTS_PROF_SAMPLER
+  port_prof_start(CH_PROF_FREQUENCY);
+#endif
+}
+
+/**
+ * @brief   Stops the profiling session.
+ * @details The samples are retained until the next session is started.
+ *
+ * @api
+ */
+void chDbgProfStop(void) {
+
+#if PORT_SUPPORTS_PROF_SAMPLER
+  port_prof_stop();
+#endif
+  chSysLock();
+  dbg_prof_buffer.pb_enabled = FALSE;
+  chSysUnlock();
+}
+
+/**
+ * @brief   Dumps the profiler samples on a stream.
+ * @details The dump is a binary image meant to be decoded by the
+ *          @p tools/prof/chprof.py script, all the fields are in the target
+ *          native endianness:
+ *          - Header: magic, version (byte), pointer size (byte), two
+ *            padding bytes, sampling frequency, threads number, samples
+ *            number, samples taken by the session (32 bits fields), the
+ *            address of this function used by the script in order to
+ *            relocate the samples.
+ *          - Threads table: pointer and name of each thread in the
+ *            registry, the table is empty if the registry is disabled.
+ *          - Samples, oldest first: program counter and thread pointers.
+ *          .
+ * @note    The sampling is suspended during the dump, the previous state is
+ *          restored after.
+ *
+ * @param[in] chp       pointer to a @p BaseSequentialStream implementation
+ *
+ * @api
+ */
+void chDbgProfDump(BaseSequentialStream *chp) {
+  ch_prof_sample_t *psp;
+  uint32_t n, nthreads;
+  uint8_t hdr[4];
+  bool_t enabled;
+
+  chDbgCheck(chp != NULL, "chDbgProfDump");
+
+  chSysLock();
+  enabled = dbg_prof_buffer.pb_enabled;
+  dbg_prof_buffer.pb_enabled = FALSE;
+  chSysUnlock();
+
+  nthreads = dump_count_threads();
+  n = dbg_prof_buffer.pb_count < CH_PROF_BUFFER_SIZE ?
+      dbg_prof_buffer.pb_count : CH_PROF_BUFFER_SIZE;
+
+  dump_u32(chp, CH_PROF_MAGIC);
+  hdr[0] = CH_PROF_VERSION;
+  hdr[1] = sizeof (void *);
+  hdr[2] = hdr[3] = 0;
+  chSequentialStreamWrite(chp, hdr, sizeof hdr);
+#if PORT_SUPPORTS_PROF_SAMPLER
+  dump_u32(chp, CH_PROF_FREQUENCY);
+#else
+  dump_u32(chp, CH_FREQUENCY);
+#endif
+  dump_u32(chp, nthreads);
+  dump_u32(chp, n);
+  dump_u32(chp, dbg_prof_buffer.pb_count);
+  dump_ptr(chp, (void *)chDbgProfDump);
+
+  dump_threads(chp, nthreads);
+
+  psp = dbg_prof_buffer.pb_ptr - n;
+  if (psp < &dbg_prof_buffer.pb_buffer[0])
+    psp += CH_PROF_BUFFER_SIZE;
+  while (n-- > 0) {
+    dump_ptr(chp, psp->ps_pc);
+    dump_ptr(chp, psp->ps_tp);
+    if (++psp >= &dbg_prof_buffer.pb_buffer[CH_PROF_BUFFER_SIZE])
+      psp = &dbg_prof_buffer.pb_buffer[0];
+  }
+
+  chSysLock();
+  dbg_prof_buffer.pb_enabled = enabled;
+  chSysUnlock();
+}
+#endif /* CH_DBG_PROFILER */
+
 /*===========================================================================*/
 /* Panic related code and variables.                                         */
 /*===========================================================================*/
@@ -264,6 +993,9 @@ const char *dbg_panic_msg;
 void chDbgPanic(const char *msg) {
 
   dbg_panic_msg = msg;
+#if CH_DBG_ENABLE_TRACE
+  dbg_trace_buffer.tb_frozen = TRUE;
+#endif
   chSysHalt();
 }
 #endif /* CH_DBG_ENABLED */
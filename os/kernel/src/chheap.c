@@ -32,7 +32,11 @@
  *          By enabling the @p CH_USE_MALLOC_HEAP option the heap manager
  *          will use the runtime-provided @p malloc() and @p free() as
  *          back end for the heap APIs instead of the system provided
- *          allocator.
+ *          allocator.<br>
+ *          By enabling the @p CH_DBG_HEAP_PROFILING option the heap manager
+ *          keeps track of the allocated memory attributing each block to
+ *          the call site that allocated it, the fragmentation of the free
+ *          space can be inspected using @p chHeapGetProfile().
  * @pre     In order to use the heap APIs the @p CH_USE_HEAP option must
  *          be enabled in @p chconf.h.
  * @{
@@ -55,6 +59,69 @@
 #define H_UNLOCK(h)     chSemSignal(&(h)->h_sem)
 #endif
 
+#if CH_DBG_HEAP_PROFILING || defined(__DOXYGEN__)
+/**
+ * @brief   Returns the address of the caller of the current function.
+ */
+#if !defined(HEAP_CALLER) || defined(__DOXYGEN__)
+#if defined(__GNUC__) || defined(__DOXYGEN__)
+#define HEAP_CALLER()   __builtin_return_address(0)
+#else
+#define HEAP_CALLER()   NULL
+#endif
+#endif
+
+/**
+ * @brief   Heap profiler call sites table.
+ */
+ch_heap_site_t dbg_heap_sites[CH_HEAP_PROFILE_SITES];
+
+/*
+ * Accounts an allocated block, the block is attributed to the call site,
+ * when the table is full the last entry is used.
+ */
+static void heap_profile_alloc(MemoryHeap *heapp, union heap_header *hp,
+                               void *caller) {
+  ch_heap_site_t *sp;
+
+  chSysLock();
+  for (sp = &dbg_heap_sites[0];
+       sp < &dbg_heap_sites[CH_HEAP_PROFILE_SITES - 1];
+       sp++) {
+    if (sp->hs_caller == caller)
+      break;
+    if (sp->hs_caller == NULL) {
+      sp->hs_caller = caller;
+      break;
+    }
+  }
+  sp->hs_bytes += hp->h.size;
+  sp->hs_count++;
+  sp->hs_allocs++;
+  hp->h.site = sp;
+  heapp->h_used += hp->h.size;
+  if (heapp->h_used > heapp->h_peak)
+    heapp->h_peak = heapp->h_used;
+  chSysUnlock();
+}
+
+/*
+ * Accounts a freed block.
+ */
+static void heap_profile_free(MemoryHeap *heapp, union heap_header *hp) {
+
+  chSysLock();
+  hp->h.site->hs_bytes -= hp->h.size;
+  hp->h.site->hs_count--;
+  heapp->h_used -= hp->h.size;
+  chSysUnlock();
+}
+#else /* !CH_DBG_HEAP_PROFILING */
+#define HEAP_CALLER()   NULL
+#define heap_profile_alloc(heapp, hp, caller)
+#define heap_profile_free(heapp, hp)
+#endif /* !CH_DBG_HEAP_PROFILING */
+
 /**
  * @brief   Default heap descriptor.
  */
@@ -74,6 +141,10 @@ void _heap_init(void) {
 #else
   chSemInit(&default_heap.h_sem, 1);
 #endif
+#if CH_DBG_HEAP_PROFILING
+  default_heap.h_used = 0;
+  default_heap.h_peak = 0;
+#endif
 }
 
 /**
@@ -104,6 +175,10 @@ void chHeapInit(MemoryHeap *heapp, void *buf, size_t size) {
 #else
   chSemInit(&heapp->h_sem, 1);
 #endif
+#if CH_DBG_HEAP_PROFILING
+  heapp->h_used = 0;
+  heapp->h_peak = 0;
+#endif
 }
 
 /**
@@ -124,6 +199,9 @@ void chHeapInit(MemoryHeap *heapp, void *buf, size_t size) {
  */
 void *chHeapAlloc(MemoryHeap *heapp, size_t size) {
   union heap_header *qp, *hp, *fp;
+#if CH_DBG_HEAP_PROFILING
+  void *caller = HEAP_CALLER();
+#endif
 
   if (heapp == NULL)
     heapp = &default_heap;
@@ -152,6 +230,7 @@ void *chHeapAlloc(MemoryHeap *heapp, size_t size) {
       hp->h.u.heap = heapp;
 
       H_UNLOCK(heapp);
+      heap_profile_alloc(heapp, hp, caller);
       return (void *)(hp + 1);
     }
     qp = hp;
@@ -166,6 +245,7 @@ void *chHeapAlloc(MemoryHeap *heapp, size_t size) {
     if (hp != NULL) {
       hp->h.u.heap = heapp;
       hp->h.size = size;
+      heap_profile_alloc(heapp, hp, caller);
       hp++;
       return (void *)hp;
     }
@@ -193,6 +273,7 @@ void chHeapFree(void *p) {
   hp = (union heap_header *)p - 1;
   heapp = hp->h.u.heap;
   qp = &heapp->h_free;
+  heap_profile_free(heapp, hp);
   H_LOCK(heapp);
 
   while (TRUE) {
@@ -259,6 +340,179 @@ size_t chHeapStatus(MemoryHeap *heapp, size_t *sizep) {
   return n;
 }
 
+#if CH_DBG_HEAP_PROFILING || defined(__DOXYGEN__)
+/**
+ * @brief   Returns the profile of a heap.
+ * @details The free list is scanned in order to report the total free
+ *          space, the number of fragments, the largest free block and the
+ *          free blocks size histogram.
+ * @note    The allocated bytes count does not include the blocks headers.
+ *
+ * @param[in] heapp     pointer to a heap descriptor or @p NULL in order to
+ *                      access the default heap.
+ * @param[out] hpp      pointer to a @p ch_heap_profile_t structure
+ *
+ * @api
+ */
+void chHeapGetProfile(MemoryHeap *heapp, ch_heap_profile_t *hpp) {
+  union heap_header *qp;
+  unsigned i;
+
+  chDbgCheck(hpp != NULL, "chHeapGetProfile");
+
+  if (heapp == NULL)
+    heapp = &default_heap;
+
+  hpp->hp_free = 0;
+  hpp->hp_fragments = 0;
+  hpp->hp_largest = 0;
+  for (i = 0; i < CH_HEAP_HISTOGRAM_BINS; i++)
+    hpp->hp_histogram[i] = 0;
+
+  H_LOCK(heapp);
+  for (qp = heapp->h_free.h.u.next; qp != NULL; qp = qp->h.u.next) {
+    size_t sz = qp->h.size >> 5;
+
+    hpp->hp_free += qp->h.size;
+    hpp->hp_fragments++;
+    if (qp->h.size > hpp->hp_largest)
+      hpp->hp_largest = qp->h.size;
+    for (i = 0; (sz != 0) && (i < CH_HEAP_HISTOGRAM_BINS - 1); i++)
+      sz >>= 1;
+    hpp->hp_histogram[i]++;
+  }
+  chSysLock();
+  hpp->hp_used = heapp->h_used;
+  hpp->hp_peak = heapp->h_peak;
+  chSysUnlock();
+  H_UNLOCK(heapp);
+}
+
+/**
+ * @brief   Resets the allocated bytes high-water mark of a heap.
+ *
+ * @param[in] heapp     pointer to a heap descriptor or @p NULL in order to
+ *                      access the default heap.
+ *
+ * @api
+ */
+void chHeapResetPeak(MemoryHeap *heapp) {
+
+  if (heapp == NULL)
+    heapp = &default_heap;
+
+  chSysLock();
+  heapp->h_peak = heapp->h_used;
+  chSysUnlock();
+}
+
+/*
+ * Appends a value to the dump buffer in native byte order.
+ */
+static uint8_t *dump_put(uint8_t *bp, const void *p, size_t n) {
+  const uint8_t *sp = p;
+
+  while (n--)
+    *bp++ = *sp++;
+  return bp;
+}
+
+static uint8_t *dump_u16(uint8_t *bp, size_t n) {
+  uint16_t v = (uint16_t)n;
+
+  return dump_put(bp, &v, sizeof v);
+}
+
+static uint8_t *dump_u32(uint8_t *bp, size_t n) {
+  uint32_t v = (uint32_t)n;
+
+  return dump_put(bp, &v, sizeof v);
+}
+
+/**
+ * @brief   Writes a binary dump of the heap profile into a buffer.
+ * @details The dump is meant to be transferred to an host and decoded by
+ *          the @p heapreport.py tool, all the fields are written in the
+ *          native byte order and the host detects it from the magic
+ *          number. The dump is composed of:
+ *          - A 16 bytes header: magic (32 bits), format version (16 bits),
+ *            pointer size (8 bits), padding (8 bits), number of histogram
+ *            bins (16 bits), number of call sites (16 bits), reserved
+ *            (32 bits).
+ *          - The allocated bytes, peak, free bytes, fragments and largest
+ *            free block (32 bits each).
+ *          - The histogram bins (32 bits each).
+ *          - The call sites records, each one composed of the call site
+ *            address (pointer size) followed by the live bytes, the live
+ *            blocks and the total allocations (32 bits each).
+ *          .
+ * @note    The call sites table is global so the sites are shared among
+ *          all the heaps.
+ * @note    The call sites are copied one at a time, each record is
+ *          consistent but allocations performed during the dump can be
+ *          partially reflected.
+ *
+ * @param[in] heapp     pointer to a heap descriptor or @p NULL in order to
+ *                      access the default heap.
+ * @param[out] buf      pointer to the dump buffer
+ * @param[in] size      size of the dump buffer, a buffer of
+ *                      @p CH_HEAP_PROFILE_DUMP_SIZE bytes is always large
+ *                      enough
+ * @return              The size of the dump.
+ * @retval 0            if the buffer is too small.
+ *
+ * @api
+ */
+size_t chHeapProfileDump(MemoryHeap *heapp, uint8_t *buf, size_t size) {
+  ch_heap_profile_t hp;
+  uint8_t *bp, *np;
+  unsigned i, n;
+
+  chDbgCheck(buf != NULL, "chHeapProfileDump");
+
+  if (size < 36 + (4 * CH_HEAP_HISTOGRAM_BINS))
+    return 0;
+
+  chHeapGetProfile(heapp, &hp);
+  bp = dump_u32(buf, CH_HEAP_PROFILE_MAGIC);
+  bp = dump_u16(bp, CH_HEAP_PROFILE_VERSION);
+  *bp++ = (uint8_t)sizeof(void *);
+  *bp++ = 0;
+  bp = dump_u16(bp, CH_HEAP_HISTOGRAM_BINS);
+  np = bp;
+  bp = dump_u16(bp, 0);
+  bp = dump_u32(bp, 0);
+  bp = dump_u32(bp, hp.hp_used);
+  bp = dump_u32(bp, hp.hp_peak);
+  bp = dump_u32(bp, hp.hp_free);
+  bp = dump_u32(bp, hp.hp_fragments);
+  bp = dump_u32(bp, hp.hp_largest);
+  for (i = 0; i < CH_HEAP_HISTOGRAM_BINS; i++)
+    bp = dump_u32(bp, hp.hp_histogram[i]);
+
+  /* The call sites are streamed into the buffer one at a time, the number
+     of sites is written into the header at the end.*/
+  for (i = 0, n = 0; i < CH_HEAP_PROFILE_SITES; i++) {
+    ch_heap_site_t site;
+
+    chSysLock();
+    site = dbg_heap_sites[i];
+    chSysUnlock();
+    if (site.hs_allocs == 0)
+      continue;
+    if ((size_t)(bp - buf) + sizeof(void *) + 12 > size)
+      return 0;
+    bp = dump_put(bp, &site.hs_caller, sizeof(void *));
+    bp = dump_u32(bp, site.hs_bytes);
+    bp = dump_u32(bp, site.hs_count);
+    bp = dump_u32(bp, site.hs_allocs);
+    n++;
+  }
+  (void)dump_u16(np, n);
+  return (size_t)(bp - buf);
+}
+#endif /* CH_DBG_HEAP_PROFILING */
+
 #else /* CH_USE_MALLOC_HEAP */
 
 #include <stdlib.h>
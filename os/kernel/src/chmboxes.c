@@ -50,9 +50,58 @@
  * @{
  */
 
+#include <string.h>
+
 #include "ch.h"
 
 #if CH_USE_MAILBOXES || defined(__DOXYGEN__)
+
+/**
+ * @brief   Copies messages into the mailbox buffer.
+ * @details The messages are copied starting from the write pointer and the
+ *          write pointer is advanced, the semaphores are not updated.
+ *
+ * @param[in] mbp       the pointer to an initialized Mailbox object
+ * @param[in] msgs      pointer to an array of messages
+ * @param[in] n         number of messages to be copied
+ */
+static void mbcopyin(Mailbox *mbp, const msg_t *msgs, cnt_t n) {
+  size_t s = (size_t)(mbp->mb_top - mbp->mb_wrptr);
+
+  if ((size_t)n < s) {
+    memcpy(mbp->mb_wrptr, msgs, n * sizeof (msg_t));
+    mbp->mb_wrptr += n;
+  }
+  else {
+    memcpy(mbp->mb_wrptr, msgs, s * sizeof (msg_t));
+    memcpy(mbp->mb_buffer, msgs + s, (n - s) * sizeof (msg_t));
+    mbp->mb_wrptr = mbp->mb_buffer + (n - s);
+  }
+}
+
+/**
+ * @brief   Copies messages out of the mailbox buffer.
+ * @details The messages are copied starting from the read pointer and the
+ *          read pointer is advanced, the semaphores are not updated.
+ *
+ * @param[in] mbp       the pointer to an initialized Mailbox object
+ * @param[out] msgs     pointer to an array receiving the messages
+ * @param[in] n         number of messages to be copied
+ */
+static void mbcopyout(Mailbox *mbp, msg_t *msgs, cnt_t n) {
+  size_t s = (size_t)(mbp->mb_top - mbp->mb_rdptr);
+
+  if ((size_t)n < s) {
+    memcpy(msgs, mbp->mb_rdptr, n * sizeof (msg_t));
+    mbp->mb_rdptr += n;
+  }
+  else {
+    memcpy(msgs, mbp->mb_rdptr, s * sizeof (msg_t));
+    memcpy(msgs + s, mbp->mb_buffer, (n - s) * sizeof (msg_t));
+    mbp->mb_rdptr = mbp->mb_buffer + (n - s);
+  }
+}
+
 /**
  * @brief   Initializes a Mailbox object.
  *
@@ -279,6 +328,113 @@ msg_t chMBPostAheadI(Mailbox *mbp, msg_t msg) {
   return RDY_OK;
 }
 
+/**
+ * @brief   Posts multiple messages into a mailbox.
+ * @details The invoking thread waits until at least one empty slot in the
+ *          mailbox becomes available or the specified time runs out, then
+ *          posts as many messages as the free slots allow.
+ *
+ * @param[in] mbp       the pointer to an initialized Mailbox object
+ * @param[in] msgs      pointer to an array of messages to be posted
+ * @param[in] n         number of messages in the array
+ * @param[in] time      the number of ticks before the operation timeouts,
+ *                      the following special values are allowed:
+ *                      - @a TIME_IMMEDIATE immediate timeout.
+ *                      - @a TIME_INFINITE no timeout.
+ *                      .
+ * @return              The number of posted messages.
+ * @retval 0            if the mailbox has been reset while waiting or if
+ *                      the operation has timed out.
+ *
+ * @api
+ */
+cnt_t chMBPostN(Mailbox *mbp, const msg_t *msgs, cnt_t n, systime_t time) {
+  cnt_t k;
+
+  chSysLock();
+  k = chMBPostNS(mbp, msgs, n, time);
+  chSysUnlock();
+  return k;
+}
+
+/**
+ * @brief   Posts multiple messages into a mailbox.
+ * @details The invoking thread waits until at least one empty slot in the
+ *          mailbox becomes available or the specified time runs out, then
+ *          posts as many messages as the free slots allow.
+ *
+ * @param[in] mbp       the pointer to an initialized Mailbox object
+ * @param[in] msgs      pointer to an array of messages to be posted
+ * @param[in] n         number of messages in the array
+ * @param[in] time      the number of ticks before the operation timeouts,
+ *                      the following special values are allowed:
+ *                      - @a TIME_IMMEDIATE immediate timeout.
+ *                      - @a TIME_INFINITE no timeout.
+ *                      .
+ * @return              The number of posted messages.
+ * @retval 0            if the mailbox has been reset while waiting or if
+ *                      the operation has timed out.
+ *
+ * @sclass
+ */
+cnt_t chMBPostNS(Mailbox *mbp, const msg_t *msgs, cnt_t n, systime_t time) {
+  cnt_t k;
+
+  chDbgCheckClassS();
+  chDbgCheck((mbp != NULL) && (msgs != NULL) && (n > 0), "chMBPostNS");
+
+  if (chSemGetCounterI(&mbp->mb_emptysem) > 0)
+    k = chMBPostNI(mbp, msgs, n);
+  else {
+    if (chSemWaitTimeoutS(&mbp->mb_emptysem, time) != RDY_OK)
+      return 0;
+    /* The wait obtained one slot, the other slots are taken only if the
+       counter is still positive, other waiters could be queued.*/
+    k = chSemGetCounterI(&mbp->mb_emptysem);
+    if (k > n - 1)
+      k = n - 1;
+    if (k > 0)
+      mbp->mb_emptysem.s_cnt -= k;
+    else
+      k = 0;
+    k++;
+    mbcopyin(mbp, msgs, k);
+    chSemAddCounterI(&mbp->mb_fullsem, k);
+  }
+  chSchRescheduleS();
+  return k;
+}
+
+/**
+ * @brief   Posts multiple messages into a mailbox.
+ * @details This variant is non-blocking, the function posts as many
+ *          messages as the free slots allow.
+ *
+ * @param[in] mbp       the pointer to an initialized Mailbox object
+ * @param[in] msgs      pointer to an array of messages to be posted
+ * @param[in] n         number of messages in the array
+ * @return              The number of posted messages.
+ * @retval 0            if the mailbox is full.
+ *
+ * @iclass
+ */
+cnt_t chMBPostNI(Mailbox *mbp, const msg_t *msgs, cnt_t n) {
+  cnt_t k;
+
+  chDbgCheckClassI();
+  chDbgCheck((mbp != NULL) && (msgs != NULL) && (n > 0), "chMBPostNI");
+
+  k = chSemGetCounterI(&mbp->mb_emptysem);
+  if (k <= 0)
+    return 0;
+  if (k > n)
+    k = n;
+  mbp->mb_emptysem.s_cnt -= k;
+  mbcopyin(mbp, msgs, k);
+  chSemAddCounterI(&mbp->mb_fullsem, k);
+  return k;
+}
+
 /**
  * @brief   Retrieves a message from a mailbox.
  * @details The invoking thread waits until a message is posted in the mailbox
@@ -371,6 +527,113 @@ msg_t chMBFetchI(Mailbox *mbp, msg_t *msgp) {
   chSemSignalI(&mbp->mb_emptysem);
   return RDY_OK;
 }
+
+/**
+ * @brief   Retrieves multiple messages from a mailbox.
+ * @details The invoking thread waits until at least one message is posted
+ *          in the mailbox or the specified time runs out, then fetches as
+ *          many messages as available.
+ *
+ * @param[in] mbp       the pointer to an initialized Mailbox object
+ * @param[out] msgs     pointer to an array receiving the messages
+ * @param[in] n         number of messages in the array
+ * @param[in] time      the number of ticks before the operation timeouts,
+ *                      the following special values are allowed:
+ *                      - @a TIME_IMMEDIATE immediate timeout.
+ *                      - @a TIME_INFINITE no timeout.
+ *                      .
+ * @return              The number of fetched messages.
+ * @retval 0            if the mailbox has been reset while waiting or if
+ *                      the operation has timed out.
+ *
+ * @api
+ */
+cnt_t chMBFetchN(Mailbox *mbp, msg_t *msgs, cnt_t n, systime_t time) {
+  cnt_t k;
+
+  chSysLock();
+  k = chMBFetchNS(mbp, msgs, n, time);
+  chSysUnlock();
+  return k;
+}
+
+/**
+ * @brief   Retrieves multiple messages from a mailbox.
+ * @details The invoking thread waits until at least one message is posted
+ *          in the mailbox or the specified time runs out, then fetches as
+ *          many messages as available.
+ *
+ * @param[in] mbp       the pointer to an initialized Mailbox object
+ * @param[out] msgs     pointer to an array receiving the messages
+ * @param[in] n         number of messages in the array
+ * @param[in] time      the number of ticks before the operation timeouts,
+ *                      the following special values are allowed:
+ *                      - @a TIME_IMMEDIATE immediate timeout.
+ *                      - @a TIME_INFINITE no timeout.
+ *                      .
+ * @return              The number of fetched messages.
+ * @retval 0            if the mailbox has been reset while waiting or if
+ *                      the operation has timed out.
+ *
+ * @sclass
+ */
+cnt_t chMBFetchNS(Mailbox *mbp, msg_t *msgs, cnt_t n, systime_t time) {
+  cnt_t k;
+
+  chDbgCheckClassS();
+  chDbgCheck((mbp != NULL) && (msgs != NULL) && (n > 0), "chMBFetchNS");
+
+  if (chSemGetCounterI(&mbp->mb_fullsem) > 0)
+    k = chMBFetchNI(mbp, msgs, n);
+  else {
+    if (chSemWaitTimeoutS(&mbp->mb_fullsem, time) != RDY_OK)
+      return 0;
+    /* The wait obtained one message, the other messages are taken only if
+       the counter is still positive, other waiters could be queued.*/
+    k = chSemGetCounterI(&mbp->mb_fullsem);
+    if (k > n - 1)
+      k = n - 1;
+    if (k > 0)
+      mbp->mb_fullsem.s_cnt -= k;
+    else
+      k = 0;
+    k++;
+    mbcopyout(mbp, msgs, k);
+    chSemAddCounterI(&mbp->mb_emptysem, k);
+  }
+  chSchRescheduleS();
+  return k;
+}
+
+/**
+ * @brief   Retrieves multiple messages from a mailbox.
+ * @details This variant is non-blocking, the function fetches as many
+ *          messages as available.
+ *
+ * @param[in] mbp       the pointer to an initialized Mailbox object
+ * @param[out] msgs     pointer to an array receiving the messages
+ * @param[in] n         number of messages in the array
+ * @return              The number of fetched messages.
+ * @retval 0            if the mailbox is empty.
+ *
+ * @iclass
+ */
+cnt_t chMBFetchNI(Mailbox *mbp, msg_t *msgs, cnt_t n) {
+  cnt_t k;
+
+  chDbgCheckClassI();
+  chDbgCheck((mbp != NULL) && (msgs != NULL) && (n > 0), "chMBFetchNI");
+
+  k = chSemGetCounterI(&mbp->mb_fullsem);
+  if (k <= 0)
+    return 0;
+  if (k > n)
+    k = n;
+  mbp->mb_fullsem.s_cnt -= k;
+  mbcopyout(mbp, msgs, k);
+  chSemAddCounterI(&mbp->mb_emptysem, k);
+  return k;
+}
 #endif /* CH_USE_MAILBOXES */
 
 /** @} */
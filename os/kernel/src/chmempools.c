@@ -30,15 +30,103 @@
  *          problems.<br>
  *          Memory Pools do not enforce any alignment constraint on the
  *          contained object however the objects must be properly aligned
- *          to contain a pointer to void.
+ *          to contain a pointer to void.<br>
+ *          Guarded Memory Pools add a counting semaphore to the pool,
+ *          threads trying to allocate from an empty pool can wait, with
+ *          an optional timeout, for an object to be returned.<br>
+ *          When the @p CH_USE_MEMPOOLS_LOCKFREE option is enabled the free
+ *          objects list is a lock-free stack, objects can be allocated and
+ *          freed from any context without entering a critical zone.
  * @pre     In order to use the memory pools APIs the @p CH_USE_MEMPOOLS option
  *          must be enabled in @p chconf.h.
+ * @pre     In order to use the guarded memory pools APIs the
+ *          @p CH_USE_SEMAPHORES option must also be enabled in
+ *          @p chconf.h.
  * @{
  */
 
 #include "ch.h"
 
 #if CH_USE_MEMPOOLS || defined(__DOXYGEN__)
+
+#if CH_USE_MEMPOOLS_LOCKFREE
+#if !CH_MEMPOOLS_TAGGED
+/*
+ * Pops an object from the free objects list using the exclusive access
+ * primitives, an interrupt or an access from another core between the load
+ * and the store makes the store fail so the ABA problem cannot happen.
+ */
+static struct pool_header *pool_pop(MemoryPool *mp) {
+  struct pool_header *php;
+
+  do {
+    php = port_ll((void * volatile *)&mp->mp_next);
+    if (php == NULL) {
+      port_ll_clear();
+      return NULL;
+    }
+  } while (!port_sc((void * volatile *)&mp->mp_next, php->ph_next));
+  return php;
+}
+
+/*
+ * Pushes an object on the free objects list using the exclusive access
+ * primitives.
+ */
+static void pool_push(MemoryPool *mp, struct pool_header *php) {
+  struct pool_header *next;
+
+  while (TRUE) {
+    next = *(struct pool_header * volatile *)&mp->mp_next;
+    php->ph_next = next;
+    if ((port_ll((void * volatile *)&mp->mp_next) == next) &&
+        port_sc((void * volatile *)&mp->mp_next, php))
+      return;
+    port_ll_clear();
+  }
+}
+#else /* CH_MEMPOOLS_TAGGED */
+/*
+ * Pops an object from the free objects list, the tag is incremented on
+ * each pop so a compare and swap on a list head that has been popped and
+ * pushed back in the meantime fails (ABA problem).
+ */
+static struct pool_header *pool_pop(MemoryPool *mp) {
+  port_tagged_t old, upd;
+
+  old = mp->mp_head;
+  while (TRUE) {
+    if (old.tp_ptr == NULL) {
+      /* The head could have been read while being modified, the empty
+         state is confirmed by a swap with itself.*/
+      upd = old;
+      if (port_dwcas(&mp->mp_head, &old, &upd))
+        return NULL;
+      continue;
+    }
+    upd.tp_ptr = ((struct pool_header *)old.tp_ptr)->ph_next;
+    upd.tp_tag = old.tp_tag + 1;
+    if (port_dwcas(&mp->mp_head, &old, &upd))
+      return old.tp_ptr;
+  }
+}
+
+/*
+ * Pushes an object on the free objects list.
+ */
+static void pool_push(MemoryPool *mp, struct pool_header *php) {
+  port_tagged_t old, upd;
+
+  old = mp->mp_head;
+  do {
+    php->ph_next = old.tp_ptr;
+    upd.tp_ptr = php;
+    upd.tp_tag = old.tp_tag;
+  } while (!port_dwcas(&mp->mp_head, &old, &upd));
+}
+#endif /* CH_MEMPOOLS_TAGGED */
+#endif /* CH_USE_MEMPOOLS_LOCKFREE */
+
 /**
  * @brief   Initializes an empty memory pool.
  *
@@ -56,7 +144,12 @@ void chPoolInit(MemoryPool *mp, size_t size, memgetfunc_t provider) {
 
   chDbgCheck((mp != NULL) && (size >= sizeof(void *)), "chPoolInit");
 
+#if !CH_MEMPOOLS_TAGGED
   mp->mp_next = NULL;
+#else
+  mp->mp_head.tp_ptr = NULL;
+  mp->mp_head.tp_tag = 0;
+#endif
   mp->mp_object_size = size;
   mp->mp_provider = provider;
 }
@@ -88,6 +181,10 @@ void chPoolLoadArray(MemoryPool *mp, void *p, size_t n) {
 /**
  * @brief   Allocates an object from a memory pool.
  * @pre     The memory pool must be already been initialized.
+ * @note    When the @p CH_USE_MEMPOOLS_LOCKFREE option is enabled this
+ *          function can also be invoked out of a critical zone, in that
+ *          case the memory provider, if any, must be able to work in the
+ *          caller context.
  *
  * @param[in] mp        pointer to a @p MemoryPool structure
  * @return              The pointer to the allocated object.
@@ -98,12 +195,21 @@ void chPoolLoadArray(MemoryPool *mp, void *p, size_t n) {
 void *chPoolAllocI(MemoryPool *mp) {
   void *objp;
 
+#if !CH_USE_MEMPOOLS_LOCKFREE
   chDbgCheckClassI();
+#endif
   chDbgCheck(mp != NULL, "chPoolAllocI");
 
-  if ((objp = mp->mp_next) != NULL)
+#if !CH_USE_MEMPOOLS_LOCKFREE
+  if ((objp = mp->mp_next) != NULL) {
     mp->mp_next = mp->mp_next->ph_next;
-  else if (mp->mp_provider != NULL)
+    return objp;
+  }
+#else
+  if ((objp = pool_pop(mp)) != NULL)
+    return objp;
+#endif
+  if (mp->mp_provider != NULL)
     objp = mp->mp_provider(mp->mp_object_size);
   return objp;
 }
@@ -121,6 +227,14 @@ void *chPoolAllocI(MemoryPool *mp) {
 void *chPoolAlloc(MemoryPool *mp) {
   void *objp;
 
+#if CH_USE_MEMPOOLS_LOCKFREE
+  /* Fast path, the critical zone is only entered in order to invoke the
+     memory provider.*/
+  chDbgCheck(mp != NULL, "chPoolAlloc");
+
+  if ((objp = pool_pop(mp)) != NULL)
+    return objp;
+#endif
   chSysLock();
   objp = chPoolAllocI(mp);
   chSysUnlock();
@@ -134,6 +248,9 @@ void *chPoolAlloc(MemoryPool *mp) {
  *          memory pool.
  * @pre     The object must be properly aligned to contain a pointer to void.
  *
+ * @note    When the @p CH_USE_MEMPOOLS_LOCKFREE option is enabled this
+ *          function can also be invoked out of a critical zone.
+ *
  * @param[in] mp        pointer to a @p MemoryPool structure
  * @param[in] objp      the pointer to the object to be released
  *
@@ -142,11 +259,17 @@ void *chPoolAlloc(MemoryPool *mp) {
 void chPoolFreeI(MemoryPool *mp, void *objp) {
   struct pool_header *php = objp;
 
+#if !CH_USE_MEMPOOLS_LOCKFREE
   chDbgCheckClassI();
+#endif
   chDbgCheck((mp != NULL) && (objp != NULL), "chPoolFreeI");
 
+#if !CH_USE_MEMPOOLS_LOCKFREE
   php->ph_next = mp->mp_next;
   mp->mp_next = php;
+#else
+  pool_push(mp, php);
+#endif
 }
 
 /**
@@ -163,10 +286,255 @@ void chPoolFreeI(MemoryPool *mp, void *objp) {
  */
 void chPoolFree(MemoryPool *mp, void *objp) {
 
+#if !CH_USE_MEMPOOLS_LOCKFREE
   chSysLock();
   chPoolFreeI(mp, objp);
   chSysUnlock();
+#else
+  chPoolFreeI(mp, objp);
+#endif
+}
+
+#if CH_USE_SEMAPHORES || defined(__DOXYGEN__)
+/**
+ * @brief   Initializes an empty guarded memory pool.
+ *
+ * @param[out] gmp      pointer to a @p GuardedMemoryPool structure
+ * @param[in] size      the size of the objects contained in this guarded
+ *                      memory pool, the minimum accepted size is the size
+ *                      of a pointer to void.
+ *
+ * @init
+ */
+void chGuardedPoolInit(GuardedMemoryPool *gmp, size_t size) {
+
+  chDbgCheck(gmp != NULL, "chGuardedPoolInit");
+
+  chPoolInit(&gmp->gmp_pool, size, NULL);
+  chSemInit(&gmp->gmp_sem, 0);
+  gmp->gmp_min = 0;
+}
+
+/**
+ * @brief   Loads a guarded memory pool with an array of static objects.
+ * @pre     The guarded memory pool must be already been initialized.
+ * @pre     The array elements must be of the right size for the specified
+ *          guarded memory pool.
+ * @post    The guarded memory pool contains the elements of the input array.
+ * @note    If there are no threads waiting on the pool the objects are
+ *          accounted without rescheduling, the function can also be
+ *          invoked during the initialization, before @p chSysInit().
+ *
+ * @param[in] gmp       pointer to a @p GuardedMemoryPool structure
+ * @param[in] p         pointer to the array first element
+ * @param[in] n         number of elements in the array
+ *
+ * @api
+ */
+void chGuardedPoolLoadArray(GuardedMemoryPool *gmp, void *p, size_t n) {
+
+  chDbgCheck((gmp != NULL) && (n != 0), "chGuardedPoolLoadArray");
+
+  chSysLock();
+  if (chSemGetCounterI(&gmp->gmp_sem) >= 0) {
+    gmp->gmp_sem.s_cnt += (cnt_t)n;
+    gmp->gmp_min += (cnt_t)n;
+    while (n) {
+      chPoolAddI(&gmp->gmp_pool, p);
+      p = (void *)(((uint8_t *)p) + gmp->gmp_pool.mp_object_size);
+      n--;
+    }
+  }
+  else {
+    while (n) {
+      chGuardedPoolAddI(gmp, p);
+      p = (void *)(((uint8_t *)p) + gmp->gmp_pool.mp_object_size);
+      n--;
+    }
+    chSchRescheduleS();
+  }
+  chSysUnlock();
+}
+
+/**
+ * @brief   Allocates an object from a guarded memory pool.
+ * @details This function does not block, it is meant to be used from
+ *          interrupt handlers and from within critical zones.
+ * @pre     The guarded memory pool must be already been initialized.
+ *
+ * @param[in] gmp       pointer to a @p GuardedMemoryPool structure
+ * @return              The pointer to the allocated object.
+ * @retval NULL         if the pool is empty.
+ *
+ * @iclass
+ */
+void *chGuardedPoolAllocI(GuardedMemoryPool *gmp) {
+  void *objp;
+
+  chDbgCheckClassI();
+  chDbgCheck(gmp != NULL, "chGuardedPoolAllocI");
+
+  if (chSemGetCounterI(&gmp->gmp_sem) <= 0)
+    return NULL;
+  chSemFastWaitI(&gmp->gmp_sem);
+  if (chSemGetCounterI(&gmp->gmp_sem) < gmp->gmp_min)
+    gmp->gmp_min = chSemGetCounterI(&gmp->gmp_sem);
+  objp = chPoolAllocI(&gmp->gmp_pool);
+  chDbgAssert(objp != NULL, "chGuardedPoolAllocI(), #1", "pool corrupted");
+  return objp;
+}
+
+/**
+ * @brief   Allocates an object from a guarded memory pool.
+ * @details If the pool is empty then the calling thread waits until an
+ *          object is returned to the pool or the timeout expires.
+ * @pre     The guarded memory pool must be already been initialized.
+ *
+ * @param[in] gmp       pointer to a @p GuardedMemoryPool structure
+ * @param[in] time      the number of ticks before the operation timeouts,
+ *                      the following special values are allowed:
+ *                      - @a TIME_IMMEDIATE immediate timeout.
+ *                      - @a TIME_INFINITE no timeout.
+ *                      .
+ * @return              The pointer to the allocated object.
+ * @retval NULL         if the operation timed out.
+ *
+ * @sclass
+ */
+void *chGuardedPoolAllocTimeoutS(GuardedMemoryPool *gmp, systime_t time) {
+  void *objp;
+  cnt_t n;
+
+  chDbgCheckClassS();
+  chDbgCheck(gmp != NULL, "chGuardedPoolAllocTimeoutS");
+
+  if (chSemWaitTimeoutS(&gmp->gmp_sem, time) != RDY_OK)
+    return NULL;
+  /* The counter is negative if other threads are still waiting.*/
+  n = chSemGetCounterI(&gmp->gmp_sem);
+  if (n < 0)
+    n = 0;
+  if (n < gmp->gmp_min)
+    gmp->gmp_min = n;
+  objp = chPoolAllocI(&gmp->gmp_pool);
+  chDbgAssert(objp != NULL, "chGuardedPoolAllocTimeoutS(), #1",
+              "pool corrupted");
+  return objp;
+}
+
+/**
+ * @brief   Allocates an object from a guarded memory pool.
+ * @details If the pool is empty then the calling thread waits until an
+ *          object is returned to the pool or the timeout expires.
+ * @pre     The guarded memory pool must be already been initialized.
+ *
+ * @param[in] gmp       pointer to a @p GuardedMemoryPool structure
+ * @param[in] time      the number of ticks before the operation timeouts,
+ *                      the following special values are allowed:
+ *                      - @a TIME_IMMEDIATE immediate timeout.
+ *                      - @a TIME_INFINITE no timeout.
+ *                      .
+ * @return              The pointer to the allocated object.
+ * @retval NULL         if the operation timed out.
+ *
+ * @api
+ */
+void *chGuardedPoolAllocTimeout(GuardedMemoryPool *gmp, systime_t time) {
+  void *objp;
+
+  chSysLock();
+  objp = chGuardedPoolAllocTimeoutS(gmp, time);
+  chSysUnlock();
+  return objp;
+}
+
+/**
+ * @brief   Releases an object into a guarded memory pool.
+ * @details A thread waiting for an object, if any, is made ready but no
+ *          reschedule is performed, the function can be used from
+ *          interrupt handlers.
+ * @pre     The guarded memory pool must be already been initialized.
+ * @pre     The freed object must be of the right size for the specified
+ *          guarded memory pool.
+ * @pre     The object must have been allocated from the same pool.
+ *
+ * @param[in] gmp       pointer to a @p GuardedMemoryPool structure
+ * @param[in] objp      the pointer to the object to be released
+ *
+ * @iclass
+ */
+void chGuardedPoolFreeI(GuardedMemoryPool *gmp, void *objp) {
+
+  chDbgCheckClassI();
+  chDbgCheck((gmp != NULL) && (objp != NULL), "chGuardedPoolFreeI");
+
+  chPoolFreeI(&gmp->gmp_pool, objp);
+  chSemSignalI(&gmp->gmp_sem);
+}
+
+/**
+ * @brief   Releases an object into a guarded memory pool.
+ * @pre     The guarded memory pool must be already been initialized.
+ * @pre     The freed object must be of the right size for the specified
+ *          guarded memory pool.
+ * @pre     The object must have been allocated from the same pool.
+ *
+ * @param[in] gmp       pointer to a @p GuardedMemoryPool structure
+ * @param[in] objp      the pointer to the object to be released
+ *
+ * @api
+ */
+void chGuardedPoolFree(GuardedMemoryPool *gmp, void *objp) {
+
+  chSysLock();
+  chGuardedPoolFreeI(gmp, objp);
+  chSchRescheduleS();
+  chSysUnlock();
+}
+
+/**
+ * @brief   Adds an object to a guarded memory pool.
+ * @details Differently from @p chGuardedPoolFreeI() the object increases
+ *          the pool capacity, the minimum free objects statistic is
+ *          updated accordingly.
+ * @pre     The guarded memory pool must be already been initialized.
+ * @pre     The added object must be of the right size for the specified
+ *          guarded memory pool.
+ * @pre     The added object must be properly aligned to contain a pointer
+ *          to void.
+ *
+ * @param[in] gmp       pointer to a @p GuardedMemoryPool structure
+ * @param[in] objp      the pointer to the object to be added
+ *
+ * @iclass
+ */
+void chGuardedPoolAddI(GuardedMemoryPool *gmp, void *objp) {
+
+  chGuardedPoolFreeI(gmp, objp);
+  gmp->gmp_min++;
+}
+
+/**
+ * @brief   Adds an object to a guarded memory pool.
+ * @pre     The guarded memory pool must be already been initialized.
+ * @pre     The added object must be of the right size for the specified
+ *          guarded memory pool.
+ * @pre     The added object must be properly aligned to contain a pointer
+ *          to void.
+ *
+ * @param[in] gmp       pointer to a @p GuardedMemoryPool structure
+ * @param[in] objp      the pointer to the object to be added
+ *
+ * @api
+ */
+void chGuardedPoolAdd(GuardedMemoryPool *gmp, void *objp) {
+
+  chSysLock();
+  chGuardedPoolAddI(gmp, objp);
+  chSchRescheduleS();
+  chSysUnlock();
 }
+#endif /* CH_USE_SEMAPHORES */
 
 #endif /* CH_USE_MEMPOOLS */
 
@@ -71,6 +71,7 @@ msg_t chMsgSend(Thread *tp, msg_t msg) {
   chDbgCheck(tp != NULL, "chMsgSend");
 
   chSysLock();
+  dbg_trace_event(CH_TRACE_MSG, CH_TRACE_TYPE_MSG_SEND, tp, (intptr_t)msg);
   ctp->p_msg = msg;
   ctp->p_u.wtobjp = &tp->p_msgqueue;
   msg_insert(ctp, &tp->p_msgqueue);
@@ -82,6 +82,7 @@ void chMtxInit(Mutex *mp) {
 
   queue_init(&mp->m_queue);
   mp->m_owner = NULL;
+  sync_prof_init(&mp->m_prof);
 }
 
 /**
@@ -117,6 +118,7 @@ void chMtxLockS(Mutex *mp) {
   chDbgCheckClassS();
   chDbgCheck(mp != NULL, "chMtxLockS");
 
+  sync_prof_acquire(&mp->m_prof);
   /* Is the mutex already locked? */
   if (mp->m_owner != NULL) {
     /* Priority inheritance protocol; explores the thread-mutex dependencies
@@ -126,6 +128,7 @@ void chMtxLockS(Mutex *mp) {
     /* Does the running thread have higher priority than the mutex
        owning thread? */
     while (tp->p_prio < ctp->p_prio) {
+      sync_prof_boost(&mp->m_prof);
       /* Make priority of thread tp match the running thread's priority.*/
       tp->p_prio = ctp->p_prio;
       /* The following states need priority queues reordering.*/
@@ -157,6 +160,7 @@ void chMtxLockS(Mutex *mp) {
         tp->p_state = THD_STATE_CURRENT;
 #endif
         /* Re-enqueues tp with its new priority on the ready list.*/
+        stats_ready_remove();
         chSchReadyI(dequeue(tp));
         break;
       }
@@ -165,7 +169,9 @@ void chMtxLockS(Mutex *mp) {
     /* Sleep on the mutex.*/
     prio_insert(ctp, &mp->m_queue);
     ctp->p_u.wtobjp = mp;
+    sync_prof_wait_start();
     chSchGoSleepS(THD_STATE_WTMTX);
+    sync_prof_wait_end(&mp->m_prof);
     /* It is assumed that the thread performing the unlock operation assigns
        the mutex to this thread.*/
     chDbgAssert(mp->m_owner == ctp, "chMtxLockS(), #1", "not owner");
@@ -176,7 +182,9 @@ void chMtxLockS(Mutex *mp) {
     mp->m_owner = ctp;
     mp->m_next = ctp->p_mtxlist;
     ctp->p_mtxlist = mp;
+    sync_prof_hold_start(&mp->m_prof);
   }
+  dbg_trace_event(CH_TRACE_MTX, CH_TRACE_TYPE_MTX_LOCK, mp, NULL);
 }
 
 /**
@@ -234,6 +242,9 @@ bool_t chMtxTryLockS(Mutex *mp) {
   mp->m_owner = currp;
   mp->m_next = currp->p_mtxlist;
   currp->p_mtxlist = mp;
+  sync_prof_acquire(&mp->m_prof);
+  sync_prof_hold_start(&mp->m_prof);
+  dbg_trace_event(CH_TRACE_MTX, CH_TRACE_TYPE_MTX_LOCK, mp, NULL);
   return TRUE;
 }
 
@@ -262,6 +273,8 @@ Mutex *chMtxUnlock(void) {
      as not owned.*/
   ump = ctp->p_mtxlist;
   ctp->p_mtxlist = ump->m_next;
+  dbg_trace_event(CH_TRACE_MTX, CH_TRACE_TYPE_MTX_UNLOCK, ump, NULL);
+  sync_prof_hold_end(&ump->m_prof);
   /* If a thread is waiting on the mutex then the fun part begins.*/
   if (chMtxQueueNotEmptyS(ump)) {
     Thread *tp;
@@ -287,6 +300,7 @@ Mutex *chMtxUnlock(void) {
     ump->m_owner = tp;
     ump->m_next = tp->p_mtxlist;
     tp->p_mtxlist = ump;
+    sync_prof_hold_start(&ump->m_prof);
     chSchWakeupS(tp, RDY_OK);
   }
   else
@@ -323,6 +337,8 @@ Mutex *chMtxUnlockS(void) {
      owned.*/
   ump = ctp->p_mtxlist;
   ctp->p_mtxlist = ump->m_next;
+  dbg_trace_event(CH_TRACE_MTX, CH_TRACE_TYPE_MTX_UNLOCK, ump, NULL);
+  sync_prof_hold_end(&ump->m_prof);
   /* If a thread is waiting on the mutex then the fun part begins.*/
   if (chMtxQueueNotEmptyS(ump)) {
     Thread *tp;
@@ -346,6 +362,7 @@ Mutex *chMtxUnlockS(void) {
     ump->m_owner = tp;
     ump->m_next = tp->p_mtxlist;
     tp->p_mtxlist = ump;
+    sync_prof_hold_start(&ump->m_prof);
     chSchReadyI(tp);
   }
   else
@@ -372,11 +389,14 @@ void chMtxUnlockAll(void) {
     do {
       Mutex *ump = ctp->p_mtxlist;
       ctp->p_mtxlist = ump->m_next;
+      dbg_trace_event(CH_TRACE_MTX, CH_TRACE_TYPE_MTX_UNLOCK, ump, NULL);
+      sync_prof_hold_end(&ump->m_prof);
       if (chMtxQueueNotEmptyS(ump)) {
         Thread *tp = fifo_remove(&ump->m_queue);
         ump->m_owner = tp;
         ump->m_next = tp->p_mtxlist;
         tp->p_mtxlist = ump;
+        sync_prof_hold_start(&ump->m_prof);
         chSchReadyI(tp);
       }
       else
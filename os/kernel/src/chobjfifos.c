@@ -0,0 +1,323 @@
+/*
+    ChibiOS/RT - Copyright (C) 2006,2007,2008,2009,2010,
+                 2011,2012,2013 Giovanni Di Sirio.
+
+    This file is part of ChibiOS/RT.
+
+    ChibiOS/RT is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    ChibiOS/RT is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * @file    chobjfifos.c
+ * @brief   Objects FIFOs code.
+ *
+ * @addtogroup objfifos
+ * @details Zero-copy exchange of fixed size objects between threads.
+ *          <h2>Operation mode</h2>
+ *          An objects FIFO combines a guarded memory pool and a mailbox
+ *          sharing the same capacity, the producer allocates a free object,
+ *          fills it and posts it, the consumer fetches the object, processes
+ *          it and frees it back. Each step requires a single critical zone
+ *          and no data is copied.<br>
+ *          Operations defined for objects FIFOs:
+ *          - <b>Alloc</b>: A free object is taken, the caller can wait with
+ *            a timeout for an object to be freed.
+ *          - <b>Post</b>: An allocated object is queued, this operation
+ *            never waits because the mailbox can contain all the objects.
+ *          - <b>Fetch</b>: The oldest posted object is dequeued, the caller
+ *            can wait with a timeout for an object to be posted.
+ *          - <b>Free</b>: A fetched, or allocated, object is returned.
+ *          - <b>Peek</b>: The oldest posted object is inspected without
+ *            removing it.
+ *          .
+ * @pre     In order to use the objects FIFOs APIs the @p CH_USE_OBJFIFOS
+ *          option must be enabled in @p chconf.h.
+ * @{
+ */
+
+#include "ch.h"
+
+#if CH_USE_OBJFIFOS || defined(__DOXYGEN__)
+
+/**
+ * @brief   Initializes an objects FIFO.
+ * @note    The objects FIFO is initialized with all the objects free.
+ *
+ * @param[out] ofp      pointer to an @p ObjectsFifo structure
+ * @param[in] objsize   size of the objects, the objects must be able to
+ *                      contain a pointer and be properly aligned for it
+ * @param[in] objn      number of objects
+ * @param[in] objbuf    pointer to the objects buffer, an array of @p objn
+ *                      elements of @p objsize size
+ * @param[in] msgbuf    pointer to the messages buffer, an array of @p objn
+ *                      @p msg_t elements
+ *
+ * @init
+ */
+void chFifoInit(ObjectsFifo *ofp, size_t objsize, size_t objn,
+                void *objbuf, msg_t *msgbuf) {
+
+  chDbgCheck((ofp != NULL) && (objn > 0) && (objbuf != NULL) &&
+             (msgbuf != NULL), "chFifoInit");
+
+  /* The free objects are loaded into the pool and accounted in the
+     semaphore directly, there cannot be waiting threads and the function
+     can be invoked before chSysInit().*/
+  chGuardedPoolInit(&ofp->of_free, objsize);
+  chPoolLoadArray(&ofp->of_free.gmp_pool, objbuf, objn);
+  chSemInit(&ofp->of_free.gmp_sem, (cnt_t)objn);
+  ofp->of_free.gmp_min = (cnt_t)objn;
+  chMBInit(&ofp->of_mbx, msgbuf, (cnt_t)objn);
+}
+
+/**
+ * @brief   Allocates a free object.
+ *
+ * @param[in] ofp       pointer to an @p ObjectsFifo structure
+ * @return              The pointer to the allocated object.
+ * @retval NULL         if no free objects are available.
+ *
+ * @iclass
+ */
+void *chFifoAllocI(ObjectsFifo *ofp) {
+
+  return chGuardedPoolAllocI(&ofp->of_free);
+}
+
+/**
+ * @brief   Allocates a free object.
+ * @details If no free objects are available then the calling thread waits
+ *          until an object is freed or the timeout expires.
+ *
+ * @param[in] ofp       pointer to an @p ObjectsFifo structure
+ * @param[in] time      the number of ticks before the operation timeouts,
+ *                      the following special values are allowed:
+ *                      - @a TIME_IMMEDIATE immediate timeout.
+ *                      - @a TIME_INFINITE no timeout.
+ *                      .
+ * @return              The pointer to the allocated object.
+ * @retval NULL         if the operation timed out.
+ *
+ * @sclass
+ */
+void *chFifoAllocTimeoutS(ObjectsFifo *ofp, systime_t time) {
+
+  return chGuardedPoolAllocTimeoutS(&ofp->of_free, time);
+}
+
+/**
+ * @brief   Allocates a free object.
+ * @details If no free objects are available then the calling thread waits
+ *          until an object is freed or the timeout expires.
+ *
+ * @param[in] ofp       pointer to an @p ObjectsFifo structure
+ * @param[in] time      the number of ticks before the operation timeouts,
+ *                      the following special values are allowed:
+ *                      - @a TIME_IMMEDIATE immediate timeout.
+ *                      - @a TIME_INFINITE no timeout.
+ *                      .
+ * @return              The pointer to the allocated object.
+ * @retval NULL         if the operation timed out.
+ *
+ * @api
+ */
+void *chFifoAllocTimeout(ObjectsFifo *ofp, systime_t time) {
+
+  return chGuardedPoolAllocTimeout(&ofp->of_free, time);
+}
+
+/**
+ * @brief   Frees an object.
+ * @details The object is returned to the free objects, a thread waiting
+ *          for an object is made ready but no reschedule is performed.
+ *
+ * @param[in] ofp       pointer to an @p ObjectsFifo structure
+ * @param[in] objp      pointer to an object obtained from the same FIFO
+ *
+ * @iclass
+ */
+void chFifoFreeI(ObjectsFifo *ofp, void *objp) {
+
+  chGuardedPoolFreeI(&ofp->of_free, objp);
+}
+
+/**
+ * @brief   Frees an object.
+ *
+ * @param[in] ofp       pointer to an @p ObjectsFifo structure
+ * @param[in] objp      pointer to an object obtained from the same FIFO
+ *
+ * @api
+ */
+void chFifoFree(ObjectsFifo *ofp, void *objp) {
+
+  chGuardedPoolFree(&ofp->of_free, objp);
+}
+
+/**
+ * @brief   Posts an object.
+ * @details The object is queued after the previously posted objects, a
+ *          thread waiting for an object is made ready but no reschedule
+ *          is performed.
+ * @note    The operation never waits because the FIFO can contain all the
+ *          objects.
+ *
+ * @param[in] ofp       pointer to an @p ObjectsFifo structure
+ * @param[in] objp      pointer to an object allocated from the same FIFO
+ *
+ * @iclass
+ */
+void chFifoPostI(ObjectsFifo *ofp, void *objp) {
+  msg_t msg;
+
+  chDbgCheckClassI();
+  chDbgCheck((ofp != NULL) && (objp != NULL), "chFifoPostI");
+
+  msg = chMBPostI(&ofp->of_mbx, (msg_t)objp);
+  chDbgAssert(msg == RDY_OK, "chFifoPostI(), #1", "mailbox full");
+  (void)msg;
+}
+
+/**
+ * @brief   Posts an object.
+ * @details The object is queued after the previously posted objects.
+ * @note    The operation never waits because the FIFO can contain all the
+ *          objects.
+ *
+ * @param[in] ofp       pointer to an @p ObjectsFifo structure
+ * @param[in] objp      pointer to an object allocated from the same FIFO
+ *
+ * @sclass
+ */
+void chFifoPostS(ObjectsFifo *ofp, void *objp) {
+
+  chFifoPostI(ofp, objp);
+  chSchRescheduleS();
+}
+
+/**
+ * @brief   Posts an object.
+ * @details The object is queued after the previously posted objects.
+ * @note    The operation never waits because the FIFO can contain all the
+ *          objects.
+ *
+ * @param[in] ofp       pointer to an @p ObjectsFifo structure
+ * @param[in] objp      pointer to an object allocated from the same FIFO
+ *
+ * @api
+ */
+void chFifoPost(ObjectsFifo *ofp, void *objp) {
+
+  chSysLock();
+  chFifoPostS(ofp, objp);
+  chSysUnlock();
+}
+
+/**
+ * @brief   Fetches an object.
+ * @details The oldest posted object is removed from the FIFO, the object
+ *          must be freed after use.
+ *
+ * @param[in] ofp       pointer to an @p ObjectsFifo structure
+ * @param[out] objpp    pointer to a pointer to object variable
+ * @return              The operation status.
+ * @retval RDY_OK       if an object has been correctly fetched.
+ * @retval RDY_TIMEOUT  if the FIFO is empty and an object cannot be
+ *                      fetched.
+ *
+ * @iclass
+ */
+msg_t chFifoFetchI(ObjectsFifo *ofp, void **objpp) {
+
+  chDbgCheck((ofp != NULL) && (objpp != NULL), "chFifoFetchI");
+
+  return chMBFetchI(&ofp->of_mbx, (msg_t *)objpp);
+}
+
+/**
+ * @brief   Fetches an object.
+ * @details The oldest posted object is removed from the FIFO, the object
+ *          must be freed after use. If the FIFO is empty then the calling
+ *          thread waits until an object is posted or the timeout expires.
+ *
+ * @param[in] ofp       pointer to an @p ObjectsFifo structure
+ * @param[out] objpp    pointer to a pointer to object variable
+ * @param[in] time      the number of ticks before the operation timeouts,
+ *                      the following special values are allowed:
+ *                      - @a TIME_IMMEDIATE immediate timeout.
+ *                      - @a TIME_INFINITE no timeout.
+ *                      .
+ * @return              The operation status.
+ * @retval RDY_OK       if an object has been correctly fetched.
+ * @retval RDY_TIMEOUT  if the operation has timed out.
+ *
+ * @sclass
+ */
+msg_t chFifoFetchTimeoutS(ObjectsFifo *ofp, void **objpp, systime_t time) {
+
+  chDbgCheck((ofp != NULL) && (objpp != NULL), "chFifoFetchTimeoutS");
+
+  return chMBFetchS(&ofp->of_mbx, (msg_t *)objpp, time);
+}
+
+/**
+ * @brief   Fetches an object.
+ * @details The oldest posted object is removed from the FIFO, the object
+ *          must be freed after use. If the FIFO is empty then the calling
+ *          thread waits until an object is posted or the timeout expires.
+ *
+ * @param[in] ofp       pointer to an @p ObjectsFifo structure
+ * @param[out] objpp    pointer to a pointer to object variable
+ * @param[in] time      the number of ticks before the operation timeouts,
+ *                      the following special values are allowed:
+ *                      - @a TIME_IMMEDIATE immediate timeout.
+ *                      - @a TIME_INFINITE no timeout.
+ *                      .
+ * @return              The operation status.
+ * @retval RDY_OK       if an object has been correctly fetched.
+ * @retval RDY_TIMEOUT  if the operation has timed out.
+ *
+ * @api
+ */
+msg_t chFifoFetchTimeout(ObjectsFifo *ofp, void **objpp, systime_t time) {
+  msg_t msg;
+
+  chSysLock();
+  msg = chFifoFetchTimeoutS(ofp, objpp, time);
+  chSysUnlock();
+  return msg;
+}
+
+/**
+ * @brief   Returns the oldest posted object without removing it.
+ *
+ * @param[in] ofp       pointer to an @p ObjectsFifo structure
+ * @return              The pointer to the oldest posted object.
+ * @retval NULL         if the FIFO is empty.
+ *
+ * @iclass
+ */
+void *chFifoPeekI(ObjectsFifo *ofp) {
+
+  chDbgCheckClassI();
+  chDbgCheck(ofp != NULL, "chFifoPeekI");
+
+  if (chMBGetUsedCountI(&ofp->of_mbx) <= 0)
+    return NULL;
+  return (void *)chMBPeekI(&ofp->of_mbx);
+}
+
+#endif /* CH_USE_OBJFIFOS */
+
+/** @} */
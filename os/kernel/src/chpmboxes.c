@@ -0,0 +1,421 @@
+/*
+    ChibiOS/RT - Copyright (C) 2006,2007,2008,2009,2010,
+                 2011,2012,2013 Giovanni Di Sirio.
+
+    This file is part of ChibiOS/RT.
+
+    ChibiOS/RT is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    ChibiOS/RT is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * @file    chpmboxes.c
+ * @brief   Priority mailboxes code.
+ *
+ * @addtogroup pmailboxes
+ * @details Asynchronous messages with priority levels.
+ *          <h2>Operation mode</h2>
+ *          A priority mailbox is a mailbox made of several lanes, each
+ *          lane is a FIFO of messages with its own capacity. Messages are
+ *          posted in the lane matching their priority and are always
+ *          fetched from the highest priority non-empty lane, lanes with
+ *          higher index have higher priority.<br>
+ *          A bitmap of the non-empty lanes is kept so that the lane to be
+ *          served is found in constant time regardless of the number of
+ *          queued messages.<br>
+ *          Operations defined for priority mailboxes:
+ *          - <b>Post</b>: Posts a message in the lane of the specified
+ *            priority, the caller can wait with a timeout for an empty
+ *            slot in that lane, a full lane does not affect the others.
+ *          - <b>Fetch</b>: The oldest message of the highest priority
+ *            non-empty lane is fetched and removed, the caller can wait
+ *            with a timeout for a message to be posted.
+ *          - <b>Reset</b>: All the lanes are emptied and all the stored
+ *            messages are lost.
+ *          .
+ * @pre     In order to use the priority mailboxes APIs the
+ *          @p CH_USE_PRIO_MAILBOXES option must be enabled in @p chconf.h.
+ * @{
+ */
+
+#include "ch.h"
+
+#if CH_USE_PRIO_MAILBOXES || defined(__DOXYGEN__)
+
+/**
+ * @brief   Returns the highest priority lane in a non-empty bitmap.
+ *
+ * @param[in] map       the lanes bitmap, must not be zero
+ * @return              The index of the highest set bit.
+ */
+static cnt_t pmb_highest(lanemap_t map) {
+  static const uint8_t msb[16] = {0, 0, 1, 1, 2, 2, 2, 2,
+                                  3, 3, 3, 3, 3, 3, 3, 3};
+  cnt_t n = 0;
+
+  if (map & 0xFFFF0000) {
+    map >>= 16;
+    n += 16;
+  }
+  if (map & 0xFF00) {
+    map >>= 8;
+    n += 8;
+  }
+  if (map & 0xF0) {
+    map >>= 4;
+    n += 4;
+  }
+  return n + msb[map];
+}
+
+/**
+ * @brief   Initializes a priority mailbox lane.
+ * @note    The lanes must be initialized before the priority mailbox
+ *          they belong to.
+ *
+ * @param[out] mlp      the pointer to the @p MailboxLane structure to be
+ *                      initialized
+ * @param[in] buf       pointer to the messages buffer as an array of @p msg_t
+ * @param[in] n         number of elements in the buffer array
+ *
+ * @init
+ */
+void chPMBLaneInit(MailboxLane *mlp, msg_t *buf, cnt_t n) {
+
+  chDbgCheck((mlp != NULL) && (buf != NULL) && (n > 0), "chPMBLaneInit");
+
+  mlp->ml_buffer = mlp->ml_wrptr = mlp->ml_rdptr = buf;
+  mlp->ml_top = &buf[n];
+  mlp->ml_cnt = 0;
+  chSemInit(&mlp->ml_emptysem, n);
+}
+
+/**
+ * @brief   Initializes a @p PriorityMailbox object.
+ *
+ * @param[out] pmbp     the pointer to the @p PriorityMailbox structure to
+ *                      be initialized
+ * @param[in] lanes     pointer to an array of initialized @p MailboxLane
+ *                      objects, the lane of index zero has the lowest
+ *                      priority
+ * @param[in] n         number of lanes, from 1 to @p PMB_MAX_LANES
+ *
+ * @init
+ */
+void chPMBInit(PriorityMailbox *pmbp, MailboxLane *lanes, cnt_t n) {
+
+  chDbgCheck((pmbp != NULL) && (lanes != NULL) &&
+             (n > 0) && (n <= PMB_MAX_LANES), "chPMBInit");
+
+  pmbp->pmb_lanes = lanes;
+  pmbp->pmb_n = n;
+  pmbp->pmb_map = 0;
+  chSemInit(&pmbp->pmb_fullsem, 0);
+}
+
+/**
+ * @brief   Resets a @p PriorityMailbox object.
+ * @details All the waiting threads are resumed with status @p RDY_RESET and
+ *          the queued messages are lost.
+ * @post    This function does not reschedule so a call to a rescheduling
+ *          function must be performed before unlocking the kernel. Note that
+ *          interrupt handlers always reschedule on exit so an explicit
+ *          reschedule must not be performed in ISRs.
+ *
+ * @param[in] pmbp      the pointer to an initialized @p PriorityMailbox
+ *                      object
+ *
+ * @iclass
+ */
+void chPMBResetI(PriorityMailbox *pmbp) {
+  MailboxLane *mlp;
+
+  chDbgCheckClassI();
+  chDbgCheck(pmbp != NULL, "chPMBResetI");
+
+  for (mlp = pmbp->pmb_lanes; mlp < &pmbp->pmb_lanes[pmbp->pmb_n]; mlp++) {
+    mlp->ml_wrptr = mlp->ml_rdptr = mlp->ml_buffer;
+    mlp->ml_cnt = 0;
+    chSemResetI(&mlp->ml_emptysem, mlp->ml_top - mlp->ml_buffer);
+  }
+  pmbp->pmb_map = 0;
+  chSemResetI(&pmbp->pmb_fullsem, 0);
+}
+
+/**
+ * @brief   Resets a @p PriorityMailbox object.
+ * @details All the waiting threads are resumed with status @p RDY_RESET and
+ *          the queued messages are lost.
+ *
+ * @param[in] pmbp      the pointer to an initialized @p PriorityMailbox
+ *                      object
+ *
+ * @api
+ */
+void chPMBReset(PriorityMailbox *pmbp) {
+
+  chSysLock();
+  chPMBResetI(pmbp);
+  chSchRescheduleS();
+  chSysUnlock();
+}
+
+/**
+ * @brief   Posts a message into a priority mailbox.
+ * @details The invoking thread waits until an empty slot in the lane of the
+ *          specified priority becomes available or the specified time runs
+ *          out.
+ *
+ * @param[in] pmbp      the pointer to an initialized @p PriorityMailbox
+ *                      object
+ * @param[in] msg       the message to be posted on the mailbox
+ * @param[in] prio      the message priority, it is the index of the lane
+ * @param[in] time      the number of ticks before the operation timeouts,
+ *                      the following special values are allowed:
+ *                      - @a TIME_IMMEDIATE immediate timeout.
+ *                      - @a TIME_INFINITE no timeout.
+ *                      .
+ * @return              The operation status.
+ * @retval RDY_OK       if a message has been correctly posted.
+ * @retval RDY_RESET    if the mailbox has been reset while waiting.
+ * @retval RDY_TIMEOUT  if the operation has timed out.
+ *
+ * @api
+ */
+msg_t chPMBPost(PriorityMailbox *pmbp, msg_t msg, cnt_t prio,
+                systime_t time) {
+  msg_t rdymsg;
+
+  chSysLock();
+  rdymsg = chPMBPostS(pmbp, msg, prio, time);
+  chSysUnlock();
+  return rdymsg;
+}
+
+/**
+ * @brief   Posts a message into a priority mailbox.
+ * @details The invoking thread waits until an empty slot in the lane of the
+ *          specified priority becomes available or the specified time runs
+ *          out.
+ *
+ * @param[in] pmbp      the pointer to an initialized @p PriorityMailbox
+ *                      object
+ * @param[in] msg       the message to be posted on the mailbox
+ * @param[in] prio      the message priority, it is the index of the lane
+ * @param[in] time      the number of ticks before the operation timeouts,
+ *                      the following special values are allowed:
+ *                      - @a TIME_IMMEDIATE immediate timeout.
+ *                      - @a TIME_INFINITE no timeout.
+ *                      .
+ * @return              The operation status.
+ * @retval RDY_OK       if a message has been correctly posted.
+ * @retval RDY_RESET    if the mailbox has been reset while waiting.
+ * @retval RDY_TIMEOUT  if the operation has timed out.
+ *
+ * @sclass
+ */
+msg_t chPMBPostS(PriorityMailbox *pmbp, msg_t msg, cnt_t prio,
+                 systime_t time) {
+  MailboxLane *mlp;
+  msg_t rdymsg;
+
+  chDbgCheckClassS();
+  chDbgCheck((pmbp != NULL) && (prio >= 0) && (prio < pmbp->pmb_n),
+             "chPMBPostS");
+
+  mlp = &pmbp->pmb_lanes[prio];
+  rdymsg = chSemWaitTimeoutS(&mlp->ml_emptysem, time);
+  if (rdymsg == RDY_OK) {
+    *mlp->ml_wrptr++ = msg;
+    if (mlp->ml_wrptr >= mlp->ml_top)
+      mlp->ml_wrptr = mlp->ml_buffer;
+    mlp->ml_cnt++;
+    pmbp->pmb_map |= (lanemap_t)1 << prio;
+    chSemSignalI(&pmbp->pmb_fullsem);
+    chSchRescheduleS();
+  }
+  return rdymsg;
+}
+
+/**
+ * @brief   Posts a message into a priority mailbox.
+ * @details This variant is non-blocking, the function returns a timeout
+ *          condition if the lane of the specified priority is full.
+ *
+ * @param[in] pmbp      the pointer to an initialized @p PriorityMailbox
+ *                      object
+ * @param[in] msg       the message to be posted on the mailbox
+ * @param[in] prio      the message priority, it is the index of the lane
+ * @return              The operation status.
+ * @retval RDY_OK       if a message has been correctly posted.
+ * @retval RDY_TIMEOUT  if the lane is full and the message cannot be
+ *                      posted.
+ *
+ * @iclass
+ */
+msg_t chPMBPostI(PriorityMailbox *pmbp, msg_t msg, cnt_t prio) {
+  MailboxLane *mlp;
+
+  chDbgCheckClassI();
+  chDbgCheck((pmbp != NULL) && (prio >= 0) && (prio < pmbp->pmb_n),
+             "chPMBPostI");
+
+  mlp = &pmbp->pmb_lanes[prio];
+  if (chSemGetCounterI(&mlp->ml_emptysem) <= 0)
+    return RDY_TIMEOUT;
+  chSemFastWaitI(&mlp->ml_emptysem);
+  *mlp->ml_wrptr++ = msg;
+  if (mlp->ml_wrptr >= mlp->ml_top)
+    mlp->ml_wrptr = mlp->ml_buffer;
+  mlp->ml_cnt++;
+  pmbp->pmb_map |= (lanemap_t)1 << prio;
+  chSemSignalI(&pmbp->pmb_fullsem);
+  return RDY_OK;
+}
+
+/**
+ * @brief   Dequeues the highest priority message.
+ * @pre     At least a message must be queued and the full counter must
+ *          have been already decreased.
+ *
+ * @param[in] pmbp      the pointer to an initialized @p PriorityMailbox
+ *                      object
+ * @param[out] msgp     pointer to a message variable for the received
+ *                      message
+ * @param[out] priop    pointer to a variable receiving the message priority,
+ *                      can be @p NULL
+ */
+static void pmb_dequeue(PriorityMailbox *pmbp, msg_t *msgp, cnt_t *priop) {
+  MailboxLane *mlp;
+  cnt_t prio;
+
+  chDbgAssert(pmbp->pmb_map != 0, "pmb_dequeue(), #1", "empty lanes map");
+
+  prio = pmb_highest(pmbp->pmb_map);
+  mlp = &pmbp->pmb_lanes[prio];
+  *msgp = *mlp->ml_rdptr++;
+  if (mlp->ml_rdptr >= mlp->ml_top)
+    mlp->ml_rdptr = mlp->ml_buffer;
+  if (--mlp->ml_cnt == 0)
+    pmbp->pmb_map &= ~((lanemap_t)1 << prio);
+  chSemSignalI(&mlp->ml_emptysem);
+  if (priop != NULL)
+    *priop = prio;
+}
+
+/**
+ * @brief   Retrieves a message from a priority mailbox.
+ * @details The invoking thread waits until a message is posted in any lane
+ *          of the mailbox or the specified time runs out. The oldest message
+ *          of the highest priority non-empty lane is returned.
+ *
+ * @param[in] pmbp      the pointer to an initialized @p PriorityMailbox
+ *                      object
+ * @param[out] msgp     pointer to a message variable for the received
+ *                      message
+ * @param[out] priop    pointer to a variable receiving the message priority,
+ *                      can be @p NULL
+ * @param[in] time      the number of ticks before the operation timeouts,
+ *                      the following special values are allowed:
+ *                      - @a TIME_IMMEDIATE immediate timeout.
+ *                      - @a TIME_INFINITE no timeout.
+ *                      .
+ * @return              The operation status.
+ * @retval RDY_OK       if a message has been correctly fetched.
+ * @retval RDY_RESET    if the mailbox has been reset while waiting.
+ * @retval RDY_TIMEOUT  if the operation has timed out.
+ *
+ * @api
+ */
+msg_t chPMBFetch(PriorityMailbox *pmbp, msg_t *msgp, cnt_t *priop,
+                 systime_t time) {
+  msg_t rdymsg;
+
+  chSysLock();
+  rdymsg = chPMBFetchS(pmbp, msgp, priop, time);
+  chSysUnlock();
+  return rdymsg;
+}
+
+/**
+ * @brief   Retrieves a message from a priority mailbox.
+ * @details The invoking thread waits until a message is posted in any lane
+ *          of the mailbox or the specified time runs out. The oldest message
+ *          of the highest priority non-empty lane is returned.
+ *
+ * @param[in] pmbp      the pointer to an initialized @p PriorityMailbox
+ *                      object
+ * @param[out] msgp     pointer to a message variable for the received
+ *                      message
+ * @param[out] priop    pointer to a variable receiving the message priority,
+ *                      can be @p NULL
+ * @param[in] time      the number of ticks before the operation timeouts,
+ *                      the following special values are allowed:
+ *                      - @a TIME_IMMEDIATE immediate timeout.
+ *                      - @a TIME_INFINITE no timeout.
+ *                      .
+ * @return              The operation status.
+ * @retval RDY_OK       if a message has been correctly fetched.
+ * @retval RDY_RESET    if the mailbox has been reset while waiting.
+ * @retval RDY_TIMEOUT  if the operation has timed out.
+ *
+ * @sclass
+ */
+msg_t chPMBFetchS(PriorityMailbox *pmbp, msg_t *msgp, cnt_t *priop,
+                  systime_t time) {
+  msg_t rdymsg;
+
+  chDbgCheckClassS();
+  chDbgCheck((pmbp != NULL) && (msgp != NULL), "chPMBFetchS");
+
+  rdymsg = chSemWaitTimeoutS(&pmbp->pmb_fullsem, time);
+  if (rdymsg == RDY_OK) {
+    pmb_dequeue(pmbp, msgp, priop);
+    chSchRescheduleS();
+  }
+  return rdymsg;
+}
+
+/**
+ * @brief   Retrieves a message from a priority mailbox.
+ * @details This variant is non-blocking, the function returns a timeout
+ *          condition if the mailbox is empty.
+ *
+ * @param[in] pmbp      the pointer to an initialized @p PriorityMailbox
+ *                      object
+ * @param[out] msgp     pointer to a message variable for the received
+ *                      message
+ * @param[out] priop    pointer to a variable receiving the message priority,
+ *                      can be @p NULL
+ * @return              The operation status.
+ * @retval RDY_OK       if a message has been correctly fetched.
+ * @retval RDY_TIMEOUT  if the mailbox is empty and a message cannot be
+ *                      fetched.
+ *
+ * @iclass
+ */
+msg_t chPMBFetchI(PriorityMailbox *pmbp, msg_t *msgp, cnt_t *priop) {
+
+  chDbgCheckClassI();
+  chDbgCheck((pmbp != NULL) && (msgp != NULL), "chPMBFetchI");
+
+  if (chSemGetCounterI(&pmbp->pmb_fullsem) <= 0)
+    return RDY_TIMEOUT;
+  chSemFastWaitI(&pmbp->pmb_fullsem);
+  pmb_dequeue(pmbp, msgp, priop);
+  return RDY_OK;
+}
+
+#endif /* CH_USE_PRIO_MAILBOXES */
+
+/** @} */
@@ -36,11 +36,17 @@
  *            are implemented by pairing an input queue and an output queue
  *            together.
  *          .
+ *          Both sides can transfer blocks of data in a single critical zone
+ *          and can access the queue buffer in place through spans, the
+ *          contiguous readable or writable regions of the buffer, avoiding
+ *          any copy.
  * @pre     In order to use the I/O queues the @p CH_USE_QUEUES option must
  *          be enabled in @p chconf.h.
  * @{
  */
 
+#include <string.h>
+
 #include "ch.h"
 
 #if CH_USE_QUEUES || defined(__DOXYGEN__)
@@ -69,6 +75,95 @@ static msg_t qwait(GenericQueue *qp, systime_t time) {
   return chSchGoSleepTimeoutS(THD_STATE_WTQUEUE, time);
 }
 
+/**
+ * @brief   Wakes up all the threads waiting on a queue.
+ *
+ * @param[in] qp        pointer to an @p GenericQueue structure
+ */
+static void qwakeup(GenericQueue *qp) {
+
+  while (notempty(&qp->q_waiting))
+    chSchReadyI(fifo_remove(&qp->q_waiting))->p_u.rdymsg = Q_OK;
+}
+
+/**
+ * @brief   Copies data out of the queue buffer.
+ * @details The data is copied starting from the read pointer and the read
+ *          pointer is advanced, the counter is not updated.
+ * @pre     The specified amount of data must be available in the buffer.
+ *
+ * @param[in] qp        pointer to an @p GenericQueue structure
+ * @param[out] bp       pointer to the data buffer
+ * @param[in] n         amount of data to be copied
+ */
+static void qcopyout(GenericQueue *qp, uint8_t *bp, size_t n) {
+  size_t s = (size_t)(qp->q_top - qp->q_rdptr);
+
+  if (n < s) {
+    memcpy(bp, qp->q_rdptr, n);
+    qp->q_rdptr += n;
+  }
+  else {
+    memcpy(bp, qp->q_rdptr, s);
+    memcpy(bp + s, qp->q_buffer, n - s);
+    qp->q_rdptr = qp->q_buffer + (n - s);
+  }
+}
+
+/**
+ * @brief   Copies data into the queue buffer.
+ * @details The data is copied starting from the write pointer and the write
+ *          pointer is advanced, the counter is not updated.
+ * @pre     The specified amount of space must be available in the buffer.
+ *
+ * @param[in] qp        pointer to an @p GenericQueue structure
+ * @param[in] bp        pointer to the data buffer
+ * @param[in] n         amount of data to be copied
+ */
+static void qcopyin(GenericQueue *qp, const uint8_t *bp, size_t n) {
+  size_t s = (size_t)(qp->q_top - qp->q_wrptr);
+
+  if (n < s) {
+    memcpy(qp->q_wrptr, bp, n);
+    qp->q_wrptr += n;
+  }
+  else {
+    memcpy(qp->q_wrptr, bp, s);
+    memcpy(qp->q_buffer, bp + s, n - s);
+    qp->q_wrptr = qp->q_buffer + (n - s);
+  }
+}
+
+/**
+ * @brief   Advances a queue pointer.
+ *
+ * @param[in] qp        pointer to an @p GenericQueue structure
+ * @param[in] p         the pointer to be advanced
+ * @param[in] n         number of bytes
+ * @return              The advanced pointer.
+ */
+static uint8_t *qadvance(GenericQueue *qp, uint8_t *p, size_t n) {
+
+  p += n;
+  if (p >= qp->q_top)
+    p -= chQSizeI(qp);
+  return p;
+}
+
+/**
+ * @brief   Returns the size of the contiguous region starting at a pointer.
+ *
+ * @param[in] qp        pointer to an @p GenericQueue structure
+ * @param[in] p         start of the region
+ * @param[in] n         total size of the region, possibly wrapping
+ * @return              The size of the contiguous part of the region.
+ */
+static size_t qspan(GenericQueue *qp, uint8_t *p, size_t n) {
+  size_t s = (size_t)(qp->q_top - p);
+
+  return n < s ? n : s;
+}
+
 /**
  * @brief   Initializes an input queue.
  * @details A Semaphore is internally initialized and works as a counter of
@@ -148,6 +243,126 @@ msg_t chIQPutI(InputQueue *iqp, uint8_t b) {
   return Q_OK;
 }
 
+/**
+ * @brief   Input queue write of multiple bytes.
+ * @details The data is written into the low end of an input queue, the
+ *          operation writes as much data as the queue can accept and it is
+ *          performed in a single critical zone. Any thread waiting on the
+ *          queue is awakened.
+ * @note    This function is meant for drivers having hardware FIFOs or
+ *          buffers, it is much faster than multiple @p chIQPutI() calls.
+ *
+ * @param[in] iqp       pointer to an @p InputQueue structure
+ * @param[in] bp        pointer to the data buffer
+ * @param[in] n         the maximum amount of data to be written
+ * @return              The number of bytes effectively written.
+ * @retval 0            if the queue is full.
+ *
+ * @iclass
+ */
+size_t chIQWriteI(InputQueue *iqp, const uint8_t *bp, size_t n) {
+  size_t e;
+
+  chDbgCheckClassI();
+
+  e = chIQGetEmptyI(iqp);
+  if (n > e)
+    n = e;
+  if (n > 0) {
+    qcopyin(iqp, bp, n);
+    iqp->q_counter += n;
+    qwakeup(iqp);
+  }
+  return n;
+}
+
+/**
+ * @brief   Returns the readable contiguous region of an input queue.
+ * @details The region starts at the queue read pointer, the data can be
+ *          consumed in place and then released using
+ *          @p chIQReadCommitS().
+ * @note    Only the thread reading the queue can use this function, the
+ *          region is stable until released unless the queue is reset.
+ *
+ * @param[in] iqp       pointer to an @p InputQueue structure
+ * @param[out] bpp      pointer to a variable receiving the region address
+ * @return              The size of the region.
+ * @retval 0            if the queue is empty.
+ *
+ * @iclass
+ */
+size_t chIQGetReadSpanI(InputQueue *iqp, uint8_t **bpp) {
+
+  chDbgCheckClassI();
+
+  *bpp = iqp->q_rdptr;
+  return qspan(iqp, iqp->q_rdptr, chIQGetFullI(iqp));
+}
+
+/**
+ * @brief   Releases data read in place from an input queue.
+ * @note    The notification callback is invoked after releasing the data.
+ *
+ * @param[in] iqp       pointer to an @p InputQueue structure
+ * @param[in] n         number of bytes to be released, it must not exceed
+ *                      the size of the region returned by
+ *                      @p chIQGetReadSpanI()
+ *
+ * @sclass
+ */
+void chIQReadCommitS(InputQueue *iqp, size_t n) {
+
+  chDbgCheckClassS();
+  chDbgCheck(n <= chIQGetFullI(iqp), "chIQReadCommitS");
+
+  iqp->q_rdptr = qadvance(iqp, iqp->q_rdptr, n);
+  iqp->q_counter -= n;
+  if (iqp->q_notify)
+    iqp->q_notify(iqp);
+}
+
+/**
+ * @brief   Returns the writable contiguous region of an input queue.
+ * @details The region starts at the queue write pointer, a driver can fill
+ *          it in place, for example using a DMA, and then make the data
+ *          available using @p chIQWriteCommitI().
+ *
+ * @param[in] iqp       pointer to an @p InputQueue structure
+ * @param[out] bpp      pointer to a variable receiving the region address
+ * @return              The size of the region.
+ * @retval 0            if the queue is full.
+ *
+ * @iclass
+ */
+size_t chIQGetWriteSpanI(InputQueue *iqp, uint8_t **bpp) {
+
+  chDbgCheckClassI();
+
+  *bpp = iqp->q_wrptr;
+  return qspan(iqp, iqp->q_wrptr, chIQGetEmptyI(iqp));
+}
+
+/**
+ * @brief   Makes data written in place available in an input queue.
+ * @details Any thread waiting on the queue is awakened.
+ *
+ * @param[in] iqp       pointer to an @p InputQueue structure
+ * @param[in] n         number of bytes written, it must not exceed the
+ *                      size of the region returned by
+ *                      @p chIQGetWriteSpanI()
+ *
+ * @iclass
+ */
+void chIQWriteCommitI(InputQueue *iqp, size_t n) {
+
+  chDbgCheckClassI();
+  chDbgCheck(n <= chIQGetEmptyI(iqp), "chIQWriteCommitI");
+
+  iqp->q_wrptr = qadvance(iqp, iqp->q_wrptr, n);
+  iqp->q_counter += n;
+  qwakeup(iqp);
+}
+
 /**
  * @brief   Input queue read with timeout.
  * @details This function reads a byte value from an input queue. If the queue
@@ -200,7 +415,9 @@ msg_t chIQGetTimeout(InputQueue *iqp, systime_t time) {
  *          been reset.
  * @note    The function is not atomic, if you need atomicity it is suggested
  *          to use a semaphore or a mutex for mutual exclusion.
- * @note    The callback is invoked before reading each character from the
+ * @note    The data available in the queue is copied in contiguous runs,
+ *          one run for each critical zone.
+ * @note    The callback is invoked before reading each run of data from the
  *          buffer or before entering the state @p THD_STATE_WTQUEUE.
  *
  * @param[in] iqp       pointer to an @p InputQueue structure
@@ -225,6 +442,8 @@ size_t chIQReadTimeout(InputQueue *iqp, uint8_t *bp,
 
   chSysLock();
   while (TRUE) {
+    size_t done;
+
     if (nfy)
       nfy(iqp);
 
@@ -235,15 +454,18 @@ size_t chIQReadTimeout(InputQueue *iqp, uint8_t *bp,
       }
     }
 
-    iqp->q_counter--;
-    *bp++ = *iqp->q_rdptr++;
-    if (iqp->q_rdptr >= iqp->q_top)
-      iqp->q_rdptr = iqp->q_buffer;
+    done = chIQGetFullI(iqp);
+    if (done > n)
+      done = n;
+    qcopyout(iqp, bp, done);
+    iqp->q_counter -= done;
 
     chSysUnlock(); /* Gives a preemption chance in a controlled point.*/
-    r++;
-    if (--n == 0)
+    r += done;
+    n -= done;
+    if (n == 0)
       return r;
+    bp += done;
 
     chSysLock();
   }
@@ -372,6 +594,126 @@ msg_t chOQGetI(OutputQueue *oqp) {
   return b;
 }
 
+/**
+ * @brief   Output queue read of multiple bytes.
+ * @details The data is read from the low end of an output queue, the
+ *          operation reads as much data as available and it is performed
+ *          in a single critical zone. Any thread waiting on the queue is
+ *          awakened.
+ * @note    This function is meant for drivers having hardware FIFOs or
+ *          buffers, it is much faster than multiple @p chOQGetI() calls.
+ *
+ * @param[in] oqp       pointer to an @p OutputQueue structure
+ * @param[out] bp       pointer to the data buffer
+ * @param[in] n         the maximum amount of data to be read
+ * @return              The number of bytes effectively read.
+ * @retval 0            if the queue is empty.
+ *
+ * @iclass
+ */
+size_t chOQReadI(OutputQueue *oqp, uint8_t *bp, size_t n) {
+  size_t f;
+
+  chDbgCheckClassI();
+
+  f = chOQGetFullI(oqp);
+  if (n > f)
+    n = f;
+  if (n > 0) {
+    qcopyout(oqp, bp, n);
+    oqp->q_counter += n;
+    qwakeup(oqp);
+  }
+  return n;
+}
+
+/**
+ * @brief   Returns the writable contiguous region of an output queue.
+ * @details The region starts at the queue write pointer, the data can be
+ *          composed in place and then made available using
+ *          @p chOQWriteCommitS().
+ * @note    Only the thread writing the queue can use this function, the
+ *          region is stable until committed unless the queue is reset.
+ *
+ * @param[in] oqp       pointer to an @p OutputQueue structure
+ * @param[out] bpp      pointer to a variable receiving the region address
+ * @return              The size of the region.
+ * @retval 0            if the queue is full.
+ *
+ * @iclass
+ */
+size_t chOQGetWriteSpanI(OutputQueue *oqp, uint8_t **bpp) {
+
+  chDbgCheckClassI();
+
+  *bpp = oqp->q_wrptr;
+  return qspan(oqp, oqp->q_wrptr, chOQGetEmptyI(oqp));
+}
+
+/**
+ * @brief   Makes data written in place available in an output queue.
+ * @note    The notification callback is invoked after committing the data.
+ *
+ * @param[in] oqp       pointer to an @p OutputQueue structure
+ * @param[in] n         number of bytes written, it must not exceed the
+ *                      size of the region returned by
+ *                      @p chOQGetWriteSpanI()
+ *
+ * @sclass
+ */
+void chOQWriteCommitS(OutputQueue *oqp, size_t n) {
+
+  chDbgCheckClassS();
+  chDbgCheck(n <= chOQGetEmptyI(oqp), "chOQWriteCommitS");
+
+  oqp->q_wrptr = qadvance(oqp, oqp->q_wrptr, n);
+  oqp->q_counter -= n;
+  if (oqp->q_notify)
+    oqp->q_notify(oqp);
+}
+
+/**
+ * @brief   Returns the readable contiguous region of an output queue.
+ * @details The region starts at the queue read pointer, a driver can
+ *          transmit the data in place, for example using a DMA, and then
+ *          release it using @p chOQReadCommitI().
+ *
+ * @param[in] oqp       pointer to an @p OutputQueue structure
+ * @param[out] bpp      pointer to a variable receiving the region address
+ * @return              The size of the region.
+ * @retval 0            if the queue is empty.
+ *
+ * @iclass
+ */
+size_t chOQGetReadSpanI(OutputQueue *oqp, uint8_t **bpp) {
+
+  chDbgCheckClassI();
+
+  *bpp = oqp->q_rdptr;
+  return qspan(oqp, oqp->q_rdptr, chOQGetFullI(oqp));
+}
+
+/**
+ * @brief   Releases data read in place from an output queue.
+ * @details Any thread waiting on the queue is awakened.
+ *
+ * @param[in] oqp       pointer to an @p OutputQueue structure
+ * @param[in] n         number of bytes to be released, it must not exceed
+ *                      the size of the region returned by
+ *                      @p chOQGetReadSpanI()
+ *
+ * @iclass
+ */
+void chOQReadCommitI(OutputQueue *oqp, size_t n) {
+
+  chDbgCheckClassI();
+  chDbgCheck(n <= chOQGetFullI(oqp), "chOQReadCommitI");
+
+  oqp->q_rdptr = qadvance(oqp, oqp->q_rdptr, n);
+  oqp->q_counter += n;
+  qwakeup(oqp);
+}
+
 /**
  * @brief   Output queue write with timeout.
  * @details The function writes data from a buffer to an output queue. The
@@ -380,7 +722,9 @@ msg_t chOQGetI(OutputQueue *oqp) {
  *          been reset.
  * @note    The function is not atomic, if you need atomicity it is suggested
  *          to use a semaphore or a mutex for mutual exclusion.
- * @note    The callback is invoked after writing each character into the
+ * @note    The data is copied in contiguous runs, one run for each critical
+ *          zone.
+ * @note    The callback is invoked after writing each run of data into the
  *          buffer.
  *
  * @param[in] oqp       pointer to an @p OutputQueue structure
@@ -405,24 +749,29 @@ size_t chOQWriteTimeout(OutputQueue *oqp, const uint8_t *bp,
 
   chSysLock();
   while (TRUE) {
+    size_t done;
+
     while (chOQIsFullI(oqp)) {
       if (qwait((GenericQueue *)oqp, time) != Q_OK) {
         chSysUnlock();
         return w;
       }
     }
-    oqp->q_counter--;
-    *oqp->q_wrptr++ = *bp++;
-    if (oqp->q_wrptr >= oqp->q_top)
-      oqp->q_wrptr = oqp->q_buffer;
+    done = chOQGetEmptyI(oqp);
+    if (done > n)
+      done = n;
+    qcopyin(oqp, bp, done);
+    oqp->q_counter -= done;
 
     if (nfy)
       nfy(oqp);
 
     chSysUnlock(); /* Gives a preemption chance in a controlled point.*/
-    w++;
-    if (--n == 0)
+    w += done;
+    n -= done;
+    if (n == 0)
       return w;
+    bp += done;
     chSysLock();
   }
 }
@@ -151,6 +151,46 @@ Thread *chRegNextThread(Thread *tp) {
   return ntp;
 }
 
+#if CH_DBG_FILL_THREADS || defined(__DOXYGEN__)
+/**
+ * @brief   Returns the peak stack usage of a thread.
+ * @details The thread stack area is scanned starting from its limit, the
+ *          bytes still holding the @p CH_STACK_FILL_VALUE value have never
+ *          been touched by the thread.
+ * @pre     The @p CH_DBG_FILL_THREADS debug option must be enabled.
+ * @note    The returned value includes the size of the @p Thread structure
+ *          and so it is directly comparable with the working area size.
+ * @note    Threads created using @p chThdCreateI() are not filled, the
+ *          reported usage is meaningful only if the working area has been
+ *          filled by the application.
+ * @note    The main thread has no working area and reports zero for both
+ *          values.
+ *
+ * @param[in] tp        pointer to the thread
+ * @param[out] sizep    pointer to a variable that will receive the working
+ *                      area size, it can be @p NULL
+ * @return              The peak number of bytes of the working area used
+ *                      by the thread.
+ *
+ * @api
+ */
+size_t chRegGetStackUsage(Thread *tp, size_t *sizep) {
+  uint8_t *p, *endp;
+
+  chDbgCheck(tp != NULL, "chRegGetStackUsage");
+
+  if (sizep != NULL)
+    *sizep = tp->p_wasize;
+  if (tp->p_wasize == 0)
+    return 0;
+  p = (uint8_t *)(tp + 1);
+  endp = (uint8_t *)tp + tp->p_wasize;
+  while ((p < endp) && (*p == CH_STACK_FILL_VALUE))
+    p++;
+  return (size_t)(endp - p) + sizeof(Thread);
+}
+#endif /* CH_DBG_FILL_THREADS */
+
 #endif /* CH_USE_REGISTRY */
 
 /** @} */
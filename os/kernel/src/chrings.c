@@ -0,0 +1,378 @@
+/*
+    ChibiOS/RT - Copyright (C) 2006,2007,2008,2009,2010,
+                 2011,2012,2013 Giovanni Di Sirio.
+
+    This file is part of ChibiOS/RT.
+
+    ChibiOS/RT is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    ChibiOS/RT is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * @file    chrings.c
+ * @brief   Ring Buffers code.
+ *
+ * @addtogroup rings
+ * @details Lock-free single producer, single consumer ring buffers meant
+ *          for streaming data from an interrupt handler to a thread.
+ *          <h2>Operation mode</h2>
+ *          A ring buffer is an array of fixed size records, a power of two
+ *          in number, addressed by two free running indexes. The head index
+ *          is only written by the producer and the tail index is only
+ *          written by the consumer so both sides can access the buffer
+ *          without entering a critical zone, the record is always written
+ *          before the index is advanced.<br>
+ *          The consumer only blocks when the buffer is empty, a binary
+ *          semaphore is signaled by the producer on the empty to non-empty
+ *          transition so the common case, a put into a non-empty buffer,
+ *          does not involve the kernel at all.<br>
+ *          Operations defined for ring buffers:
+ *          - <b>Put</b>: A record, or a byte, is written into the buffer,
+ *            the operation fails if the buffer is full.
+ *          - <b>Get</b>: A record, or a byte, is read from the buffer, the
+ *            caller can wait with a timeout for data to arrive.
+ *          .
+ * @pre     In order to use the ring buffers APIs the @p CH_USE_RINGS
+ *          option must be enabled in @p chconf.h.
+ * @note    There must be a single producer and a single consumer, the
+ *          producer and the consumer must run on the same core.
+ * @{
+ */
+
+#include "ch.h"
+
+#if CH_USE_RINGS || defined(__DOXYGEN__)
+
+/**
+ * @brief   Result of a successful put that found the buffer empty.
+ */
+#define RING_WAKEUP     ((msg_t)1)
+
+/**
+ * @brief   Writes a record into the ring buffer.
+ *
+ * @param[in] rbp       pointer to a @p RingBuffer structure
+ * @param[in] recp      pointer to the record
+ * @return              The operation status.
+ * @retval RING_OK      if the operation succeeded.
+ * @retval RING_WAKEUP  if the operation succeeded and the buffer was empty.
+ * @retval RING_FULL    if the buffer is full.
+ */
+static msg_t ring_put(RingBuffer *rbp, const void *recp) {
+  size_t head = rbp->rb_head;
+
+  if (head - rbp->rb_tail > rbp->rb_mask)
+    return RING_FULL;
+  volatile_copy(rbp->rb_buffer + (head & rbp->rb_mask) * rbp->rb_recsize,
+                recp, rbp->rb_recsize);
+  rbp->rb_head = head + 1;
+
+  /* If the consumer had already read everything then it could be sleeping
+     on the semaphore.*/
+  return rbp->rb_tail == head ? RING_WAKEUP : RING_OK;
+}
+
+/**
+ * @brief   Writes a byte into the ring buffer.
+ * @note    Specialized version of @p ring_put() for byte ring buffers.
+ *
+ * @param[in] rbp       pointer to a @p RingBuffer structure
+ * @param[in] b         the byte value to be written
+ * @return              The operation status.
+ * @retval RING_OK      if the operation succeeded.
+ * @retval RING_WAKEUP  if the operation succeeded and the buffer was empty.
+ * @retval RING_FULL    if the buffer is full.
+ */
+static msg_t ring_put_byte(RingBuffer *rbp, uint8_t b) {
+  size_t head = rbp->rb_head;
+
+  if (head - rbp->rb_tail > rbp->rb_mask)
+    return RING_FULL;
+  ((volatile uint8_t *)rbp->rb_buffer)[head & rbp->rb_mask] = b;
+  rbp->rb_head = head + 1;
+  return rbp->rb_tail == head ? RING_WAKEUP : RING_OK;
+}
+
+/**
+ * @brief   Reads a record from the ring buffer.
+ *
+ * @param[in] rbp       pointer to a @p RingBuffer structure
+ * @param[out] recp     pointer to the record buffer
+ * @param[in] time      the number of ticks before the operation timeouts,
+ *                      the following special values are allowed:
+ *                      - @a TIME_IMMEDIATE immediate timeout.
+ *                      - @a TIME_INFINITE no timeout.
+ *                      .
+ * @return              The operation status.
+ * @retval RING_OK      if a record has been read.
+ * @retval RING_TIMEOUT if the specified time expired.
+ * @retval RING_RESET   if the buffer has been reset.
+ */
+static msg_t ring_get(RingBuffer *rbp, void *recp, systime_t time) {
+
+  while (TRUE) {
+    size_t tail = rbp->rb_tail;
+
+    if (rbp->rb_head != tail) {
+      volatile_copy(recp,
+                    rbp->rb_buffer + (tail & rbp->rb_mask) * rbp->rb_recsize,
+                    rbp->rb_recsize);
+      rbp->rb_tail = tail + 1;
+      return RING_OK;
+    }
+
+    /* The semaphore can have been left signaled by a previous transition,
+       the loop checks the buffer again after each wakeup.*/
+    switch (chBSemWaitTimeout(&rbp->rb_sem, time)) {
+    case RDY_TIMEOUT:
+      return RING_TIMEOUT;
+    case RDY_RESET:
+      return RING_RESET;
+    }
+  }
+}
+
+/**
+ * @brief   Initializes a ring buffer.
+ * @note    The ring buffer is initialized empty.
+ *
+ * @param[out] rbp      pointer to a @p RingBuffer structure
+ * @param[in] buffer    pointer to the records buffer, an array of @p n
+ *                      elements of @p recsize size
+ * @param[in] recsize   size of a record, must be 1 for the byte APIs
+ * @param[in] n         number of records, it must be a power of two
+ *
+ * @init
+ */
+void chRingInit(RingBuffer *rbp, void *buffer, size_t recsize, size_t n) {
+
+  chDbgCheck((rbp != NULL) && (buffer != NULL) && (recsize > 0) &&
+             (n > 0) && ((n & (n - 1)) == 0), "chRingInit");
+
+  rbp->rb_head = 0;
+  rbp->rb_tail = 0;
+  rbp->rb_mask = n - 1;
+  rbp->rb_recsize = recsize;
+  rbp->rb_buffer = (uint8_t *)buffer;
+  chBSemInit(&rbp->rb_sem, TRUE);
+}
+
+/**
+ * @brief   Resets a ring buffer.
+ * @details All the data in the ring buffer is lost, a waiting consumer is
+ *          resumed with @p RING_RESET as message.
+ * @note    The producer must not access the buffer during the reset.
+ * @note    This function does not reschedule so a call to a rescheduling
+ *          function must be performed before unlocking the kernel.
+ *
+ * @param[in] rbp       pointer to a @p RingBuffer structure
+ *
+ * @iclass
+ */
+void chRingResetI(RingBuffer *rbp) {
+
+  chDbgCheckClassI();
+  chDbgCheck(rbp != NULL, "chRingResetI");
+
+  rbp->rb_head = 0;
+  rbp->rb_tail = 0;
+  chBSemResetI(&rbp->rb_sem, TRUE);
+}
+
+/**
+ * @brief   Byte ring buffer write.
+ * @details This function writes a byte value into a byte ring buffer, it is
+ *          meant to be called from a context already holding the kernel
+ *          lock.
+ * @note    This function does not reschedule so a call to a rescheduling
+ *          function must be performed before unlocking the kernel.
+ *
+ * @param[in] rbp       pointer to a @p RingBuffer structure
+ * @param[in] b         the byte value to be written in the buffer
+ * @return              The operation status.
+ * @retval RING_OK      if the operation has been completed with success.
+ * @retval RING_FULL    if the buffer is full and the operation cannot be
+ *                      completed.
+ *
+ * @iclass
+ */
+msg_t chRingPutI(RingBuffer *rbp, uint8_t b) {
+
+  msg_t msg;
+
+  chDbgCheckClassI();
+  chDbgCheck((rbp != NULL) && (rbp->rb_recsize == 1),
+             "chRingPutI");
+
+  if ((msg = ring_put_byte(rbp, b)) == RING_WAKEUP) {
+    chBSemSignalI(&rbp->rb_sem);
+    return RING_OK;
+  }
+  return msg;
+}
+
+/**
+ * @brief   Byte ring buffer write from an interrupt handler.
+ * @details This function writes a byte value into a byte ring buffer without
+ *          entering a critical zone, the kernel is locked only when the
+ *          consumer needs to be awakened.
+ * @note    This function must be called from an ISR not holding the kernel
+ *          lock.
+ *
+ * @param[in] rbp       pointer to a @p RingBuffer structure
+ * @param[in] b         the byte value to be written in the buffer
+ * @return              The operation status.
+ * @retval RING_OK      if the operation has been completed with success.
+ * @retval RING_FULL    if the buffer is full and the operation cannot be
+ *                      completed.
+ *
+ * @special
+ */
+msg_t chRingPutFromIsr(RingBuffer *rbp, uint8_t b) {
+
+  msg_t msg;
+
+  chDbgCheck((rbp != NULL) && (rbp->rb_recsize == 1),
+             "chRingPutFromIsr");
+
+  if ((msg = ring_put_byte(rbp, b)) == RING_WAKEUP) {
+    chSysLockFromIsr();
+    chBSemSignalI(&rbp->rb_sem);
+    chSysUnlockFromIsr();
+    return RING_OK;
+  }
+  return msg;
+}
+
+/**
+ * @brief   Byte ring buffer read with timeout.
+ * @details This function reads a byte value from a byte ring buffer. If the
+ *          buffer is empty then the calling thread is suspended until a byte
+ *          arrives in the buffer or a timeout occurs.
+ *
+ * @param[in] rbp       pointer to a @p RingBuffer structure
+ * @param[in] time      the number of ticks before the operation timeouts,
+ *                      the following special values are allowed:
+ *                      - @a TIME_IMMEDIATE immediate timeout.
+ *                      - @a TIME_INFINITE no timeout.
+ *                      .
+ * @return              A byte value from the buffer.
+ * @retval RING_TIMEOUT if the specified time expired.
+ * @retval RING_RESET   if the buffer has been reset.
+ *
+ * @api
+ */
+msg_t chRingGetTimeout(RingBuffer *rbp, systime_t time) {
+  uint8_t b;
+  msg_t msg;
+
+  chDbgCheck((rbp != NULL) && (rbp->rb_recsize == 1),
+             "chRingGetTimeout");
+
+  if ((msg = ring_get(rbp, &b, time)) != RING_OK)
+    return msg;
+  return b;
+}
+
+/**
+ * @brief   Record ring buffer write.
+ * @details This function writes a record into a ring buffer, it is meant to
+ *          be called from a context already holding the kernel lock.
+ * @note    This function does not reschedule so a call to a rescheduling
+ *          function must be performed before unlocking the kernel.
+ *
+ * @param[in] rbp       pointer to a @p RingBuffer structure
+ * @param[in] recp      pointer to the record to be written, the record is
+ *                      copied into the buffer
+ * @return              The operation status.
+ * @retval RING_OK      if the operation has been completed with success.
+ * @retval RING_FULL    if the buffer is full and the operation cannot be
+ *                      completed.
+ *
+ * @iclass
+ */
+msg_t chRingPutRecordI(RingBuffer *rbp, const void *recp) {
+  msg_t msg;
+
+  chDbgCheckClassI();
+  chDbgCheck((rbp != NULL) && (recp != NULL), "chRingPutRecordI");
+
+  if ((msg = ring_put(rbp, recp)) == RING_WAKEUP) {
+    chBSemSignalI(&rbp->rb_sem);
+    return RING_OK;
+  }
+  return msg;
+}
+
+/**
+ * @brief   Record ring buffer write from an interrupt handler.
+ * @details This function writes a record into a ring buffer without
+ *          entering a critical zone, the kernel is locked only when the
+ *          consumer needs to be awakened.
+ * @note    This function must be called from an ISR not holding the kernel
+ *          lock.
+ *
+ * @param[in] rbp       pointer to a @p RingBuffer structure
+ * @param[in] recp      pointer to the record to be written, the record is
+ *                      copied into the buffer
+ * @return              The operation status.
+ * @retval RING_OK      if the operation has been completed with success.
+ * @retval RING_FULL    if the buffer is full and the operation cannot be
+ *                      completed.
+ *
+ * @special
+ */
+msg_t chRingPutRecordFromIsr(RingBuffer *rbp, const void *recp) {
+  msg_t msg;
+
+  chDbgCheck((rbp != NULL) && (recp != NULL), "chRingPutRecordFromIsr");
+
+  if ((msg = ring_put(rbp, recp)) == RING_WAKEUP) {
+    chSysLockFromIsr();
+    chBSemSignalI(&rbp->rb_sem);
+    chSysUnlockFromIsr();
+    return RING_OK;
+  }
+  return msg;
+}
+
+/**
+ * @brief   Record ring buffer read with timeout.
+ * @details This function reads a record from a ring buffer. If the buffer
+ *          is empty then the calling thread is suspended until a record
+ *          arrives in the buffer or a timeout occurs.
+ *
+ * @param[in] rbp       pointer to a @p RingBuffer structure
+ * @param[out] recp     pointer to the buffer receiving the record
+ * @param[in] time      the number of ticks before the operation timeouts,
+ *                      the following special values are allowed:
+ *                      - @a TIME_IMMEDIATE immediate timeout.
+ *                      - @a TIME_INFINITE no timeout.
+ *                      .
+ * @return              The operation status.
+ * @retval RING_OK      if a record has been read.
+ * @retval RING_TIMEOUT if the specified time expired.
+ * @retval RING_RESET   if the buffer has been reset.
+ *
+ * @api
+ */
+msg_t chRingGetRecordTimeout(RingBuffer *rbp, void *recp, systime_t time) {
+
+  chDbgCheck((rbp != NULL) && (recp != NULL), "chRingGetRecordTimeout");
+
+  return ring_get(rbp, recp, time);
+}
+
+#endif /* CH_USE_RINGS */
+
+/** @} */
@@ -82,6 +82,7 @@ Thread *chSchReadyI(Thread *tp) {
               "chSchReadyI(), #1",
               "invalid state");
 
+  stats_ready_insert(tp);
   tp->p_state = THD_STATE_READY;
   cp = (Thread *)&rlist.r_queue;
   do {
@@ -117,6 +118,7 @@ void chSchGoSleepS(tstate_t newstate) {
   otp->p_preempt = CH_TIME_QUANTUM;
 #endif
   setcurrp(fifo_remove(&rlist.r_queue));
+  stats_ready_remove();
   currp->p_state = THD_STATE_CURRENT;
   chSysSwitch(currp, otp);
 }
@@ -300,6 +302,7 @@ void chSchDoRescheduleBehind(void) {
   otp = currp;
   /* Picks the first thread from the ready queue and makes it current.*/
   setcurrp(fifo_remove(&rlist.r_queue));
+  stats_ready_remove();
   currp->p_state = THD_STATE_CURRENT;
 #if CH_TIME_QUANTUM > 0
   otp->p_preempt = CH_TIME_QUANTUM;
@@ -325,8 +328,10 @@ void chSchDoRescheduleAhead(void) {
   otp = currp;
   /* Picks the first thread from the ready queue and makes it current.*/
   setcurrp(fifo_remove(&rlist.r_queue));
+  stats_ready_remove();
   currp->p_state = THD_STATE_CURRENT;
 
+  stats_ready_insert(otp);
   otp->p_state = THD_STATE_READY;
   cp = (Thread *)&rlist.r_queue;
   do {
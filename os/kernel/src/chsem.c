@@ -82,6 +82,7 @@ void chSemInit(Semaphore *sp, cnt_t n) {
 
   queue_init(&sp->s_queue);
   sp->s_cnt = n;
+  sync_prof_init(&sp->s_prof);
 }
 
 /**
@@ -184,10 +185,14 @@ msg_t chSemWaitS(Semaphore *sp) {
               "chSemWaitS(), #1",
               "inconsistent semaphore");
 
+  dbg_trace_event(CH_TRACE_SEM, CH_TRACE_TYPE_SEM_WAIT, sp, NULL);
+  sync_prof_acquire(&sp->s_prof);
   if (--sp->s_cnt < 0) {
     currp->p_u.wtobjp = sp;
     sem_insert(currp, &sp->s_queue);
+    sync_prof_wait_start();
     chSchGoSleepS(THD_STATE_WTSEM);
+    sync_prof_wait_end(&sp->s_prof);
     return currp->p_u.rdymsg;
   }
   return RDY_OK;
@@ -249,15 +254,23 @@ msg_t chSemWaitTimeoutS(Semaphore *sp, systime_t time) {
               "chSemWaitTimeoutS(), #1",
               "inconsistent semaphore");
 
+  dbg_trace_event(CH_TRACE_SEM, CH_TRACE_TYPE_SEM_WAIT, sp, NULL);
   if (--sp->s_cnt < 0) {
+    msg_t msg;
+
     if (TIME_IMMEDIATE == time) {
       sp->s_cnt++;
       return RDY_TIMEOUT;
     }
+    sync_prof_acquire(&sp->s_prof);
     currp->p_u.wtobjp = sp;
     sem_insert(currp, &sp->s_queue);
-    return chSchGoSleepTimeoutS(THD_STATE_WTSEM, time);
+    sync_prof_wait_start();
+    msg = chSchGoSleepTimeoutS(THD_STATE_WTSEM, time);
+    sync_prof_wait_end(&sp->s_prof);
+    return msg;
   }
+  sync_prof_acquire(&sp->s_prof);
   return RDY_OK;
 }
 
@@ -277,6 +290,7 @@ void chSemSignal(Semaphore *sp) {
               "inconsistent semaphore");
 
   chSysLock();
+  dbg_trace_event(CH_TRACE_SEM, CH_TRACE_TYPE_SEM_SIGNAL, sp, NULL);
   if (++sp->s_cnt <= 0)
     chSchWakeupS(fifo_remove(&sp->s_queue), RDY_OK);
   chSysUnlock();
@@ -302,6 +316,7 @@ void chSemSignalI(Semaphore *sp) {
               "chSemSignalI(), #1",
               "inconsistent semaphore");
 
+  dbg_trace_event(CH_TRACE_SEM, CH_TRACE_TYPE_SEM_SIGNAL, sp, NULL);
   if (++sp->s_cnt <= 0) {
     /* Note, it is done this way in order to allow a tail call on
              chSchReadyI().*/
@@ -370,13 +385,18 @@ msg_t chSemSignalWait(Semaphore *sps, Semaphore *spw) {
               "inconsistent semaphore");
 
   chSysLock();
+  dbg_trace_event(CH_TRACE_SEM, CH_TRACE_TYPE_SEM_SIGNAL, sps, NULL);
+  dbg_trace_event(CH_TRACE_SEM, CH_TRACE_TYPE_SEM_WAIT, spw, NULL);
+  sync_prof_acquire(&spw->s_prof);
   if (++sps->s_cnt <= 0)
     chSchReadyI(fifo_remove(&sps->s_queue))->p_u.rdymsg = RDY_OK;
   if (--spw->s_cnt < 0) {
     Thread *ctp = currp;
     sem_insert(ctp, &spw->s_queue);
     ctp->p_u.wtobjp = spw;
+    sync_prof_wait_start();
     chSchGoSleepS(THD_STATE_WTSEM);
+    sync_prof_wait_end(&spw->s_prof);
     msg = ctp->p_u.rdymsg;
   }
   else {
@@ -0,0 +1,115 @@
+/*
+    ChibiOS/RT - Copyright (C) 2006,2007,2008,2009,2010,
+                 2011,2012,2013 Giovanni Di Sirio.
+
+    This file is part of ChibiOS/RT.
+
+    ChibiOS/RT is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    ChibiOS/RT is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * @file    chstats.c
+ * @brief   Kernel statistics code.
+ *
+ * @addtogroup statistics
+ * @details Always-on kernel counters, cheap enough to be left enabled in
+ *          production builds.
+ *          <h2>Operation mode</h2>
+ *          The scheduler, the virtual timers and the IRQ macros increase a
+ *          set of global counters: context switches, preemptions, yields,
+ *          IRQ handlers entries and virtual timers expirations. The current
+ *          ready list depth and its high-water mark are also tracked and
+ *          each thread counts the times it has been made ready.<br>
+ *          The counters are never reset, an application computes rates by
+ *          taking two snapshots using @p chStatsGetSnapshot() and dividing
+ *          the differences by the elapsed time.
+ * @pre     In order to use the statistics the @p CH_DBG_STATISTICS option
+ *          must be enabled in @p chconf.h.
+ * @{
+ */
+
+#include "ch.h"
+
+#if CH_DBG_STATISTICS || defined(__DOXYGEN__)
+
+/**
+ * @brief   Global kernel statistics.
+ */
+ch_kernel_stats_t kernel_stats;
+
+/**
+ * @brief   Kernel statistics initialization.
+ *
+ * @notapi
+ */
+void _stats_init(void) {
+
+  kernel_stats.ks_switches = 0;
+  kernel_stats.ks_preemptions = 0;
+  kernel_stats.ks_yields = 0;
+  kernel_stats.ks_isr = 0;
+  kernel_stats.ks_vt = 0;
+  kernel_stats.ks_ready = 0;
+  kernel_stats.ks_ready_max = 0;
+  kernel_stats.ks_yielding = FALSE;
+}
+
+/**
+ * @brief   Accounts an IRQ handler entry.
+ * @note    The counter is protected because IRQ handlers could be nested.
+ *
+ * @notapi
+ */
+void _stats_isr(void) {
+
+  port_lock_from_isr();
+  kernel_stats.ks_isr++;
+  port_unlock_from_isr();
+}
+
+/**
+ * @brief   Takes a snapshot of the kernel statistics.
+ * @details All the counters are copied within a single critical zone so the
+ *          snapshot is consistent.
+ *
+ * @param[out] ksp      pointer to the @p ch_kernel_stats_t structure to be
+ *                      filled
+ *
+ * @api
+ */
+void chStatsGetSnapshot(ch_kernel_stats_t *ksp) {
+
+  chDbgCheck(ksp != NULL, "chStatsGetSnapshot");
+
+  chSysLock();
+  *ksp = kernel_stats;
+  chSysUnlock();
+}
+
+/**
+ * @brief   Resets the ready list depth high-water mark.
+ * @details The mark is set to the current ready list depth.
+ *
+ * @api
+ */
+void chStatsResetReadyMax(void) {
+
+  chSysLock();
+  kernel_stats.ks_ready_max = kernel_stats.ks_ready;
+  chSysUnlock();
+}
+
+#endif /* CH_DBG_STATISTICS */
+
+/** @} */
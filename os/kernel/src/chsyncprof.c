@@ -0,0 +1,212 @@
+/*
+    ChibiOS/RT - Copyright (C) 2006,2007,2008,2009,2010,
+                 2011,2012,2013 Giovanni Di Sirio.
+
+    This file is part of ChibiOS/RT.
+
+    ChibiOS/RT is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    ChibiOS/RT is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * @file    chsyncprof.c
+ * @brief   Synchronization objects profiling code.
+ *
+ * @addtogroup sync_profiling
+ * @details Contention statistics of semaphores, binary semaphores and
+ *          mutexes.
+ *          <h2>Operation mode</h2>
+ *          Each object embeds a profile updated by the kernel while it
+ *          operates on the object: number of wait or lock operations,
+ *          number of operations that had to wait, total and longest wait
+ *          time. Mutexes also record the longest ownership time and the
+ *          number of priority inheritance boosts caused by threads trying
+ *          to lock them.<br>
+ *          Objects can be registered with an optional name, registered
+ *          objects are linked in a list that can be inspected using
+ *          @p chSyncProfGetTop(). All objects are profiled, registered or
+ *          not.
+ * @pre     In order to use the profiling the @p CH_DBG_SYNC_PROFILING
+ *          option must be enabled in @p chconf.h, when the option is
+ *          disabled the profiling code and the profile structures are not
+ *          compiled.
+ * @{
+ */
+
+#include "ch.h"
+
+#if CH_DBG_SYNC_PROFILING || defined(__DOXYGEN__)
+
+/**
+ * @brief   Registered profiles list.
+ */
+static ch_sync_profile_t *profiles;
+
+/**
+ * @brief   Initializes an object profile.
+ * @details The profile is cleared and not registered.
+ *
+ * @param[out] pp       pointer to the profile
+ *
+ * @notapi
+ */
+void _sync_prof_init(ch_sync_profile_t *pp) {
+
+  pp->sp_next = NULL;
+  pp->sp_name = NULL;
+  pp->sp_type = 0;
+  pp->sp_acquisitions = 0;
+  pp->sp_contended = 0;
+  pp->sp_boosts = 0;
+  pp->sp_wait_max = 0;
+  pp->sp_wait_total = 0;
+  pp->sp_hold_max = 0;
+  pp->sp_hold_start = 0;
+}
+
+/**
+ * @brief   Accounts the end of a wait of the current thread.
+ *
+ * @param[in] pp        pointer to the profile of the object
+ *
+ * @notapi
+ */
+void _sync_prof_wait_end(ch_sync_profile_t *pp) {
+  uint32_t d = port_rt_get_counter_value() - currp->p_wtstart;
+
+  pp->sp_contended++;
+  pp->sp_wait_total += d;
+  if (d > pp->sp_wait_max)
+    pp->sp_wait_max = d;
+}
+
+/**
+ * @brief   Accounts the end of a mutex ownership.
+ *
+ * @param[in] pp        pointer to the profile of the mutex
+ *
+ * @notapi
+ */
+void _sync_prof_hold_end(ch_sync_profile_t *pp) {
+  uint32_t d = port_rt_get_counter_value() - pp->sp_hold_start;
+
+  if (d > pp->sp_hold_max)
+    pp->sp_hold_max = d;
+}
+
+/**
+ * @brief   Registers an object profile.
+ * @note    Use the type-specific macros @p chSemRegister(),
+ *          @p chBSemRegister() and @p chMtxRegister().
+ * @note    An object must be unregistered before its memory is reused.
+ *
+ * @param[in] pp        pointer to the profile
+ * @param[in] type      the object type
+ * @param[in] name      the object name or @p NULL
+ *
+ * @api
+ */
+void chSyncProfRegister(ch_sync_profile_t *pp, uint8_t type,
+                        const char *name) {
+
+  chDbgCheck(pp != NULL, "chSyncProfRegister");
+
+  chSysLock();
+  pp->sp_type = type;
+  pp->sp_name = name;
+  pp->sp_next = profiles;
+  profiles = pp;
+  chSysUnlock();
+}
+
+/**
+ * @brief   Unregisters an object profile.
+ *
+ * @param[in] pp        pointer to the profile
+ *
+ * @api
+ */
+void chSyncProfUnregister(ch_sync_profile_t *pp) {
+  ch_sync_profile_t **ppp;
+
+  chDbgCheck(pp != NULL, "chSyncProfUnregister");
+
+  chSysLock();
+  for (ppp = &profiles; *ppp != NULL; ppp = &(*ppp)->sp_next)
+    if (*ppp == pp) {
+      *ppp = pp->sp_next;
+      break;
+    }
+  chSysUnlock();
+}
+
+/**
+ * @brief   Clears the statistics of an object profile.
+ *
+ * @param[in] pp        pointer to the profile
+ *
+ * @api
+ */
+void chSyncProfReset(ch_sync_profile_t *pp) {
+
+  chDbgCheck(pp != NULL, "chSyncProfReset");
+
+  chSysLock();
+  pp->sp_acquisitions = 0;
+  pp->sp_contended = 0;
+  pp->sp_boosts = 0;
+  pp->sp_wait_max = 0;
+  pp->sp_wait_total = 0;
+  pp->sp_hold_max = 0;
+  chSysUnlock();
+}
+
+/**
+ * @brief   Returns the most contended registered objects.
+ * @details The profiles are copied ordered by decreasing number of
+ *          contended operations.
+ * @note    The list is scanned within a single critical zone, its duration
+ *          grows with the number of registered objects and with @p n.
+ *
+ * @param[out] pa       array receiving the profiles copies
+ * @param[in] n         size of the array
+ * @return              The number of profiles copied.
+ *
+ * @api
+ */
+unsigned chSyncProfGetTop(ch_sync_profile_t *pa, unsigned n) {
+  ch_sync_profile_t *pp;
+  unsigned i, cnt = 0;
+
+  chDbgCheck((pa != NULL) && (n > 0), "chSyncProfGetTop");
+
+  chSysLock();
+  for (pp = profiles; pp != NULL; pp = pp->sp_next) {
+    /* Insertion into the ordered array, the last element drops out when
+       the array is full.*/
+    i = cnt < n ? cnt++ : n;
+    while ((i > 0) && (pa[i - 1].sp_contended < pp->sp_contended)) {
+      if (i < n)
+        pa[i] = pa[i - 1];
+      i--;
+    }
+    if (i < n)
+      pa[i] = *pp;
+  }
+  chSysUnlock();
+  return cnt;
+}
+
+#endif /* CH_DBG_SYNC_PROFILING */
+
+/** @} */
@@ -92,6 +92,12 @@ void chSysInit(void) {
 #if CH_DBG_ENABLE_TRACE
   _trace_init();
 #endif
+#if CH_DBG_CPU_ACCOUNTING
+  _acct_init();
+#endif
+#if CH_DBG_STATISTICS
+  _stats_init();
+#endif
 
   /* Now this instructions flow becomes the main thread.*/
   setcurrp(_thread_init(&mainthread, NORMALPRIO));
@@ -131,6 +137,7 @@ void chSysTimerHandlerI(void) {
 
   chDbgCheckClassI();
 
+  dbg_prof_tick();
 #if CH_TIME_QUANTUM > 0
   /* Running thread has not used up quantum yet? */
   if (currp->p_preempt > 0)
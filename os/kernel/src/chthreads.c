@@ -84,6 +84,12 @@ Thread *_thread_init(Thread *tp, tprio_t prio) {
 #if CH_DBG_THREADS_PROFILING
   tp->p_time = 0;
 #endif
+#if CH_DBG_CPU_ACCOUNTING
+  tp->p_cycles = 0;
+#endif
+#if CH_DBG_STATISTICS
+  tp->p_wakeups = 0;
+#endif
 #if CH_USE_DYNAMIC
   tp->p_refs = 1;
 #endif
@@ -97,9 +103,15 @@ Thread *_thread_init(Thread *tp, tprio_t prio) {
 #if CH_USE_MESSAGES
   queue_init(&tp->p_msgqueue);
 #endif
+#if CH_USE_ARENAS
+  tp->p_arena = NULL;
+#endif
 #if CH_DBG_ENABLE_STACK_CHECK
   tp->p_stklimit = (stkalign_t *)(tp + 1);
 #endif
+#if CH_DBG_FILL_THREADS
+  tp->p_wasize = 0;
+#endif
 #if defined(THREAD_EXT_INIT_HOOK)
   THREAD_EXT_INIT_HOOK(tp);
 #endif
@@ -158,7 +170,11 @@ Thread *chThdCreateI(void *wsp, size_t size,
              (prio <= HIGHPRIO) && (pf != NULL),
              "chThdCreateI");
   SETUP_CONTEXT(wsp, size, pf, arg);
-  return _thread_init(tp, prio);
+  _thread_init(tp, prio);
+#if CH_DBG_FILL_THREADS
+  tp->p_wasize = size;
+#endif
+  return tp;
 }
 
 /**
@@ -360,6 +376,9 @@ void chThdExitS(msg_t msg) {
   Thread *tp = currp;
 
   tp->p_u.exitcode = msg;
+#if CH_DBG_STACK_EXIT_REPORT
+  THREAD_STACK_REPORT_HOOK(tp, tp->p_wasize, chRegGetStackUsage(tp, NULL));
+#endif
 #if defined(THREAD_EXT_EXIT_HOOK)
   THREAD_EXT_EXIT_HOOK(tp);
 #endif
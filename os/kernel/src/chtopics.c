@@ -0,0 +1,266 @@
+/*
+    ChibiOS/RT - Copyright (C) 2006,2007,2008,2009,2010,
+                 2011,2012,2013 Giovanni Di Sirio.
+
+    This file is part of ChibiOS/RT.
+
+    ChibiOS/RT is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    ChibiOS/RT is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * @file    chtopics.c
+ * @brief   Topics code.
+ *
+ * @addtogroup topics
+ * @details Publish/subscribe exchange of fixed size messages.
+ *          <h2>Operation mode</h2>
+ *          A topic is a circular buffer of fixed size messages, a power of
+ *          two in number, addressed by two free running counters: the
+ *          number of started publishes and the number of completed
+ *          publishes. A publish copies the message once into the topic
+ *          buffer and then broadcasts the @p TOPIC_PUBLISHED flag on the
+ *          topic event source.<br>
+ *          Subscribers read the messages directly from the topic buffer
+ *          without entering a critical zone, the publish counters act as a
+ *          sequence lock: after copying a message the subscriber checks
+ *          that no publish started overwriting it, otherwise the read is
+ *          retried with a more recent message.<br>
+ *          A subscriber can be:
+ *          - <b>Latest-value</b>: Each read returns the most recent
+ *            message, older unread messages are skipped.
+ *          - <b>Queued</b>: Messages are read in publishing order, up to
+ *            the subscription depth of unread messages are retained, older
+ *            messages are skipped. The depth cannot exceed the number of
+ *            message slots of the topic.
+ *          .
+ *          Skipped messages are accounted in the subscriber drop counter,
+ *          the topic keeps a publish counter and the time of the last
+ *          publish.
+ * @pre     In order to use the topics APIs the @p CH_USE_TOPICS option must
+ *          be enabled in @p chconf.h.
+ * @note    Publishes are serialized by a critical zone so the message size
+ *          should be kept small, the subscribers access is lock-free.
+ * @{
+ */
+
+#include "ch.h"
+
+#if CH_USE_TOPICS || defined(__DOXYGEN__)
+
+/**
+ * @brief   Initializes a @p Topic object.
+ *
+ * @param[out] tp       pointer to a @p Topic structure
+ * @param[in] buffer    pointer to the messages buffer, it must be able to
+ *                      contain @p depth messages
+ * @param[in] size      size of a message
+ * @param[in] depth     number of message slots, must be a power of two
+ *
+ * @init
+ */
+void chTopicInit(Topic *tp, void *buffer, size_t size, size_t depth) {
+
+  chDbgCheck((tp != NULL) && (buffer != NULL) && (size > 0) &&
+             (depth > 0) && ((depth & (depth - 1)) == 0), "chTopicInit");
+
+  tp->t_buffer = buffer;
+  tp->t_size = size;
+  tp->t_mask = (uint32_t)depth - 1;
+  tp->t_begin = 0;
+  tp->t_end = 0;
+  tp->t_last = 0;
+  chEvtInit(&tp->t_es);
+}
+
+/**
+ * @brief   Publishes a message on a topic.
+ * @details The message is copied into the topic buffer overwriting the
+ *          oldest one, then the subscribers are notified.
+ * @post    This function does not reschedule so a call to a rescheduling
+ *          function must be performed before unlocking the kernel. Note that
+ *          interrupt handlers always reschedule on exit so an explicit
+ *          reschedule must not be performed in ISRs.
+ *
+ * @param[in] tp        pointer to a @p Topic structure
+ * @param[in] msgp      pointer to the message
+ *
+ * @iclass
+ */
+void chTopicPublishI(Topic *tp, const void *msgp) {
+  uint32_t n;
+
+  chDbgCheckClassI();
+  chDbgCheck((tp != NULL) && (msgp != NULL), "chTopicPublishI");
+
+  n = tp->t_begin;
+  tp->t_begin = n + 1;
+  volatile_copy(tp->t_buffer + (n & tp->t_mask) * tp->t_size, msgp,
+                tp->t_size);
+  tp->t_end = n + 1;
+  tp->t_last = chTimeNow();
+  chEvtBroadcastFlagsI(&tp->t_es, TOPIC_PUBLISHED);
+}
+
+/**
+ * @brief   Publishes a message on a topic.
+ * @details The message is copied into the topic buffer overwriting the
+ *          oldest one, then the subscribers are notified.
+ *
+ * @param[in] tp        pointer to a @p Topic structure
+ * @param[in] msgp      pointer to the message
+ *
+ * @api
+ */
+void chTopicPublish(Topic *tp, const void *msgp) {
+
+  chSysLock();
+  chTopicPublishI(tp, msgp);
+  chSchRescheduleS();
+  chSysUnlock();
+}
+
+/**
+ * @brief   Subscribes the current thread to a topic.
+ * @details The subscriber only receives the messages published after this
+ *          call, the specified event mask is signaled to the thread on each
+ *          publish.
+ *
+ * @param[in] tp        pointer to a @p Topic structure
+ * @param[out] sp       pointer to a @p TopicSubscriber structure
+ * @param[in] mask      the mask of event flags to be signaled on publish
+ * @param[in] depth     the maximum number of unread messages to be retained,
+ *                      it cannot exceed the topic depth, the special value
+ *                      @p TOPIC_LATEST makes a latest-value subscriber
+ *
+ * @api
+ */
+void chTopicSubscribe(Topic *tp, TopicSubscriber *sp,
+                      eventmask_t mask, size_t depth) {
+
+  chDbgCheck((tp != NULL) && (sp != NULL) && (depth <= tp->t_mask + 1),
+             "chTopicSubscribe");
+
+  sp->s_topic = tp;
+  sp->s_depth = (uint32_t)depth;
+  sp->s_received = 0;
+  sp->s_dropped = 0;
+  chEvtRegisterMask(&tp->t_es, &sp->s_el, mask);
+  chSysLock();
+  sp->s_next = tp->t_end;
+  chSysUnlock();
+}
+
+/**
+ * @brief   Unsubscribes from a topic.
+ *
+ * @param[in] sp        pointer to a @p TopicSubscriber structure
+ *
+ * @api
+ */
+void chTopicUnsubscribe(TopicSubscriber *sp) {
+
+  chDbgCheck(sp != NULL, "chTopicUnsubscribe");
+
+  chEvtUnregister(&sp->s_topic->t_es, &sp->s_el);
+}
+
+/**
+ * @brief   Reads a message from a topic.
+ * @details This function never waits, a latest-value subscriber reads the
+ *          most recent message, a queued subscriber reads the oldest unread
+ *          message still retained.
+ * @note    This function does not enter a critical zone and can be called
+ *          in any context, a subscriber must be read by a single thread.
+ *
+ * @param[in] sp        pointer to a @p TopicSubscriber structure
+ * @param[out] msgp     pointer to a buffer receiving the message
+ * @return              The operation status.
+ * @retval RDY_OK       if a message has been read.
+ * @retval RDY_TIMEOUT  if there are no new messages.
+ *
+ * @special
+ */
+msg_t chTopicReceive(TopicSubscriber *sp, void *msgp) {
+  Topic *tp;
+  uint32_t end, n, lim;
+
+  chDbgCheck((sp != NULL) && (msgp != NULL), "chTopicReceive");
+
+  tp = sp->s_topic;
+  while (TRUE) {
+    end = tp->t_end;
+    if (end == sp->s_next)
+      return RDY_TIMEOUT;
+
+    /* Number of readable messages, a message slot is lost while a publish
+       is in progress.*/
+    lim = tp->t_mask + 1 - (tp->t_begin - end);
+    if ((sp->s_depth != TOPIC_LATEST) && (sp->s_depth < lim))
+      lim = sp->s_depth;
+    if (lim == 0)
+      return RDY_TIMEOUT;
+    if (sp->s_depth == TOPIC_LATEST)
+      n = end - 1;
+    else if (end - sp->s_next > lim)
+      n = end - lim;
+    else
+      n = sp->s_next;
+
+    volatile_copy(msgp, tp->t_buffer + (n & tp->t_mask) * tp->t_size,
+                  tp->t_size);
+
+    /* If a publish started overwriting the slot then the read is retried.*/
+    if (tp->t_begin - n <= tp->t_mask + 1) {
+      sp->s_dropped += n - sp->s_next;
+      sp->s_received++;
+      sp->s_next = n + 1;
+      return RDY_OK;
+    }
+  }
+}
+
+/**
+ * @brief   Reads a message from a topic.
+ * @details If there are no new messages then the invoking thread waits on
+ *          the subscription event mask until a message is published or the
+ *          specified time runs out.
+ * @note    The timeout is restarted if the thread is woken without a
+ *          message being available.
+ *
+ * @param[in] sp        pointer to a @p TopicSubscriber structure
+ * @param[out] msgp     pointer to a buffer receiving the message
+ * @param[in] time      the number of ticks before the operation timeouts,
+ *                      the following special values are allowed:
+ *                      - @a TIME_IMMEDIATE immediate timeout.
+ *                      - @a TIME_INFINITE no timeout.
+ *                      .
+ * @return              The operation status.
+ * @retval RDY_OK       if a message has been read.
+ * @retval RDY_TIMEOUT  if the operation has timed out.
+ *
+ * @api
+ */
+msg_t chTopicReceiveTimeout(TopicSubscriber *sp, void *msgp,
+                            systime_t time) {
+
+  while (chTopicReceive(sp, msgp) != RDY_OK) {
+    if (chEvtWaitAnyTimeout(sp->s_el.el_mask, time) == 0)
+      return RDY_TIMEOUT;
+  }
+  return RDY_OK;
+}
+
+#endif /* CH_USE_TOPICS */
+
+/** @} */
@@ -160,6 +160,57 @@ struct context {
  */
 #define WORKING_AREA(s, n) stkalign_t s[THD_WA_SIZE(n) / sizeof(stkalign_t)]
 
+/**
+ * @brief   Exclusive access primitives support.
+ * @details Optional, if @p TRUE then the port provides the @p port_ll(),
+ *          @p port_sc() and @p port_ll_clear() primitives used by the
+ *          lock-free algorithms.
+ */
+#define PORT_SUPPORTS_LLSC              FALSE
+
+/**
+ * @brief   Double word compare and swap support.
+ * @details Optional, if @p TRUE then the port provides the @p port_tagged_t
+ *          type and the @p port_dwcas() primitive used by the lock-free
+ *          algorithms.
+ */
+#define PORT_SUPPORTS_DWCAS             FALSE
+
+/**
+ * @brief   Free running counter support.
+ * @details Optional, if @p TRUE then the port provides a free running 32
+ *          bits counter read by @p port_rt_get_counter_value(), it is used
+ *          for the trace timestamps. The port can also define
+ *          @p PORT_RT_COUNTER_FREQUENCY if the counter frequency is known.
+ */
+#define PORT_SUPPORTS_RT_COUNTER        FALSE
+
+/**
+ * @brief   Interrupt source identification support.
+ * @details Optional, if @p TRUE then the port provides
+ *          @p port_get_irq_source() returning an identifier of the
+ *          interrupt being served, it is used by the CPU accounting.
+ */
+#define PORT_SUPPORTS_IRQ_SOURCE        FALSE
+
+/**
+ * @brief   Interrupted program counter support.
+ * @details Optional, if @p TRUE then the port provides
+ *          @p port_get_irq_pc() returning the program counter of the
+ *          interrupted thread, it is used by the sampling profiler from
+ *          the system tick handler.
+ */
+#define PORT_SUPPORTS_IRQ_PC            FALSE
+
+/**
+ * @brief   Profiler sampler support.
+ * @details Optional, if @p TRUE then the port has its own sampling timer
+ *          started and stopped by @p port_prof_start() and
+ *          @p port_prof_stop(), the sampler must invoke
+ *          @p dbg_prof_sample() with the interrupted program counter.
+ */
+#define PORT_SUPPORTS_PROF_SAMPLER      FALSE
+
 /**
  * @brief   IRQ prologue code.
  * @details This macro must be inserted at the start of all IRQ handlers
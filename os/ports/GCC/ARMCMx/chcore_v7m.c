@@ -121,6 +121,12 @@ void _port_init(void) {
     CORTEX_PRIORITY_MASK(CORTEX_PRIORITY_PENDSV));
   nvicSetSystemHandlerPriority(HANDLER_SYSTICK,
     CORTEX_PRIORITY_MASK(CORTEX_PRIORITY_SYSTICK));
+
+#if CORTEX_ENABLE_RT_COUNTER
+  /* Enabling the DWT cycle counter used as free running counter.*/
+  SCS_DEMCR |= SCS_DEMCR_TRCENA;
+  DWT_CTRL |= DWT_CTRL_CYCCNTENA;
+#endif
 }
 
 #if !CH_OPTIMIZE_SPEED
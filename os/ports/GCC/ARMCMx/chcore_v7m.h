@@ -141,6 +141,20 @@
 #define CORTEX_PRIGROUP_INIT            (7 - CORTEX_PRIORITY_BITS)
 #endif
 
+/**
+ * @brief   Enables the DWT cycle counter as free running counter.
+ * @details By default the counter is only enabled if a kernel debug option
+ *          requiring it is active, the application can force it in order
+ *          to use the counter directly, for example in the test suite
+ *          latency benchmarks.
+ */
+#if !defined(CORTEX_ENABLE_RT_COUNTER) || defined(__DOXYGEN__)
+#define CORTEX_ENABLE_RT_COUNTER        (CH_DBG_ENABLE_TRACE ||             \
+                                         CH_DBG_CPU_ACCOUNTING ||           \
+                                         CH_DBG_CRITICAL_MONITOR ||         \
+                                         CH_DBG_SYNC_PROFILING)
+#endif
+
 /*===========================================================================*/
 /* Port derived parameters.                                                  */
 /*===========================================================================*/
@@ -500,6 +514,107 @@ struct context {
 }
 #endif
 
+/**
+ * @brief   The port supports the exclusive access primitives.
+ * @details The @p port_ll(), @p port_sc() and @p port_ll_clear()
+ *          primitives can be used in order to implement lock-free
+ *          algorithms, the exclusive monitor is cleared on exception
+ *          entry and exit.
+ */
+#define PORT_SUPPORTS_LLSC              TRUE
+
+/**
+ * @brief   The port provides a free running counter.
+ * @details The counter is the DWT cycle counter, it is enabled by
+ *          @p port_init() if @p CORTEX_ENABLE_RT_COUNTER is enabled. The
+ *          counter frequency is the core clock, it is not known by the port
+ *          and can be specified to the trace subsystem by defining
+ *          @p CH_TRACE_TIMESTAMP_FREQUENCY.
+ */
+#define PORT_SUPPORTS_RT_COUNTER        CORTEX_ENABLE_RT_COUNTER
+
+/**
+ * @brief   Returns the current value of the free running counter.
+ */
+#define port_rt_get_counter_value() ((uint32_t)DWT_CYCCNT)
+
+/**
+ * @brief   The port can identify the interrupt being served.
+ */
+#define PORT_SUPPORTS_IRQ_SOURCE        TRUE
+
+/**
+ * @brief   Returns the identifier of the interrupt being served.
+ * @details The identifier is the active exception number.
+ *
+ * @return              The exception number.
+ */
+static INLINE uint32_t port_get_irq_source(void) {
+  uint32_t ipsr;
+
+  asm volatile ("mrs     %0, IPSR" : "=r" (ipsr));
+  return ipsr;
+}
+
+/**
+ * @brief   The port can return the interrupted thread program counter.
+ */
+#define PORT_SUPPORTS_IRQ_PC            TRUE
+
+/**
+ * @brief   Returns the program counter of the interrupted thread.
+ * @details The value is read from the exception frame on the process stack,
+ *          if the handler preempted another handler then the returned value
+ *          is where the thread has been interrupted by the first handler.
+ *
+ * @return              The program counter.
+ */
+static INLINE void *port_get_irq_pc(void) {
+  struct extctx *ctxp;
+
+  asm volatile ("mrs     %0, PSP" : "=r" (ctxp) : : "memory");
+  return (void *)ctxp->pc;
+}
+
+/**
+ * @brief   Load-linked.
+ * @details Loads a pointer and marks its location for exclusive access.
+ *
+ * @param[in] p         pointer to the location
+ * @return              The location content.
+ */
+static INLINE void *port_ll(void * volatile *p) {
+  void *v;
+
+  asm volatile ("ldrex   %0, [%1]" : "=r" (v) : "r" (p) : "memory");
+  return v;
+}
+
+/**
+ * @brief   Store-conditional.
+ * @details Stores a pointer in a location previously marked using
+ *          @p port_ll().
+ *
+ * @param[in] p         pointer to the location
+ * @param[in] v         the value to be stored
+ * @return              The operation status.
+ * @retval FALSE        if the exclusive access has been lost, nothing has
+ *                      been stored.
+ * @retval TRUE         if the value has been stored.
+ */
+static INLINE bool_t port_sc(void * volatile *p, void *v) {
+  uint32_t r;
+
+  asm volatile ("strex   %0, %2, [%1]" : "=&r" (r) : "r" (p), "r" (v)
+                                       : "memory");
+  return r == 0;
+}
+
+/**
+ * @brief   Clears an exclusive access marked using @p port_ll().
+ */
+#define port_ll_clear() asm volatile ("clrex" : : : "memory")
+
 #ifdef __cplusplus
 extern "C" {
 #endif
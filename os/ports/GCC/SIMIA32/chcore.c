@@ -23,7 +23,18 @@
  * @{
  */
 
+#if !defined(WIN32) && !defined(__APPLE__) && !defined(_GNU_SOURCE)
+/* Required for the ucontext registers names.*/
+#define _GNU_SOURCE
+#endif
+
 #include <stdlib.h>
+#if !defined(WIN32)
+#include <time.h>
+#include <signal.h>
+#include <sys/time.h>
+#include <ucontext.h>
+#endif
 
 #include "ch.h"
 #include "hal.h"
@@ -83,4 +94,98 @@ void _port_thread_start(msg_t (*pf)(void *), void *p) {
   while(1);
 }
 
+/**
+ * @brief   Returns the current value of the free running counter.
+ * @details The counter is the host monotonic time in nanoseconds, truncated
+ *          to 32 bits.
+ *
+ * @return              The counter value.
+ */
+uint32_t port_rt_get_counter_value(void) {
+#if defined(WIN32)
+  static LARGE_INTEGER freq;
+  LARGE_INTEGER cnt;
+
+  if (freq.QuadPart == 0)
+    QueryPerformanceFrequency(&freq);
+  QueryPerformanceCounter(&cnt);
+  return (uint32_t)((cnt.QuadPart / freq.QuadPart) * 1000000000ULL +
+                    ((cnt.QuadPart % freq.QuadPart) * 1000000000ULL) /
+                    freq.QuadPart);
+#else
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint32_t)((uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec);
+#endif
+}
+
+#if (CH_DBG_PROFILER && PORT_SUPPORTS_PROF_SAMPLER) || defined(__DOXYGEN__)
+#if CH_PROF_FREQUENCY > 1000000
+#error "CH_PROF_FREQUENCY above the profiling timer resolution"
+#endif
+
+/**
+ * @brief   Profiler signal handler stack.
+ * @details The host signal frame is too large for the threads working
+ *          areas, the handler runs on its own stack.
+ */
+static uint8_t prof_stack[65536];
+
+/**
+ * @brief   Profiler signal handler.
+ * @details Samples the program counter saved in the signal context.
+ */
+static void prof_handler(int sig, siginfo_t *sip, void *p) {
+  ucontext_t *ucp = (ucontext_t *)p;
+
+  (void)sig;
+  (void)sip;
+#if defined(__APPLE__)
+  dbg_prof_sample((void *)ucp->uc_mcontext->__ss.__eip);
+#else
+  dbg_prof_sample((void *)ucp->uc_mcontext.gregs[REG_EIP]);
+#endif
+}
+
+/**
+ * @brief   Starts the profiler sampler.
+ * @details The sampler is the host @p SIGPROF signal, the profiling timer
+ *          counts the CPU time consumed by the simulator process so the
+ *          time spent sleeping on the host is not sampled.
+ *
+ * @param[in] freq      the sampling frequency in Hz, the timer resolution
+ *                      is one microsecond so the maximum is 1MHz
+ */
+void port_prof_start(uint32_t freq) {
+  struct sigaction sa;
+  struct itimerval it;
+  stack_t ss;
+
+  chDbgCheck((freq > 0) && (freq <= 1000000), "port_prof_start");
+
+  ss.ss_sp = prof_stack;
+  ss.ss_size = sizeof prof_stack;
+  ss.ss_flags = 0;
+  sigaltstack(&ss, NULL);
+  sa.sa_sigaction = prof_handler;
+  sa.sa_flags = SA_SIGINFO | SA_RESTART | SA_ONSTACK;
+  sigemptyset(&sa.sa_mask);
+  sigaction(SIGPROF, &sa, NULL);
+  it.it_interval.tv_sec = 0;
+  it.it_interval.tv_usec = 1000000 / freq;
+  it.it_value = it.it_interval;
+  setitimer(ITIMER_PROF, &it, NULL);
+}
+
+/**
+ * @brief   Stops the profiler sampler.
+ */
+void port_prof_stop(void) {
+  struct itimerval it = {{0, 0}, {0, 0}};
+
+  setitimer(ITIMER_PROF, &it, NULL);
+}
+#endif /* CH_DBG_PROFILER && PORT_SUPPORTS_PROF_SAMPLER */
+
 /** @} */
@@ -30,6 +30,10 @@
 #error "option CH_DBG_ENABLE_STACK_CHECK not supported by this port"
 #endif
 
+#if defined(SIM_USE_PREEMPTION) && SIM_USE_PREEMPTION
+#error "option SIM_USE_PREEMPTION not supported by this port"
+#endif
+
 /**
  * Macro defining the a simulated architecture into x86.
  */
@@ -226,6 +230,60 @@ struct context {
  */
 #define port_wait_for_interrupt() ChkIntSources()
 
+/**
+ * The port provides a free running counter, the host monotonic time in
+ * nanoseconds.
+ */
+#define PORT_SUPPORTS_RT_COUNTER        TRUE
+
+/**
+ * Frequency of the free running counter.
+ */
+#define PORT_RT_COUNTER_FREQUENCY       1000000000
+
+/**
+ * The port has its own profiler sampler, the host @p SIGPROF signal. It is
+ * not available on Windows.
+ */
+#if !defined(WIN32)
+#define PORT_SUPPORTS_PROF_SAMPLER      TRUE
+#else
+#define PORT_SUPPORTS_PROF_SAMPLER      FALSE
+#endif
+
+/**
+ * The port supports a double word compare and swap instruction.
+ */
+#define PORT_SUPPORTS_DWCAS             TRUE
+
+/**
+ * Tagged pointer, a pointer and a modifications counter updated atomically
+ * by @p port_dwcas().
+ */
+typedef struct {
+  void                  *tp_ptr;
+  uint32_t              tp_tag;
+} port_tagged_t __attribute__((aligned(8)));
+
+/**
+ * Double word compare and swap, if the location contains the expected
+ * value then the new value is stored, else the expected value is updated
+ * with the location content.
+ */
+static INLINE bool_t port_dwcas(volatile port_tagged_t *p,
+                                port_tagged_t *oldp,
+                                const port_tagged_t *newp) {
+  uint8_t ok;
+
+  asm volatile ("lock; cmpxchg8b %0\n\t"
+                "setz    %1"
+                : "+m" (*p), "=q" (ok),
+                  "+a" (oldp->tp_ptr), "+d" (oldp->tp_tag)
+                : "b" (newp->tp_ptr), "c" (newp->tp_tag)
+                : "memory", "cc");
+  return (bool_t)ok;
+}
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -234,6 +292,11 @@ extern "C" {
   __attribute__((cdecl, noreturn)) void _port_thread_start(msg_t (*pf)(void *),
                                                            void *p);
   void ChkIntSources(void);
+  uint32_t port_rt_get_counter_value(void);
+#if PORT_SUPPORTS_PROF_SAMPLER
+  void port_prof_start(uint32_t freq);
+  void port_prof_stop(void);
+#endif
 #ifdef __cplusplus
 }
 #endif
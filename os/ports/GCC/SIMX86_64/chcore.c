@@ -0,0 +1,288 @@
+/*
+    ChibiOS/RT - Copyright (C) 2006,2007,2008,2009,2010,
+                 2011,2012,2013 Giovanni Di Sirio.
+
+    This file is part of ChibiOS/RT.
+
+    ChibiOS/RT is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    ChibiOS/RT is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * @addtogroup SIMX86_64_CORE
+ * @{
+ */
+
+#if !defined(__APPLE__) && !defined(_GNU_SOURCE)
+/* Required for the ucontext registers names.*/
+#define _GNU_SOURCE
+#endif
+
+#include <errno.h>
+#include <stdlib.h>
+#include <time.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/time.h>
+#include <ucontext.h>
+
+#include "ch.h"
+#include "hal.h"
+
+/* The context switch code assumes this position of the context field.*/
+typedef char port_ctx_offset_check[offsetof(Thread, p_ctx) == 24 ? 1 : -1];
+
+/**
+ * Performs a context switch between two threads.
+ * @details The callee-saved registers of the System V ABI are pushed on the
+ *          stack of the outgoing thread, the stack pointer is saved into
+ *          @p otp->p_ctx and the incoming thread registers are restored from
+ *          its own stack. The offset 24 is the position of @p p_ctx in the
+ *          @p Thread structure.
+ * @param ntp the thread to be switched in
+ * @param otp the thread to be switched out
+ */
+__attribute__((used))
+static void __dummy(Thread *ntp, Thread *otp) {
+  (void)ntp; (void)otp;
+
+  asm volatile (
+#if defined(__APPLE__)
+                ".globl _port_switch                            \n\t"
+                "_port_switch:                                  \n\t"
+#else
+                ".globl port_switch                             \n\t"
+                "port_switch:                                   \n\t"
+#endif
+                "push    %rbp                                   \n\t"
+                "push    %rbx                                   \n\t"
+                "push    %r12                                   \n\t"
+                "push    %r13                                   \n\t"
+                "push    %r14                                   \n\t"
+                "push    %r15                                   \n\t"
+                "movq    %rsp, 24(%rsi)                         \n\t"
+                "movq    24(%rdi), %rsp                         \n\t"
+                "pop     %r15                                   \n\t"
+                "pop     %r14                                   \n\t"
+                "pop     %r13                                   \n\t"
+                "pop     %r12                                   \n\t"
+                "pop     %rbx                                   \n\t"
+                "pop     %rbp                                   \n\t"
+                "ret                                            \n\t"
+#if defined(__APPLE__)
+                ".globl __port_thread_trampoline                \n\t"
+                "__port_thread_trampoline:                      \n\t"
+                "movq    %rbx, %rdi                             \n\t"
+                "movq    %r12, %rsi                             \n\t"
+                "call    __port_thread_start                    \n\t"
+#else
+                ".globl _port_thread_trampoline                 \n\t"
+                "_port_thread_trampoline:                       \n\t"
+                "movq    %rbx, %rdi                             \n\t"
+                "movq    %r12, %rsi                             \n\t"
+                "call    _port_thread_start@PLT                 \n\t"
+#endif
+                "ud2");
+}
+
+/**
+ * Halts the system. In this implementation it just exits the simulation.
+ */
+void port_halt(void) {
+
+  exit(2);
+}
+
+/**
+ * @brief   Start a thread by invoking its work function.
+ * @details If the work function returns @p chThdExit() is automatically
+ *          invoked. It is called by @p _port_thread_trampoline() with the
+ *          thread function and argument saved in the context by
+ *          @p SETUP_CONTEXT().
+ */
+__attribute__((noreturn))
+void _port_thread_start(msg_t (*pf)(void *), void *p) {
+
+  chSysUnlock();
+  chThdExit(pf(p));
+  while(1);
+}
+
+/**
+ * @brief   Returns the current value of the free running counter.
+ * @details The counter is the host monotonic time in nanoseconds, truncated
+ *          to 32 bits.
+ *
+ * @return              The counter value.
+ */
+uint32_t port_rt_get_counter_value(void) {
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint32_t)((uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec);
+}
+
+#if SIM_USE_PREEMPTION || defined(__DOXYGEN__)
+/**
+ * @brief   Simulated interrupts mask.
+ * @details The interrupts are masked until @p chSysInit() enables the
+ *          kernel.
+ */
+volatile bool_t _port_irq_masked = TRUE;
+
+/**
+ * @brief   Simulated interrupt pending.
+ */
+volatile bool_t _port_irq_pending = FALSE;
+
+/**
+ * @brief   Serves the simulated interrupts.
+ * @details Invoked by the host signal handler and by @p port_unlock() when
+ *          a host signal has been received while the interrupts were
+ *          masked. The sources are served until no more system ticks are
+ *          due, host signals are merged while pending so a single signal
+ *          can stand for several ticks, the system time would lag behind
+ *          the host time otherwise.
+ */
+void _port_irq_serve(void) {
+  systime_t time;
+
+  _port_irq_pending = FALSE;
+  do {
+    time = chTimeNow();
+    ChkIntSources();
+  } while (chTimeNow() != time);
+}
+
+/**
+ * @brief   Simulated interrupt, host @p SIGALRM signal handler.
+ * @details The handler runs on the stack of the interrupted thread,
+ *          @p ChkIntSources() masks the interrupts while serving the
+ *          sources and the context switch to a preempting thread, deferred
+ *          to the end of the interrupt, happens inside the handler. The
+ *          interrupted thread returns from the handler when rescheduled.
+ *          The signal is not blocked during the handler, a context switch
+ *          would leave it blocked for the other threads.
+ */
+static void irq_handler(int sig) {
+  int e = errno;
+
+  (void)sig;
+  if (_port_irq_masked)
+    _port_irq_pending = TRUE;
+  else
+    _port_irq_serve();
+  errno = e;
+}
+
+/**
+ * @brief   Simulator initialization.
+ * @details Starts the host interval timer raising @p SIGALRM at the system
+ *          tick rate.
+ */
+void port_init(void) {
+  struct sigaction sa;
+  struct itimerval it;
+
+  sa.sa_handler = irq_handler;
+  sa.sa_flags = SA_RESTART | SA_NODEFER;
+  sigemptyset(&sa.sa_mask);
+  sigaction(SIGALRM, &sa, NULL);
+  it.it_interval.tv_sec = (1000000 / CH_FREQUENCY) / 1000000;
+  it.it_interval.tv_usec = (1000000 / CH_FREQUENCY) % 1000000;
+  it.it_value = it.it_interval;
+  setitimer(ITIMER_REAL, &it, NULL);
+}
+
+/**
+ * @brief   Waits for a simulated interrupt.
+ * @details The host process sleeps until a signal is received.
+ */
+void port_wait_for_interrupt(void) {
+
+  pause();
+}
+#endif /* SIM_USE_PREEMPTION */
+
+#if (CH_DBG_PROFILER && PORT_SUPPORTS_PROF_SAMPLER) || defined(__DOXYGEN__)
+#if CH_PROF_FREQUENCY > 1000000
+#error "CH_PROF_FREQUENCY above the profiling timer resolution"
+#endif
+
+/**
+ * @brief   Profiler signal handler stack.
+ * @details The host signal frame is too large for the threads working
+ *          areas, the handler runs on its own stack.
+ */
+static uint8_t prof_stack[65536];
+
+/**
+ * @brief   Profiler signal handler.
+ * @details Samples the program counter saved in the signal context.
+ */
+static void prof_handler(int sig, siginfo_t *sip, void *p) {
+  ucontext_t *ucp = (ucontext_t *)p;
+
+  (void)sig;
+  (void)sip;
+#if defined(__APPLE__)
+  dbg_prof_sample((void *)ucp->uc_mcontext->__ss.__rip);
+#else
+  dbg_prof_sample((void *)ucp->uc_mcontext.gregs[REG_RIP]);
+#endif
+}
+
+/**
+ * @brief   Starts the profiler sampler.
+ * @details The sampler is the host @p SIGPROF signal, the profiling timer
+ *          counts the CPU time consumed by the simulator process so the
+ *          time spent sleeping on the host is not sampled.
+ *
+ * @param[in] freq      the sampling frequency in Hz, the timer resolution
+ *                      is one microsecond so the maximum is 1MHz
+ */
+void port_prof_start(uint32_t freq) {
+  struct sigaction sa;
+  struct itimerval it;
+  stack_t ss;
+
+  chDbgCheck((freq > 0) && (freq <= 1000000), "port_prof_start");
+
+  ss.ss_sp = prof_stack;
+  ss.ss_size = sizeof prof_stack;
+  ss.ss_flags = 0;
+  sigaltstack(&ss, NULL);
+  sa.sa_sigaction = prof_handler;
+  sa.sa_flags = SA_SIGINFO | SA_RESTART | SA_ONSTACK;
+  /* The simulated interrupt must not preempt the sampler, it could switch
+     context while on the alternate stack.*/
+  sigemptyset(&sa.sa_mask);
+  sigaddset(&sa.sa_mask, SIGALRM);
+  sigaction(SIGPROF, &sa, NULL);
+  it.it_interval.tv_sec = 0;
+  it.it_interval.tv_usec = 1000000 / freq;
+  it.it_value = it.it_interval;
+  setitimer(ITIMER_PROF, &it, NULL);
+}
+
+/**
+ * @brief   Stops the profiler sampler.
+ */
+void port_prof_stop(void) {
+  struct itimerval it = {{0, 0}, {0, 0}};
+
+  setitimer(ITIMER_PROF, &it, NULL);
+}
+#endif /* CH_DBG_PROFILER && PORT_SUPPORTS_PROF_SAMPLER */
+
+/** @} */
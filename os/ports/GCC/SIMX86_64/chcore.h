@@ -0,0 +1,383 @@
+/*
+    ChibiOS/RT - Copyright (C) 2006,2007,2008,2009,2010,
+                 2011,2012,2013 Giovanni Di Sirio.
+
+    This file is part of ChibiOS/RT.
+
+    ChibiOS/RT is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    ChibiOS/RT is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * @addtogroup SIMX86_64_CORE
+ * @{
+ */
+
+#ifndef _CHCORE_H_
+#define _CHCORE_H_
+
+#if CH_DBG_ENABLE_STACK_CHECK
+#error "option CH_DBG_ENABLE_STACK_CHECK not supported by this port"
+#endif
+
+#if defined(WIN32)
+#error "the SIMX86_64 port requires a System V ABI host"
+#endif
+
+/**
+ * @brief   Enables the preemptive simulator mode.
+ * @details If enabled the simulated interrupt sources are served by the
+ *          host @p SIGALRM signal, raised at the system tick rate, so a
+ *          busy thread is preempted by the tick, by the serial I/O and by
+ *          the threads woken up by them.
+ *          If disabled the interrupt sources are only polled when the idle
+ *          thread runs or when a thread invokes @p ChkIntSources().
+ * @note    The host library is not reentrant, in the preemptive mode the
+ *          threads calling it, @p printf() as an example, can be preempted
+ *          by threads calling it too.
+ */
+#if !defined(SIM_USE_PREEMPTION) || defined(__DOXYGEN__)
+#define SIM_USE_PREEMPTION              FALSE
+#endif
+
+/**
+ * Macro defining the a simulated architecture into x86-64.
+ */
+#define CH_ARCHITECTURE_SIMX86_64
+
+/**
+ * Name of the implemented architecture.
+ */
+#define CH_ARCHITECTURE_NAME            "Simulator"
+
+/**
+ * @brief   Name of the architecture variant (optional).
+ */
+#define CH_CORE_VARIANT_NAME            "x86-64 (integer only)"
+
+/**
+ * @brief   Name of the compiler supported by this port.
+ */
+#define CH_COMPILER_NAME                "GCC " __VERSION__
+
+/**
+ * @brief   Port-specific information string.
+ */
+#if !SIM_USE_PREEMPTION || defined(__DOXYGEN__)
+#define CH_PORT_INFO                    "No preemption"
+#else
+#define CH_PORT_INFO                    "Preemption by host signals"
+#endif
+
+/**
+ * 16 bytes stack alignment.
+ */
+typedef struct {
+  uint8_t a[16];
+} stkalign_t __attribute__((aligned(16)));
+
+/**
+ * Generic x86-64 register.
+ */
+typedef void *regx86;
+
+/**
+ * Interrupt saved context.
+ * This structure represents the stack frame saved during a preemption-capable
+ * interrupt handler.
+ */
+struct extctx {
+};
+
+/**
+ * System saved context.
+ * @details Only the callee-saved registers of the System V ABI are saved,
+ *          the context switch is a function call so the other registers
+ *          are already preserved by the caller.
+ * @note In this demo the floating point registers are not saved, the
+ *       MXCSR and x87 control words are never changed by the threads.
+ */
+struct intctx {
+  regx86  r15;
+  regx86  r14;
+  regx86  r13;
+  regx86  r12;
+  regx86  rbx;
+  regx86  rbp;
+  regx86  rip;
+};
+
+/**
+ * Platform dependent part of the @p Thread structure.
+ * This structure usually contains just the saved stack pointer defined as a
+ * pointer to a @p intctx structure.
+ * @note The field keeps the SIMIA32 name, the simulator demos are shared
+ *       between the two ports.
+ */
+struct context {
+  struct intctx volatile *esp;
+};
+
+/**
+ * Platform dependent part of the @p chThdCreateI() API.
+ * This code usually setup the context switching frame represented by a
+ * @p intctx structure.
+ * The thread function and its argument are passed in @p rbx and @p r12 to
+ * the @p _port_thread_trampoline() code. The trampoline is entered with the
+ * stack pointer aligned to 16 bytes, as required at the call instructions,
+ * a null return address above the frame terminates the debugger backtraces.
+ */
+#define SETUP_CONTEXT(workspace, wsize, pf, arg) {                      \
+  uint8_t *rsp = (uint8_t *)(((uintptr_t)(workspace) + (wsize)) &       \
+                             ~(uintptr_t)15);                           \
+  rsp -= 16;                                                            \
+  *(void **)rsp = NULL;                                                 \
+  rsp -= sizeof(struct intctx);                                         \
+  ((struct intctx *)rsp)->rip = (void *)_port_thread_trampoline;        \
+  ((struct intctx *)rsp)->rbx = (void *)(pf);                           \
+  ((struct intctx *)rsp)->r12 = (void *)(arg);                          \
+  ((struct intctx *)rsp)->r13 = 0;                                      \
+  ((struct intctx *)rsp)->r14 = 0;                                      \
+  ((struct intctx *)rsp)->r15 = 0;                                      \
+  ((struct intctx *)rsp)->rbp = 0;                                      \
+  tp->p_ctx.esp = (struct intctx *)rsp;                                 \
+}
+
+/**
+ * Stack size for the system idle thread.
+ */
+#ifndef PORT_IDLE_THREAD_STACK_SIZE
+#define PORT_IDLE_THREAD_STACK_SIZE     256
+#endif
+
+/**
+ * Per-thread stack overhead for interrupts servicing, it is used in the
+ * calculation of the correct working area size.
+ * It requires stack space because the simulated "interrupt handlers" can
+ * invoke host library functions inside so it better have a lot of space.
+ */
+#ifndef PORT_INT_REQUIRED_STACK
+#define PORT_INT_REQUIRED_STACK         32768
+#endif
+
+/**
+ * Enforces a correct alignment for a stack area size value.
+ */
+#define STACK_ALIGN(n) ((((n) - 1) | (sizeof(stkalign_t) - 1)) + 1)
+
+ /**
+  * Computes the thread working area global size.
+  */
+#define THD_WA_SIZE(n) STACK_ALIGN(sizeof(Thread) +                     \
+                                   sizeof(void *) * 4 +                 \
+                                   sizeof(struct intctx) +              \
+                                   sizeof(struct extctx) +              \
+                                   (n) + (PORT_INT_REQUIRED_STACK))
+
+/**
+ * Macro used to allocate a thread working area aligned as both position and
+ * size.
+ */
+#define WORKING_AREA(s, n) stkalign_t s[THD_WA_SIZE(n) / sizeof(stkalign_t)]
+
+/**
+ * IRQ prologue code, inserted at the start of all IRQ handlers enabled to
+ * invoke system APIs.
+ */
+#define PORT_IRQ_PROLOGUE()
+
+/**
+ * IRQ epilogue code, inserted at the end of all IRQ handlers enabled to
+ * invoke system APIs.
+ */
+#define PORT_IRQ_EPILOGUE()
+
+/**
+ * IRQ handler function declaration.
+ */
+#define PORT_IRQ_HANDLER(id) void id(void)
+
+#if !SIM_USE_PREEMPTION || defined(__DOXYGEN__)
+/**
+ * Simulator initialization.
+ */
+#define port_init()
+
+/**
+ * Does nothing in this simulator.
+ */
+#define port_lock() asm volatile("nop")
+
+/**
+ * Does nothing in this simulator.
+ */
+#define port_unlock() asm volatile("nop")
+
+/**
+ * Does nothing in this simulator.
+ */
+#define port_lock_from_isr()
+
+/**
+ * Does nothing in this simulator.
+ */
+#define port_unlock_from_isr()
+
+/**
+ * Does nothing in this simulator.
+ */
+#define port_disable()
+
+/**
+ * Does nothing in this simulator.
+ */
+#define port_suspend()
+
+/**
+ * Does nothing in this simulator.
+ */
+#define port_enable()
+
+/**
+ * In the simulator this does a polling pass on the simulated interrupt
+ * sources.
+ */
+#define port_wait_for_interrupt() ChkIntSources()
+
+#else /* SIM_USE_PREEMPTION */
+/**
+ * Masks the simulated interrupts, a host signal received while masked is
+ * held pending.
+ */
+#define port_lock() {                                                       \
+  _port_irq_masked = TRUE;                                                  \
+  asm volatile ("" : : : "memory");                                         \
+}
+
+/**
+ * Unmasks the simulated interrupts, a pending interrupt is served before
+ * returning.
+ */
+#define port_unlock() {                                                     \
+  asm volatile ("" : : : "memory");                                         \
+  _port_irq_masked = FALSE;                                                 \
+  if (_port_irq_pending)                                                    \
+    _port_irq_serve();                                                      \
+}
+
+/**
+ * The host signal handler masks the interrupts while serving them.
+ */
+#define port_lock_from_isr()
+
+/**
+ * The host signal handler masks the interrupts while serving them.
+ */
+#define port_unlock_from_isr()
+
+/**
+ * Masks the simulated interrupts.
+ */
+#define port_disable() port_lock()
+
+/**
+ * Masks the simulated interrupts.
+ */
+#define port_suspend() port_lock()
+
+/**
+ * Unmasks the simulated interrupts.
+ */
+#define port_enable() port_unlock()
+#endif /* SIM_USE_PREEMPTION */
+
+/**
+ * The port provides a free running counter, the host monotonic time in
+ * nanoseconds.
+ */
+#define PORT_SUPPORTS_RT_COUNTER        TRUE
+
+/**
+ * Frequency of the free running counter.
+ */
+#define PORT_RT_COUNTER_FREQUENCY       1000000000
+
+/**
+ * The port has its own profiler sampler, the host @p SIGPROF signal.
+ */
+#define PORT_SUPPORTS_PROF_SAMPLER      TRUE
+
+/**
+ * The port supports a double word compare and swap instruction.
+ * @note    The @p cmpxchg16b instruction is not part of the original x86-64
+ *          instruction set, all the 64 bits hosts able to run a modern OS
+ *          have it.
+ */
+#define PORT_SUPPORTS_DWCAS             TRUE
+
+/**
+ * Tagged pointer, a pointer and a modifications counter updated atomically
+ * by @p port_dwcas().
+ */
+typedef struct {
+  void                  *tp_ptr;
+  uint64_t              tp_tag;
+} port_tagged_t __attribute__((aligned(16)));
+
+/**
+ * Double word compare and swap, if the location contains the expected
+ * value then the new value is stored, else the expected value is updated
+ * with the location content.
+ */
+static INLINE bool_t port_dwcas(volatile port_tagged_t *p,
+                                port_tagged_t *oldp,
+                                const port_tagged_t *newp) {
+  uint8_t ok;
+
+  asm volatile ("lock; cmpxchg16b %0\n\t"
+                "setz    %1"
+                : "+m" (*p), "=q" (ok),
+                  "+a" (oldp->tp_ptr), "+d" (oldp->tp_tag)
+                : "b" (newp->tp_ptr), "c" (newp->tp_tag)
+                : "memory", "cc");
+  return (bool_t)ok;
+}
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+  void port_switch(Thread *ntp, Thread *otp);
+  void port_halt(void);
+  void _port_thread_trampoline(void);
+  __attribute__((noreturn)) void _port_thread_start(msg_t (*pf)(void *),
+                                                    void *p);
+  void ChkIntSources(void);
+  uint32_t port_rt_get_counter_value(void);
+#if SIM_USE_PREEMPTION
+  extern volatile bool_t _port_irq_masked;
+  extern volatile bool_t _port_irq_pending;
+  void port_init(void);
+  void port_wait_for_interrupt(void);
+  void _port_irq_serve(void);
+#endif
+#if PORT_SUPPORTS_PROF_SAMPLER
+  void port_prof_start(uint32_t freq);
+  void port_prof_stop(void);
+#endif
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _CHCORE_H_ */
+
+/** @} */
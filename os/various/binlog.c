@@ -0,0 +1,316 @@
+/*
+    ChibiOS/RT - Copyright (C) 2006,2007,2008,2009,2010,
+                 2011,2012,2013 Giovanni Di Sirio.
+
+    This file is part of ChibiOS/RT.
+
+    ChibiOS/RT is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    ChibiOS/RT is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * @file    binlog.c
+ * @brief   Deferred formatting binary logger code.
+ *
+ * @addtogroup binlog
+ * @{
+ */
+
+#include "ch.h"
+#include "chprintf.h"
+#include "binlog.h"
+
+/**
+ * @brief   Logger state.
+ */
+static struct {
+  binlog_record_t       buffer[BINLOG_BUFFER_SIZE];
+  uint32_t              head;
+  uint32_t              tail;
+  uint32_t              posted;
+  uint32_t              dropped;
+  uint32_t              reported;
+  BinarySemaphore       sem;
+  BaseSequentialStream  *chp;
+  binlogmode_t          mode;
+  Thread                *tp;
+} binlog;
+
+static WORKING_AREA(binlog_wa, BINLOG_THREAD_STACK_SIZE);
+
+static void write_binary(BaseSequentialStream *chp, uint8_t n,
+                         systime_t time, const void *p, size_t size) {
+
+  chSequentialStreamPut(chp, n);
+  chSequentialStreamWrite(chp, (const uint8_t *)&time, sizeof (systime_t));
+  chSequentialStreamWrite(chp, (const uint8_t *)p, size);
+}
+
+static void write_record(const binlog_record_t *rp) {
+  BaseSequentialStream *chp = binlog.chp;
+
+  if (binlog.mode == BINLOG_BINARY) {
+    /* Format pointer followed by the used arguments.*/
+    write_binary(chp, rp->r_n, rp->r_time, &rp->r_fmt, sizeof (binlogarg_t));
+    chSequentialStreamWrite(chp, (const uint8_t *)rp->r_args,
+                            rp->r_n * sizeof (binlogarg_t));
+    return;
+  }
+  chprintf(chp, "%10U ", (unsigned long)rp->r_time);
+  chprintf(chp, rp->r_fmt, rp->r_args[0], rp->r_args[1],
+           rp->r_args[2], rp->r_args[3]);
+  chprintf(chp, "\r\n");
+}
+
+static void write_dropped(uint32_t n) {
+  binlogarg_t arg = (binlogarg_t)n;
+
+  if (binlog.mode == BINLOG_BINARY)
+    write_binary(binlog.chp, BINLOG_DROPPED, BINLOG_TIMESTAMP(),
+                 &arg, sizeof (binlogarg_t));
+  else
+    chprintf(binlog.chp, "*** %U records dropped\r\n", (unsigned long)n);
+}
+
+/**
+ * @brief   Log output thread.
+ */
+static msg_t binlog_thread(void *p) {
+  binlog_record_t r;
+  uint32_t dropped;
+
+  (void)p;
+  chRegSetThreadName("binlog");
+  if (binlog.mode == BINLOG_BINARY) {
+    static const struct {
+      uint32_t          magic;
+      uint8_t           version;
+      uint8_t           timesize;
+      uint8_t           argsize;
+      uint8_t           maxargs;
+    } header = {BINLOG_MAGIC, BINLOG_VERSION, sizeof (systime_t),
+                sizeof (binlogarg_t), BINLOG_MAX_ARGUMENTS};
+
+    chSequentialStreamWrite(binlog.chp, (const uint8_t *)&header,
+                            sizeof (header));
+  }
+  do {
+    chBSemWait(&binlog.sem);
+    while (TRUE) {
+      /* The record is copied out of the buffer inside a short critical zone
+         so the output cannot be overrun by the producers.*/
+      chSysLock();
+      if (binlog.tail == binlog.head) {
+        dropped = binlog.dropped;
+        chSysUnlock();
+        break;
+      }
+      r = binlog.buffer[binlog.tail & (BINLOG_BUFFER_SIZE - 1)];
+      binlog.tail++;
+      chSysUnlock();
+      write_record(&r);
+    }
+    if (dropped != binlog.reported) {
+      write_dropped(dropped - binlog.reported);
+      binlog.reported = dropped;
+    }
+  } while (!chThdShouldTerminate());
+  return 0;
+}
+
+/**
+ * @brief   Logger initialization.
+ * @note    Records can be posted after initialization, before starting the
+ *          output thread.
+ * @note    The output thread must not be running.
+ *
+ * @init
+ */
+void binlogInit(void) {
+
+  binlog.head = binlog.tail = 0;
+  binlog.posted = binlog.dropped = binlog.reported = 0;
+  chBSemInit(&binlog.sem, TRUE);
+}
+
+/**
+ * @brief   Starts the log output thread.
+ * @details The records already in the buffer are preserved, in binary mode
+ *          a stream header describing the records layout is sent first.
+ *
+ * @param[in] chp       pointer to a @p BaseSequentialStream receiving the
+ *                      log output
+ * @param[in] mode      the output mode
+ * @param[in] prio      priority of the output thread, it should be lower
+ *                      than the priority of the logging threads
+ * @return              A pointer to the output thread.
+ *
+ * @api
+ */
+Thread *binlogStart(BaseSequentialStream *chp, binlogmode_t mode,
+                    tprio_t prio) {
+
+  chDbgCheck(chp != NULL, "binlogStart");
+  chDbgAssert(binlog.tp == NULL, "binlogStart(), #1", "already started");
+
+  binlog.chp = chp;
+  binlog.mode = mode;
+  binlog.tp = chThdCreateStatic(binlog_wa, sizeof(binlog_wa), prio,
+                                binlog_thread, NULL);
+  return binlog.tp;
+}
+
+#if CH_USE_WAITEXIT || defined(__DOXYGEN__)
+/**
+ * @brief   Stops the log output thread.
+ * @details The records in the buffer are output before the thread exits,
+ *          the logger can then be started again.
+ * @pre     The configuration option @p CH_USE_WAITEXIT must be enabled in
+ *          order to use this function.
+ *
+ * @api
+ */
+void binlogStop(void) {
+
+  chDbgAssert(binlog.tp != NULL, "binlogStop(), #1", "not started");
+
+  chThdTerminate(binlog.tp);
+  chBSemSignal(&binlog.sem);
+  chThdWait(binlog.tp);
+  binlog.tp = NULL;
+}
+#endif /* CH_USE_WAITEXIT */
+
+/**
+ * @brief   Posts a log record.
+ * @details The record is stored in the log buffer, if the buffer is full
+ *          the record is dropped and accounted in the dropped counter.
+ * @post    This function does not reschedule so a call to a rescheduling
+ *          function must be performed before unlocking the kernel. Note that
+ *          interrupt handlers always reschedule on exit so an explicit
+ *          reschedule must not be performed in ISRs.
+ *
+ * @param[in] fmt       the format string, it must remain valid until the
+ *                      record is output
+ * @param[in] n         number of used arguments
+ * @param[in] a0        first argument
+ * @param[in] a1        second argument
+ * @param[in] a2        third argument
+ * @param[in] a3        fourth argument
+ *
+ * @iclass
+ */
+void binlogPostI(const char *fmt, unsigned n, binlogarg_t a0,
+                 binlogarg_t a1, binlogarg_t a2, binlogarg_t a3) {
+  binlog_record_t *rp;
+
+  chDbgCheckClassI();
+  chDbgCheck((fmt != NULL) && (n <= BINLOG_MAX_ARGUMENTS), "binlogPostI");
+
+  binlog.posted++;
+  if (binlog.head - binlog.tail >= BINLOG_BUFFER_SIZE) {
+    binlog.dropped++;
+    return;
+  }
+  rp = &binlog.buffer[binlog.head & (BINLOG_BUFFER_SIZE - 1)];
+  rp->r_time = BINLOG_TIMESTAMP();
+  rp->r_fmt = fmt;
+  rp->r_args[0] = a0;
+  rp->r_args[1] = a1;
+  rp->r_args[2] = a2;
+  rp->r_args[3] = a3;
+  rp->r_n = (uint8_t)n;
+
+  /* The output thread is only awakened on the empty to non-empty
+     transition.*/
+  if (binlog.head++ == binlog.tail)
+    chBSemSignalI(&binlog.sem);
+}
+
+/**
+ * @brief   Posts a log record.
+ * @details The record is stored in the log buffer, if the buffer is full
+ *          the record is dropped and accounted in the dropped counter.
+ * @note    The output thread is not rescheduled by this function, it runs
+ *          when the logging threads release the CPU.
+ *
+ * @param[in] fmt       the format string, it must remain valid until the
+ *                      record is output
+ * @param[in] n         number of used arguments
+ * @param[in] a0        first argument
+ * @param[in] a1        second argument
+ * @param[in] a2        third argument
+ * @param[in] a3        fourth argument
+ *
+ * @api
+ */
+void binlogPost(const char *fmt, unsigned n, binlogarg_t a0,
+                binlogarg_t a1, binlogarg_t a2, binlogarg_t a3) {
+
+  chSysLock();
+  binlogPostI(fmt, n, a0, a1, a2, a3);
+  chSysUnlock();
+}
+
+/**
+ * @brief   Posts a log record from an interrupt handler.
+ * @details The record is stored in the log buffer, if the buffer is full
+ *          the record is dropped and accounted in the dropped counter.
+ * @note    This function must be called from an ISR not holding the
+ *          kernel lock.
+ *
+ * @param[in] fmt       the format string, it must remain valid until the
+ *                      record is output
+ * @param[in] n         number of used arguments
+ * @param[in] a0        first argument
+ * @param[in] a1        second argument
+ * @param[in] a2        third argument
+ * @param[in] a3        fourth argument
+ *
+ * @special
+ */
+void binlogPostFromIsr(const char *fmt, unsigned n, binlogarg_t a0,
+                       binlogarg_t a1, binlogarg_t a2, binlogarg_t a3) {
+
+  chSysLockFromIsr();
+  binlogPostI(fmt, n, a0, a1, a2, a3);
+  chSysUnlockFromIsr();
+}
+
+/**
+ * @brief   Returns the number of records posted since initialization.
+ * @note    The counter includes the dropped records.
+ *
+ * @return              The number of posted records.
+ *
+ * @api
+ */
+uint32_t binlogGetPosted(void) {
+
+  return binlog.posted;
+}
+
+/**
+ * @brief   Returns the number of records dropped because the buffer was
+ *          full.
+ *
+ * @return              The number of dropped records.
+ *
+ * @api
+ */
+uint32_t binlogGetDropped(void) {
+
+  return binlog.dropped;
+}
+
+/** @} */
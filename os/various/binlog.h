@@ -0,0 +1,169 @@
+/*
+    ChibiOS/RT - Copyright (C) 2006,2007,2008,2009,2010,
+                 2011,2012,2013 Giovanni Di Sirio.
+
+    This file is part of ChibiOS/RT.
+
+    ChibiOS/RT is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    ChibiOS/RT is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * @file    binlog.h
+ * @brief   Deferred formatting binary logger header.
+ *
+ * @addtogroup binlog
+ * @{
+ */
+
+#ifndef _BINLOG_H_
+#define _BINLOG_H_
+
+#if !CH_USE_SEMAPHORES
+#error "the binary logger requires CH_USE_SEMAPHORES"
+#endif
+
+/**
+ * @brief   Number of records in the log buffer.
+ * @note    It must be a power of two.
+ */
+#if !defined(BINLOG_BUFFER_SIZE) || defined(__DOXYGEN__)
+#define BINLOG_BUFFER_SIZE          64
+#endif
+
+#if (BINLOG_BUFFER_SIZE <= 0) ||                                            \
+    ((BINLOG_BUFFER_SIZE & (BINLOG_BUFFER_SIZE - 1)) != 0)
+#error "BINLOG_BUFFER_SIZE must be a power of two"
+#endif
+
+/**
+ * @brief   Stack size of the log output thread.
+ */
+#if !defined(BINLOG_THREAD_STACK_SIZE) || defined(__DOXYGEN__)
+#define BINLOG_THREAD_STACK_SIZE    256
+#endif
+
+/**
+ * @brief   Timestamp source of the log records.
+ * @note    The default is the system time, a faster clock can be used by
+ *          redefining this macro, the value must fit a @p systime_t.
+ */
+#if !defined(BINLOG_TIMESTAMP) || defined(__DOXYGEN__)
+#define BINLOG_TIMESTAMP()          chTimeNow()
+#endif
+
+/**
+ * @brief   Magic number at the beginning of a binary log stream.
+ */
+#define BINLOG_MAGIC                0x474F4C42
+
+/**
+ * @brief   Binary log stream format version.
+ */
+#define BINLOG_VERSION              1
+
+/**
+ * @brief   Maximum number of arguments of a log record.
+ */
+#define BINLOG_MAX_ARGUMENTS        4
+
+/**
+ * @brief   Arguments count of a dropped records notice.
+ */
+#define BINLOG_DROPPED              0xFF
+
+/**
+ * @brief   Type of a log argument.
+ * @details Arguments are stored as pointer sized integers, integers,
+ *          characters and pointers to strings that remain valid until the
+ *          record is output can be logged, floating point numbers cannot.
+ */
+typedef uintptr_t binlogarg_t;
+
+/**
+ * @brief   Log output modes.
+ */
+typedef enum {
+  BINLOG_TEXT = 0,                  /**< Records formatted by chprintf().   */
+  BINLOG_BINARY = 1                 /**< Raw records for a host decoder.    */
+} binlogmode_t;
+
+/**
+ * @brief   Log record type.
+ */
+typedef struct {
+  systime_t             r_time;         /**< @brief Record timestamp.       */
+  const char            *r_fmt;         /**< @brief Format string.          */
+  binlogarg_t           r_args[BINLOG_MAX_ARGUMENTS];
+                                        /**< @brief Raw arguments.          */
+  uint8_t               r_n;            /**< @brief Number of arguments.    */
+} binlog_record_t;
+
+/**
+ * @name    Logging macros
+ * @details Each macro stores the format string pointer and the arguments
+ *          in the log buffer, the formatting is performed later by the log
+ *          output thread. The @p BINLOG_ISRn() variants must be used from
+ *          interrupt handlers.
+ * @{
+ */
+#define BINLOG0(fmt)                                                        \
+  binlogPost(fmt, 0, 0, 0, 0, 0)
+#define BINLOG1(fmt, a)                                                     \
+  binlogPost(fmt, 1, (binlogarg_t)(a), 0, 0, 0)
+#define BINLOG2(fmt, a, b)                                                  \
+  binlogPost(fmt, 2, (binlogarg_t)(a), (binlogarg_t)(b), 0, 0)
+#define BINLOG3(fmt, a, b, c)                                               \
+  binlogPost(fmt, 3, (binlogarg_t)(a), (binlogarg_t)(b),                    \
+             (binlogarg_t)(c), 0)
+#define BINLOG4(fmt, a, b, c, d)                                            \
+  binlogPost(fmt, 4, (binlogarg_t)(a), (binlogarg_t)(b),                    \
+             (binlogarg_t)(c), (binlogarg_t)(d))
+#define BINLOG_ISR0(fmt)                                                    \
+  binlogPostFromIsr(fmt, 0, 0, 0, 0, 0)
+#define BINLOG_ISR1(fmt, a)                                                 \
+  binlogPostFromIsr(fmt, 1, (binlogarg_t)(a), 0, 0, 0)
+#define BINLOG_ISR2(fmt, a, b)                                              \
+  binlogPostFromIsr(fmt, 2, (binlogarg_t)(a), (binlogarg_t)(b), 0, 0)
+#define BINLOG_ISR3(fmt, a, b, c)                                           \
+  binlogPostFromIsr(fmt, 3, (binlogarg_t)(a), (binlogarg_t)(b),             \
+                    (binlogarg_t)(c), 0)
+#define BINLOG_ISR4(fmt, a, b, c, d)                                        \
+  binlogPostFromIsr(fmt, 4, (binlogarg_t)(a), (binlogarg_t)(b),             \
+                    (binlogarg_t)(c), (binlogarg_t)(d))
+/** @} */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+  void binlogInit(void);
+  Thread *binlogStart(BaseSequentialStream *chp, binlogmode_t mode,
+                      tprio_t prio);
+#if CH_USE_WAITEXIT
+  void binlogStop(void);
+#endif
+  void binlogPostI(const char *fmt, unsigned n, binlogarg_t a0,
+                   binlogarg_t a1, binlogarg_t a2, binlogarg_t a3);
+  void binlogPost(const char *fmt, unsigned n, binlogarg_t a0,
+                  binlogarg_t a1, binlogarg_t a2, binlogarg_t a3);
+  void binlogPostFromIsr(const char *fmt, unsigned n, binlogarg_t a0,
+                         binlogarg_t a1, binlogarg_t a2, binlogarg_t a3);
+  uint32_t binlogGetPosted(void);
+  uint32_t binlogGetDropped(void);
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _BINLOG_H_ */
+
+/** @} */
@@ -34,7 +34,8 @@
 #include "ch.h"
 #include "chprintf.h"
 
-#define MAX_FILLER 11
+/* Digits of the largest long in octal, 11 with 32 bits, 22 with 64 bits.*/
+#define MAX_FILLER ((sizeof(long) * 8 + 2) / 3)
 #define FLOAT_PRECISION 100000
 
 static char *long_to_string_with_divisor(char *p,
@@ -43,13 +44,13 @@ static char *long_to_string_with_divisor(char *p,
                                          long divisor) {
   int i;
   char *q;
-  long l, ll;
+  unsigned long l, ll;
 
-  l = num;
+  l = (unsigned long)num;
   if (divisor == 0) {
-    ll = num;
+    ll = l;
   } else {
-    ll = divisor;
+    ll = (unsigned long)divisor;
   }
 
   q = p + MAX_FILLER;
@@ -231,7 +232,7 @@ unsigned_common:
       if (is_long)
         l = va_arg(ap, long);
       else
-        l = va_arg(ap, int);
+        l = (long)va_arg(ap, unsigned int);
       p = ltoa(p, l, c);
       break;
     default:
@@ -684,6 +684,31 @@ namespace chibios_rt {
     return chIQPutI(&iq, b);
   }
 
+  size_t InQueue::writeI(const uint8_t *bp, size_t n) {
+
+    return chIQWriteI(&iq, bp, n);
+  }
+
+  size_t InQueue::getReadSpanI(uint8_t **bpp) {
+
+    return chIQGetReadSpanI(&iq, bpp);
+  }
+
+  void InQueue::readCommitS(size_t n) {
+
+    chIQReadCommitS(&iq, n);
+  }
+
+  size_t InQueue::getWriteSpanI(uint8_t **bpp) {
+
+    return chIQGetWriteSpanI(&iq, bpp);
+  }
+
+  void InQueue::writeCommitI(size_t n) {
+
+    chIQWriteCommitI(&iq, n);
+  }
+
   msg_t InQueue::get() {
 
     return chIQGet(&iq);
@@ -747,6 +772,31 @@ namespace chibios_rt {
     return chOQGetI(&oq);
   }
 
+  size_t OutQueue::readI(uint8_t *bp, size_t n) {
+
+    return chOQReadI(&oq, bp, n);
+  }
+
+  size_t OutQueue::getWriteSpanI(uint8_t **bpp) {
+
+    return chOQGetWriteSpanI(&oq, bpp);
+  }
+
+  void OutQueue::writeCommitS(size_t n) {
+
+    chOQWriteCommitS(&oq, n);
+  }
+
+  size_t OutQueue::getReadSpanI(uint8_t **bpp) {
+
+    return chOQGetReadSpanI(&oq, bpp);
+  }
+
+  void OutQueue::readCommitI(size_t n) {
+
+    chOQReadCommitI(&oq, n);
+  }
+
   size_t OutQueue::writeTimeout(const uint8_t *bp, size_t n,
                                 systime_t time) {
 
@@ -854,7 +904,109 @@ namespace chibios_rt {
 
     chPoolFreeI(&pool, objp);
   }
+
+#if CH_USE_SEMAPHORES
+  /*------------------------------------------------------------------------*
+   * chibios_rt::GuardedMemoryPool                                          *
+   *------------------------------------------------------------------------*/
+  GuardedMemoryPool::GuardedMemoryPool(size_t size) {
+
+    chGuardedPoolInit(&pool, size);
+  }
+
+  GuardedMemoryPool::GuardedMemoryPool(size_t size, void* p, size_t n) {
+
+    chGuardedPoolInit(&pool, size);
+    chGuardedPoolLoadArray(&pool, p, n);
+  }
+
+  void GuardedMemoryPool::loadArray(void *p, size_t n) {
+
+    chGuardedPoolLoadArray(&pool, p, n);
+  }
+
+  void *GuardedMemoryPool::allocI(void) {
+
+    return chGuardedPoolAllocI(&pool);
+  }
+
+  void *GuardedMemoryPool::allocS(systime_t time) {
+
+    return chGuardedPoolAllocTimeoutS(&pool, time);
+  }
+
+  void *GuardedMemoryPool::alloc(systime_t time) {
+
+    return chGuardedPoolAllocTimeout(&pool, time);
+  }
+
+  void GuardedMemoryPool::free(void *objp) {
+
+    chGuardedPoolFree(&pool, objp);
+  }
+
+  void GuardedMemoryPool::freeI(void *objp) {
+
+    chGuardedPoolFreeI(&pool, objp);
+  }
+
+  cnt_t GuardedMemoryPool::getMinFree(void) {
+
+    return chGuardedPoolGetMinFree(&pool);
+  }
+#endif /* CH_USE_SEMAPHORES */
 #endif /* CH_USE_MEMPOOLS */
+
+#if CH_USE_ARENAS
+  /*------------------------------------------------------------------------*
+   * chibios_rt::MemoryArena                                                *
+   *------------------------------------------------------------------------*/
+  MemoryArena::MemoryArena(size_t size, memgetfunc_t provider) {
+
+    chArenaInit(&arena, size, provider);
+  }
+
+  MemoryArena::MemoryArena(void *buf, size_t size) {
+
+    chArenaInit(&arena, 0, NULL);
+    chArenaLoadBuffer(&arena, buf, size);
+  }
+
+  void MemoryArena::loadBuffer(void *buf, size_t size) {
+
+    chArenaLoadBuffer(&arena, buf, size);
+  }
+
+  void *MemoryArena::alloc(size_t size) {
+
+    return chArenaAlloc(&arena, size);
+  }
+
+  arenamark_t MemoryArena::getMark(void) {
+
+    return chArenaGetMark(&arena);
+  }
+
+  void MemoryArena::release(arenamark_t mark) {
+
+    chArenaRelease(&arena, mark);
+  }
+
+  void MemoryArena::reset(void) {
+
+    chArenaReset(&arena);
+  }
+
+  void MemoryArena::trim(void) {
+
+    chArenaTrim(&arena);
+  }
+
+  ::MemoryArena *MemoryArena::setDefault(void) {
+
+    return chArenaSetDefault(&arena);
+  }
+#endif /* CH_USE_ARENAS */
 }
 
 /** @} */
@@ -31,6 +31,8 @@
 #ifndef _CH_HPP_
 #define _CH_HPP_
 
+#include <new>
+
 /**
  * @brief   ChibiOS kernel-related classes and interfaces.
  */
@@ -1548,6 +1550,57 @@ namespace chibios_rt {
      */
     msg_t putI(uint8_t b);
 
+    /**
+     * @brief   Input queue write of multiple bytes.
+     * @details The data is written into the low end of an input queue in a
+     *          single critical zone.
+     *
+     * @param[in] bp        pointer to the data buffer
+     * @param[in] n         the maximum amount of data to be written
+     * @return              The number of bytes effectively written.
+     *
+     * @iclass
+     */
+    size_t writeI(const uint8_t *bp, size_t n);
+
+    /**
+     * @brief   Returns the readable contiguous region of the queue.
+     *
+     * @param[out] bpp      pointer to a variable receiving the region address
+     * @return              The size of the region.
+     *
+     * @iclass
+     */
+    size_t getReadSpanI(uint8_t **bpp);
+
+    /**
+     * @brief   Releases data read in place from the queue.
+     *
+     * @param[in] n         number of bytes to be released
+     *
+     * @sclass
+     */
+    void readCommitS(size_t n);
+
+    /**
+     * @brief   Returns the writable contiguous region of the queue.
+     *
+     * @param[out] bpp      pointer to a variable receiving the region address
+     * @return              The size of the region.
+     *
+     * @iclass
+     */
+    size_t getWriteSpanI(uint8_t **bpp);
+
+    /**
+     * @brief   Makes data written in place available in the queue.
+     *
+     * @param[in] n         number of bytes written
+     *
+     * @iclass
+     */
+    void writeCommitI(size_t n);
+
     /**
      * @brief   Input queue read.
      * @details This function reads a byte value from an input queue. If the
@@ -1590,8 +1643,8 @@ namespace chibios_rt {
      *          been reset.
      * @note    The function is not atomic, if you need atomicity it is
      *          suggested to use a semaphore or a mutex for mutual exclusion.
-     * @note    The callback is invoked before reading each character from the
-     *          buffer or before entering the state @p THD_STATE_WTQUEUE.
+     * @note    The callback is invoked before reading each run of data from
+     *          the buffer or before entering the state @p THD_STATE_WTQUEUE.
      *
      * @param[out] bp       pointer to the data buffer
      * @param[in] n         the maximum amount of data to be transferred, the
@@ -1765,6 +1818,57 @@ namespace chibios_rt {
      */
     msg_t getI(void);
 
+    /**
+     * @brief   Output queue read of multiple bytes.
+     * @details The data is read from the low end of an output queue in a
+     *          single critical zone.
+     *
+     * @param[out] bp       pointer to the data buffer
+     * @param[in] n         the maximum amount of data to be read
+     * @return              The number of bytes effectively read.
+     *
+     * @iclass
+     */
+    size_t readI(uint8_t *bp, size_t n);
+
+    /**
+     * @brief   Returns the writable contiguous region of the queue.
+     *
+     * @param[out] bpp      pointer to a variable receiving the region address
+     * @return              The size of the region.
+     *
+     * @iclass
+     */
+    size_t getWriteSpanI(uint8_t **bpp);
+
+    /**
+     * @brief   Makes data written in place available in the queue.
+     *
+     * @param[in] n         number of bytes written
+     *
+     * @sclass
+     */
+    void writeCommitS(size_t n);
+
+    /**
+     * @brief   Returns the readable contiguous region of the queue.
+     *
+     * @param[out] bpp      pointer to a variable receiving the region address
+     * @return              The size of the region.
+     *
+     * @iclass
+     */
+    size_t getReadSpanI(uint8_t **bpp);
+
+    /**
+     * @brief   Releases data read in place from the queue.
+     *
+     * @param[in] n         number of bytes to be released
+     *
+     * @iclass
+     */
+    void readCommitI(size_t n);
+
     /**
      * @brief   Output queue write with timeout.
      * @details The function writes data from a buffer to an output queue. The
@@ -1773,8 +1877,8 @@ namespace chibios_rt {
      *          been reset.
      * @note    The function is not atomic, if you need atomicity it is
      *          suggested to use a semaphore or a mutex for mutual exclusion.
-     * @note    The callback is invoked after writing each character into the
-     *          buffer.
+     * @note    The callback is invoked after writing each run of data into
+     *          the buffer.
      *
      * @param[out] bp       pointer to the data buffer
      * @param[in] n         the maximum amount of data to be transferred, the
@@ -1819,6 +1923,278 @@ namespace chibios_rt {
   };
 #endif /* CH_USE_QUEUES */
 
+#if CH_USE_RINGS || defined(__DOXYGEN__)
+  /*------------------------------------------------------------------------*
+   * chibios_rt::RingBuffer                                                 *
+   *------------------------------------------------------------------------*/
+  /**
+   * @brief   Template class encapsulating a ring buffer and its records.
+   *
+   * @param T                   type of the records, records are copied
+   *                            without invoking constructors
+   * @param N                   number of records, it must be a power of two
+   */
+  template<class T, size_t N>
+  class RingBuffer {
+  private:
+    /**
+     * @brief   Embedded @p ::RingBuffer structure.
+     */
+    ::RingBuffer rb;
+    T rb_buf[N];
+
+  public:
+    /**
+     * @brief   RingBuffer constructor.
+     *
+     * @init
+     */
+    RingBuffer(void) {
+
+      chRingInit(&rb, rb_buf, sizeof (T), N);
+    }
+
+    /**
+     * @brief   Returns the number of records in the ring buffer.
+     *
+     * @return              The number of records in the buffer.
+     *
+     * @special
+     */
+    size_t getUsed(void) {
+
+      return chRingGetUsed(&rb);
+    }
+
+    /**
+     * @brief   Resets the ring buffer.
+     * @note    The producer must not access the buffer during the reset.
+     *
+     * @iclass
+     */
+    void resetI(void) {
+
+      chRingResetI(&rb);
+    }
+
+    /**
+     * @brief   Ring buffer write.
+     *
+     * @param[in] rec       the record to be written
+     * @return              The operation status.
+     * @retval RING_OK      if the operation has been completed with success.
+     * @retval RING_FULL    if the buffer is full.
+     *
+     * @iclass
+     */
+    msg_t putI(const T &rec) {
+
+      return chRingPutRecordI(&rb, &rec);
+    }
+
+    /**
+     * @brief   Ring buffer write from an interrupt handler.
+     * @note    This function must be called from an ISR not holding the
+     *          kernel lock.
+     *
+     * @param[in] rec       the record to be written
+     * @return              The operation status.
+     * @retval RING_OK      if the operation has been completed with success.
+     * @retval RING_FULL    if the buffer is full.
+     *
+     * @special
+     */
+    msg_t putFromIsr(const T &rec) {
+
+      return chRingPutRecordFromIsr(&rb, &rec);
+    }
+
+    /**
+     * @brief   Ring buffer read with timeout.
+     *
+     * @param[out] rec      the record receiving the data
+     * @param[in] time      the number of ticks before the operation timeouts,
+     *                      the following special values are allowed:
+     *                      - @a TIME_IMMEDIATE immediate timeout.
+     *                      - @a TIME_INFINITE no timeout.
+     *                      .
+     * @return              The operation status.
+     * @retval RING_OK      if a record has been read.
+     * @retval RING_TIMEOUT if the specified time expired.
+     * @retval RING_RESET   if the buffer has been reset.
+     *
+     * @api
+     */
+    msg_t get(T &rec, systime_t time) {
+
+      return chRingGetRecordTimeout(&rb, &rec, time);
+    }
+  };
+#endif /* CH_USE_RINGS */
+
+#if CH_USE_TOPICS || defined(__DOXYGEN__)
+  /*------------------------------------------------------------------------*
+   * chibios_rt::Topic                                                      *
+   *------------------------------------------------------------------------*/
+  /**
+   * @brief   Template class encapsulating a topic and its messages buffer.
+   *
+   * @param T                   type of the messages, messages are copied
+   *                            without invoking constructors
+   * @param N                   number of message slots, it must be a power
+   *                            of two
+   */
+  template<class T, size_t N = 1>
+  class Topic {
+  public:
+    /**
+     * @brief   Embedded @p ::Topic structure.
+     */
+    ::Topic topic;
+
+  private:
+    T t_buf[N];
+
+  public:
+    /**
+     * @brief   Topic constructor.
+     *
+     * @init
+     */
+    Topic(void) {
+
+      chTopicInit(&topic, t_buf, sizeof (T), N);
+    }
+
+    /**
+     * @brief   Returns the number of messages published on the topic.
+     *
+     * @return              The number of published messages.
+     *
+     * @special
+     */
+    uint32_t getPublished(void) {
+
+      return chTopicGetPublished(&topic);
+    }
+
+    /**
+     * @brief   Publishes a message on the topic.
+     *
+     * @param[in] msg       the message to be published
+     *
+     * @iclass
+     */
+    void publishI(const T &msg) {
+
+      chTopicPublishI(&topic, &msg);
+    }
+
+    /**
+     * @brief   Publishes a message on the topic.
+     *
+     * @param[in] msg       the message to be published
+     *
+     * @api
+     */
+    void publish(const T &msg) {
+
+      chTopicPublish(&topic, &msg);
+    }
+  };
+
+  /*------------------------------------------------------------------------*
+   * chibios_rt::TopicSubscriber                                            *
+   *------------------------------------------------------------------------*/
+  /**
+   * @brief   Template class encapsulating a topic subscriber.
+   *
+   * @param T                   type of the messages
+   */
+  template<class T>
+  class TopicSubscriber {
+  public:
+    /**
+     * @brief   Embedded @p ::TopicSubscriber structure.
+     */
+    ::TopicSubscriber sub;
+
+    /**
+     * @brief   Subscribes the current thread to a topic.
+     *
+     * @param[in] tp        the topic to subscribe to
+     * @param[in] mask      the mask of event flags to be signaled on publish
+     * @param[in] depth     the maximum number of unread messages to be
+     *                      retained, the special value @p TOPIC_LATEST makes
+     *                      a latest-value subscriber
+     *
+     * @api
+     */
+    template<size_t N>
+    void subscribe(Topic<T, N> &tp, eventmask_t mask, size_t depth) {
+
+      chTopicSubscribe(&tp.topic, &sub, mask, depth);
+    }
+
+    /**
+     * @brief   Unsubscribes from the topic.
+     *
+     * @api
+     */
+    void unsubscribe(void) {
+
+      chTopicUnsubscribe(&sub);
+    }
+
+    /**
+     * @brief   Returns the number of messages lost by the subscriber.
+     *
+     * @return              The number of dropped messages.
+     *
+     * @special
+     */
+    uint32_t getDropped(void) {
+
+      return chTopicGetDropped(&sub);
+    }
+
+    /**
+     * @brief   Reads a message without waiting.
+     *
+     * @param[out] msg      the message receiving the data
+     * @return              The operation status.
+     * @retval RDY_OK       if a message has been read.
+     * @retval RDY_TIMEOUT  if there are no new messages.
+     *
+     * @special
+     */
+    msg_t receive(T &msg) {
+
+      return chTopicReceive(&sub, &msg);
+    }
+
+    /**
+     * @brief   Reads a message with timeout.
+     *
+     * @param[out] msg      the message receiving the data
+     * @param[in] time      the number of ticks before the operation timeouts,
+     *                      the following special values are allowed:
+     *                      - @a TIME_IMMEDIATE immediate timeout.
+     *                      - @a TIME_INFINITE no timeout.
+     *                      .
+     * @return              The operation status.
+     * @retval RDY_OK       if a message has been read.
+     * @retval RDY_TIMEOUT  if the operation has timed out.
+     *
+     * @api
+     */
+    msg_t receive(T &msg, systime_t time) {
+
+      return chTopicReceiveTimeout(&sub, &msg, time);
+    }
+  };
+#endif /* CH_USE_TOPICS */
+
 #if CH_USE_MAILBOXES || defined(__DOXYGEN__)
   /*------------------------------------------------------------------------*
    * chibios_rt::Mailbox                                                    *
@@ -2185,8 +2561,381 @@ namespace chibios_rt {
       loadArray(pool_buf, N);
     }
   };
+
+#if CH_USE_SEMAPHORES || defined(__DOXYGEN__)
+  /*------------------------------------------------------------------------*
+   * chibios_rt::GuardedMemoryPool                                          *
+   *------------------------------------------------------------------------*/
+  /**
+   * @brief   Class encapsulating a guarded memory pool.
+   */
+  class GuardedMemoryPool {
+  public:
+    /**
+     * @brief   Embedded @p ::GuardedMemoryPool structure.
+     */
+    ::GuardedMemoryPool pool;
+
+    /**
+     * @brief   GuardedMemoryPool constructor.
+     *
+     * @param[in] size      the size of the objects contained in this guarded
+     *                      memory pool, the minimum accepted size is the size
+     *                      of a pointer to void.
+     *
+     * @init
+     */
+    GuardedMemoryPool(size_t size);
+
+    /**
+     * @brief   GuardedMemoryPool constructor.
+     *
+     * @param[in] size      the size of the objects contained in this guarded
+     *                      memory pool, the minimum accepted size is the size
+     *                      of a pointer to void.
+     * @param[in] p         pointer to the array first element
+     * @param[in] n         number of elements in the array
+     *
+     * @init
+     */
+    GuardedMemoryPool(size_t size, void* p, size_t n);
+
+    /**
+     * @brief   Loads a guarded memory pool with an array of static objects.
+     * @pre     The array elements must be of the right size for the specified
+     *          guarded memory pool.
+     *
+     * @param[in] p         pointer to the array first element
+     * @param[in] n         number of elements in the array
+     *
+     * @api
+     */
+    void loadArray(void *p, size_t n);
+
+    /**
+     * @brief   Allocates an object from a guarded memory pool.
+     *
+     * @return              The pointer to the allocated object.
+     * @retval NULL         if pool is empty.
+     *
+     * @iclass
+     */
+    void *allocI(void);
+
+    /**
+     * @brief   Allocates an object from a guarded memory pool.
+     * @details If the pool is empty then the calling thread waits until an
+     *          object is returned to the pool or the timeout expires.
+     *
+     * @param[in] time      the number of ticks before the operation timeouts,
+     *                      the following special values are allowed:
+     *                      - @a TIME_IMMEDIATE immediate timeout.
+     *                      - @a TIME_INFINITE no timeout.
+     *                      .
+     * @return              The pointer to the allocated object.
+     * @retval NULL         if the operation timed out.
+     *
+     * @sclass
+     */
+    void *allocS(systime_t time);
+
+    /**
+     * @brief   Allocates an object from a guarded memory pool.
+     * @details If the pool is empty then the calling thread waits until an
+     *          object is returned to the pool or the timeout expires.
+     *
+     * @param[in] time      the number of ticks before the operation timeouts,
+     *                      the following special values are allowed:
+     *                      - @a TIME_IMMEDIATE immediate timeout.
+     *                      - @a TIME_INFINITE no timeout.
+     *                      .
+     * @return              The pointer to the allocated object.
+     * @retval NULL         if the operation timed out.
+     *
+     * @api
+     */
+    void *alloc(systime_t time);
+
+    /**
+     * @brief   Releases an object into a guarded memory pool.
+     *
+     * @param[in] objp      the pointer to the object to be released
+     *
+     * @api
+     */
+    void free(void *objp);
+
+    /**
+     * @brief   Releases an object into a guarded memory pool.
+     *
+     * @param[in] objp      the pointer to the object to be released
+     *
+     * @iclass
+     */
+    void freeI(void *objp);
+
+    /**
+     * @brief   Returns the minimum number of free objects ever reached.
+     *
+     * @return              The minimum number of free objects.
+     *
+     * @api
+     */
+    cnt_t getMinFree(void);
+  };
+
+  /*------------------------------------------------------------------------*
+   * chibios_rt::GuardedObjectsPool                                         *
+   *------------------------------------------------------------------------*/
+  /**
+   * @brief   Template class encapsulating a guarded memory pool and its
+   *          elements.
+   */
+  template<class T, size_t N>
+  class GuardedObjectsPool : public GuardedMemoryPool {
+  private:
+    /* The buffer is declared as an array of pointers to void for two
+       reasons:
+       1) The objects must be properly aligned to hold a pointer as
+          first field.
+       2) There is no need to invoke constructors for object that are
+          into the pool.*/
+    void *pool_buf[(N * sizeof (T)) / sizeof (void *)];
+
+  public:
+    /**
+     * @brief   GuardedObjectsPool constructor.
+     *
+     * @init
+     */
+    GuardedObjectsPool(void) : GuardedMemoryPool(sizeof (T)) {
+
+      loadArray(pool_buf, N);
+    }
+  };
+#endif /* CH_USE_SEMAPHORES */
 #endif /* CH_USE_MEMPOOLS */
 
+#if CH_USE_ARENAS || defined(__DOXYGEN__)
+  /*------------------------------------------------------------------------*
+   * chibios_rt::MemoryArena                                                *
+   *------------------------------------------------------------------------*/
+  /**
+   * @brief   Class encapsulating a memory arena.
+   */
+  class MemoryArena {
+  public:
+    /**
+     * @brief   Embedded @p ::MemoryArena structure.
+     */
+    ::MemoryArena arena;
+
+    /**
+     * @brief   MemoryArena constructor.
+     *
+     * @param[in] size      default size of the blocks obtained from the
+     *                      provider
+     * @param[in] provider  memory provider function for the memory arena or
+     *                      @p NULL if the arena is not allowed to grow
+     *                      automatically
+     *
+     * @init
+     */
+    MemoryArena(size_t size, memgetfunc_t provider);
+
+    /**
+     * @brief   MemoryArena constructor.
+     *
+     * @param[in] buf       pointer to a static buffer to be loaded
+     * @param[in] size      size of the buffer
+     *
+     * @init
+     */
+    MemoryArena(void *buf, size_t size);
+
+    /**
+     * @brief   Loads a static buffer into the memory arena.
+     * @pre     The buffer base must be aligned to the @p stkalign_t type size.
+     *
+     * @param[in] buf       pointer to the buffer
+     * @param[in] size      size of the buffer
+     *
+     * @api
+     */
+    void loadBuffer(void *buf, size_t size);
+
+    /**
+     * @brief   Allocates an object from the memory arena.
+     *
+     * @param[in] size      the size of the object to be allocated
+     * @return              A pointer to the allocated object.
+     * @retval NULL         if the object cannot be allocated.
+     *
+     * @api
+     */
+    void *alloc(size_t size);
+
+    /**
+     * @brief   Returns a mark of the current arena position.
+     *
+     * @return              The arena mark.
+     *
+     * @api
+     */
+    arenamark_t getMark(void);
+
+    /**
+     * @brief   Releases the objects allocated after a mark.
+     *
+     * @param[in] mark      the arena mark
+     *
+     * @api
+     */
+    void release(arenamark_t mark);
+
+    /**
+     * @brief   Releases all the objects allocated in the arena.
+     *
+     * @api
+     */
+    void reset(void);
+
+    /**
+     * @brief   Returns the spare blocks to the heap.
+     *
+     * @api
+     */
+    void trim(void);
+
+    /**
+     * @brief   Makes this arena the default arena of the current thread.
+     *
+     * @return              The previous default arena.
+     *
+     * @api
+     */
+    ::MemoryArena *setDefault(void);
+  };
+
+  /*------------------------------------------------------------------------*
+   * chibios_rt::ArenaAllocator                                             *
+   *------------------------------------------------------------------------*/
+  /**
+   * @brief   Allocator template class allocating from a memory arena.
+   * @details This class satisfies the standard allocator requirements and
+   *          can be used with the standard containers. The deallocation
+   *          is a no-operation, the memory is reclaimed by releasing the
+   *          arena.
+   *
+   * @param T               the allocated objects type
+   */
+  template<class T>
+  class ArenaAllocator {
+  public:
+    typedef T value_type;
+    typedef T *pointer;
+    typedef const T *const_pointer;
+    typedef T &reference;
+    typedef const T &const_reference;
+    typedef size_t size_type;
+    typedef ptrdiff_t difference_type;
+
+    template<class U>
+    struct rebind {
+      typedef ArenaAllocator<U> other;
+    };
+
+    /**
+     * @brief   Pointer to the encapsulated arena.
+     */
+    ::MemoryArena *ap;
+
+    /**
+     * @brief   ArenaAllocator constructor.
+     *
+     * @param[in] arena     the memory arena
+     *
+     * @init
+     */
+    ArenaAllocator(MemoryArena &arena) : ap(&arena.arena) {
+
+    }
+
+    /**
+     * @brief   ArenaAllocator converting constructor.
+     *
+     * @init
+     */
+    template<class U>
+    ArenaAllocator(const ArenaAllocator<U> &other) : ap(other.ap) {
+
+    }
+
+    pointer address(reference x) const {
+
+      return &x;
+    }
+
+    const_pointer address(const_reference x) const {
+
+      return &x;
+    }
+
+    /**
+     * @brief   Allocates an array of objects, the objects are not
+     *          constructed.
+     *
+     * @param[in] n         number of objects
+     * @return              A pointer to the allocated array.
+     * @retval NULL         if the array cannot be allocated.
+     *
+     * @api
+     */
+    pointer allocate(size_type n, const void * = 0) {
+
+      return static_cast<pointer>(chArenaAlloc(ap, n * sizeof (T)));
+    }
+
+    /**
+     * @brief   Deallocation, does nothing.
+     *
+     * @api
+     */
+    void deallocate(pointer p, size_type n) {
+
+      (void)p;
+      (void)n;
+    }
+
+    size_type max_size(void) const {
+
+      return ((size_type)-1) / sizeof (T);
+    }
+
+    void construct(pointer p, const T &val) {
+
+      ::new((void *)p) T(val);
+    }
+
+    void destroy(pointer p) {
+
+      p->~T();
+    }
+  };
+
+  template<class T, class U>
+  bool operator==(const ArenaAllocator<T> &a, const ArenaAllocator<U> &b) {
+
+    return a.ap == b.ap;
+  }
+
+  template<class T, class U>
+  bool operator!=(const ArenaAllocator<T> &a, const ArenaAllocator<U> &b) {
+
+    return a.ap != b.ap;
+  }
+#endif /* CH_USE_ARENAS */
+
   /*------------------------------------------------------------------------*
    * chibios_rt::BaseSequentialStreamInterface                              *
    *------------------------------------------------------------------------*/
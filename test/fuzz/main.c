@@ -0,0 +1,877 @@
+/*
+    ChibiOS/RT - Copyright (C) 2006,2007,2008,2009,2010,
+                 2011,2012,2013 Giovanni Di Sirio.
+
+    This file is part of ChibiOS/RT.
+
+    ChibiOS/RT is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    ChibiOS/RT is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*
+ * Scheduler worst-case latency fuzzer.
+ *
+ * Each run creates a set of worker threads with random priorities, every
+ * worker executes a random sequence of semaphore, mutex, condition variable,
+ * mailbox, memory pool, virtual timer and priority operations. Simulated
+ * interrupts are raised by a virtual timer re-armed at random intervals,
+ * its callback performs random I-class operations from the tick interrupt
+ * context. All the random choices derive from the run seed.
+ *
+ * The memory pool objects are stamped by their owner and verified before
+ * being freed, a pool returning an object to two owners or losing objects
+ * is reported as an error. The fuzzer configuration enables the lock-free
+ * pools, the preemptive simulator interleaves their fast paths with the
+ * interrupt side allocations.
+ *
+ * Two probe threads, above the workers priority, measure the latencies:
+ * - Interrupt-to-thread, from the simulated interrupt to the probe thread
+ *   execution, this includes the timers expiring in the same tick.
+ * - Wakeup, from a worker signaling the probe thread to its execution.
+ *
+ * The global order of the operations is recorded, the operations sequence
+ * leading to the worst latency is saved together with the seed and can be
+ * replayed, the replay enforces the recorded operations order.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "ch.h"
+#include "hal.h"
+
+#if !PORT_SUPPORTS_RT_COUNTER
+#error "the fuzzer requires a port with a realtime counter"
+#endif
+
+/**
+ * @brief   Maximum number of worker threads.
+ */
+#define FUZZ_MAX_THREADS    8
+
+/**
+ * @brief   Number of objects of each kind shared by the workers.
+ */
+#define FUZZ_SEMS           4
+#define FUZZ_MUTEXES        4
+#define FUZZ_MB_SIZE        4
+#define FUZZ_TIMERS         32
+#define FUZZ_POOL_SIZE      4
+
+/**
+ * @brief   Maximum semaphores counter, limits the signals accumulation.
+ */
+#define FUZZ_SEM_MAX        2
+
+/**
+ * @brief   Operations trace size in entries.
+ */
+#define FUZZ_TRACE_SIZE     0x40000
+
+/**
+ * @brief   Workers priorities range.
+ */
+#define FUZZ_PRIO_BASE      (NORMALPRIO - 8)
+#define FUZZ_PRIO_RANGE     17
+
+/**
+ * @brief   Probe threads priority, above all the workers.
+ */
+#define FUZZ_PROBE_PRIO     (NORMALPRIO + 20)
+
+/**
+ * @brief   Trace thread identifier of the interrupt operations.
+ */
+#define FUZZ_ISR            0xFF
+
+#define FUZZ_WA_SIZE        THD_WA_SIZE(2048)
+
+/*
+ * Operation codes, the interrupt operations follow the thread ones.
+ */
+#define OP_SEM_WAIT         0
+#define OP_SEM_SIGNAL       1
+#define OP_MTX_CHAIN        2
+#define OP_COND_WAIT        3
+#define OP_COND_SIGNAL      4
+#define OP_COND_BROADCAST   5
+#define OP_MB_POST          6
+#define OP_MB_FETCH         7
+#define OP_SLEEP            8
+#define OP_TIMERS           9
+#define OP_PRIO             10
+#define OP_PROBE            11
+#define OP_POOL             12
+#define OP_NUM              13
+#define IOP_SEM_SIGNAL      13
+#define IOP_COND_BROADCAST  14
+#define IOP_MB_POST         15
+#define IOP_PROBE           16
+#define IOP_POOL            17
+#define IOP_NUM             5
+
+static const char *const opnames[] = {
+  "semwait", "semsignal", "mtxchain", "condwait", "condsignal",
+  "condbroadcast", "mbpost", "mbfetch", "sleep", "timers", "prio", "probe",
+  "pool", "isr-semsignal", "isr-condbroadcast", "isr-mbpost", "isr-probe",
+  "isr-pool"
+};
+
+/**
+ * @brief   Operations trace entry.
+ */
+typedef struct {
+  uint8_t               thread;     /**< @brief Worker index or FUZZ_ISR.   */
+  uint8_t               op;         /**< @brief Operation code.             */
+  uint8_t               a;          /**< @brief First argument.             */
+  uint8_t               b;          /**< @brief Second argument.            */
+  uint8_t               c;          /**< @brief Third argument.             */
+} fuzzentry_t;
+
+/**
+ * @brief   Latency probe.
+ */
+typedef struct {
+  Semaphore             sem;        /**< @brief Wakeup semaphore.           */
+  volatile uint32_t     stamp;      /**< @brief Counter at wakeup.          */
+  uint32_t              max;        /**< @brief Worst latency in cycles.    */
+  unsigned              seq;        /**< @brief Operations before worst.    */
+  unsigned              count;      /**< @brief Number of samples.          */
+} fuzzprobe_t;
+
+/*
+ * Run parameters.
+ */
+static uint32_t seed;
+static unsigned runs = 10;
+static unsigned nthreads = 6;
+static unsigned nops = 1000;
+static bool_t metric_isr = TRUE;
+static const char *outname = "worst.txt";
+static const char *replayname;
+
+/*
+ * Run state.
+ */
+static fuzzentry_t trace[FUZZ_TRACE_SIZE];
+static unsigned tlen;
+static unsigned tpos;
+static bool_t replay;
+static bool_t truncated;
+static bool_t diverged;
+static bool_t stopping;
+static Thread *waiting[FUZZ_MAX_THREADS];
+static uint32_t isr_rnd, isr_timing_rnd;
+
+/*
+ * Kernel objects shared by the workers.
+ */
+static Semaphore sems[FUZZ_SEMS];
+static Mutex mtxs[FUZZ_MUTEXES];
+static Mutex cmtx;
+static CondVar cond;
+static Mailbox mb;
+static msg_t mb_buffer[FUZZ_MB_SIZE];
+static VirtualTimer timers[FUZZ_TIMERS];
+static unsigned tnext;
+static VirtualTimer isr_vt;
+static fuzzprobe_t isr_probe, wake_probe;
+static MemoryPool pool;
+static uint32_t pool_objects[FUZZ_POOL_SIZE][4];
+static uint32_t pool_stamp;
+static unsigned pool_errors;
+
+static WORKING_AREA(waworkers[FUZZ_MAX_THREADS], FUZZ_WA_SIZE);
+static WORKING_AREA(waprobes[2], FUZZ_WA_SIZE);
+
+/*===========================================================================*/
+/* Random workload generation.                                               */
+/*===========================================================================*/
+
+/*
+ * Xorshift generator.
+ */
+static uint32_t fuzz_rand(uint32_t *sp) {
+  uint32_t x = *sp;
+
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  return *sp = x;
+}
+
+/*
+ * Independent generator state for each random stream of a run, the workers
+ * streams do not depend on the threads interleaving.
+ */
+static uint32_t fuzz_stream(uint32_t s, unsigned stream) {
+  uint32_t x = (s ^ 0x5BD1E995U) * 2654435761U + (stream + 1) * 0x9E3779B9U;
+
+  x ^= x >> 16;
+  x *= 0x85EBCA6BU;
+  x ^= x >> 13;
+  return x != 0 ? x : 1;
+}
+
+/*
+ * Generates the next operation of a worker.
+ */
+static void fuzz_gen(uint32_t *sp, fuzzentry_t *ep) {
+  uint32_t op = fuzz_rand(sp) % OP_NUM;
+  uint32_t r1 = fuzz_rand(sp), r2 = fuzz_rand(sp), r3 = fuzz_rand(sp);
+
+  ep->op = (uint8_t)op;
+  ep->a = ep->b = ep->c = 0;
+  switch (op) {
+  case OP_SEM_WAIT:
+    ep->a = r1 % FUZZ_SEMS;
+    ep->b = 1 + r2 % 4;
+    break;
+  case OP_SEM_SIGNAL:
+    ep->a = r1 % FUZZ_SEMS;
+    break;
+  case OP_MTX_CHAIN:
+    /* Nested locks in ascending order, it forms inheritance chains.*/
+    ep->a = r1 % FUZZ_MUTEXES;
+    ep->b = 1 + r2 % (FUZZ_MUTEXES - ep->a);
+    ep->c = r3 % 3;
+    break;
+  case OP_COND_WAIT:
+  case OP_MB_POST:
+  case OP_MB_FETCH:
+    ep->a = 1 + r1 % 4;
+    break;
+  case OP_SLEEP:
+    ep->a = r1 % 3;
+    break;
+  case OP_TIMERS:
+    /* Timers set on the same deadline, mass expiry.*/
+    ep->a = 1 + r1 % 8;
+    ep->b = 1 + r2 % 4;
+    break;
+  case OP_PRIO:
+    ep->a = r1 % FUZZ_PRIO_RANGE;
+    break;
+  case OP_POOL:
+    ep->a = 1 + r1 % 3;
+    ep->c = r3 % 3;
+    break;
+  }
+}
+
+/*
+ * Generates the next simulated interrupt operation.
+ */
+static void fuzz_gen_isr(uint32_t *sp, fuzzentry_t *ep) {
+  uint32_t op = fuzz_rand(sp) % IOP_NUM;
+  uint32_t r1 = fuzz_rand(sp);
+
+  ep->thread = FUZZ_ISR;
+  ep->op = (uint8_t)(OP_NUM + op);
+  ep->a = ep->op == IOP_SEM_SIGNAL ? r1 % FUZZ_SEMS : 0;
+  ep->b = ep->c = 0;
+}
+
+/*===========================================================================*/
+/* Operations execution.                                                     */
+/*===========================================================================*/
+
+static bool_t fuzz_same(const fuzzentry_t *e1, const fuzzentry_t *e2) {
+
+  return (e1->thread == e2->thread) && (e1->op == e2->op) &&
+         (e1->a == e2->a) && (e1->b == e2->b) && (e1->c == e2->c);
+}
+
+/*
+ * Operations started so far.
+ */
+static unsigned fuzz_seq(void) {
+
+  return replay ? tpos : tlen;
+}
+
+/*
+ * Ends a replay, the waiting workers are released and terminate.
+ */
+static void fuzz_end_i(void) {
+  unsigned i;
+
+  tlen = tpos;
+  for (i = 0; i < FUZZ_MAX_THREADS; i++) {
+    if (waiting[i] != NULL) {
+      chSchReadyI(waiting[i]);
+      waiting[i] = NULL;
+    }
+  }
+}
+
+/*
+ * Resumes the worker owning the next replayed operation, if waiting.
+ */
+static void fuzz_next_i(void) {
+  unsigned id;
+
+  if (tpos >= tlen) {
+    fuzz_end_i();
+    return;
+  }
+  id = trace[tpos].thread;
+  if ((id != FUZZ_ISR) && (waiting[id] != NULL)) {
+    chSchReadyI(waiting[id]);
+    waiting[id] = NULL;
+  }
+}
+
+/*
+ * Records an operation, in replay mode waits for its turn in the recorded
+ * order and checks that it matches.
+ */
+static bool_t fuzz_turn(const fuzzentry_t *ep) {
+  bool_t go = TRUE;
+
+  chSysLock();
+  if (!replay) {
+    if (tlen < FUZZ_TRACE_SIZE)
+      trace[tlen++] = *ep;
+    else
+      truncated = TRUE;
+  }
+  else {
+    while ((tpos < tlen) && (trace[tpos].thread != ep->thread)) {
+      waiting[ep->thread] = currp;
+      chSchGoSleepS(THD_STATE_SUSPENDED);
+    }
+    if (tpos >= tlen)
+      go = FALSE;
+    else if (!fuzz_same(&trace[tpos], ep)) {
+      diverged = TRUE;
+      fuzz_end_i();
+      go = FALSE;
+    }
+    else {
+      tpos++;
+      fuzz_next_i();
+    }
+    chSchRescheduleS();
+  }
+  chSysUnlock();
+  return go;
+}
+
+static void fuzz_sem_signal_i(Semaphore *sp) {
+
+  if (chSemGetCounterI(sp) < FUZZ_SEM_MAX)
+    chSemSignalI(sp);
+}
+
+static void fuzz_probe_i(fuzzprobe_t *pp) {
+
+  if (chSemGetCounterI(&pp->sem) < 0) {
+    pp->stamp = port_rt_get_counter_value();
+    chSemSignalI(&pp->sem);
+  }
+}
+
+static void fuzz_timer_cb(void *p) {
+
+  chSysLockFromIsr();
+  fuzz_sem_signal_i((Semaphore *)p);
+  chSysUnlockFromIsr();
+}
+
+/*
+ * Stamps a pool object with a signature unique to its owner.
+ */
+static uint32_t fuzz_pool_stamp(uint32_t *objp, unsigned owner) {
+  uint32_t sig = ((uint32_t)owner << 24) | (pool_stamp++ & 0xFFFFFF);
+  unsigned i;
+
+  for (i = 0; i < 4; i++)
+    objp[i] = sig;
+  return sig;
+}
+
+/*
+ * Verifies the signature of a pool object before freeing it.
+ */
+static void fuzz_pool_check(const uint32_t *objp, uint32_t sig) {
+  unsigned i;
+
+  for (i = 0; i < 4; i++)
+    if (objp[i] != sig)
+      pool_errors++;
+}
+
+static void fuzz_delay(unsigned n) {
+
+  if (n == 0)
+    chThdYield();
+  else
+    chThdSleep((systime_t)n);
+}
+
+/*
+ * Executes a worker operation.
+ */
+static void fuzz_exec(const fuzzentry_t *ep, unsigned id) {
+  uint32_t *objs[3], sigs[3];
+  unsigned i;
+  msg_t msg;
+
+  switch (ep->op) {
+  case OP_SEM_WAIT:
+    chSemWaitTimeout(&sems[ep->a], (systime_t)ep->b);
+    break;
+  case OP_SEM_SIGNAL:
+    chSysLock();
+    fuzz_sem_signal_i(&sems[ep->a]);
+    chSchRescheduleS();
+    chSysUnlock();
+    break;
+  case OP_MTX_CHAIN:
+    for (i = 0; i < ep->b; i++)
+      chMtxLock(&mtxs[ep->a + i]);
+    fuzz_delay(ep->c);
+    for (i = 0; i < ep->b; i++)
+      chMtxUnlock();
+    break;
+  case OP_COND_WAIT:
+    chMtxLock(&cmtx);
+    /* On timeout the mutex is not re-acquired.*/
+    if (chCondWaitTimeout(&cond, (systime_t)ep->a) != RDY_TIMEOUT)
+      chMtxUnlock();
+    break;
+  case OP_COND_SIGNAL:
+  case OP_COND_BROADCAST:
+    chMtxLock(&cmtx);
+    if (ep->op == OP_COND_SIGNAL)
+      chCondSignal(&cond);
+    else
+      chCondBroadcast(&cond);
+    chMtxUnlock();
+    break;
+  case OP_MB_POST:
+    chMBPost(&mb, (msg_t)ep->a, (systime_t)ep->a);
+    break;
+  case OP_MB_FETCH:
+    chMBFetch(&mb, &msg, (systime_t)ep->a);
+    break;
+  case OP_SLEEP:
+    fuzz_delay(ep->a);
+    break;
+  case OP_TIMERS:
+    chSysLock();
+    for (i = 0; i < ep->a; i++) {
+      VirtualTimer *vtp = &timers[tnext];
+
+      if (!chVTIsArmedI(vtp))
+        chVTSetI(vtp, (systime_t)ep->b, fuzz_timer_cb,
+                 &sems[tnext % FUZZ_SEMS]);
+      tnext = (tnext + 1) % FUZZ_TIMERS;
+    }
+    chSysUnlock();
+    break;
+  case OP_PRIO:
+    chThdSetPriority(FUZZ_PRIO_BASE + ep->a);
+    break;
+  case OP_PROBE:
+    chSysLock();
+    fuzz_probe_i(&wake_probe);
+    chSchRescheduleS();
+    chSysUnlock();
+    break;
+  case OP_POOL:
+    for (i = 0; i < ep->a; i++)
+      if ((objs[i] = chPoolAlloc(&pool)) != NULL)
+        sigs[i] = fuzz_pool_stamp(objs[i], id);
+    fuzz_delay(ep->c);
+    for (i = 0; i < ep->a; i++) {
+      if (objs[i] != NULL) {
+        fuzz_pool_check(objs[i], sigs[i]);
+        chPoolFree(&pool, objs[i]);
+      }
+    }
+    break;
+  }
+}
+
+/*
+ * Executes a simulated interrupt operation.
+ */
+static void fuzz_exec_isr(const fuzzentry_t *ep) {
+  uint32_t *objp, sig;
+
+  switch (ep->op) {
+  case IOP_SEM_SIGNAL:
+    fuzz_sem_signal_i(&sems[ep->a]);
+    break;
+  case IOP_COND_BROADCAST:
+    chCondBroadcastI(&cond);
+    break;
+  case IOP_MB_POST:
+    chMBPostI(&mb, (msg_t)ep->op);
+    break;
+  case IOP_PROBE:
+    fuzz_probe_i(&isr_probe);
+    break;
+  case IOP_POOL:
+    if ((objp = chPoolAllocI(&pool)) != NULL) {
+      sig = fuzz_pool_stamp(objp, FUZZ_ISR);
+      fuzz_pool_check(objp, sig);
+      chPoolFreeI(&pool, objp);
+    }
+    break;
+  }
+}
+
+/*
+ * Simulated interrupts source, it runs in the tick interrupt context. In
+ * replay mode it fires every tick and executes the interrupt operations
+ * whose turn has come.
+ */
+static void fuzz_isr_cb(void *p) {
+  fuzzentry_t e;
+  unsigned n;
+
+  (void)p;
+  chSysLockFromIsr();
+  if (!replay) {
+    n = 1 + fuzz_rand(&isr_timing_rnd) % 3;
+    while (n--) {
+      fuzz_gen_isr(&isr_rnd, &e);
+      if (tlen < FUZZ_TRACE_SIZE)
+        trace[tlen++] = e;
+      else
+        truncated = TRUE;
+      fuzz_exec_isr(&e);
+    }
+    n = 1 + fuzz_rand(&isr_timing_rnd) % 2;
+  }
+  else {
+    while ((tpos < tlen) && (trace[tpos].thread == FUZZ_ISR)) {
+      fuzz_gen_isr(&isr_rnd, &e);
+      if (!fuzz_same(&trace[tpos], &e)) {
+        diverged = TRUE;
+        break;
+      }
+      tpos++;
+      fuzz_exec_isr(&e);
+    }
+    if (diverged)
+      fuzz_end_i();
+    else
+      fuzz_next_i();
+    n = 1;
+  }
+  if (!stopping)
+    chVTSetI(&isr_vt, (systime_t)n, fuzz_isr_cb, NULL);
+  chSysUnlockFromIsr();
+}
+
+/*===========================================================================*/
+/* Threads.                                                                  */
+/*===========================================================================*/
+
+static msg_t probe_thread(void *p) {
+  fuzzprobe_t *pp = p;
+  uint32_t dt;
+
+  while (TRUE) {
+    chSemWait(&pp->sem);
+    dt = port_rt_get_counter_value() - pp->stamp;
+    if (stopping)
+      return 0;
+    if (dt > pp->max) {
+      pp->max = dt;
+      pp->seq = fuzz_seq();
+    }
+    pp->count++;
+  }
+}
+
+static msg_t worker_thread(void *p) {
+  unsigned id = (unsigned)(size_t)p;
+  uint32_t rnd = fuzz_stream(seed, id);
+  fuzzentry_t e;
+  unsigned n;
+
+  e.thread = (uint8_t)id;
+  for (n = 0; n < nops; n++) {
+    fuzz_gen(&rnd, &e);
+    if (!fuzz_turn(&e))
+      break;
+    fuzz_exec(&e, id);
+  }
+  return 0;
+}
+
+/*===========================================================================*/
+/* Runs.                                                                     */
+/*===========================================================================*/
+
+static uint32_t fuzz_ns(uint32_t cycles) {
+
+  return (uint32_t)(((uint64_t)cycles * 1000000000U) /
+                    PORT_RT_COUNTER_FREQUENCY);
+}
+
+/*
+ * Executes a run with the current seed.
+ */
+static void fuzz_run(void) {
+  Thread *workers[FUZZ_MAX_THREADS], *probes[2];
+  uint32_t rnd = fuzz_stream(seed, FUZZ_ISR);
+  unsigned i;
+
+  for (i = 0; i < FUZZ_SEMS; i++)
+    chSemInit(&sems[i], 0);
+  for (i = 0; i < FUZZ_MUTEXES; i++)
+    chMtxInit(&mtxs[i]);
+  chMtxInit(&cmtx);
+  chCondInit(&cond);
+  chMBInit(&mb, mb_buffer, FUZZ_MB_SIZE);
+  chPoolInit(&pool, sizeof pool_objects[0], NULL);
+  chPoolLoadArray(&pool, pool_objects, FUZZ_POOL_SIZE);
+  memset(&isr_probe, 0, sizeof isr_probe);
+  memset(&wake_probe, 0, sizeof wake_probe);
+  chSemInit(&isr_probe.sem, 0);
+  chSemInit(&wake_probe.sem, 0);
+  isr_rnd = fuzz_stream(seed, nthreads);
+  isr_timing_rnd = fuzz_stream(seed, nthreads + 1);
+  if (!replay)
+    tlen = 0;
+  tpos = 0;
+  tnext = 0;
+  pool_errors = 0;
+  truncated = diverged = stopping = FALSE;
+
+  /* The threads start together when this thread waits for the workers.*/
+  chThdSetPriority(FUZZ_PROBE_PRIO + 1);
+  probes[0] = chThdCreateStatic(waprobes[0], sizeof waprobes[0],
+                                FUZZ_PROBE_PRIO, probe_thread, &isr_probe);
+  probes[1] = chThdCreateStatic(waprobes[1], sizeof waprobes[1],
+                                FUZZ_PROBE_PRIO, probe_thread, &wake_probe);
+  for (i = 0; i < nthreads; i++)
+    workers[i] = chThdCreateStatic(waworkers[i], sizeof waworkers[i],
+                                   FUZZ_PRIO_BASE +
+                                   fuzz_rand(&rnd) % FUZZ_PRIO_RANGE,
+                                   worker_thread, (void *)(size_t)i);
+  chSysLock();
+  chVTSetI(&isr_vt, 1, fuzz_isr_cb, NULL);
+  chSysUnlock();
+  for (i = 0; i < nthreads; i++)
+    chThdWait(workers[i]);
+
+  chSysLock();
+  stopping = TRUE;
+  if (chVTIsArmedI(&isr_vt))
+    chVTResetI(&isr_vt);
+  for (i = 0; i < FUZZ_TIMERS; i++)
+    if (chVTIsArmedI(&timers[i]))
+      chVTResetI(&timers[i]);
+  chSemResetI(&isr_probe.sem, 0);
+  chSemResetI(&wake_probe.sem, 0);
+  chSchRescheduleS();
+  chSysUnlock();
+  chThdWait(probes[0]);
+  chThdWait(probes[1]);
+  chThdSetPriority(NORMALPRIO);
+
+  /* All the objects must be back in the pool.*/
+  for (i = 0; chPoolAlloc(&pool) != NULL; i++)
+    ;
+  if (i != FUZZ_POOL_SIZE)
+    pool_errors++;
+}
+
+static bool_t fuzz_save(const char *name, const fuzzprobe_t *pp) {
+  FILE *f = fopen(name, "w");
+  unsigned i, n = pp->seq < tlen ? pp->seq : tlen;
+
+  if (f == NULL)
+    return FALSE;
+  fprintf(f, "# ChibiOS/RT scheduler latency fuzzer, worst case\n");
+  fprintf(f, "seed 0x%08x\n", (unsigned)seed);
+  fprintf(f, "threads %u\n", nthreads);
+  fprintf(f, "ops %u\n", nops);
+  fprintf(f, "metric %s\n", metric_isr ? "isr" : "wakeup");
+  fprintf(f, "latency %u\n", (unsigned)fuzz_ns(pp->max));
+  fprintf(f, "length %u\n", n);
+  for (i = 0; i < n; i++) {
+    const fuzzentry_t *ep = &trace[i];
+
+    if (ep->thread == FUZZ_ISR)
+      fprintf(f, "%u isr", i);
+    else
+      fprintf(f, "%u %u", i, ep->thread);
+    fprintf(f, " %s %u %u %u\n", opnames[ep->op], ep->a, ep->b, ep->c);
+  }
+  return fclose(f) == 0;
+}
+
+static bool_t fuzz_load(const char *name, unsigned *latency) {
+  FILE *f = fopen(name, "r");
+  char line[128], thread[8], op[24];
+  unsigned i, n, u, a, b, c;
+  bool_t ok = TRUE;
+
+  if (f == NULL)
+    return FALSE;
+  n = 0;
+  while (ok && (fgets(line, sizeof line, f) != NULL)) {
+    if ((line[0] == '#') || (line[0] == '\n'))
+      continue;
+    if (sscanf(line, "seed %i", &u) == 1)
+      seed = u;
+    else if (sscanf(line, "threads %u", &u) == 1)
+      nthreads = u;
+    else if (sscanf(line, "ops %u", &u) == 1)
+      nops = u;
+    else if (sscanf(line, "metric %7s", op) == 1)
+      metric_isr = strcmp(op, "isr") == 0;
+    else if (sscanf(line, "latency %u", &u) == 1)
+      *latency = u;
+    else if (sscanf(line, "length %u", &u) == 1)
+      continue;
+    else if ((sscanf(line, "%u %7s %23s %u %u %u",
+                     &u, thread, op, &a, &b, &c) == 6) &&
+             (u == n) && (n < FUZZ_TRACE_SIZE)) {
+      for (i = 0; i < sizeof opnames / sizeof opnames[0]; i++)
+        if (strcmp(op, opnames[i]) == 0)
+          break;
+      trace[n].thread = strcmp(thread, "isr") == 0 ? FUZZ_ISR :
+                                                     (uint8_t)atoi(thread);
+      trace[n].op = (uint8_t)i;
+      trace[n].a = (uint8_t)a;
+      trace[n].b = (uint8_t)b;
+      trace[n].c = (uint8_t)c;
+      ok = i < sizeof opnames / sizeof opnames[0];
+      n++;
+    }
+    else
+      ok = FALSE;
+  }
+  fclose(f);
+  tlen = n;
+  return ok && (nthreads > 0) && (nthreads <= FUZZ_MAX_THREADS);
+}
+
+static void fuzz_print_run(void) {
+
+  printf("seed 0x%08x: isr %u ns (%u samples), wakeup %u ns (%u samples), "
+         "%u ops%s\n",
+         (unsigned)seed,
+         (unsigned)fuzz_ns(isr_probe.max), isr_probe.count,
+         (unsigned)fuzz_ns(wake_probe.max), wake_probe.count,
+         fuzz_seq(), truncated ? ", trace truncated" : "");
+  if (pool_errors > 0)
+    printf("seed 0x%08x: %u memory pool errors\n", (unsigned)seed,
+           pool_errors);
+}
+
+static void usage(void) {
+
+  fprintf(stderr,
+          "usage: ch [-s seed] [-r runs] [-t threads] [-n ops]"
+          " [-m isr|wakeup] [-o file]\n"
+          "       ch -p file\n");
+  exit(2);
+}
+
+/*
+ * Simulator main.
+ */
+int main(int argc, char *argv[]) {
+  unsigned i, errors = 0, latency = 0;
+  uint32_t worst = 0;
+  int c;
+
+  seed = (uint32_t)time(NULL);
+  for (c = 1; c < argc; c++) {
+    if ((argv[c][0] != '-') || (argv[c][1] == 0) || (argv[c][2] != 0) ||
+        (c + 1 >= argc))
+      usage();
+    switch (argv[c++][1]) {
+    case 's':
+      seed = (uint32_t)strtoul(argv[c], NULL, 0);
+      break;
+    case 'r':
+      runs = (unsigned)atoi(argv[c]);
+      break;
+    case 't':
+      nthreads = (unsigned)atoi(argv[c]);
+      break;
+    case 'n':
+      nops = (unsigned)atoi(argv[c]);
+      break;
+    case 'm':
+      metric_isr = strcmp(argv[c], "wakeup") != 0;
+      break;
+    case 'o':
+      outname = argv[c];
+      break;
+    case 'p':
+      replayname = argv[c];
+      break;
+    default:
+      usage();
+    }
+  }
+  if ((nthreads == 0) || (nthreads > FUZZ_MAX_THREADS))
+    usage();
+
+  /*
+   * System initializations.
+   * - HAL initialization, this also initializes the configured device drivers
+   *   and performs the board-specific initializations.
+   * - Kernel initialization, the main() function becomes a thread and the
+   *   RTOS is active.
+   */
+  halInit();
+  chSysInit();
+
+  if (replayname != NULL) {
+    if (!fuzz_load(replayname, &latency)) {
+      fprintf(stderr, "%s: invalid worst case file\n", replayname);
+      exit(2);
+    }
+    replay = TRUE;
+    i = tlen;
+    fuzz_run();
+    fuzz_print_run();
+    printf("replay of %u ops %s, recorded %s latency %u ns\n",
+           i, diverged ? "diverged" : "completed",
+           metric_isr ? "isr" : "wakeup", latency);
+    exit(diverged || (pool_errors > 0) ? 1 : 0);
+  }
+
+  for (i = 0; i < runs; i++, seed++) {
+    const fuzzprobe_t *pp = metric_isr ? &isr_probe : &wake_probe;
+
+    fuzz_run();
+    fuzz_print_run();
+    errors += pool_errors;
+    if (pp->max > worst) {
+      worst = pp->max;
+      if (!fuzz_save(outname, pp)) {
+        fprintf(stderr, "%s: write error\n", outname);
+        exit(2);
+      }
+    }
+  }
+  printf("worst %s latency %u ns, saved to %s\n",
+         metric_isr ? "isr" : "wakeup", (unsigned)fuzz_ns(worst), outname);
+  exit(errors > 0 ? 1 : 0);
+}
@@ -35,11 +35,18 @@
 #include "testmtx.h"
 #include "testmsg.h"
 #include "testmbox.h"
+#include "testpmbox.h"
+#include "testobjfifo.h"
 #include "testevt.h"
+#include "testtopic.h"
 #include "testheap.h"
 #include "testpools.h"
+#include "testarena.h"
 #include "testdyn.h"
 #include "testqueues.h"
+#include "testbqueues.h"
+#include "testrings.h"
+#include "testbinlog.h"
 #include "testbmk.h"
 
 /*
@@ -51,11 +58,18 @@ static ROMCONST struct testcase * ROMCONST *patterns[] = {
   patternmtx,
   patternmsg,
   patternmbox,
+  patternpmbox,
+  patternobjfifo,
   patternevt,
+  patterntopic,
   patternheap,
   patternpools,
+  patternarenas,
   patterndyn,
   patternqueues,
+  patternbqueues,
+  patternrings,
+  patternbinlog,
   patternbmk,
   NULL
 };
@@ -87,6 +101,18 @@ void * ROMCONST wa[5] = {test.wa.T0, test.wa.T1, test.wa.T2,
  */
 static BaseSequentialStream *chp;
 
+/*
+ * Scores recorded by the benchmarks harness, the pointer is NULL when the
+ * scores are only printed.
+ */
+struct bmkscore {
+  const char    *metric;
+  const char    *unit;
+  uint32_t      values[TEST_BMK_MAX_REPEAT];
+};
+static struct bmkscore *scores;
+static unsigned nscores, score_index, repetition;
+
 /**
  * @brief   Prints a decimal unsigned number.
  *
@@ -128,6 +154,30 @@ void test_println(const char *msgp) {
   chSequentialStreamWrite(chp, (const uint8_t *)"\r\n", 2);
 }
 
+/**
+ * @brief   Prints a benchmark score.
+ * @details The score is printed followed by its unit, when the benchmarks
+ *          harness is running the score is also recorded under the
+ *          specified metric name.
+ *
+ * @param[in] metric    short metric name, unique within the benchmark
+ * @param[in] value     the score value
+ * @param[in] unit      the score unit
+ */
+void test_print_score(const char *metric, uint32_t value, const char *unit) {
+
+  test_printn(value);
+  test_print(" ");
+  test_print(unit);
+  if ((scores != NULL) && (score_index < TEST_BMK_MAX_SCORES)) {
+    scores[score_index].metric = metric;
+    scores[score_index].unit = unit;
+    scores[score_index].values[repetition] = value;
+    if (++score_index > nscores)
+      nscores = score_index;
+  }
+}
+
 /*
  * Tokens.
  */
@@ -391,4 +441,419 @@ msg_t TestThread(void *p) {
   return (msg_t)global_fail;
 }
 
+/*
+ * Benchmarks harness.
+ */
+
+/*
+ * Stream discarding the human readable output of the benchmarks while the
+ * harness is running them.
+ */
+static size_t null_writes(void *ip, const uint8_t *bp, size_t n) {
+
+  (void)ip;
+  (void)bp;
+  return n;
+}
+
+static size_t null_reads(void *ip, uint8_t *bp, size_t n) {
+
+  (void)ip;
+  (void)bp;
+  (void)n;
+  return 0;
+}
+
+static msg_t null_put(void *ip, uint8_t b) {
+
+  (void)ip;
+  (void)b;
+  return RDY_OK;
+}
+
+static msg_t null_get(void *ip) {
+
+  (void)ip;
+  return RDY_RESET;
+}
+
+static const struct BaseSequentialStreamVMT null_vmt = {
+  null_writes, null_reads, null_put, null_get
+};
+
+static BaseSequentialStream null_stream = {&null_vmt};
+
+/*
+ * Build information reported in the results.
+ */
+static ROMCONST struct {
+  const char    *key;
+  const char    *value;
+} bmk_build[] = {
+  {"kernel",        CH_KERNEL_VERSION},
+  {"compiled",      __DATE__ " - " __TIME__},
+#ifdef CH_COMPILER_NAME
+  {"compiler",      CH_COMPILER_NAME},
+#endif
+  {"architecture",  CH_ARCHITECTURE_NAME},
+#ifdef CH_CORE_VARIANT_NAME
+  {"core",          CH_CORE_VARIANT_NAME},
+#endif
+#ifdef CH_PORT_INFO
+  {"port",          CH_PORT_INFO},
+#endif
+#ifdef PLATFORM_NAME
+  {"platform",      PLATFORM_NAME},
+#endif
+#ifdef BOARD_NAME
+  {"board",         BOARD_NAME},
+#endif
+};
+
+/*
+ * Kernel configuration reported in the results, the options not present
+ * in older configuration files are only reported when defined.
+ */
+#define BMK_OPTION(name) {#name, (uint32_t)(name)}
+
+static ROMCONST struct {
+  const char    *name;
+  uint32_t      value;
+} bmk_options[] = {
+  BMK_OPTION(CH_FREQUENCY),
+  BMK_OPTION(CH_TIME_QUANTUM),
+  BMK_OPTION(CH_MEMCORE_SIZE),
+  BMK_OPTION(CH_NO_IDLE_THREAD),
+  BMK_OPTION(CH_OPTIMIZE_SPEED),
+  BMK_OPTION(CH_USE_REGISTRY),
+  BMK_OPTION(CH_USE_WAITEXIT),
+  BMK_OPTION(CH_USE_SEMAPHORES),
+  BMK_OPTION(CH_USE_SEMAPHORES_PRIORITY),
+  BMK_OPTION(CH_USE_SEMSW),
+  BMK_OPTION(CH_USE_MUTEXES),
+  BMK_OPTION(CH_USE_CONDVARS),
+  BMK_OPTION(CH_USE_CONDVARS_TIMEOUT),
+  BMK_OPTION(CH_USE_EVENTS),
+  BMK_OPTION(CH_USE_EVENTS_TIMEOUT),
+#if defined(CH_USE_TOPICS)
+  BMK_OPTION(CH_USE_TOPICS),
+#endif
+  BMK_OPTION(CH_USE_MESSAGES),
+  BMK_OPTION(CH_USE_MESSAGES_PRIORITY),
+  BMK_OPTION(CH_USE_MAILBOXES),
+#if defined(CH_USE_PRIO_MAILBOXES)
+  BMK_OPTION(CH_USE_PRIO_MAILBOXES),
+#endif
+#if defined(CH_USE_OBJFIFOS)
+  BMK_OPTION(CH_USE_OBJFIFOS),
+#endif
+  BMK_OPTION(CH_USE_QUEUES),
+#if defined(CH_USE_RINGS)
+  BMK_OPTION(CH_USE_RINGS),
+#endif
+  BMK_OPTION(CH_USE_MEMCORE),
+  BMK_OPTION(CH_USE_HEAP),
+  BMK_OPTION(CH_USE_MALLOC_HEAP),
+  BMK_OPTION(CH_USE_MEMPOOLS),
+#if defined(CH_USE_MEMPOOLS_LOCKFREE)
+  BMK_OPTION(CH_USE_MEMPOOLS_LOCKFREE),
+#endif
+#if defined(CH_USE_ARENAS)
+  BMK_OPTION(CH_USE_ARENAS),
+#endif
+  BMK_OPTION(CH_USE_DYNAMIC),
+  BMK_OPTION(CH_DBG_SYSTEM_STATE_CHECK),
+  BMK_OPTION(CH_DBG_ENABLE_CHECKS),
+  BMK_OPTION(CH_DBG_ENABLE_ASSERTS),
+  BMK_OPTION(CH_DBG_ENABLE_TRACE),
+  BMK_OPTION(CH_DBG_ENABLE_STACK_CHECK),
+  BMK_OPTION(CH_DBG_FILL_THREADS),
+  BMK_OPTION(CH_DBG_THREADS_PROFILING),
+#if defined(CH_DBG_STACK_EXIT_REPORT)
+  BMK_OPTION(CH_DBG_STACK_EXIT_REPORT),
+#endif
+#if defined(CH_DBG_HEAP_PROFILING)
+  BMK_OPTION(CH_DBG_HEAP_PROFILING),
+#endif
+#if defined(CH_DBG_CPU_ACCOUNTING)
+  BMK_OPTION(CH_DBG_CPU_ACCOUNTING),
+#endif
+#if defined(CH_DBG_CRITICAL_MONITOR)
+  BMK_OPTION(CH_DBG_CRITICAL_MONITOR),
+#endif
+#if defined(CH_DBG_SYNC_PROFILING)
+  BMK_OPTION(CH_DBG_SYNC_PROFILING),
+#endif
+#if defined(CH_DBG_STATISTICS)
+  BMK_OPTION(CH_DBG_STATISTICS),
+#endif
+#if defined(CH_DBG_PROFILER)
+  BMK_OPTION(CH_DBG_PROFILER),
+#endif
+};
+
+#define BMK_ITEMS(a) (sizeof(a) / sizeof((a)[0]))
+
+/*
+ * Checks if the benchmark with the specified number is part of a selection
+ * string.
+ */
+static bool_t bmk_selected(const char *sel, unsigned n) {
+  unsigned first, last;
+
+  if ((sel == NULL) || (*sel == '\0'))
+    return TRUE;
+  while (TRUE) {
+    first = 0;
+    while ((*sel >= '0') && (*sel <= '9'))
+      first = first * 10 + (*sel++ - '0');
+    last = first;
+    if (*sel == '-') {
+      sel++;
+      last = 0;
+      while ((*sel >= '0') && (*sel <= '9'))
+        last = last * 10 + (*sel++ - '0');
+    }
+    if ((n >= first) && (n <= last))
+      return TRUE;
+    if (*sel++ != ',')
+      return FALSE;
+  }
+}
+
+/*
+ * Prints a string as a JSON string or as a quoted CSV field.
+ */
+static void bmk_print_string(unsigned format, const char *s) {
+
+  chSequentialStreamPut(chp, '"');
+  while (*s) {
+    if (format == TEST_BMK_FORMAT_JSON) {
+      if ((*s == '"') || (*s == '\\'))
+        chSequentialStreamPut(chp, '\\');
+    }
+    else if (*s == '"')
+      chSequentialStreamPut(chp, '"');
+    chSequentialStreamPut(chp, *s++);
+  }
+  chSequentialStreamPut(chp, '"');
+}
+
+/*
+ * Sorts the samples of a score, the number of samples is small.
+ */
+static void bmk_sort(uint32_t *v, unsigned n) {
+  unsigned i, j;
+  uint32_t x;
+
+  for (i = 1; i < n; i++) {
+    x = v[i];
+    for (j = i; (j > 0) && (v[j - 1] > x); j--)
+      v[j] = v[j - 1];
+    v[j] = x;
+  }
+}
+
+static void bmk_print_header(const struct testbmkconfig *cfgp) {
+  unsigned i;
+
+  if (cfgp->format == TEST_BMK_FORMAT_JSON) {
+    test_println("{");
+    for (i = 0; i < BMK_ITEMS(bmk_build); i++) {
+      test_print("  ");
+      bmk_print_string(cfgp->format, bmk_build[i].key);
+      test_print(": ");
+      bmk_print_string(cfgp->format, bmk_build[i].value);
+      test_println(",");
+    }
+    test_println("  \"config\": {");
+    for (i = 0; i < BMK_ITEMS(bmk_options); i++) {
+      test_print("    ");
+      bmk_print_string(cfgp->format, bmk_options[i].name);
+      test_print(": ");
+      test_printn(bmk_options[i].value);
+      test_println(i < BMK_ITEMS(bmk_options) - 1 ? "," : "");
+    }
+    test_println("  },");
+    test_print("  \"repeat\": ");
+    test_printn(cfgp->repeat);
+    test_println(",");
+    test_print("  \"benchmarks\": [");
+  }
+  else {
+    for (i = 0; i < BMK_ITEMS(bmk_build); i++) {
+      test_print("# ");
+      test_print(bmk_build[i].key);
+      test_print(",");
+      bmk_print_string(cfgp->format, bmk_build[i].value);
+      test_println("");
+    }
+    for (i = 0; i < BMK_ITEMS(bmk_options); i++) {
+      test_print("# config,");
+      test_print(bmk_options[i].name);
+      test_print(",");
+      test_printn(bmk_options[i].value);
+      test_println("");
+    }
+    test_print("# repeat,");
+    test_printn(cfgp->repeat);
+    test_println("");
+    test_println("index,benchmark,metric,unit,min,median,max,failed");
+  }
+}
+
+static void bmk_print_result(const struct testbmkconfig *cfgp, unsigned n,
+                             const char *name, bool_t failed, bool_t first) {
+  unsigned i, j, r = cfgp->repeat;
+  uint32_t *v;
+
+  if (cfgp->format == TEST_BMK_FORMAT_JSON) {
+    test_println(first ? "" : ",");
+    test_println("    {");
+    test_print("      \"index\": ");
+    test_printn(n);
+    test_println(",");
+    test_print("      \"name\": ");
+    bmk_print_string(cfgp->format, name);
+    test_println(",");
+    test_print("      \"failed\": ");
+    test_print(failed ? "true" : "false");
+    test_println(",");
+    test_print("      \"scores\": [");
+  }
+  else if (nscores == 0) {
+    test_printn(n);
+    test_print(",");
+    bmk_print_string(cfgp->format, name);
+    test_print(",,,,,,");
+    test_println(failed ? "1" : "0");
+  }
+  for (i = 0; i < nscores; i++) {
+    v = scores[i].values;
+    bmk_sort(v, r);
+    if (cfgp->format == TEST_BMK_FORMAT_JSON) {
+      test_println(i == 0 ? "" : ",");
+      test_print("        {\"metric\": ");
+      bmk_print_string(cfgp->format, scores[i].metric);
+      test_print(", \"unit\": ");
+      bmk_print_string(cfgp->format, scores[i].unit);
+      test_print(", \"min\": ");
+      test_printn(v[0]);
+      test_print(", \"median\": ");
+      test_printn(v[(r - 1) / 2] + (v[r / 2] - v[(r - 1) / 2]) / 2);
+      test_print(", \"max\": ");
+      test_printn(v[r - 1]);
+      test_print(", \"samples\": [");
+      for (j = 0; j < r; j++) {
+        test_printn(v[j]);
+        test_print(j < r - 1 ? ", " : "");
+      }
+      test_print("]}");
+    }
+    else {
+      test_printn(n);
+      test_print(",");
+      bmk_print_string(cfgp->format, name);
+      test_print(",");
+      test_print(scores[i].metric);
+      test_print(",");
+      test_print(scores[i].unit);
+      test_print(",");
+      test_printn(v[0]);
+      test_print(",");
+      test_printn(v[(r - 1) / 2] + (v[r / 2] - v[(r - 1) / 2]) / 2);
+      test_print(",");
+      test_printn(v[r - 1]);
+      test_print(",");
+      test_println(failed ? "1" : "0");
+    }
+  }
+  if (cfgp->format == TEST_BMK_FORMAT_JSON) {
+    if (nscores > 0)
+      test_println("");
+    test_print(nscores > 0 ? "      ]" : "]");
+    test_println("");
+    test_print("    }");
+  }
+}
+
+/**
+ * @brief   Prints the list of the available benchmarks.
+ * @details Each line contains the number used in the harness selection
+ *          strings and the benchmark name.
+ *
+ * @param[in] stream    the output stream
+ */
+void TestBenchmarksList(BaseSequentialStream *stream) {
+  unsigned i;
+
+  chp = stream;
+  for (i = 0; patternbmk[i] != NULL; i++) {
+    test_printn(i + 1);
+    test_print(" ");
+    test_println(patternbmk[i]->name);
+  }
+}
+
+/**
+ * @brief   Benchmarks harness thread function.
+ * @details The selected benchmarks are executed the specified number of
+ *          times with their human readable output suppressed, then the
+ *          minimum, median and maximum of each recorded score are emitted
+ *          together with the build information and the kernel
+ *          configuration, as a JSON document or as a CSV table.
+ *
+ * @param[in] p         pointer to a @p testbmkconfig structure
+ * @return              A failure boolean value.
+ */
+msg_t TestBenchmarks(void *p) {
+  static struct bmkscore bmk_scores[TEST_BMK_MAX_SCORES];
+  const struct testbmkconfig *cfgp = p;
+  struct testbmkconfig cfg = *cfgp;
+  bool_t failed, first = TRUE;
+  unsigned i, j;
+
+  if (cfg.repeat == 0)
+    cfg.repeat = 1;
+  if (cfg.repeat > TEST_BMK_MAX_REPEAT)
+    cfg.repeat = TEST_BMK_MAX_REPEAT;
+  chp = cfg.chp;
+  bmk_print_header(&cfg);
+
+  global_fail = FALSE;
+  for (i = 0; patternbmk[i] != NULL; i++) {
+    if (!bmk_selected(cfg.select, i + 1))
+      continue;
+    for (j = 0; j < TEST_BMK_MAX_SCORES * TEST_BMK_MAX_REPEAT; j++)
+      bmk_scores[j / TEST_BMK_MAX_REPEAT].values[j % TEST_BMK_MAX_REPEAT] = 0;
+    scores = bmk_scores;
+    nscores = 0;
+    failed = FALSE;
+    chp = &null_stream;
+    for (repetition = 0; repetition < cfg.repeat; repetition++) {
+      score_index = 0;
+#if DELAY_BETWEEN_TESTS > 0
+      chThdSleepMilliseconds(DELAY_BETWEEN_TESTS);
+#endif
+      execute_test(patternbmk[i]);
+      if (local_fail)
+        failed = TRUE;
+    }
+    chp = cfg.chp;
+    bmk_print_result(&cfg, i + 1, patternbmk[i]->name, failed, first);
+    scores = NULL;
+    first = FALSE;
+  }
+
+  if (cfg.format == TEST_BMK_FORMAT_JSON) {
+    test_println(first ? "]," : "");
+    if (!first)
+      test_println("  ],");
+    test_print("  \"failed\": ");
+    test_println(global_fail ? "true" : "false");
+    test_println("}");
+  }
+  return (msg_t)global_fail;
+}
+
 /** @} */
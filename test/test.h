@@ -43,6 +43,47 @@
 #define TEST_NO_BENCHMARKS      FALSE
 #endif
 
+/**
+ * @brief   Number of background load threads in the latency benchmarks.
+ * @details The load threads run at a priority lower than the measuring
+ *          threads and continuously exercise the kernel, up to three
+ *          threads can be specified.
+ */
+#if !defined(TEST_BMK_LOAD_THREADS) || defined(__DOXYGEN__)
+#define TEST_BMK_LOAD_THREADS   0
+#endif
+
+/**
+ * @brief   If @p TRUE then the binary logger test and benchmark are included.
+ * @note    The application must build @p binlog.c, @p chprintf.c and
+ *          @p memstreams.c from @p os/various.
+ */
+#if !defined(TEST_USE_BINLOG) || defined(__DOXYGEN__)
+#define TEST_USE_BINLOG         FALSE
+#endif
+
+/**
+ * @brief   Maximum number of repetitions of the benchmarks harness.
+ */
+#if !defined(TEST_BMK_MAX_REPEAT) || defined(__DOXYGEN__)
+#define TEST_BMK_MAX_REPEAT     9
+#endif
+
+/**
+ * @brief   Maximum number of scores recorded for a single benchmark.
+ */
+#if !defined(TEST_BMK_MAX_SCORES) || defined(__DOXYGEN__)
+#define TEST_BMK_MAX_SCORES     12
+#endif
+
+/**
+ * @name    Benchmarks harness output formats
+ * @{
+ */
+#define TEST_BMK_FORMAT_JSON    0       /**< @brief JSON document.          */
+#define TEST_BMK_FORMAT_CSV     1       /**< @brief CSV table.              */
+/** @} */
+
 #define MAX_THREADS             5
 #define MAX_TOKENS              16
 
@@ -50,7 +91,7 @@
 #define THREADS_STACK_SIZE      48
 #elif defined(CH_ARCHITECTURE_STM8)
 #define THREADS_STACK_SIZE      64
-#elif defined(CH_ARCHITECTURE_SIMIA32)
+#elif defined(CH_ARCHITECTURE_SIMIA32) || defined(CH_ARCHITECTURE_SIMX86_64)
 #define THREADS_STACK_SIZE      512
 #else
 #define THREADS_STACK_SIZE      128
@@ -67,6 +108,18 @@ struct testcase {
   void (*execute)(void);        /**< @brief Test case execution function.   */
 };
 
+/**
+ * @brief   Structure representing a benchmarks harness run.
+ */
+struct testbmkconfig {
+  BaseSequentialStream  *chp;   /**< @brief Results output stream.          */
+  const char            *select;/**< @brief Selected benchmarks as a list of
+                                     numbers and ranges, for example
+                                     "1,3-5", @p NULL for all.              */
+  unsigned              repeat; /**< @brief Number of repetitions.          */
+  unsigned              format; /**< @brief Output format.                  */
+};
+
 #ifndef __DOXYGEN__
 union test_buffers {
   struct {
@@ -84,9 +137,12 @@ union test_buffers {
 extern "C" {
 #endif
   msg_t TestThread(void *p);
+  msg_t TestBenchmarks(void *p);
+  void TestBenchmarksList(BaseSequentialStream *chp);
   void test_printn(uint32_t n);
   void test_print(const char *msgp);
   void test_println(const char *msgp);
+  void test_print_score(const char *metric, uint32_t value, const char *unit);
   void test_emit_token(char token);
   bool_t _test_fail(unsigned point);
   bool_t _test_assert(unsigned point, bool_t condition);
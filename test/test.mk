@@ -5,11 +5,18 @@ TESTSRC = ${CHIBIOS}/test/test.c \
           ${CHIBIOS}/test/testmtx.c \
           ${CHIBIOS}/test/testmsg.c \
           ${CHIBIOS}/test/testmbox.c \
+          ${CHIBIOS}/test/testpmbox.c \
+          ${CHIBIOS}/test/testobjfifo.c \
           ${CHIBIOS}/test/testevt.c \
+          ${CHIBIOS}/test/testtopic.c \
           ${CHIBIOS}/test/testheap.c \
           ${CHIBIOS}/test/testpools.c \
+          ${CHIBIOS}/test/testarena.c \
           ${CHIBIOS}/test/testdyn.c \
           ${CHIBIOS}/test/testqueues.c \
+          ${CHIBIOS}/test/testbqueues.c \
+          ${CHIBIOS}/test/testrings.c \
+          ${CHIBIOS}/test/testbinlog.c \
           ${CHIBIOS}/test/testbmk.c
 
 # Required include directories
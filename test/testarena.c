@@ -0,0 +1,200 @@
+/*
+    ChibiOS/RT - Copyright (C) 2006,2007,2008,2009,2010,
+                 2011,2012,2013 Giovanni Di Sirio.
+
+    This file is part of ChibiOS/RT.
+
+    ChibiOS/RT is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    ChibiOS/RT is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "ch.h"
+#include "test.h"
+
+/**
+ * @page test_arenas Memory Arenas test
+ *
+ * File: @ref testarena.c
+ *
+ * <h2>Description</h2>
+ * This module implements the test sequence for the @ref arenas subsystem.
+ *
+ * <h2>Objective</h2>
+ * Objective of the test module is to cover 100% of the @ref arenas code.
+ *
+ * <h2>Preconditions</h2>
+ * The module requires the following kernel options:
+ * - @p CH_USE_ARENAS
+ * - @p CH_USE_HEAP (test case 002 only)
+ * .
+ * In case some of the required options are not enabled then some or all tests
+ * may be skipped.
+ *
+ * <h2>Test Cases</h2>
+ * - @subpage test_arenas_001
+ * - @subpage test_arenas_002
+ * .
+ * @file testarena.c
+ * @brief Memory Arenas test source file
+ * @file testarena.h
+ * @brief Memory Arenas test header file
+ */
+
+#if CH_USE_ARENAS || defined(__DOXYGEN__)
+
+#define SIZE 16
+
+static MEMORYARENA_DECL(ma1, 0, NULL);
+
+/**
+ * @page test_arenas_001 Allocation and mark/release test
+ *
+ * <h2>Description</h2>
+ * A static buffer is loaded into an arena then objects are allocated and
+ * released using marks. The default thread arena is also exercised.<br>
+ * The test expects allocations to be aligned and contiguous and the arena
+ * to return to the marked positions after each release.
+ */
+
+static void arenas1_setup(void) {
+
+  chArenaInit(&ma1, 0, NULL);
+}
+
+static void arenas1_execute(void) {
+  void *p1, *p2, *p3;
+  arenamark_t mark;
+  size_t n;
+
+  /* Empty arena without provider.*/
+  test_assert(1, chArenaAlloc(&ma1, SIZE) == NULL, "allocation not failed");
+
+  /* Allocations from a static buffer.*/
+  chArenaLoadBuffer(&ma1, wa[0], WA_SIZE);
+  p1 = chArenaAlloc(&ma1, SIZE);
+  test_assert(2, (p1 != NULL) && MEM_IS_ALIGNED(p1), "invalid object");
+  p2 = chArenaAlloc(&ma1, SIZE + 1);
+  test_assert(3, (uint8_t *)p2 == (uint8_t *)p1 + MEM_ALIGN_NEXT(SIZE),
+              "not contiguous");
+
+  /* Mark and release.*/
+  mark = chArenaGetMark(&ma1);
+  p3 = chArenaAlloc(&ma1, SIZE);
+  (void)chArenaAlloc(&ma1, SIZE);
+  chArenaRelease(&ma1, mark);
+  test_assert(4, chArenaAlloc(&ma1, SIZE) == p3, "mark not restored");
+
+  /* Exhaustion, the buffer cannot contain the object.*/
+  test_assert(5, chArenaAlloc(&ma1, WA_SIZE) == NULL, "allocation not failed");
+  test_assert(6, chArenaStatus(&ma1, &n) == 1, "wrong number of blocks");
+  test_assert(7, n == MEM_ALIGN_NEXT(SIZE) * 2 + MEM_ALIGN_NEXT(SIZE + 1),
+              "wrong allocated size");
+
+  /* Full reset, the block goes back in the spare list and is reused.*/
+  chArenaReset(&ma1);
+  test_assert(8, chArenaStatus(&ma1, &n) == 0, "not empty");
+  test_assert(9, chArenaAlloc(&ma1, SIZE) == p1, "block not reused");
+
+  /* Thread default arena.*/
+  test_assert(10, chArenaGetDefault() == NULL, "default arena present");
+  test_assert(11, chArenaSetDefault(&ma1) == NULL, "default arena present");
+  mark = chArenaGetMark(NULL);
+  test_assert(12, mark == chArenaGetMark(&ma1), "wrong default arena");
+  test_assert(13, chArenaAlloc(NULL, SIZE) == p2, "wrong default arena");
+  chArenaRelease(NULL, mark);
+  test_assert(14, chArenaSetDefault(NULL) == &ma1, "wrong default arena");
+  chArenaReset(&ma1);
+}
+
+ROMCONST struct testcase testarenas1 = {
+  "Memory Arenas, allocation and mark/release",
+  arenas1_setup,
+  NULL,
+  arenas1_execute
+};
+
+#if (CH_USE_HEAP && !CH_USE_MALLOC_HEAP) || defined(__DOXYGEN__)
+/**
+ * @page test_arenas_002 Chained growth test
+ *
+ * <h2>Description</h2>
+ * An arena taking blocks from a local heap is made grow beyond its default
+ * block size, released and trimmed.<br>
+ * The test expects new blocks to be chained when the current one is
+ * exhausted, to be reused after a release and to be returned to the heap
+ * by a trim operation.
+ */
+
+static MemoryHeap test_heap;
+
+static void arenas2_setup(void) {
+
+  chHeapInit(&test_heap, test.buffer, sizeof(union test_buffers));
+  chArenaInitHeap(&ma1, SIZE * 4, &test_heap);
+}
+
+static void arenas2_execute(void) {
+  void *p1;
+  arenamark_t mark;
+  size_t n, sz;
+  int i;
+
+  (void)chHeapStatus(&test_heap, &sz);
+
+  /* Filling the first block then chaining a second one.*/
+  p1 = chArenaAlloc(&ma1, SIZE);
+  test_assert(1, p1 != NULL, "allocation failed");
+  mark = chArenaGetMark(&ma1);
+  for (i = 0; i < 4; i++)
+    test_assert(2, chArenaAlloc(&ma1, SIZE) != NULL, "allocation failed");
+  test_assert(3, chArenaStatus(&ma1, NULL) == 2, "not chained");
+
+  /* Objects bigger than the default block size.*/
+  test_assert(4, chArenaAlloc(&ma1, SIZE * 8) != NULL, "allocation failed");
+  test_assert(5, chArenaStatus(&ma1, NULL) == 3, "not chained");
+
+  /* Releasing to the mark, the blocks become spare blocks.*/
+  chArenaRelease(&ma1, mark);
+  test_assert(6, chArenaStatus(&ma1, NULL) == 1, "not released");
+  test_assert(7, chArenaAlloc(&ma1, SIZE * 8) != NULL, "allocation failed");
+  test_assert(8, chHeapStatus(&test_heap, NULL) == 1, "spare not reused");
+
+  /* Returning all the memory to the heap.*/
+  chArenaReset(&ma1);
+  chArenaTrim(&ma1);
+  test_assert(9, chHeapStatus(&test_heap, &n) == 1, "heap fragmented");
+  test_assert(10, n == sz, "memory not returned");
+}
+
+ROMCONST struct testcase testarenas2 = {
+  "Memory Arenas, chained growth",
+  arenas2_setup,
+  NULL,
+  arenas2_execute
+};
+#endif /* CH_USE_HEAP && !CH_USE_MALLOC_HEAP */
+
+#endif /* CH_USE_ARENAS */
+
+/**
+ * @brief   Test sequence for arenas.
+ */
+ROMCONST struct testcase * ROMCONST patternarenas[] = {
+#if CH_USE_ARENAS || defined(__DOXYGEN__)
+  &testarenas1,
+#if (CH_USE_HEAP && !CH_USE_MALLOC_HEAP) || defined(__DOXYGEN__)
+  &testarenas2,
+#endif
+#endif
+  NULL
+};
@@ -0,0 +1,249 @@
+/*
+    ChibiOS/RT - Copyright (C) 2006,2007,2008,2009,2010,
+                 2011,2012,2013 Giovanni Di Sirio.
+
+    This file is part of ChibiOS/RT.
+
+    ChibiOS/RT is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    ChibiOS/RT is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <string.h>
+
+#include "ch.h"
+#include "test.h"
+
+#if TEST_USE_BINLOG || defined(__DOXYGEN__)
+#include "memstreams.h"
+#include "binlog.h"
+#endif
+
+/**
+ * @page test_binlog Binary Logger test
+ *
+ * File: @ref testbinlog.c
+ *
+ * <h2>Description</h2>
+ * This module implements the test sequence for the @ref binlog module.
+ * The tests are performed by posting records into the logger and by
+ * checking the output decoded from a memory stream.
+ *
+ * <h2>Objective</h2>
+ * Objective of the test module is to cover 100% of the @ref binlog code.
+ *
+ * <h2>Preconditions</h2>
+ * The module requires the following options:
+ * - @p TEST_USE_BINLOG, the application must build @p binlog.c,
+ *   @p chprintf.c and @p memstreams.c from @p os/various.
+ * - @p CH_USE_WAITEXIT (and dependent options)
+ * .
+ * In case some of the required options are not enabled then some or all tests
+ * may be skipped.
+ *
+ * <h2>Test Cases</h2>
+ * - @subpage test_binlog_001
+ * - @subpage test_binlog_002
+ * .
+ * @file testbinlog.c
+ * @brief Binary Logger test source file
+ * @file testbinlog.h
+ * @brief Binary Logger test header file
+ */
+
+#if (TEST_USE_BINLOG && CH_USE_WAITEXIT) || defined(__DOXYGEN__)
+
+/*
+ * Number of records posted in excess of the log buffer size.
+ */
+#define BINLOG_EXCESS   3
+
+static MemoryStream ms;
+static uint8_t msbuf[BINLOG_BUFFER_SIZE * 32 + 64];
+
+static const char fmt0[] = "r";
+static const char fmt2[] = "%d,%s";
+
+/*
+ * Starts the logger output and stops it after all the posted records have
+ * been output, the output thread has a lower priority so it only runs
+ * while it is being stopped.
+ */
+static void binlog_output(binlogmode_t mode) {
+
+  msObjectInit(&ms, msbuf, sizeof msbuf, 0);
+  binlogStart((BaseSequentialStream *)&ms, mode, chThdGetPriority() - 1);
+  binlogStop();
+}
+
+/*
+ * Reads the next text line from the log output and compares it, the
+ * timestamp is skipped if required.
+ */
+static bool_t text_line(bool_t timestamp, const char *s) {
+  size_t n = strlen(s);
+
+  if (timestamp) {
+    if (ms.eos - ms.offset < 11)
+      return FALSE;
+    ms.offset += 11;
+  }
+  if ((ms.eos - ms.offset < n + 2) ||
+      (memcmp(ms.buffer + ms.offset, s, n) != 0) ||
+      (memcmp(ms.buffer + ms.offset + n, "\r\n", 2) != 0))
+    return FALSE;
+  ms.offset += n + 2;
+  return TRUE;
+}
+
+/*
+ * Reads the next binary record from the log output and compares it, the
+ * timestamp is skipped.
+ */
+static bool_t binary_record(unsigned n, const char *fmt, binlogarg_t a0,
+                            binlogarg_t a1) {
+  binlogarg_t args[3];
+  size_t size;
+
+  if (n == BINLOG_DROPPED) {
+    args[0] = a0;
+    size = sizeof (binlogarg_t);
+  }
+  else {
+    args[0] = (binlogarg_t)fmt;
+    args[1] = a0;
+    args[2] = a1;
+    size = (n + 1) * sizeof (binlogarg_t);
+  }
+  if ((ms.eos - ms.offset < 1 + sizeof (systime_t) + size) ||
+      (ms.buffer[ms.offset] != n))
+    return FALSE;
+  ms.offset += 1 + sizeof (systime_t);
+  if (memcmp(ms.buffer + ms.offset, args, size) != 0)
+    return FALSE;
+  ms.offset += size;
+  return TRUE;
+}
+
+/**
+ * @page test_binlog_001 Text output
+ *
+ * <h2>Description</h2>
+ * Records with different arguments are posted and output in text mode,
+ * the formatted records are expected in the output. The log buffer is then
+ * overflowed, the records in excess must be dropped and reported with a
+ * notice after the buffered records.
+ */
+
+static void binlog1_execute(void) {
+  unsigned i;
+
+  /* Records formatting.*/
+  binlogInit();
+  BINLOG0("start");
+  BINLOG2(fmt2, -1, "one");
+  BINLOG4("%u %x %c %s", 2, 0x3f, 'c', "end");
+  test_assert(1, binlogGetPosted() == 3, "wrong posted counter");
+  binlog_output(BINLOG_TEXT);
+  test_assert(2, text_line(TRUE, "start"), "wrong record");
+  test_assert(3, text_line(TRUE, "-1,one"), "wrong record");
+  test_assert(4, text_line(TRUE, "2 3F c end"), "wrong record");
+  test_assert(5, ms.offset == ms.eos, "unexpected output");
+
+  /* Buffer overflow.*/
+  binlogInit();
+  for (i = 0; i < BINLOG_BUFFER_SIZE + BINLOG_EXCESS; i++)
+    BINLOG0(fmt0);
+  test_assert(6, binlogGetPosted() == BINLOG_BUFFER_SIZE + BINLOG_EXCESS,
+              "wrong posted counter");
+  test_assert(7, binlogGetDropped() == BINLOG_EXCESS,
+              "wrong dropped counter");
+  binlog_output(BINLOG_TEXT);
+  for (i = 0; i < BINLOG_BUFFER_SIZE; i++)
+    test_assert(8, text_line(TRUE, fmt0), "wrong record");
+  test_assert(9, text_line(FALSE, "*** 3 records dropped"),
+              "wrong dropped notice");
+  test_assert(10, ms.offset == ms.eos, "unexpected output");
+}
+
+ROMCONST struct testcase testbinlog1 = {
+  "Binary Logger, text output",
+  NULL,
+  NULL,
+  binlog1_execute
+};
+
+/**
+ * @page test_binlog_002 Binary output
+ *
+ * <h2>Description</h2>
+ * The log buffer is overflowed and output in binary mode, the output is
+ * expected to start with the stream header followed by the raw records
+ * and by a dropped records notice.
+ */
+
+static void binlog2_execute(void) {
+  struct {
+    uint32_t            magic;
+    uint8_t             version;
+    uint8_t             timesize;
+    uint8_t             argsize;
+    uint8_t             maxargs;
+  } header;
+  unsigned i;
+
+  binlogInit();
+  BINLOG2(fmt2, 10, 20);
+  for (i = 1; i < BINLOG_BUFFER_SIZE + BINLOG_EXCESS; i++)
+    BINLOG0(fmt0);
+  test_assert(1, binlogGetDropped() == BINLOG_EXCESS,
+              "wrong dropped counter");
+  binlog_output(BINLOG_BINARY);
+
+  /* Stream header.*/
+  test_assert(2, chSequentialStreamRead(&ms, (uint8_t *)&header,
+                                        sizeof header) == sizeof header,
+              "missing header");
+  test_assert(3, (header.magic == BINLOG_MAGIC) &&
+                 (header.version == BINLOG_VERSION) &&
+                 (header.timesize == sizeof (systime_t)) &&
+                 (header.argsize == sizeof (binlogarg_t)) &&
+                 (header.maxargs == BINLOG_MAX_ARGUMENTS),
+              "wrong header");
+
+  /* Records and dropped records notice.*/
+  test_assert(4, binary_record(2, fmt2, 10, 20), "wrong record");
+  for (i = 1; i < BINLOG_BUFFER_SIZE; i++)
+    test_assert(5, binary_record(0, fmt0, 0, 0), "wrong record");
+  test_assert(6, binary_record(BINLOG_DROPPED, NULL, BINLOG_EXCESS, 0),
+              "wrong dropped notice");
+  test_assert(7, ms.offset == ms.eos, "unexpected output");
+}
+
+ROMCONST struct testcase testbinlog2 = {
+  "Binary Logger, binary output",
+  NULL,
+  NULL,
+  binlog2_execute
+};
+#endif /* TEST_USE_BINLOG && CH_USE_WAITEXIT */
+
+/**
+ * @brief   Test sequence for the binary logger.
+ */
+ROMCONST struct testcase * ROMCONST patternbinlog[] = {
+#if (TEST_USE_BINLOG && CH_USE_WAITEXIT) || defined(__DOXYGEN__)
+  &testbinlog1,
+  &testbinlog2,
+#endif
+  NULL
+};
@@ -20,6 +20,9 @@
 
 #include "ch.h"
 #include "test.h"
+#if TEST_USE_BINLOG || defined(__DOXYGEN__)
+#include "binlog.h"
+#endif
 
 /**
  * @page test_benchmarks Kernel Benchmarks
@@ -53,6 +56,26 @@
  * - @subpage test_benchmarks_011
  * - @subpage test_benchmarks_012
  * - @subpage test_benchmarks_013
+ * - @subpage test_benchmarks_014
+ * - @subpage test_benchmarks_015
+ * - @subpage test_benchmarks_016
+ * - @subpage test_benchmarks_017
+ * - @subpage test_benchmarks_018
+ * - @subpage test_benchmarks_019
+ * - @subpage test_benchmarks_020
+ * - @subpage test_benchmarks_021
+ * - @subpage test_benchmarks_022
+ * - @subpage test_benchmarks_023
+ * - @subpage test_benchmarks_024
+ * - @subpage test_benchmarks_025
+ * - @subpage test_benchmarks_026
+ * - @subpage test_benchmarks_027
+ * - @subpage test_benchmarks_028
+ * - @subpage test_benchmarks_029
+ * - @subpage test_benchmarks_030
+ * - @subpage test_benchmarks_031
+ * - @subpage test_benchmarks_032
+ * - @subpage test_benchmarks_033
  * .
  * @file testbmk.c Kernel Benchmarks
  * @brief Kernel Benchmarks source file
@@ -113,10 +136,10 @@ static void bmk1_execute(void) {
   n = msg_loop_test(threads[0]);
   test_wait_threads();
   test_print("--- Score : ");
-  test_printn(n);
-  test_print(" msgs/S, ");
-  test_printn(n << 1);
-  test_println(" ctxswc/S");
+  test_print_score("msgs", n, "msgs/S");
+  test_print(", ");
+  test_print_score("ctxswc", n << 1, "ctxswc/S");
+  test_println("");
 }
 
 ROMCONST struct testcase testbmk1 = {
@@ -142,10 +165,10 @@ static void bmk2_execute(void) {
   n = msg_loop_test(threads[0]);
   test_wait_threads();
   test_print("--- Score : ");
-  test_printn(n);
-  test_print(" msgs/S, ");
-  test_printn(n << 1);
-  test_println(" ctxswc/S");
+  test_print_score("msgs", n, "msgs/S");
+  test_print(", ");
+  test_print_score("ctxswc", n << 1, "ctxswc/S");
+  test_println("");
 }
 
 ROMCONST struct testcase testbmk2 = {
@@ -181,10 +204,10 @@ static void bmk3_execute(void) {
   n = msg_loop_test(threads[0]);
   test_wait_threads();
   test_print("--- Score : ");
-  test_printn(n);
-  test_print(" msgs/S, ");
-  test_printn(n << 1);
-  test_println(" ctxswc/S");
+  test_print_score("msgs", n, "msgs/S");
+  test_print(", ");
+  test_print_score("ctxswc", n << 1, "ctxswc/S");
+  test_println("");
 }
 
 ROMCONST struct testcase testbmk3 = {
@@ -244,8 +267,8 @@ static void bmk4_execute(void) {
 
   test_wait_threads();
   test_print("--- Score : ");
-  test_printn(n * 2);
-  test_println(" ctxswc/S");
+  test_print_score("ctxswc", n * 2, "ctxswc/S");
+  test_println("");
 }
 
 ROMCONST struct testcase testbmk4 = {
@@ -281,8 +304,8 @@ static void bmk5_execute(void) {
 #endif
   } while (!test_timer_done);
   test_print("--- Score : ");
-  test_printn(n);
-  test_println(" threads/S");
+  test_print_score("threads", n, "threads/S");
+  test_println("");
 }
 
 ROMCONST struct testcase testbmk5 = {
@@ -320,8 +343,8 @@ static void bmk6_execute(void) {
 #endif
   } while (!test_timer_done);
   test_print("--- Score : ");
-  test_printn(n);
-  test_println(" threads/S");
+  test_print_score("threads", n, "threads/S");
+  test_println("");
 }
 
 ROMCONST struct testcase testbmk6 = {
@@ -379,10 +402,10 @@ static void bmk7_execute(void) {
   test_wait_threads();
 
   test_print("--- Score : ");
-  test_printn(n);
-  test_print(" reschedules/S, ");
-  test_printn(n * 6);
-  test_println(" ctxswc/S");
+  test_print_score("reschedules", n, "reschedules/S");
+  test_print(", ");
+  test_print_score("ctxswc", n * 6, "ctxswc/S");
+  test_println("");
 }
 
 ROMCONST struct testcase testbmk7 = {
@@ -434,8 +457,8 @@ static void bmk8_execute(void) {
   test_wait_threads();
 
   test_print("--- Score : ");
-  test_printn(n);
-  test_println(" ctxswc/S");
+  test_print_score("ctxswc", n, "ctxswc/S");
+  test_println("");
 }
 
 ROMCONST struct testcase testbmk8 = {
@@ -481,8 +504,8 @@ static void bmk9_execute(void) {
 #endif
   } while (!test_timer_done);
   test_print("--- Score : ");
-  test_printn(n * 4);
-  test_println(" bytes/S");
+  test_print_score("bytes", n * 4, "bytes/S");
+  test_println("");
 }
 
 ROMCONST struct testcase testbmk9 = {
@@ -522,8 +545,8 @@ static void bmk10_execute(void) {
 #endif
   } while (!test_timer_done);
   test_print("--- Score : ");
-  test_printn(n * 2);
-  test_println(" timers/S");
+  test_print_score("timers", n * 2, "timers/S");
+  test_println("");
 }
 
 ROMCONST struct testcase testbmk10 = {
@@ -568,8 +591,8 @@ static void bmk11_execute(void) {
 #endif
   } while (!test_timer_done);
   test_print("--- Score : ");
-  test_printn(n * 4);
-  test_println(" wait+signal/S");
+  test_print_score("wait+signal", n * 4, "wait+signal/S");
+  test_println("");
 }
 
 ROMCONST struct testcase testbmk11 = {
@@ -615,8 +638,8 @@ static void bmk12_execute(void) {
 #endif
   } while (!test_timer_done);
   test_print("--- Score : ");
-  test_printn(n * 4);
-  test_println(" lock+unlock/S");
+  test_print_score("lock+unlock", n * 4, "lock+unlock/S");
+  test_println("");
 }
 
 ROMCONST struct testcase testbmk12 = {
@@ -637,48 +660,53 @@ ROMCONST struct testcase testbmk12 = {
 static void bmk13_execute(void) {
 
   test_print("--- System: ");
-  test_printn(sizeof(ReadyList) + sizeof(VTList) +
-              PORT_IDLE_THREAD_STACK_SIZE +
-              (sizeof(Thread) + sizeof(struct intctx) +
-               sizeof(struct extctx) +
-               PORT_INT_REQUIRED_STACK) * 2);
-  test_println(" bytes");
+  test_print_score("system", sizeof(ReadyList) + sizeof(VTList) +
+                   PORT_IDLE_THREAD_STACK_SIZE +
+                   (sizeof(Thread) + sizeof(struct intctx) +
+                    sizeof(struct extctx) +
+                    PORT_INT_REQUIRED_STACK) * 2, "bytes");
+  test_println("");
   test_print("--- Thread: ");
-  test_printn(sizeof(Thread));
-  test_println(" bytes");
+  test_print_score("thread", sizeof(Thread), "bytes");
+  test_println("");
   test_print("--- Timer : ");
-  test_printn(sizeof(VirtualTimer));
-  test_println(" bytes");
+  test_print_score("timer", sizeof(VirtualTimer), "bytes");
+  test_println("");
   test_print("--- Semaph: ");
-  test_printn(sizeof(Semaphore));
-  test_println(" bytes");
+  test_print_score("semaphore", sizeof(Semaphore), "bytes");
+  test_println("");
 #if CH_USE_EVENTS || defined(__DOXYGEN__)
   test_print("--- EventS: ");
-  test_printn(sizeof(EventSource));
-  test_println(" bytes");
+  test_print_score("eventsource", sizeof(EventSource), "bytes");
+  test_println("");
   test_print("--- EventL: ");
-  test_printn(sizeof(EventListener));
-  test_println(" bytes");
+  test_print_score("eventlistener", sizeof(EventListener), "bytes");
+  test_println("");
 #endif
 #if CH_USE_MUTEXES || defined(__DOXYGEN__)
   test_print("--- Mutex : ");
-  test_printn(sizeof(Mutex));
-  test_println(" bytes");
+  test_print_score("mutex", sizeof(Mutex), "bytes");
+  test_println("");
 #endif
 #if CH_USE_CONDVARS || defined(__DOXYGEN__)
   test_print("--- CondV.: ");
-  test_printn(sizeof(CondVar));
-  test_println(" bytes");
+  test_print_score("condvar", sizeof(CondVar), "bytes");
+  test_println("");
 #endif
 #if CH_USE_QUEUES || defined(__DOXYGEN__)
   test_print("--- Queue : ");
-  test_printn(sizeof(GenericQueue));
-  test_println(" bytes");
+  test_print_score("queue", sizeof(GenericQueue), "bytes");
+  test_println("");
 #endif
 #if CH_USE_MAILBOXES || defined(__DOXYGEN__)
   test_print("--- MailB.: ");
-  test_printn(sizeof(Mailbox));
-  test_println(" bytes");
+  test_print_score("mailbox", sizeof(Mailbox), "bytes");
+  test_println("");
+#endif
+#if CH_USE_ARENAS || defined(__DOXYGEN__)
+  test_print("--- Arena : ");
+  test_print_score("arena", sizeof(MemoryArena), "bytes");
+  test_println("");
 #endif
 }
 
@@ -689,26 +717,1510 @@ ROMCONST struct testcase testbmk13 = {
   bmk13_execute
 };
 
+#if (CH_USE_HEAP && !CH_USE_MALLOC_HEAP) || defined(__DOXYGEN__)
 /**
- * @brief   Test sequence for benchmarks.
+ * @page test_benchmarks_014 Heap request processing performance
+ *
+ * <h2>Description</h2>
+ * A series of transient objects of various sizes is allocated from a heap
+ * then all the objects are freed, simulating the processing of a request,
+ * into a continuous loop.<br>
+ * The performance is calculated by measuring the number of iterations after
+ * a second of continuous operations.
  */
-ROMCONST struct testcase * ROMCONST patternbmk[] = {
-#if !TEST_NO_BENCHMARKS
-  &testbmk1,
-  &testbmk2,
-  &testbmk3,
-  &testbmk4,
-  &testbmk5,
-  &testbmk6,
-  &testbmk7,
-  &testbmk8,
-  &testbmk9,
-  &testbmk10,
-  &testbmk11,
-#if CH_USE_MUTEXES || defined(__DOXYGEN__)
-  &testbmk12,
+
+static MemoryHeap bmk_heap;
+
+static void bmk14_setup(void) {
+
+  chHeapInit(&bmk_heap, test.buffer, sizeof(union test_buffers));
+}
+
+static void bmk14_execute(void) {
+  void *objs[8];
+  uint32_t n = 0;
+  unsigned i;
+
+  test_wait_tick();
+  test_start_timer(1000);
+  do {
+    for (i = 0; i < 8; i++)
+      objs[i] = chHeapAlloc(&bmk_heap, 8 + (i * 12));
+    for (i = 0; i < 8; i++)
+      chHeapFree(objs[i]);
+    n++;
+#if defined(SIMULATOR)
+    ChkIntSources();
+#endif
+  } while (!test_timer_done);
+  test_print("--- Score : ");
+  test_print_score("requests", n, "requests/S");
+  test_println("");
+}
+
+ROMCONST struct testcase testbmk14 = {
+  "Benchmark, heap request processing",
+  bmk14_setup,
+  NULL,
+  bmk14_execute
+};
+#endif /* CH_USE_HEAP && !CH_USE_MALLOC_HEAP */
+
+#if CH_USE_ARENAS || defined(__DOXYGEN__)
+/**
+ * @page test_benchmarks_015 Arena request processing performance
+ *
+ * <h2>Description</h2>
+ * The same objects of the previous benchmark are allocated from a memory
+ * arena then released all together to a mark, into a continuous loop. The
+ * mark is taken once after the arena obtained its first block so the loop
+ * measures the steady state allocation path.<br>
+ * The performance is calculated by measuring the number of iterations after
+ * a second of continuous operations.
+ */
+
+static MEMORYARENA_DECL(bmk_arena, 0, NULL);
+
+static void bmk15_setup(void) {
+
+  chArenaInit(&bmk_arena, 0, NULL);
+  chArenaLoadBuffer(&bmk_arena, test.buffer, sizeof(union test_buffers));
+}
+
+static void bmk15_execute(void) {
+  arenamark_t mark;
+  uint32_t n = 0;
+  unsigned i;
+
+  /* The first allocation makes the arena take its block, the mark taken
+     after it lays inside the block.*/
+  (void)chArenaAlloc(&bmk_arena, 8);
+  mark = chArenaGetMark(&bmk_arena);
+  test_wait_tick();
+  test_start_timer(1000);
+  do {
+    for (i = 0; i < 8; i++)
+      (void)chArenaAlloc(&bmk_arena, 8 + (i * 12));
+    chArenaRelease(&bmk_arena, mark);
+    n++;
+#if defined(SIMULATOR)
+    ChkIntSources();
+#endif
+  } while (!test_timer_done);
+  test_print("--- Score : ");
+  test_print_score("requests", n, "requests/S");
+  test_println("");
+}
+
+ROMCONST struct testcase testbmk15 = {
+  "Benchmark, arena request processing",
+  bmk15_setup,
+  NULL,
+  bmk15_execute
+};
+#endif /* CH_USE_ARENAS */
+
+#if (CH_USE_MAILBOXES && CH_USE_MEMPOOLS) || defined(__DOXYGEN__)
+/**
+ * @page test_benchmarks_016 Mailbox and pool objects passing performance
+ *
+ * <h2>Description</h2>
+ * Objects are allocated from a memory pool and posted into a mailbox, a
+ * higher priority thread fetches the objects and frees them back into
+ * the pool, the objects are exchanged into a continuous loop.<br>
+ * The performance is calculated by measuring the number of iterations after
+ * a second of continuous operations.
+ */
+
+#define BMK_OBJECTS 4
+
+typedef struct {
+  bool_t                stop;
+  uint32_t              data[3];
+} bmk_record_t;
+
+static bmk_record_t bmk_records[BMK_OBJECTS];
+static msg_t bmk_msgs[BMK_OBJECTS];
+static MemoryPool bmk_mp;
+static Mailbox bmk_mb;
+
+static msg_t thread6(void *p) {
+  bmk_record_t *rp;
+  bool_t stop;
+
+  (void)p;
+  do {
+    chMBFetch(&bmk_mb, (msg_t *)&rp, TIME_INFINITE);
+    stop = rp->stop;
+    chPoolFree(&bmk_mp, rp);
+  } while (!stop);
+  return 0;
+}
+
+static void bmk16_setup(void) {
+
+  chPoolInit(&bmk_mp, sizeof(bmk_record_t), NULL);
+  chPoolLoadArray(&bmk_mp, bmk_records, BMK_OBJECTS);
+  chMBInit(&bmk_mb, bmk_msgs, BMK_OBJECTS);
+}
+
+static void bmk16_execute(void) {
+  bmk_record_t *rp;
+  uint32_t n = 0;
+
+  threads[0] = chThdCreateStatic(wa[0], WA_SIZE, chThdGetPriority()+1,
+                                 thread6, NULL);
+  test_wait_tick();
+  test_start_timer(1000);
+  do {
+    rp = chPoolAlloc(&bmk_mp);
+    rp->stop = FALSE;
+    chMBPost(&bmk_mb, (msg_t)rp, TIME_INFINITE);
+    n++;
+#if defined(SIMULATOR)
+    ChkIntSources();
+#endif
+  } while (!test_timer_done);
+  rp = chPoolAlloc(&bmk_mp);
+  rp->stop = TRUE;
+  chMBPost(&bmk_mb, (msg_t)rp, TIME_INFINITE);
+  test_wait_threads();
+  test_print("--- Score : ");
+  test_print_score("objects", n, "objects/S");
+  test_println("");
+}
+
+ROMCONST struct testcase testbmk16 = {
+  "Benchmark, mailbox and pool objects passing",
+  bmk16_setup,
+  NULL,
+  bmk16_execute
+};
+#endif /* CH_USE_MAILBOXES && CH_USE_MEMPOOLS */
+
+#if CH_USE_OBJFIFOS || defined(__DOXYGEN__)
+/**
+ * @page test_benchmarks_017 Objects FIFO objects passing performance
+ *
+ * <h2>Description</h2>
+ * The same exchange of the previous benchmark is performed using an
+ * objects FIFO.<br>
+ * The performance is calculated by measuring the number of iterations after
+ * a second of continuous operations.
+ */
+
+static ObjectsFifo bmk_of;
+
+static msg_t thread7(void *p) {
+  bmk_record_t *rp;
+  bool_t stop;
+
+  (void)p;
+  do {
+    chFifoFetchTimeout(&bmk_of, (void **)&rp, TIME_INFINITE);
+    stop = rp->stop;
+    chFifoFree(&bmk_of, rp);
+  } while (!stop);
+  return 0;
+}
+
+static void bmk17_setup(void) {
+
+  chFifoInit(&bmk_of, sizeof(bmk_record_t), BMK_OBJECTS,
+             bmk_records, bmk_msgs);
+}
+
+static void bmk17_execute(void) {
+  bmk_record_t *rp;
+  uint32_t n = 0;
+
+  threads[0] = chThdCreateStatic(wa[0], WA_SIZE, chThdGetPriority()+1,
+                                 thread7, NULL);
+  test_wait_tick();
+  test_start_timer(1000);
+  do {
+    rp = chFifoAlloc(&bmk_of);
+    rp->stop = FALSE;
+    chFifoPost(&bmk_of, rp);
+    n++;
+#if defined(SIMULATOR)
+    ChkIntSources();
+#endif
+  } while (!test_timer_done);
+  rp = chFifoAlloc(&bmk_of);
+  rp->stop = TRUE;
+  chFifoPost(&bmk_of, rp);
+  test_wait_threads();
+  test_print("--- Score : ");
+  test_print_score("objects", n, "objects/S");
+  test_println("");
+}
+
+ROMCONST struct testcase testbmk17 = {
+  "Benchmark, objects FIFO objects passing",
+  bmk17_setup,
+  NULL,
+  bmk17_execute
+};
+#endif /* CH_USE_OBJFIFOS */
+
+/**
+ * @page test_benchmarks_018 I/O Queues bulk throughput
+ *
+ * <h2>Description</h2>
+ * Sixteen bytes are written as a single block and then read from an
+ * @p InputQueue into a continuous loop, the score can be compared with the
+ * byte oriented transfers of @ref test_benchmarks_009.<br>
+ * The performance is calculated by measuring the number of iterations after
+ * a second of continuous operations.
+ */
+
+static void bmk18_execute(void) {
+  uint32_t n;
+  static uint8_t ib[32];
+  static uint8_t buf[16];
+  static InputQueue iq;
+
+  chIQInit(&iq, ib, sizeof(ib), NULL, NULL);
+  n = 0;
+  test_wait_tick();
+  test_start_timer(1000);
+  do {
+    chSysLock();
+    chIQWriteI(&iq, buf, sizeof(buf));
+    chSysUnlock();
+    (void)chIQReadTimeout(&iq, buf, sizeof(buf), TIME_INFINITE);
+    n++;
+#if defined(SIMULATOR)
+    ChkIntSources();
+#endif
+  } while (!test_timer_done);
+  test_print("--- Score : ");
+  test_print_score("bytes", n * sizeof(buf), "bytes/S");
+  test_println("");
+}
+
+ROMCONST struct testcase testbmk18 = {
+  "Benchmark, I/O Queues bulk throughput",
+  NULL,
+  NULL,
+  bmk18_execute
+};
+
+#if CH_USE_RINGS || defined(__DOXYGEN__)
+/**
+ * @page test_benchmarks_019 Interrupt side write cost, queues and rings
+ *
+ * <h2>Description</h2>
+ * Sixteen bytes are written one at time from an interrupt context into an
+ * empty @p InputQueue, each byte inside its own critical zone, then the
+ * same is done with a @p RingBuffer that only enters a critical zone on the
+ * empty to non-empty transition. The buffers are reset after each block.
+ * The interrupt context is simulated with the interrupts disabled so that
+ * a real interrupt cannot nest into it.<br>
+ * The performance is calculated by measuring the number of iterations after
+ * a second of continuous operations.
+ */
+
+static void bmk19_execute(void) {
+  static uint8_t ib[16];
+  static uint8_t rbuf[16];
+  static InputQueue iq;
+  static RingBuffer rb;
+  uint32_t n;
+  unsigned i;
+
+  chIQInit(&iq, ib, sizeof(ib), NULL, NULL);
+  n = 0;
+  test_wait_tick();
+  test_start_timer(1000);
+  do {
+    chSysDisable();
+    dbg_check_enter_isr();
+    for (i = 0; i < sizeof(ib); i++) {
+      chSysLockFromIsr();
+      chIQPutI(&iq, (uint8_t)i);
+      chSysUnlockFromIsr();
+    }
+    dbg_check_leave_isr();
+    chSysEnable();
+    chSysLock();
+    chIQResetI(&iq);
+    chSysUnlock();
+    n++;
+#if defined(SIMULATOR)
+    ChkIntSources();
+#endif
+  } while (!test_timer_done);
+  test_print("--- Queue : ");
+  test_print_score("queue", n * sizeof(ib), "bytes/S");
+  test_println("");
+
+  chRingInit(&rb, rbuf, sizeof(uint8_t), sizeof(rbuf));
+  n = 0;
+  test_wait_tick();
+  test_start_timer(1000);
+  do {
+    chSysDisable();
+    dbg_check_enter_isr();
+    for (i = 0; i < sizeof(rbuf); i++)
+      chRingPutFromIsr(&rb, (uint8_t)i);
+    dbg_check_leave_isr();
+    chSysEnable();
+    chSysLock();
+    chRingResetI(&rb);
+    chSysUnlock();
+    n++;
+#if defined(SIMULATOR)
+    ChkIntSources();
+#endif
+  } while (!test_timer_done);
+  test_print("--- Ring  : ");
+  test_print_score("ring", n * sizeof(rbuf), "bytes/S");
+  test_println("");
+}
+
+ROMCONST struct testcase testbmk19 = {
+  "Benchmark, ISR side write, queues vs rings",
+  NULL,
+  NULL,
+  bmk19_execute
+};
+#endif /* CH_USE_RINGS */
+
+#if CH_USE_MAILBOXES || defined(__DOXYGEN__)
+/**
+ * @page test_benchmarks_020 Mailbox single and batched transfers
+ *
+ * <h2>Description</h2>
+ * A thread posts messages into a mailbox, a higher priority thread fetches
+ * them. The messages are first transferred one at time using
+ * @p chMBPost() and @p chMBFetch(), then in bursts of sixteen messages
+ * using @p chMBPostN() and @p chMBFetchN().<br>
+ * The performance is calculated by measuring the number of messages
+ * transferred after a second of continuous operations.
+ */
+
+#define BMK_BURST 16
+
+static msg_t bmk_burst_buf[BMK_BURST];
+static Mailbox bmk_burst_mb;
+
+static msg_t thread9(void *p) {
+  msg_t msgs[BMK_BURST];
+  cnt_t i, n;
+
+  if (p == NULL) {
+    do {
+      chMBFetch(&bmk_burst_mb, &msgs[0], TIME_INFINITE);
+    } while (msgs[0] != 0);
+    return 0;
+  }
+  while (TRUE) {
+    n = chMBFetchN(&bmk_burst_mb, msgs, BMK_BURST, TIME_INFINITE);
+    for (i = 0; i < n; i++)
+      if (msgs[i] == 0)
+        return 0;
+  }
+}
+
+static void bmk20_setup(void) {
+
+  chMBInit(&bmk_burst_mb, bmk_burst_buf, BMK_BURST);
+}
+
+static void bmk20_execute(void) {
+  msg_t msgs[BMK_BURST];
+  uint32_t n;
+  cnt_t i;
+
+  threads[0] = chThdCreateStatic(wa[0], WA_SIZE, chThdGetPriority()+1,
+                                 thread9, NULL);
+  n = 0;
+  test_wait_tick();
+  test_start_timer(1000);
+  do {
+    for (i = 0; i < BMK_BURST; i++)
+      chMBPost(&bmk_burst_mb, 1, TIME_INFINITE);
+    n += BMK_BURST;
+#if defined(SIMULATOR)
+    ChkIntSources();
+#endif
+  } while (!test_timer_done);
+  chMBPost(&bmk_burst_mb, 0, TIME_INFINITE);
+  test_wait_threads();
+  test_print("--- Single: ");
+  test_print_score("single", n, "msgs/S");
+  test_println("");
+
+  for (i = 0; i < BMK_BURST; i++)
+    msgs[i] = 1;
+  threads[0] = chThdCreateStatic(wa[0], WA_SIZE, chThdGetPriority()+1,
+                                 thread9, "");
+  n = 0;
+  test_wait_tick();
+  test_start_timer(1000);
+  do {
+    chMBPostN(&bmk_burst_mb, msgs, BMK_BURST, TIME_INFINITE);
+    n += BMK_BURST;
+#if defined(SIMULATOR)
+    ChkIntSources();
+#endif
+  } while (!test_timer_done);
+  chMBPost(&bmk_burst_mb, 0, TIME_INFINITE);
+  test_wait_threads();
+  test_print("--- Batch : ");
+  test_print_score("batch", n, "msgs/S");
+  test_println("");
+}
+
+ROMCONST struct testcase testbmk20 = {
+  "Benchmark, mailbox single vs batched transfers",
+  bmk20_setup,
+  NULL,
+  bmk20_execute
+};
+#endif /* CH_USE_MAILBOXES */
+
+#if CH_USE_TOPICS || defined(__DOXYGEN__)
+/**
+ * @page test_benchmarks_021 Topic publish to receive round trip
+ *
+ * <h2>Description</h2>
+ * A higher priority thread subscribes to a topic with 1, 4 and 16
+ * latest-value subscribers, on each publish the thread is woken and reads
+ * the message from all its subscribers before the publisher can continue,
+ * the reciprocal of the score is the publish to receive latency.<br>
+ * The performance is calculated by measuring the number of iterations after
+ * a second of continuous operations.
+ */
+
+#define BMK_SUBSCRIBERS 16
+
+static uint32_t bmk_topic_buf[1];
+static Topic bmk_topic;
+static TopicSubscriber bmk_subs[BMK_SUBSCRIBERS];
+
+static msg_t thread10(void *p) {
+  unsigned i, n = (unsigned)(size_t)p;
+  uint32_t msg;
+  bool_t stop = FALSE;
+
+  for (i = 0; i < n; i++)
+    chTopicSubscribe(&bmk_topic, &bmk_subs[i], EVENT_MASK(i), TOPIC_LATEST);
+  while (!stop) {
+    chEvtWaitAny(ALL_EVENTS);
+    for (i = 0; i < n; i++)
+      if ((chTopicReceive(&bmk_subs[i], &msg) == RDY_OK) && (msg == 0))
+        stop = TRUE;
+  }
+  for (i = 0; i < n; i++)
+    chTopicUnsubscribe(&bmk_subs[i]);
+  return 0;
+}
+
+static void bmk21_setup(void) {
+
+  chTopicInit(&bmk_topic, bmk_topic_buf, sizeof(uint32_t), 1);
+}
+
+static void bmk21_execute(void) {
+  static const unsigned subs[] = {1, 4, BMK_SUBSCRIBERS};
+  static const char * const metrics[] = {"subs1", "subs4", "subs16"};
+  uint32_t n, msg;
+  unsigned i;
+
+  for (i = 0; i < sizeof(subs) / sizeof(subs[0]); i++) {
+    threads[0] = chThdCreateStatic(wa[0], WA_SIZE, chThdGetPriority()+1,
+                                   thread10, (void *)(size_t)subs[i]);
+    n = 0;
+    msg = 1;
+    test_wait_tick();
+    test_start_timer(1000);
+    do {
+      chTopicPublish(&bmk_topic, &msg);
+      n++;
+#if defined(SIMULATOR)
+      ChkIntSources();
+#endif
+    } while (!test_timer_done);
+    msg = 0;
+    chTopicPublish(&bmk_topic, &msg);
+    test_wait_threads();
+    test_print("--- Subs ");
+    test_printn(subs[i]);
+    test_print(subs[i] < 10 ? " : " : ": ");
+    test_print_score(metrics[i], n, "msgs/S");
+    test_println("");
+  }
+}
+
+ROMCONST struct testcase testbmk21 = {
+  "Benchmark, topic publish to receive",
+  bmk21_setup,
+  NULL,
+  bmk21_execute
+};
+#endif /* CH_USE_TOPICS */
+
+#if PORT_SUPPORTS_RT_COUNTER || defined(__DOXYGEN__)
+/*
+ * Latency benchmarks support. The latencies are measured in free running
+ * counter cycles and accumulated into a histogram with eight linear bins
+ * for each power of two, the percentiles are reported as the upper bound
+ * of the bin containing them, the maximum is exact.
+ */
+
+#if TEST_BMK_LOAD_THREADS > MAX_THREADS - 2
+#error "TEST_BMK_LOAD_THREADS too large"
+#endif
+
+#define BMK_LAT_DURATION    1000
+#define BMK_LAT_CAL_TICKS   ((CH_FREQUENCY + 9) / 10)
+#define BMK_LAT_BURST       16
+#define BMK_LAT_SUB_BITS    3
+#define BMK_LAT_SUB         (1 << BMK_LAT_SUB_BITS)
+#define BMK_LAT_BINS        ((32 - BMK_LAT_SUB_BITS + 1) * BMK_LAT_SUB)
+
+#if defined(PORT_RT_COUNTER_FREQUENCY)
+#define BMK_LAT_UNIT        "ns"
+#define bmk_lat_time(c)     ((uint32_t)(((uint64_t)(c) * 1000000000) /      \
+                                        PORT_RT_COUNTER_FREQUENCY))
+#else
+#define BMK_LAT_UNIT        "cycles"
+#define bmk_lat_time(c)     (c)
+#endif
+
+static struct {
+  uint32_t      bins[BMK_LAT_BINS];
+  uint32_t      n;
+  uint32_t      max;
+} bmk_lat;
+
+static volatile uint32_t bmk_lat_t0, bmk_lat_last;
+static uint32_t bmk_lat_period;
+static VirtualTimer bmk_lat_vt;
+
+static unsigned bmk_lat_bin(uint32_t c) {
+  unsigned e;
+
+  if (c < BMK_LAT_SUB)
+    return (unsigned)c;
+  for (e = BMK_LAT_SUB_BITS; c >> (e + 1); e++)
+    ;
+  return (e - BMK_LAT_SUB_BITS + 1) * BMK_LAT_SUB +
+         ((c >> (e - BMK_LAT_SUB_BITS)) & (BMK_LAT_SUB - 1));
+}
+
+static uint32_t bmk_lat_bin_top(unsigned i) {
+  unsigned s;
+
+  if (i < BMK_LAT_SUB)
+    return i;
+  s = i / BMK_LAT_SUB - 1;
+  return ((uint32_t)(BMK_LAT_SUB + i % BMK_LAT_SUB) << s) +
+         (((uint32_t)1 << s) - 1);
+}
+
+static void bmk_lat_reset(void) {
+  unsigned i;
+
+  for (i = 0; i < BMK_LAT_BINS; i++)
+    bmk_lat.bins[i] = 0;
+  bmk_lat.n = 0;
+  bmk_lat.max = 0;
+}
+
+static void bmk_lat_record(uint32_t c) {
+
+  bmk_lat.bins[bmk_lat_bin(c)]++;
+  bmk_lat.n++;
+  if (c > bmk_lat.max)
+    bmk_lat.max = c;
+}
+
+/*
+ * Records the deviation of the interval since the previous call from the
+ * calibrated period.
+ */
+static void bmk_lat_record_jitter(void) {
+  uint32_t now = port_rt_get_counter_value();
+  uint32_t d = now - bmk_lat_last;
+
+  bmk_lat_record(d > bmk_lat_period ? d - bmk_lat_period :
+                                      bmk_lat_period - d);
+  bmk_lat_last = now;
+}
+
+/*
+ * Percentile in hundredths of percent.
+ */
+static uint32_t bmk_lat_percentile(uint32_t p) {
+  uint32_t target, sum = 0;
+  unsigned i;
+
+  target = (uint32_t)(((uint64_t)bmk_lat.n * p + 9999) / 10000);
+  for (i = 0; i < BMK_LAT_BINS; i++) {
+    sum += bmk_lat.bins[i];
+    if ((sum > 0) && (sum >= target))
+      break;
+  }
+  if ((i == BMK_LAT_BINS) || (bmk_lat_bin_top(i) > bmk_lat.max))
+    return bmk_lat.max;
+  return bmk_lat_bin_top(i);
+}
+
+static void bmk_lat_print(void) {
+  uint32_t n;
+  unsigned i, j;
+
+  test_print("--- Samples: ");
+  test_printn(bmk_lat.n);
+  test_println("");
+  for (i = 0; i < BMK_LAT_BINS; i += BMK_LAT_SUB) {
+    n = 0;
+    for (j = i; j < i + BMK_LAT_SUB; j++)
+      n += bmk_lat.bins[j];
+    if (n > 0) {
+      test_print("---   <= ");
+      test_printn(bmk_lat_time(bmk_lat_bin_top(i + BMK_LAT_SUB - 1)));
+      test_print(" " BMK_LAT_UNIT ": ");
+      test_printn(n);
+      test_println("");
+    }
+  }
+  test_print("--- p50  : ");
+  test_print_score("p50", bmk_lat_time(bmk_lat_percentile(5000)),
+                   BMK_LAT_UNIT);
+  test_println("");
+  test_print("--- p99  : ");
+  test_print_score("p99", bmk_lat_time(bmk_lat_percentile(9900)),
+                   BMK_LAT_UNIT);
+  test_println("");
+  test_print("--- p99.9: ");
+  test_print_score("p99.9", bmk_lat_time(bmk_lat_percentile(9990)),
+                   BMK_LAT_UNIT);
+  test_println("");
+  test_print("--- Max  : ");
+  test_print_score("max", bmk_lat_time(bmk_lat.max), BMK_LAT_UNIT);
+  test_println("");
+}
+
+/*
+ * Measures the system tick period in counter cycles.
+ */
+static void bmk_lat_calibrate(void) {
+  uint32_t start;
+
+  test_wait_tick();
+  start = port_rt_get_counter_value();
+  chThdSleep(BMK_LAT_CAL_TICKS);
+  bmk_lat_period = (port_rt_get_counter_value() - start) / BMK_LAT_CAL_TICKS;
+}
+
+/*
+ * Background load, the threads keep the ready list populated and execute
+ * kernel critical sections while the measuring threads are waiting.
+ */
+#if TEST_BMK_LOAD_THREADS > 0
+static msg_t thread11(void *p) {
+  VirtualTimer vt;
+
+  (void)p;
+  while (!chThdShouldTerminate()) {
+    chSysLock();
+    chVTSetI(&vt, 10, tmo, NULL);
+    chVTResetI(&vt);
+    chSysUnlock();
+    chThdYield();
+#if defined(SIMULATOR)
+    ChkIntSources();
+#endif
+  }
+  return 0;
+}
+#endif
+
+static void bmk_lat_load_start(void) {
+#if TEST_BMK_LOAD_THREADS > 0
+  unsigned i;
+
+  for (i = 0; i < TEST_BMK_LOAD_THREADS; i++)
+    threads[MAX_THREADS - 1 - i] = chThdCreateStatic(wa[MAX_THREADS - 1 - i],
+                                                     WA_SIZE,
+                                                     chThdGetPriority()-1,
+                                                     thread11, NULL);
+#endif
+}
+
+static void bmk_lat_load_stop(void) {
+
+  test_terminate_threads();
+  test_wait_threads();
+}
+
+/*
+ * Thread to thread wakeup latency, the higher priority waiter thread
+ * records the latency after each wakeup, the trigger function wakes it
+ * up. The triggering thread sleeps for a tick after each burst of
+ * wakeups in order to let the load threads run.
+ */
+static void bmk_lat_wakeup(tfunc_t waiter, void (*trigger)(void)) {
+  unsigned i;
+
+  threads[0] = chThdCreateStatic(wa[0], WA_SIZE, chThdGetPriority()+1,
+                                 waiter, NULL);
+  bmk_lat_load_start();
+  test_wait_tick();
+  test_start_timer(BMK_LAT_DURATION);
+  do {
+    for (i = 0; i < BMK_LAT_BURST; i++)
+      trigger();
+    chThdSleep(1);
+  } while (!test_timer_done);
+  chThdTerminate(threads[0]);
+  trigger();
+  bmk_lat_load_stop();
+  bmk_lat_print();
+}
+
+/**
+ * @page test_benchmarks_022 Semaphore wakeup latency
+ *
+ * <h2>Description</h2>
+ * A thread signals a semaphore, a higher priority thread waiting on it
+ * measures the time elapsed since the signal using the port free running
+ * counter. The distribution of the latencies is printed as an histogram
+ * with the 50th, 99th and 99.9th percentiles and the maximum.<br>
+ * The @p TEST_BMK_LOAD_THREADS option adds background load threads to
+ * this and the following latency benchmarks.
+ */
+
+static msg_t thread12(void *p) {
+
+  (void)p;
+  while (TRUE) {
+    chSemWait(&sem1);
+    if (chThdShouldTerminate())
+      return 0;
+    bmk_lat_record(port_rt_get_counter_value() - bmk_lat_t0);
+  }
+}
+
+static void bmk22_setup(void) {
+
+  chSemInit(&sem1, 0);
+  bmk_lat_reset();
+}
+
+static void bmk22_trigger(void) {
+
+  bmk_lat_t0 = port_rt_get_counter_value();
+  chSemSignal(&sem1);
+}
+
+static void bmk22_execute(void) {
+
+  bmk_lat_wakeup(thread12, bmk22_trigger);
+}
+
+ROMCONST struct testcase testbmk22 = {
+  "Benchmark, semaphore wakeup latency",
+  bmk22_setup,
+  NULL,
+  bmk22_execute
+};
+
+#if CH_USE_EVENTS || defined(__DOXYGEN__)
+/**
+ * @page test_benchmarks_023 Event wakeup latency
+ *
+ * <h2>Description</h2>
+ * A thread signals an event flag to a higher priority thread waiting for
+ * it, the waiting thread measures the time elapsed since the signal. The
+ * distribution of the latencies is printed.
+ */
+
+static msg_t thread13(void *p) {
+
+  (void)p;
+  while (TRUE) {
+    chEvtWaitAny(1);
+    if (chThdShouldTerminate())
+      return 0;
+    bmk_lat_record(port_rt_get_counter_value() - bmk_lat_t0);
+  }
+}
+
+static void bmk23_setup(void) {
+
+  bmk_lat_reset();
+}
+
+static void bmk23_trigger(void) {
+
+  bmk_lat_t0 = port_rt_get_counter_value();
+  chEvtSignal(threads[0], 1);
+}
+
+static void bmk23_execute(void) {
+
+  bmk_lat_wakeup(thread13, bmk23_trigger);
+}
+
+ROMCONST struct testcase testbmk23 = {
+  "Benchmark, event wakeup latency",
+  bmk23_setup,
+  NULL,
+  bmk23_execute
+};
+#endif /* CH_USE_EVENTS */
+
+#if CH_USE_MAILBOXES || defined(__DOXYGEN__)
+/**
+ * @page test_benchmarks_024 Mailbox wakeup latency
+ *
+ * <h2>Description</h2>
+ * A thread posts the current counter value into a mailbox, a higher
+ * priority thread fetching from the mailbox measures the time elapsed
+ * since the post. The distribution of the latencies is printed.
+ */
+
+static msg_t bmk_lat_mb_buf[1];
+static Mailbox bmk_lat_mb;
+
+static msg_t thread14(void *p) {
+  msg_t msg;
+
+  (void)p;
+  while (TRUE) {
+    chMBFetch(&bmk_lat_mb, &msg, TIME_INFINITE);
+    if (chThdShouldTerminate())
+      return 0;
+    bmk_lat_record(port_rt_get_counter_value() - (uint32_t)msg);
+  }
+}
+
+static void bmk24_setup(void) {
+
+  chMBInit(&bmk_lat_mb, bmk_lat_mb_buf, 1);
+  bmk_lat_reset();
+}
+
+static void bmk24_trigger(void) {
+
+  chMBPost(&bmk_lat_mb, (msg_t)port_rt_get_counter_value(), TIME_INFINITE);
+}
+
+static void bmk24_execute(void) {
+
+  bmk_lat_wakeup(thread14, bmk24_trigger);
+}
+
+ROMCONST struct testcase testbmk24 = {
+  "Benchmark, mailbox wakeup latency",
+  bmk24_setup,
+  NULL,
+  bmk24_execute
+};
+#endif /* CH_USE_MAILBOXES */
+
+/**
+ * @page test_benchmarks_025 ISR to thread latency
+ *
+ * <h2>Description</h2>
+ * A virtual timer callback, invoked from the system tick interrupt, signals
+ * a semaphore on every tick, a higher priority thread waiting on it
+ * measures the time elapsed since the signal. The distribution of the
+ * latencies is printed.
+ */
+
+static void bmk25_isr(void *p) {
+
+  (void)p;
+  chSysLockFromIsr();
+  bmk_lat_t0 = port_rt_get_counter_value();
+  chSemSignalI(&sem1);
+  chVTSetI(&bmk_lat_vt, 1, bmk25_isr, NULL);
+  chSysUnlockFromIsr();
+}
+
+static void bmk25_execute(void) {
+
+  threads[0] = chThdCreateStatic(wa[0], WA_SIZE, chThdGetPriority()+1,
+                                 thread12, NULL);
+  bmk_lat_load_start();
+  test_wait_tick();
+  chVTSet(&bmk_lat_vt, 1, bmk25_isr, NULL);
+  chThdSleepMilliseconds(BMK_LAT_DURATION);
+  chSysLock();
+  if (chVTIsArmedI(&bmk_lat_vt))
+    chVTResetI(&bmk_lat_vt);
+  chSysUnlock();
+  chThdTerminate(threads[0]);
+  chSemSignal(&sem1);
+  bmk_lat_load_stop();
+  bmk_lat_print();
+}
+
+ROMCONST struct testcase testbmk25 = {
+  "Benchmark, ISR to thread latency",
+  bmk22_setup,
+  NULL,
+  bmk25_execute
+};
+
+/**
+ * @page test_benchmarks_026 Virtual timers jitter
+ *
+ * <h2>Description</h2>
+ * A virtual timer is rearmed for the next tick from its own callback, the
+ * callback measures the deviation of the interval since the previous
+ * invocation from the tick period. The distribution of the deviations is
+ * printed.
+ */
+
+static void bmk26_isr(void *p) {
+
+  if (p != NULL)
+    bmk_lat_record_jitter();
+  else
+    bmk_lat_last = port_rt_get_counter_value();
+  chSysLockFromIsr();
+  chVTSetI(&bmk_lat_vt, 1, bmk26_isr, &bmk_lat_vt);
+  chSysUnlockFromIsr();
+}
+
+static void bmk26_setup(void) {
+
+  bmk_lat_reset();
+  bmk_lat_calibrate();
+}
+
+static void bmk26_execute(void) {
+
+  bmk_lat_load_start();
+  test_wait_tick();
+  chVTSet(&bmk_lat_vt, 1, bmk26_isr, NULL);
+  chThdSleepMilliseconds(BMK_LAT_DURATION);
+  chSysLock();
+  if (chVTIsArmedI(&bmk_lat_vt))
+    chVTResetI(&bmk_lat_vt);
+  chSysUnlock();
+  bmk_lat_load_stop();
+  bmk_lat_print();
+}
+
+ROMCONST struct testcase testbmk26 = {
+  "Benchmark, virtual timers jitter",
+  bmk26_setup,
+  NULL,
+  bmk26_execute
+};
+
+/**
+ * @page test_benchmarks_027 Periodic thread release jitter
+ *
+ * <h2>Description</h2>
+ * A thread executes a periodic loop sleeping until the next release time,
+ * with a one tick period, and measures the deviation of each release
+ * interval from the tick period. A missed release restarts the period. The
+ * distribution of the deviations is printed.
+ */
+
+static void bmk27_execute(void) {
+  systime_t time;
+
+  bmk_lat_load_start();
+  time = test_wait_tick();
+  bmk_lat_last = port_rt_get_counter_value();
+  test_start_timer(BMK_LAT_DURATION);
+  do {
+    time++;
+    chSysLock();
+    /* A missed release restarts the period, a preempted simulator can be
+       stalled by the host and the release time would be reached again only
+       after a system time wrap around.*/
+    if ((systime_t)(time - chTimeNow()) > 1)
+      time = chTimeNow() + 1;
+    if (time != chTimeNow())
+      chThdSleepS(time - chTimeNow());
+    chSysUnlock();
+    bmk_lat_record_jitter();
+  } while (!test_timer_done);
+  bmk_lat_load_stop();
+  bmk_lat_print();
+}
+
+ROMCONST struct testcase testbmk27 = {
+  "Benchmark, periodic thread release jitter",
+  bmk26_setup,
+  NULL,
+  bmk27_execute
+};
+#endif /* PORT_SUPPORTS_RT_COUNTER */
+
+#if (PORT_SUPPORTS_RT_COUNTER && CH_USE_HEAP) || defined(__DOXYGEN__)
+/*
+ * Scalability benchmarks support. Each benchmark measures the average cost
+ * of an operation on a kernel structure populated with an increasing number
+ * of elements, the elements are allocated from the default heap and the
+ * sizes not fitting in the available memory are skipped.
+ */
+
+#define BMK_SCALE_OPS       64
+#define BMK_SCALE_NOMEM     0xFFFFFFFFU
+#define BMK_SCALE_DELAY     MS2ST(10000)
+#define BMK_SCALE_BLOCK     16
+#define BMK_SCALE_CHUNK     100
+
+/*
+ * Placeholder thread, the queues under measure only access the links and
+ * the priority, the layout matches the head of the @p Thread structure.
+ */
+struct bmk_scale_thread {
+  Thread            *p_next;
+  Thread            *p_prev;
+  tprio_t           p_prio;
+};
+
+/*
+ * The placeholders are allocated in small chunks, a fragmented heap can
+ * still hold the largest population.
+ */
+static struct bmk_scale_thread *bmk_scale_chunks[1000 / BMK_SCALE_CHUNK];
+static Thread bmk_scale_ntp;
+
+static void bmk_scale_free_threads(void) {
+  unsigned i;
+
+  for (i = 0; i < sizeof(bmk_scale_chunks) / sizeof(bmk_scale_chunks[0]);
+       i++) {
+    if (bmk_scale_chunks[i] != NULL) {
+      chHeapFree(bmk_scale_chunks[i]);
+      bmk_scale_chunks[i] = NULL;
+    }
+  }
+}
+
+static bool_t bmk_scale_alloc_threads(unsigned n) {
+  unsigned i;
+
+  for (i = 0; i < (n + BMK_SCALE_CHUNK - 1) / BMK_SCALE_CHUNK; i++) {
+    bmk_scale_chunks[i] = chHeapAlloc(NULL, BMK_SCALE_CHUNK *
+                                            sizeof(struct bmk_scale_thread));
+    if (bmk_scale_chunks[i] == NULL) {
+      bmk_scale_free_threads();
+      return FALSE;
+    }
+  }
+  return TRUE;
+}
+
+static Thread *bmk_scale_thread(unsigned i) {
+
+  return (Thread *)&bmk_scale_chunks[i / BMK_SCALE_CHUNK][i % BMK_SCALE_CHUNK];
+}
+
+static const unsigned bmk_scale_sizes[] = {1, 10, 100, 1000};
+static const char * const bmk_scale_metrics[] = {"n1", "n10", "n100",
+                                                 "n1000"};
+
+/*
+ * Runs the measure function for all the sizes and prints the results, the
+ * function returns the counter cycles taken by @p BMK_SCALE_OPS operations
+ * or @p BMK_SCALE_NOMEM.
+ */
+static void bmk_scale_sweep(uint32_t (*measure)(unsigned n)) {
+  uint32_t c;
+  unsigned i;
+
+  for (i = 0; i < sizeof(bmk_scale_sizes) / sizeof(bmk_scale_sizes[0]); i++) {
+    c = measure(bmk_scale_sizes[i]);
+    test_print("--- Size ");
+    test_printn(bmk_scale_sizes[i]);
+    test_print(bmk_scale_sizes[i] < 10 ? "   : " :
+               bmk_scale_sizes[i] < 100 ? "  : " :
+               bmk_scale_sizes[i] < 1000 ? " : " : ": ");
+    if (c == BMK_SCALE_NOMEM)
+      test_println("not enough memory");
+    else {
+      test_print_score(bmk_scale_metrics[i],
+                       bmk_lat_time(c / BMK_SCALE_OPS), BMK_LAT_UNIT "/op");
+      test_println("");
+    }
+  }
+}
+
+/**
+ * @page test_benchmarks_028 Ready list scalability
+ *
+ * <h2>Description</h2>
+ * The ready list is populated with an increasing number of placeholder
+ * threads at idle priority, then a thread with the same priority is made
+ * ready, scanning the whole list, and removed again.<br>
+ * The cost is the average duration of the @p chSchReadyI() operation
+ * for each population size.
+ */
+
+static uint32_t bmk28_measure(unsigned n) {
+  Thread *ntp = &bmk_scale_ntp;
+  uint32_t start, c;
+  unsigned i;
+
+  if (!bmk_scale_alloc_threads(n))
+    return BMK_SCALE_NOMEM;
+  ntp->p_prio = IDLEPRIO;
+  chSysLock();
+  for (i = 0; i < n; i++) {
+    bmk_scale_thread(i)->p_prio = IDLEPRIO;
+    queue_insert(bmk_scale_thread(i), &rlist.r_queue);
+  }
+  start = port_rt_get_counter_value();
+  for (i = 0; i < BMK_SCALE_OPS; i++) {
+    ntp->p_state = THD_STATE_SUSPENDED;
+    chSchReadyI(ntp);
+    dequeue(ntp);
+    stats_ready_remove();
+  }
+  c = port_rt_get_counter_value() - start;
+  for (i = 0; i < n; i++)
+    dequeue(bmk_scale_thread(i));
+  chSysUnlock();
+  bmk_scale_free_threads();
+  return c;
+}
+
+static void bmk28_execute(void) {
+
+  bmk_scale_sweep(bmk28_measure);
+}
+
+ROMCONST struct testcase testbmk28 = {
+  "Benchmark, ready list scalability",
+  NULL,
+  NULL,
+  bmk28_execute
+};
+
+/**
+ * @page test_benchmarks_029 Virtual timers list scalability
+ *
+ * <h2>Description</h2>
+ * The virtual timers delta list is populated with an increasing number of
+ * timers, then a timer expiring after all of them is set, scanning the
+ * whole list, and reset again.<br>
+ * The cost is the average duration of the @p chVTSetI() operation for
+ * each population size.
+ */
+
+static uint32_t bmk29_measure(unsigned n) {
+  VirtualTimer *vtp;
+  uint32_t start, c;
+  unsigned i;
+
+  vtp = chHeapAlloc(NULL, (n + 1) * sizeof(VirtualTimer));
+  if (vtp == NULL)
+    return BMK_SCALE_NOMEM;
+  for (i = 0; i < n; i++)
+    chVTSet(&vtp[i], BMK_SCALE_DELAY + i, tmo, NULL);
+  chSysLock();
+  start = port_rt_get_counter_value();
+  for (i = 0; i < BMK_SCALE_OPS; i++) {
+    chVTSetI(&vtp[n], BMK_SCALE_DELAY + n, tmo, NULL);
+    chVTResetI(&vtp[n]);
+  }
+  c = port_rt_get_counter_value() - start;
+  chSysUnlock();
+  for (i = 0; i < n; i++)
+    chVTReset(&vtp[i]);
+  chHeapFree(vtp);
+  return c;
+}
+
+static void bmk29_execute(void) {
+
+  bmk_scale_sweep(bmk29_measure);
+}
+
+ROMCONST struct testcase testbmk29 = {
+  "Benchmark, virtual timers list scalability",
+  NULL,
+  NULL,
+  bmk29_execute
+};
+
+/**
+ * @page test_benchmarks_030 Priority ordered queues scalability
+ *
+ * <h2>Description</h2>
+ * A threads queue is populated with an increasing number of placeholder
+ * threads with the same priority, then another thread with that priority
+ * is inserted using @p prio_insert(), the function used by the mutexes
+ * and by the priority ordered semaphores and messages queues, scanning
+ * the whole queue, and removed again.<br>
+ * The cost is the average duration of the insertion for each population
+ * size.
+ */
+
+static uint32_t bmk30_measure(unsigned n) {
+  ThreadsQueue tq;
+  Thread *ntp = &bmk_scale_ntp;
+  uint32_t start, c;
+  unsigned i;
+
+  if (!bmk_scale_alloc_threads(n))
+    return BMK_SCALE_NOMEM;
+  ntp->p_prio = NORMALPRIO;
+  queue_init(&tq);
+  for (i = 0; i < n; i++) {
+    bmk_scale_thread(i)->p_prio = NORMALPRIO;
+    queue_insert(bmk_scale_thread(i), &tq);
+  }
+  chSysLock();
+  start = port_rt_get_counter_value();
+  for (i = 0; i < BMK_SCALE_OPS; i++) {
+    prio_insert(ntp, &tq);
+    dequeue(ntp);
+  }
+  c = port_rt_get_counter_value() - start;
+  chSysUnlock();
+  bmk_scale_free_threads();
+  return c;
+}
+
+static void bmk30_execute(void) {
+
+  bmk_scale_sweep(bmk30_measure);
+}
+
+ROMCONST struct testcase testbmk30 = {
+  "Benchmark, priority queues scalability",
+  NULL,
+  NULL,
+  bmk30_execute
+};
+
+#if !CH_USE_MALLOC_HEAP || defined(__DOXYGEN__)
+/**
+ * @page test_benchmarks_031 Heap free list scalability
+ *
+ * <h2>Description</h2>
+ * A private heap is fragmented into an increasing number of small free
+ * blocks separated by allocated blocks, then a block larger than the
+ * fragments is allocated, scanning the whole free list, and freed again,
+ * scanning the list for the insertion point.<br>
+ * The cost is the average duration of the allocation and release pair for
+ * each population size.
+ */
+
+static uint32_t bmk31_measure(unsigned n) {
+  const size_t unit = sizeof(union heap_header) +
+                      MEM_ALIGN_NEXT(BMK_SCALE_BLOCK);
+  MemoryHeap heap;
+  void *buf, **pp;
+  uint32_t start, c;
+  unsigned i;
+
+  buf = chHeapAlloc(NULL, (2 * n + 4) * unit);
+  pp = chHeapAlloc(NULL, 2 * n * sizeof(void *));
+  if ((buf == NULL) || (pp == NULL)) {
+    if (buf != NULL)
+      chHeapFree(buf);
+    if (pp != NULL)
+      chHeapFree(pp);
+    return BMK_SCALE_NOMEM;
+  }
+  chHeapInit(&heap, buf, (2 * n + 4) * unit);
+  for (i = 0; i < 2 * n; i++)
+    pp[i] = chHeapAlloc(&heap, BMK_SCALE_BLOCK);
+  for (i = 0; i < 2 * n; i += 2)
+    chHeapFree(pp[i]);
+  start = port_rt_get_counter_value();
+  for (i = 0; i < BMK_SCALE_OPS; i++)
+    chHeapFree(chHeapAlloc(&heap, 2 * BMK_SCALE_BLOCK));
+  c = port_rt_get_counter_value() - start;
+  for (i = 1; i < 2 * n; i += 2)
+    chHeapFree(pp[i]);
+  chHeapFree(pp);
+  chHeapFree(buf);
+  return c;
+}
+
+static void bmk31_execute(void) {
+
+  bmk_scale_sweep(bmk31_measure);
+}
+
+ROMCONST struct testcase testbmk31 = {
+  "Benchmark, heap free list scalability",
+  NULL,
+  NULL,
+  bmk31_execute
+};
+#endif /* !CH_USE_MALLOC_HEAP */
+
+#if CH_USE_EVENTS || defined(__DOXYGEN__)
+/**
+ * @page test_benchmarks_032 Event listeners scalability
+ *
+ * <h2>Description</h2>
+ * An increasing number of listeners is registered on an event source, then
+ * the event source is broadcasted, signaling all the listeners.<br>
+ * The cost is the average duration of the @p chEvtBroadcastFlagsI()
+ * operation for each population size.
+ */
+
+static uint32_t bmk32_measure(unsigned n) {
+  EventSource es;
+  EventListener *elp;
+  uint32_t start, c;
+  unsigned i;
+
+  elp = chHeapAlloc(NULL, n * sizeof(EventListener));
+  if (elp == NULL)
+    return BMK_SCALE_NOMEM;
+  chEvtInit(&es);
+  for (i = 0; i < n; i++)
+    chEvtRegisterMask(&es, &elp[i], EVENT_MASK(0));
+  chSysLock();
+  start = port_rt_get_counter_value();
+  for (i = 0; i < BMK_SCALE_OPS; i++)
+    chEvtBroadcastFlagsI(&es, 0);
+  c = port_rt_get_counter_value() - start;
+  chSysUnlock();
+  for (i = n; i > 0; i--)
+    chEvtUnregister(&es, &elp[i - 1]);
+  chEvtGetAndClearEvents(EVENT_MASK(0));
+  chHeapFree(elp);
+  return c;
+}
+
+static void bmk32_execute(void) {
+
+  bmk_scale_sweep(bmk32_measure);
+}
+
+ROMCONST struct testcase testbmk32 = {
+  "Benchmark, event listeners scalability",
+  NULL,
+  NULL,
+  bmk32_execute
+};
+#endif /* CH_USE_EVENTS */
+#endif /* PORT_SUPPORTS_RT_COUNTER && CH_USE_HEAP */
+
+#if TEST_USE_BINLOG || defined(__DOXYGEN__)
+/**
+ * @page test_benchmarks_033 Binary logger post
+ *
+ * <h2>Description</h2>
+ * Records with four arguments are posted into the binary logger until the
+ * log buffer is full, then the logger is reinitialized emptying the
+ * buffer. The output thread is not started so the measure only includes
+ * the @p binlogPost() cost.<br>
+ * The performance is calculated by measuring the number of iterations after
+ * a second of continuous operations.
+ */
+
+static void bmk33_execute(void) {
+  uint32_t n;
+  unsigned i;
+
+  binlogInit();
+  n = 0;
+  test_wait_tick();
+  test_start_timer(1000);
+  do {
+    for (i = 0; i < BINLOG_BUFFER_SIZE; i++)
+      BINLOG4("bmk %u %u %u %u", i, n, 0, 0);
+    binlogInit();
+    n++;
+#if defined(SIMULATOR)
+    ChkIntSources();
+#endif
+  } while (!test_timer_done);
+  test_print("--- Score : ");
+  test_print_score("posts", n * BINLOG_BUFFER_SIZE, "posts/S");
+  test_println("");
+}
+
+ROMCONST struct testcase testbmk33 = {
+  "Benchmark, binary logger post",
+  NULL,
+  NULL,
+  bmk33_execute
+};
+#endif /* TEST_USE_BINLOG */
+
+/**
+ * @brief   Test sequence for benchmarks.
+ */
+ROMCONST struct testcase * ROMCONST patternbmk[] = {
+#if !TEST_NO_BENCHMARKS
+  &testbmk1,
+  &testbmk2,
+  &testbmk3,
+  &testbmk4,
+  &testbmk5,
+  &testbmk6,
+  &testbmk7,
+  &testbmk8,
+  &testbmk9,
+  &testbmk10,
+  &testbmk11,
+#if CH_USE_MUTEXES || defined(__DOXYGEN__)
+  &testbmk12,
+#endif
+  &testbmk13,
+#if (CH_USE_HEAP && !CH_USE_MALLOC_HEAP) || defined(__DOXYGEN__)
+  &testbmk14,
+#endif
+#if CH_USE_ARENAS || defined(__DOXYGEN__)
+  &testbmk15,
+#endif
+#if (CH_USE_MAILBOXES && CH_USE_MEMPOOLS) || defined(__DOXYGEN__)
+  &testbmk16,
+#endif
+#if CH_USE_OBJFIFOS || defined(__DOXYGEN__)
+  &testbmk17,
+#endif
+  &testbmk18,
+#if CH_USE_RINGS || defined(__DOXYGEN__)
+  &testbmk19,
+#endif
+#if CH_USE_MAILBOXES || defined(__DOXYGEN__)
+  &testbmk20,
+#endif
+#if CH_USE_TOPICS || defined(__DOXYGEN__)
+  &testbmk21,
+#endif
+#if PORT_SUPPORTS_RT_COUNTER || defined(__DOXYGEN__)
+  &testbmk22,
+#if CH_USE_EVENTS || defined(__DOXYGEN__)
+  &testbmk23,
+#endif
+#if CH_USE_MAILBOXES || defined(__DOXYGEN__)
+  &testbmk24,
+#endif
+  &testbmk25,
+  &testbmk26,
+  &testbmk27,
+#endif
+#if (PORT_SUPPORTS_RT_COUNTER && CH_USE_HEAP) || defined(__DOXYGEN__)
+  &testbmk28,
+  &testbmk29,
+  &testbmk30,
+#if !CH_USE_MALLOC_HEAP || defined(__DOXYGEN__)
+  &testbmk31,
+#endif
+#if CH_USE_EVENTS || defined(__DOXYGEN__)
+  &testbmk32,
+#endif
+#endif
+#if TEST_USE_BINLOG || defined(__DOXYGEN__)
+  &testbmk33,
 #endif
-  &testbmk13,
 #endif
   NULL
 };
@@ -0,0 +1,436 @@
+/*
+    ChibiOS/RT - Copyright (C) 2006,2007,2008,2009,2010,
+                 2011,2012,2013 Giovanni Di Sirio.
+
+    This file is part of ChibiOS/RT.
+
+    ChibiOS/RT is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    ChibiOS/RT is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "ch.h"
+#include "hal.h"
+#include "test.h"
+
+/**
+ * @page test_bqueues Buffers Queues test
+ *
+ * File: @ref testbqueues.c
+ *
+ * <h2>Description</h2>
+ * This module implements the test sequence for the @ref BQUEUES subsystem.
+ * The tests are performed by exchanging buffers and streams of data through
+ * a buffers queue and by checking both the queue status and the correct
+ * sequence of the extracted data.
+ *
+ * <h2>Objective</h2>
+ * Objective of the test module is to cover 100% of the @ref BQUEUES code.
+ *
+ * <h2>Preconditions</h2>
+ * The module requires the following kernel options:
+ * - @p CH_USE_QUEUES (and dependent options)
+ * .
+ * In case some of the required options are not enabled then some or all tests
+ * may be skipped.
+ *
+ * <h2>Test Cases</h2>
+ * - @subpage test_bqueues_001
+ * - @subpage test_bqueues_002
+ * - @subpage test_bqueues_003
+ * .
+ * @file testbqueues.c
+ * @brief Buffers Queues test source file
+ * @file testbqueues.h
+ * @brief Buffers Queues test header file
+ */
+
+#if CH_USE_QUEUES || defined(__DOXYGEN__)
+
+#define TEST_BQUEUES_NUM        3
+#define TEST_BQUEUES_SIZE       4
+
+/*
+ * Buffers used by the asynchronous reset test, as large as the working
+ * area allows in order to make the copy window as wide as possible.
+ */
+#define TEST_BQUEUES_LARGE_NUM  2
+#define TEST_BQUEUES_LARGE_SIZE ((WA_SIZE / 2) - (2 * sizeof (size_t)))
+
+/*
+ * Number of asynchronous resets and maximum number of transfers waiting
+ * for each reset.
+ */
+#define TEST_BQUEUES_RESETS     8
+#define TEST_BQUEUES_TRANSFERS  10000
+
+static BuffersQueue bq;
+static VirtualTimer vt;
+static bool_t reset_done;
+
+/*
+ * Returns the data size of the current full buffer, the data is emitted
+ * as tokens.
+ */
+static size_t bq_emit_full(void) {
+  uint8_t *buf;
+  size_t i, n;
+
+  chSysLock();
+  buf = bqGetFullBufferI(&bq, &n);
+  chSysUnlock();
+  if (buf == NULL)
+    return 0;
+  for (i = 0; i < n; i++)
+    test_emit_token(buf[i]);
+  return n;
+}
+
+/*
+ * Emits a token representing the message returned by a queue function.
+ */
+static void bq_emit_msg(msg_t msg) {
+
+  test_emit_token(msg == Q_OK ? 'O' : msg == Q_RESET ? 'R' : 'T');
+}
+
+static void bq_reset(void *p) {
+
+  chSysLockFromIsr();
+  bqResetI((BuffersQueue *)p);
+  reset_done = TRUE;
+  chSysUnlockFromIsr();
+}
+
+static void bqueues_teardown(void) {
+
+  chVTReset(&vt);
+}
+
+/**
+ * @page test_bqueues_001 Buffers functionality and APIs
+ *
+ * <h2>Description</h2>
+ * Buffers are filled and posted, then obtained and released using the
+ * I-class APIs, the queue state is checked at each step. Threads waiting
+ * for full or empty buffers are then resumed by a post, by a release and
+ * by a reset of the queue, timeouts are also tested.
+ */
+
+static void bqueues1_setup(void) {
+
+  bqObjectInit(&bq, wa[4], TEST_BQUEUES_SIZE, TEST_BQUEUES_NUM,
+               NULL, NULL, NULL);
+}
+
+static msg_t thread1(void *p) {
+  uint8_t *buf;
+  size_t n;
+
+  if (p == NULL)
+    bq_emit_msg(bqGetFullBufferTimeout(&bq, &buf, &n, MS2ST(200)));
+  else
+    bq_emit_msg(bqGetEmptyBufferTimeout(&bq, &buf, MS2ST(200)));
+  return 0;
+}
+
+static void bqueues1_execute(void) {
+  uint8_t *buf;
+  size_t i, n;
+
+  /* Initial empty state.*/
+  test_assert_lock(1, bqIsEmptyI(&bq), "not empty");
+  test_assert_lock(2, bqGetEmptyI(&bq) == TEST_BQUEUES_NUM, "wrong count");
+  test_assert_lock(3, bqGetFullBufferI(&bq, &n) == NULL, "not empty");
+
+  /* Queue filling, the same buffer is returned until it is posted.*/
+  for (i = 0; i < TEST_BQUEUES_NUM; i++) {
+    chSysLock();
+    buf = bqGetEmptyBufferI(&bq);
+    chSysUnlock();
+    test_assert(4, buf != NULL, "no empty buffer");
+    test_assert_lock(5, bqGetEmptyBufferI(&bq) == buf, "buffer changed");
+    for (n = 0; n <= i; n++)
+      buf[n] = 'A' + i;
+    chSysLock();
+    bqPostFullBufferI(&bq, i + 1);
+    chSysUnlock();
+  }
+  test_assert_lock(6, bqIsFullI(&bq), "still has space");
+  test_assert_lock(7, bqGetEmptyBufferI(&bq) == NULL, "not full");
+
+  /* Queue emptying, the buffers carry the posted sizes.*/
+  for (i = 0; i < TEST_BQUEUES_NUM; i++) {
+    test_assert(8, bq_emit_full() == i + 1, "wrong size");
+    chSysLock();
+    bqReleaseEmptyBufferI(&bq);
+    chSysUnlock();
+  }
+  test_assert_lock(9, bqIsEmptyI(&bq), "still full");
+  test_assert_sequence(10, "ABBCCC");
+
+  /* Timeouts on both sides.*/
+  test_assert(11, bqGetFullBufferTimeout(&bq, &buf, &n, TIME_IMMEDIATE) ==
+                  Q_TIMEOUT, "wrong timeout return");
+  test_assert(12, bqGetFullBufferTimeout(&bq, &buf, &n, 10) == Q_TIMEOUT,
+              "wrong timeout return");
+  for (i = 0; i < TEST_BQUEUES_NUM; i++) {
+    test_assert(13, bqGetEmptyBufferTimeout(&bq, &buf, TIME_IMMEDIATE) ==
+                    Q_OK, "no empty buffer");
+    bqPostFullBuffer(&bq, 1);
+  }
+  test_assert(14, bqGetEmptyBufferTimeout(&bq, &buf, 10) == Q_TIMEOUT,
+              "wrong timeout return");
+
+  /* Thread waiting for an empty buffer, resumed by a release.*/
+  threads[0] = chThdCreateStatic(wa[0], WA_SIZE, chThdGetPriority()+1,
+                                 thread1, &bq);
+  bqReleaseEmptyBuffer(&bq);
+  test_wait_threads();
+
+  /* Thread waiting for a full buffer, resumed by a post.*/
+  chSysLock();
+  bqResetI(&bq);
+  chSysUnlock();
+  threads[0] = chThdCreateStatic(wa[0], WA_SIZE, chThdGetPriority()+1,
+                                 thread1, NULL);
+  bqPostFullBuffer(&bq, 1);
+  test_wait_threads();
+
+  /* Threads waiting on both sides, resumed by a reset.*/
+  chSysLock();
+  bqResetI(&bq);
+  chSysUnlock();
+  threads[0] = chThdCreateStatic(wa[0], WA_SIZE, chThdGetPriority()+1,
+                                 thread1, NULL);
+  chSysLock();
+  bqResetI(&bq);
+  chSchRescheduleS();
+  chSysUnlock();
+  test_wait_threads();
+  for (i = 0; i < TEST_BQUEUES_NUM; i++)
+    bqPostFullBuffer(&bq, 1);
+  threads[0] = chThdCreateStatic(wa[0], WA_SIZE, chThdGetPriority()+1,
+                                 thread1, &bq);
+  chSysLock();
+  bqResetI(&bq);
+  chSchRescheduleS();
+  chSysUnlock();
+  test_wait_threads();
+  test_assert_sequence(15, "OORR");
+  test_assert_lock(16, bqIsEmptyI(&bq), "not empty");
+}
+
+ROMCONST struct testcase testbqueues1 = {
+  "Buffers Queues, buffers APIs",
+  bqueues1_setup,
+  NULL,
+  bqueues1_execute
+};
+
+/**
+ * @page test_bqueues_002 Stream functionality and APIs
+ *
+ * <h2>Description</h2>
+ * Data is written into the queue using the stream APIs, the test expects
+ * the written data to be posted immediately when the consumer is idle and
+ * to be accumulated into a partially filled buffer while the consumer is
+ * busy. The partially filled buffer must be posted when the consumer
+ * releases its last buffer, when it becomes full or by @p bqFlush().<br>
+ * The data is then read using the stream APIs with reads spanning
+ * multiple buffers, timeouts are also tested.
+ */
+
+static void bqueues2_setup(void) {
+
+  bqObjectInit(&bq, wa[4], TEST_BQUEUES_SIZE, TEST_BQUEUES_NUM,
+               NULL, NULL, NULL);
+}
+
+static void bqueues2_execute(void) {
+  uint8_t buf[TEST_BQUEUES_SIZE * TEST_BQUEUES_NUM];
+  size_t i, n;
+
+  /* Consumer idle, the written data is posted immediately.*/
+  n = bqWriteTimeout(&bq, (const uint8_t *)"AB", 2, TIME_IMMEDIATE);
+  test_assert(1, n == 2, "wrong written size");
+  test_assert_lock(2, bqGetFullI(&bq) == 1, "not posted");
+
+  /* Consumer busy, the written data is accumulated.*/
+  test_assert(3, bqPutTimeout(&bq, 'C', TIME_IMMEDIATE) == Q_OK,
+              "wrong put return");
+  n = bqWriteTimeout(&bq, (const uint8_t *)"D", 1, TIME_IMMEDIATE);
+  test_assert(4, n == 1, "wrong written size");
+  test_assert_lock(5, bqGetFullI(&bq) == 1, "posted");
+
+  /* Releasing the last full buffer posts the accumulated data.*/
+  test_assert(6, bq_emit_full() == 2, "wrong size");
+  bqReleaseEmptyBuffer(&bq);
+  test_assert_lock(7, bqGetFullI(&bq) == 1, "not posted");
+  test_assert(8, bq_emit_full() == 2, "wrong size");
+  bqReleaseEmptyBuffer(&bq);
+  test_assert_sequence(9, "ABCD");
+
+  /* Consumer busy, a buffer is posted as soon as it is full.*/
+  n = bqWriteTimeout(&bq, (const uint8_t *)"A", 1, TIME_IMMEDIATE);
+  test_assert(10, n == 1, "wrong written size");
+  n = bqWriteTimeout(&bq, (const uint8_t *)"BCDEF", 5, TIME_IMMEDIATE);
+  test_assert(11, n == 5, "wrong written size");
+  test_assert_lock(12, bqGetFullI(&bq) == 2, "not posted");
+
+  /* Flushing posts the accumulated data, a second flush does nothing.*/
+  bqFlush(&bq);
+  test_assert_lock(13, bqGetFullI(&bq) == 3, "not posted");
+  bqFlush(&bq);
+  test_assert_lock(14, bqGetFullI(&bq) == 3, "posted");
+
+  /* Queue full, writes timeout.*/
+  test_assert(15, bqPutTimeout(&bq, 'G', TIME_IMMEDIATE) == Q_TIMEOUT,
+              "wrong timeout return");
+  test_assert(16, bqPutTimeout(&bq, 'G', 10) == Q_TIMEOUT,
+              "wrong timeout return");
+
+  /* Reads spanning buffers, the read stops when the queue is empty.*/
+  test_emit_token(bqGetTimeout(&bq, TIME_IMMEDIATE));
+  n = bqReadTimeout(&bq, buf, 3, TIME_IMMEDIATE);
+  test_assert(17, n == 3, "wrong read size");
+  for (i = 0; i < n; i++)
+    test_emit_token(buf[i]);
+  n = bqReadTimeout(&bq, buf, sizeof buf, TIME_IMMEDIATE);
+  test_assert(18, n == 2, "wrong read size");
+  for (i = 0; i < n; i++)
+    test_emit_token(buf[i]);
+  test_assert_sequence(19, "ABCDEF");
+  test_assert_lock(20, bqIsEmptyI(&bq), "not empty");
+
+  /* Queue empty, reads timeout.*/
+  test_assert(21, bqGetTimeout(&bq, TIME_IMMEDIATE) == Q_TIMEOUT,
+              "wrong timeout return");
+  test_assert(22, bqGetTimeout(&bq, 10) == Q_TIMEOUT,
+              "wrong timeout return");
+  n = bqReadTimeout(&bq, buf, sizeof buf, 10);
+  test_assert(23, n == 0, "wrong read size");
+}
+
+ROMCONST struct testcase testbqueues2 = {
+  "Buffers Queues, stream APIs",
+  bqueues2_setup,
+  NULL,
+  bqueues2_execute
+};
+
+/**
+ * @page test_bqueues_003 Reset during stream transfers
+ *
+ * <h2>Description</h2>
+ * Threads blocked in stream reads and writes are resumed by a reset of
+ * the queue, the test expects the amount of data transferred before the
+ * reset to be returned. The queue is then repeatedly reset by a virtual
+ * timer while data is written, the reset can happen while the data is
+ * copied outside the critical zone.<br>
+ * After each reset the data written into the queue must be posted without
+ * leftovers of the interrupted transfers.
+ */
+
+static void bqueues3_setup(void) {
+
+  bqObjectInit(&bq, wa[4], TEST_BQUEUES_SIZE, TEST_BQUEUES_NUM,
+               NULL, NULL, NULL);
+}
+
+static msg_t thread3(void *p) {
+  uint8_t buf[TEST_BQUEUES_SIZE * 2];
+
+  if (p == NULL)
+    test_emit_token('A' + bqReadTimeout(&bq, buf, sizeof buf,
+                                        TIME_INFINITE));
+  else
+    test_emit_token('A' + bqWriteTimeout(&bq, (const uint8_t *)p, 16,
+                                         TIME_INFINITE));
+  return 0;
+}
+
+static void bqueues3_execute(void) {
+  unsigned i, j;
+  size_t n;
+
+  /* Reader blocked after reading part of the data, resumed by a reset.*/
+  threads[0] = chThdCreateStatic(wa[0], WA_SIZE, chThdGetPriority()+1,
+                                 thread3, NULL);
+  n = bqWriteTimeout(&bq, (const uint8_t *)"ABC", 3, TIME_IMMEDIATE);
+  test_assert(1, n == 3, "wrong written size");
+  chSysLock();
+  bqResetI(&bq);
+  chSchRescheduleS();
+  chSysUnlock();
+  test_wait_threads();
+
+  /* Writer blocked on a full queue, resumed by a reset.*/
+  threads[0] = chThdCreateStatic(wa[0], WA_SIZE, chThdGetPriority()+1,
+                                 thread3, "ABCDEFGHIJKLMNOP");
+  test_assert_lock(2, bqIsFullI(&bq), "not full");
+  chSysLock();
+  bqResetI(&bq);
+  chSchRescheduleS();
+  chSysUnlock();
+  test_wait_threads();
+  test_assert_sequence(3, "DM");
+  test_assert_lock(4, bqIsEmptyI(&bq), "not empty");
+
+  /* Asynchronous resets while writing.*/
+  for (i = 0; i < TEST_BQUEUES_RESETS; i++) {
+    bqObjectInit(&bq, wa[4], TEST_BQUEUES_LARGE_SIZE, TEST_BQUEUES_LARGE_NUM,
+                 NULL, NULL, NULL);
+    reset_done = FALSE;
+    test_wait_tick();
+    chVTSet(&vt, 1, bq_reset, &bq);
+    for (j = 0; !reset_done && (j < TEST_BQUEUES_TRANSFERS); j++) {
+      n = bqWriteTimeout(&bq, wa[1], TEST_BQUEUES_LARGE_SIZE, TIME_IMMEDIATE);
+      test_assert(5, (n == 0) || (n == TEST_BQUEUES_LARGE_SIZE),
+                  "wrong written size");
+      chSysLock();
+      while (!bqIsEmptyI(&bq))
+        bqReleaseEmptyBufferI(&bq);
+      chSysUnlock();
+    }
+    while (!reset_done)
+      chThdSleep(1);
+
+    /* The interrupted write must not leave data behind.*/
+    test_assert_lock(6, bqIsEmptyI(&bq), "not empty");
+    n = bqWriteTimeout(&bq, (const uint8_t *)"AB", 2, TIME_IMMEDIATE);
+    test_assert(7, n == 2, "wrong written size");
+    test_assert(8, bq_emit_full() == 2, "wrong size");
+    bqReleaseEmptyBuffer(&bq);
+    test_assert_lock(9, bqIsEmptyI(&bq), "not empty");
+  }
+}
+
+ROMCONST struct testcase testbqueues3 = {
+  "Buffers Queues, reset during transfers",
+  bqueues3_setup,
+  bqueues_teardown,
+  bqueues3_execute
+};
+#endif /* CH_USE_QUEUES */
+
+/**
+ * @brief   Test sequence for buffers queues.
+ */
+ROMCONST struct testcase * ROMCONST patternbqueues[] = {
+#if CH_USE_QUEUES || defined(__DOXYGEN__)
+  &testbqueues1,
+  &testbqueues2,
+  &testbqueues3,
+#endif
+  NULL
+};
@@ -41,6 +41,7 @@
  *
  * <h2>Test Cases</h2>
  * - @subpage test_heap_001
+ * - @subpage test_heap_002
  * .
  * @file testheap.c
  * @brief Heap test source file
@@ -150,6 +151,87 @@ ROMCONST struct testcase testheap1 = {
   heap1_execute
 };
 
+#if CH_DBG_HEAP_PROFILING || defined(__DOXYGEN__)
+/**
+ * @page test_heap_002 Heap profiler test
+ *
+ * <h2>Description</h2>
+ * Blocks are allocated from a single call site and partially released, the
+ * test expects the heap profile to report the correct allocated bytes,
+ * high-water mark, fragments and call site counters. A binary dump of the
+ * profile is then generated and verified.
+ */
+
+static uint8_t heap2_dump[CH_HEAP_PROFILE_DUMP_SIZE];
+
+static void heap2_setup(void) {
+
+  chHeapInit(&test_heap, test.buffer, sizeof(union test_buffers));
+}
+
+static void heap2_execute(void) {
+  void *pa[3];
+  ch_heap_profile_t hp;
+  ch_heap_site_t *sp;
+  uint32_t magic;
+  size_t n, sz;
+  unsigned i;
+
+  (void)chHeapStatus(&test_heap, &sz);
+
+  /* Initial state.*/
+  chHeapGetProfile(&test_heap, &hp);
+  test_assert(1, (hp.hp_used == 0) && (hp.hp_peak == 0), "not empty");
+  test_assert(2, (hp.hp_fragments == 1) && (hp.hp_free == sz) &&
+                 (hp.hp_largest == sz), "wrong free space");
+
+  /* Allocations from the same call site.*/
+  for (i = 0; i < 3; i++)
+    pa[i] = chHeapAlloc(&test_heap, SIZE);
+  sp = ((union heap_header *)pa[0] - 1)->h.site;
+  test_assert(3, sp == ((union heap_header *)pa[2] - 1)->h.site,
+              "different call sites");
+  test_assert(4, (sp->hs_count >= 3) && (sp->hs_bytes >= SIZE * 3),
+              "wrong call site counters");
+  chHeapGetProfile(&test_heap, &hp);
+  test_assert(5, (hp.hp_used == SIZE * 3) && (hp.hp_peak == SIZE * 3),
+              "wrong allocated bytes");
+
+  /* Fragmentation and high-water mark.*/
+  chHeapFree(pa[1]);
+  chHeapGetProfile(&test_heap, &hp);
+  test_assert(6, (hp.hp_used == SIZE * 2) && (hp.hp_peak == SIZE * 3),
+              "wrong high-water mark");
+  test_assert(7, (hp.hp_fragments == 2) && (hp.hp_histogram[0] == 1),
+              "wrong fragments");
+  test_assert(8, hp.hp_largest == hp.hp_free - SIZE, "wrong largest block");
+  chHeapResetPeak(&test_heap);
+  chHeapGetProfile(&test_heap, &hp);
+  test_assert(9, hp.hp_peak == SIZE * 2, "peak not reset");
+
+  /* Binary dump.*/
+  test_assert(10, chHeapProfileDump(&test_heap, heap2_dump, 16) == 0,
+              "buffer overflow");
+  n = chHeapProfileDump(&test_heap, heap2_dump, sizeof heap2_dump);
+  test_assert(11, (n > 36) && (n <= sizeof heap2_dump), "wrong dump size");
+  magic = *(uint32_t *)heap2_dump;
+  test_assert(12, magic == CH_HEAP_PROFILE_MAGIC, "wrong magic");
+
+  chHeapFree(pa[0]);
+  chHeapFree(pa[2]);
+  chHeapGetProfile(&test_heap, &hp);
+  test_assert(13, (hp.hp_used == 0) && (hp.hp_fragments == 1) &&
+                  (hp.hp_free == sz), "heap not restored");
+}
+
+ROMCONST struct testcase testheap2 = {
+  "Heap, profiler",
+  heap2_setup,
+  NULL,
+  heap2_execute
+};
+#endif /* CH_DBG_HEAP_PROFILING */
+
 #endif /* CH_USE_HEAP.*/
 
 /**
@@ -158,6 +240,9 @@ ROMCONST struct testcase testheap1 = {
 ROMCONST struct testcase * ROMCONST patternheap[] = {
 #if (CH_USE_HEAP && !CH_USE_MALLOC_HEAP) || defined(__DOXYGEN__)
   &testheap1,
+#if CH_DBG_HEAP_PROFILING || defined(__DOXYGEN__)
+  &testheap2,
+#endif
 #endif
   NULL
 };
@@ -44,6 +44,8 @@
  *
  * <h2>Test Cases</h2>
  * - @subpage test_mbox_001
+ * - @subpage test_mbox_002
+ * - @subpage test_mbox_003
  * .
  * @file testmbox.c
  * @brief Mailboxes test source file
@@ -230,6 +232,192 @@ ROMCONST struct testcase testmbox1 = {
   mbox1_execute
 };
 
+/**
+ * @page test_mbox_002 Batched post and fetch
+ *
+ * <h2>Description</h2>
+ * Messages are posted/fetched from a mailbox in batches, partial transfers,
+ * wrap around and timeouts are tested, then a consumer and a producer
+ * thread are blocked on the mailbox and awakened by a batch transfer.<br>
+ * The test expects to find a consistent mailbox status after each operation.
+ */
+
+static void mbox2_setup(void) {
+
+  chMBInit(&mb1, (msg_t *)test.wa.T0, MB_SIZE);
+}
+
+static msg_t thread2(void *p) {
+  msg_t msgs[MB_SIZE];
+  cnt_t i, n;
+
+  (void)p;
+  n = chMBFetchN(&mb1, msgs, MB_SIZE, MS2ST(200));
+  for (i = 0; i < n; i++)
+    test_emit_token(msgs[i]);
+  test_emit_token('0' + n);
+  return 0;
+}
+
+static msg_t thread3(void *p) {
+  cnt_t n;
+
+  n = chMBPostN(&mb1, (const msg_t *)p, 3, MS2ST(200));
+  test_emit_token('0' + n);
+  return 0;
+}
+
+static void mbox2_execute(void) {
+  static const msg_t msgs[] = {'A', 'B', 'C', 'D', 'E', 'F', 'G', 'H'};
+  msg_t out[MB_SIZE];
+  cnt_t i, n;
+
+  /*
+   * Batch filling with partial transfers.
+   */
+  n = chMBPostN(&mb1, msgs, 3, TIME_IMMEDIATE);
+  test_assert(1, n == 3, "wrong posted count");
+  chSysLock();
+  n = chMBPostNI(&mb1, msgs + 3, 5);
+  chSysUnlock();
+  test_assert(2, n == 2, "wrong posted count");
+  test_assert_lock(3, chMBGetFreeCountI(&mb1) == 0, "still empty");
+  test_assert_lock(4, chMBGetUsedCountI(&mb1) == MB_SIZE, "not full");
+  n = chMBPostN(&mb1, msgs, 1, TIME_IMMEDIATE);
+  test_assert(5, n == 0, "posted into a full mailbox");
+
+  /*
+   * Batch emptying with wrap around.
+   */
+  n = chMBFetchN(&mb1, out, 2, TIME_IMMEDIATE);
+  test_assert(6, n == 2, "wrong fetched count");
+  for (i = 0; i < n; i++)
+    test_emit_token(out[i]);
+  n = chMBPostN(&mb1, msgs + 5, 3, TIME_IMMEDIATE);
+  test_assert(7, n == 2, "wrong posted count");
+  chSysLock();
+  n = chMBFetchNI(&mb1, out, MB_SIZE);
+  chSysUnlock();
+  test_assert(8, n == MB_SIZE, "wrong fetched count");
+  for (i = 0; i < n; i++)
+    test_emit_token(out[i]);
+  test_assert_sequence(9, "ABCDEFG");
+  test_assert_lock(10, chMBGetFreeCountI(&mb1) == MB_SIZE, "not empty");
+  test_assert_lock(11, chMBGetUsedCountI(&mb1) == 0, "still full");
+  test_assert(12, mb1.mb_rdptr == mb1.mb_wrptr, "pointers not aligned");
+  n = chMBFetchN(&mb1, out, MB_SIZE, TIME_IMMEDIATE);
+  test_assert(13, n == 0, "fetched from an empty mailbox");
+
+  /*
+   * Consumer blocked on the empty mailbox, a single batch wakes it.
+   */
+  threads[0] = chThdCreateStatic(wa[1], WA_SIZE, chThdGetPriority() + 1,
+                                 thread2, NULL);
+  n = chMBPostN(&mb1, msgs, 4, TIME_INFINITE);
+  test_wait_threads();
+  test_assert(14, n == 4, "wrong posted count");
+  test_assert_sequence(15, "ABCD4");
+
+  /*
+   * Producer blocked on the full mailbox, posts as many messages as the
+   * slots freed by a single batch.
+   */
+  n = chMBPostN(&mb1, msgs, MB_SIZE, TIME_IMMEDIATE);
+  test_assert(16, n == MB_SIZE, "wrong posted count");
+  threads[0] = chThdCreateStatic(wa[1], WA_SIZE, chThdGetPriority() + 1,
+                                 thread3, (void *)msgs);
+  n = chMBFetchN(&mb1, out, 2, TIME_INFINITE);
+  test_wait_threads();
+  test_assert(17, n == 2, "wrong fetched count");
+  test_assert_sequence(18, "2");
+  test_assert_lock(19, chMBGetUsedCountI(&mb1) == MB_SIZE, "not full");
+
+  /*
+   * Reset while a consumer is waiting.
+   */
+  chMBReset(&mb1);
+  threads[0] = chThdCreateStatic(wa[1], WA_SIZE, chThdGetPriority() + 1,
+                                 thread2, NULL);
+  chMBReset(&mb1);
+  test_wait_threads();
+  test_assert_sequence(20, "0");
+}
+
+ROMCONST struct testcase testmbox2 = {
+  "Mailboxes, batched post and fetch",
+  mbox2_setup,
+  NULL,
+  mbox2_execute
+};
+
+/**
+ * @page test_mbox_003 Multiple batch waiters
+ *
+ * <h2>Description</h2>
+ * Two consumer threads are blocked on an empty mailbox and awakened by
+ * transfers smaller than their batches, then two producer threads are
+ * blocked on a full mailbox and awakened the same way.<br>
+ * The test expects each awakened thread to transfer at least the message
+ * or slot its wait obtained and to find consistent semaphore counters
+ * after each phase.
+ */
+
+static void mbox3_execute(void) {
+  static const msg_t msgs[] = {'A', 'B', 'C', 'D', 'E'};
+  msg_t out[MB_SIZE];
+  cnt_t i, n;
+
+  /*
+   * Two consumers waiting on the empty mailbox.
+   */
+  threads[0] = chThdCreateStatic(wa[1], WA_SIZE, chThdGetPriority() + 2,
+                                 thread2, NULL);
+  threads[1] = chThdCreateStatic(wa[2], WA_SIZE, chThdGetPriority() + 1,
+                                 thread2, NULL);
+  n = chMBPostN(&mb1, msgs, 1, TIME_INFINITE);
+  test_assert(1, n == 1, "wrong posted count");
+  n = chMBPostN(&mb1, msgs + 1, 2, TIME_INFINITE);
+  test_assert(2, n == 2, "wrong posted count");
+  test_wait_threads();
+  test_assert_sequence(3, "A1BC2");
+  test_assert_lock(4, chSemGetCounterI(&mb1.mb_fullsem) == 0,
+                   "wrong full counter");
+  test_assert_lock(5, chSemGetCounterI(&mb1.mb_emptysem) == MB_SIZE,
+                   "wrong empty counter");
+
+  /*
+   * Two producers waiting on the full mailbox.
+   */
+  n = chMBPostN(&mb1, msgs, MB_SIZE, TIME_IMMEDIATE);
+  test_assert(6, n == MB_SIZE, "wrong posted count");
+  threads[0] = chThdCreateStatic(wa[1], WA_SIZE, chThdGetPriority() + 2,
+                                 thread3, (void *)msgs);
+  threads[1] = chThdCreateStatic(wa[2], WA_SIZE, chThdGetPriority() + 1,
+                                 thread3, (void *)msgs);
+  n = chMBFetchN(&mb1, out, 1, TIME_INFINITE);
+  test_assert(7, n == 1, "wrong fetched count");
+  n = chMBFetchN(&mb1, out, 2, TIME_INFINITE);
+  test_assert(8, n == 2, "wrong fetched count");
+  test_wait_threads();
+  test_assert_sequence(9, "12");
+  test_assert_lock(10, chSemGetCounterI(&mb1.mb_fullsem) == MB_SIZE,
+                   "wrong full counter");
+  test_assert_lock(11, chSemGetCounterI(&mb1.mb_emptysem) == 0,
+                   "wrong empty counter");
+  n = chMBFetchN(&mb1, out, MB_SIZE, TIME_IMMEDIATE);
+  test_assert(12, n == MB_SIZE, "wrong fetched count");
+  for (i = 0; i < n; i++)
+    test_emit_token(out[i]);
+  test_assert_sequence(13, "DEAAB");
+}
+
+ROMCONST struct testcase testmbox3 = {
+  "Mailboxes, multiple batch waiters",
+  mbox2_setup,
+  NULL,
+  mbox3_execute
+};
+
 #endif /* CH_USE_MAILBOXES */
 
 /**
@@ -238,6 +426,8 @@ ROMCONST struct testcase testmbox1 = {
 ROMCONST struct testcase * ROMCONST patternmbox[] = {
 #if CH_USE_MAILBOXES || defined(__DOXYGEN__)
   &testmbox1,
+  &testmbox2,
+  &testmbox3,
 #endif
   NULL
 };
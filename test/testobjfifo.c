@@ -0,0 +1,183 @@
+/*
+    ChibiOS/RT - Copyright (C) 2006,2007,2008,2009,2010,
+                 2011,2012,2013 Giovanni Di Sirio.
+
+    This file is part of ChibiOS/RT.
+
+    ChibiOS/RT is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    ChibiOS/RT is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "ch.h"
+#include "test.h"
+
+/**
+ * @page test_objfifo Objects FIFOs test
+ *
+ * File: @ref testobjfifo.c
+ *
+ * <h2>Description</h2>
+ * This module implements the test sequence for the @ref objfifos subsystem.
+ *
+ * <h2>Objective</h2>
+ * Objective of the test module is to cover 100% of the @ref objfifos
+ * subsystem code.<br>
+ * Note that the @ref objfifos subsystem depends on the @ref mailboxes and
+ * @ref pools subsystems that have to met their testing objectives as well.
+ *
+ * <h2>Preconditions</h2>
+ * The module requires the following kernel options:
+ * - @p CH_USE_OBJFIFOS
+ * .
+ * In case some of the required options are not enabled then some or all tests
+ * may be skipped.
+ *
+ * <h2>Test Cases</h2>
+ * - @subpage test_objfifo_001
+ * .
+ * @file testobjfifo.c
+ * @brief Objects FIFOs test source file
+ * @file testobjfifo.h
+ * @brief Objects FIFOs header file
+ */
+
+#if CH_USE_OBJFIFOS || defined(__DOXYGEN__)
+
+#define FIFO_SIZE 4
+
+typedef struct {
+  char                  token;
+  uint32_t              data;
+} record_t;
+
+static ObjectsFifo of1;
+static OBJECTSFIFO_STORAGE(of1_storage, record_t, FIFO_SIZE);
+
+/**
+ * @page test_objfifo_001 Queuing and timeouts
+ *
+ * <h2>Description</h2>
+ * Objects are allocated, posted, fetched and freed in sequences designed
+ * to empty and fill the FIFO, a consumer thread is then made wait on the
+ * empty FIFO.<br>
+ * The test expects to find a consistent FIFO status after each operation,
+ * the objects to be fetched in the posting order and the operations on a
+ * full or empty FIFO to time out.
+ */
+
+static void objfifo1_setup(void) {
+
+  chFifoInitStorage(&of1, &of1_storage);
+}
+
+static msg_t thread1(void *p) {
+  record_t *rp;
+  int i;
+
+  (void)p;
+  for (i = 0; i < FIFO_SIZE; i++) {
+    if (chFifoFetchTimeout(&of1, (void **)&rp, MS2ST(500)) != RDY_OK)
+      break;
+    test_emit_token(rp->token);
+    chFifoFree(&of1, rp);
+  }
+  return 0;
+}
+
+static void objfifo1_execute(void) {
+  record_t *objs[FIFO_SIZE], *rp;
+  msg_t msg;
+  int i;
+
+  /* Initial state.*/
+  test_assert_lock(1, chFifoGetFreeCountI(&of1) == FIFO_SIZE,
+                   "wrong free count");
+  test_assert_lock(2, chFifoGetUsedCountI(&of1) == 0, "not empty");
+  test_assert_lock(3, chFifoPeekI(&of1) == NULL, "not empty");
+
+  /* Allocating all the objects, the next allocation must time out.*/
+  for (i = 0; i < FIFO_SIZE; i++) {
+    objs[i] = chFifoAllocTimeout(&of1, TIME_IMMEDIATE);
+    test_assert(4, objs[i] != NULL, "allocation failed");
+    objs[i]->data = (uint32_t)i;
+  }
+  test_assert(5, chFifoAllocTimeout(&of1, TIME_IMMEDIATE) == NULL,
+              "allocation not failed");
+  test_assert(6, chFifoAllocTimeout(&of1, MS2ST(10)) == NULL,
+              "allocation not failed");
+
+  /* Posting all the objects.*/
+  for (i = 0; i < FIFO_SIZE; i++)
+    chFifoPost(&of1, objs[i]);
+  test_assert_lock(7, chFifoGetUsedCountI(&of1) == FIFO_SIZE, "not full");
+  test_assert_lock(8, chFifoPeekI(&of1) == objs[0], "wrong peeked object");
+
+  /* Fetching and freeing all the objects, FIFO order expected.*/
+  for (i = 0; i < FIFO_SIZE; i++) {
+    msg = chFifoFetchTimeout(&of1, (void **)&rp, TIME_IMMEDIATE);
+    test_assert(9, msg == RDY_OK, "wrong wake-up message");
+    test_assert(10, rp->data == (uint32_t)i, "wrong object");
+    chFifoFree(&of1, rp);
+  }
+  msg = chFifoFetchTimeout(&of1, (void **)&rp, TIME_IMMEDIATE);
+  test_assert(11, msg == RDY_TIMEOUT, "wrong wake-up message");
+  msg = chFifoFetchTimeout(&of1, (void **)&rp, MS2ST(10));
+  test_assert(12, msg == RDY_TIMEOUT, "wrong wake-up message");
+  test_assert_lock(13, chFifoGetFreeCountI(&of1) == FIFO_SIZE,
+                   "wrong free count");
+
+  /* A consumer thread waits on the FIFO.*/
+  threads[0] = chThdCreateStatic(wa[0], WA_SIZE, chThdGetPriority()+1,
+                                 thread1, NULL);
+  for (i = 0; i < FIFO_SIZE; i++) {
+    rp = chFifoAlloc(&of1);
+    rp->token = 'A' + i;
+    chFifoPost(&of1, rp);
+  }
+  test_wait_threads();
+  test_assert_sequence(14, "ABCD");
+
+  /* I-class variants.*/
+  chSysLock();
+  rp = chFifoAllocI(&of1);
+  chFifoPostI(&of1, rp);
+  chSysUnlock();
+  test_assert_lock(15, chFifoPeekI(&of1) == rp, "wrong peeked object");
+  chSysLock();
+  msg = chFifoFetchI(&of1, (void **)&objs[0]);
+  chFifoFreeI(&of1, objs[0]);
+  chSysUnlock();
+  test_assert(16, msg == RDY_OK, "wrong wake-up message");
+  test_assert(17, objs[0] == rp, "wrong object");
+  test_assert_lock(18, chFifoGetFreeCountI(&of1) == FIFO_SIZE,
+                   "wrong free count");
+}
+
+ROMCONST struct testcase testobjfifo1 = {
+  "Objects FIFOs, queuing and timeouts",
+  objfifo1_setup,
+  NULL,
+  objfifo1_execute
+};
+
+#endif /* CH_USE_OBJFIFOS */
+
+/**
+ * @brief   Test sequence for objects FIFOs.
+ */
+ROMCONST struct testcase * ROMCONST patternobjfifo[] = {
+#if CH_USE_OBJFIFOS || defined(__DOXYGEN__)
+  &testobjfifo1,
+#endif
+  NULL
+};
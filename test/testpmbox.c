@@ -0,0 +1,214 @@
+/*
+    ChibiOS/RT - Copyright (C) 2006,2007,2008,2009,2010,
+                 2011,2012,2013 Giovanni Di Sirio.
+
+    This file is part of ChibiOS/RT.
+
+    ChibiOS/RT is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    ChibiOS/RT is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "ch.h"
+#include "test.h"
+
+/**
+ * @page test_pmbox Priority mailboxes test
+ *
+ * File: @ref testpmbox.c
+ *
+ * <h2>Description</h2>
+ * This module implements the test sequence for the @ref pmailboxes
+ * subsystem.
+ *
+ * <h2>Objective</h2>
+ * Objective of the test module is to cover 100% of the @ref pmailboxes
+ * subsystem code.<br>
+ * Note that the @ref pmailboxes subsystem depends on the @ref semaphores
+ * subsystem that has to met its testing objectives as well.
+ *
+ * <h2>Preconditions</h2>
+ * The module requires the following kernel options:
+ * - @p CH_USE_PRIO_MAILBOXES
+ * .
+ * In case some of the required options are not enabled then some or all tests
+ * may be skipped.
+ *
+ * <h2>Test Cases</h2>
+ * - @subpage test_pmbox_001
+ * .
+ * @file testpmbox.c
+ * @brief Priority mailboxes test source file
+ * @file testpmbox.h
+ * @brief Priority mailboxes header file
+ */
+
+#if CH_USE_PRIO_MAILBOXES || defined(__DOXYGEN__)
+
+#define PMB_LANES 3
+
+static msg_t lane0_buf[2];
+static msg_t lane1_buf[3];
+static msg_t lane2_buf[4];
+
+/*
+ * Note, the static initializers are not really required because the
+ * variables are explicitly initialized in each test case. It is done in order
+ * to test the macros.
+ */
+static MailboxLane lanes[PMB_LANES] = {
+  _MAILBOX_LANE_DATA(lanes[0], lane0_buf, 2),
+  _MAILBOX_LANE_DATA(lanes[1], lane1_buf, 3),
+  _MAILBOX_LANE_DATA(lanes[2], lane2_buf, 4)
+};
+static PRIORITY_MAILBOX_DECL(pmb1, lanes, PMB_LANES);
+
+/**
+ * @page test_pmbox_001 Lanes ordering, capacity and timeouts
+ *
+ * <h2>Description</h2>
+ * Messages are posted in lanes of different priority and then fetched, the
+ * messages are expected to come out in priority order and in FIFO order
+ * within each lane. A full lane is expected to time out without affecting
+ * the other lanes. Waiting threads are then tested on both sides of the
+ * mailbox, including the reset of a mailbox with a waiting poster.
+ */
+
+static void pmbox1_setup(void) {
+
+  chPMBLaneInit(&lanes[0], lane0_buf, 2);
+  chPMBLaneInit(&lanes[1], lane1_buf, 3);
+  chPMBLaneInit(&lanes[2], lane2_buf, 4);
+  chPMBInit(&pmb1, lanes, PMB_LANES);
+}
+
+static msg_t thread1(void *p) {
+  msg_t msg;
+  cnt_t prio;
+
+  (void)p;
+  if (chPMBFetch(&pmb1, &msg, &prio, MS2ST(500)) == RDY_OK) {
+    test_emit_token((char)msg);
+    test_emit_token('0' + (char)prio);
+  }
+  return 0;
+}
+
+static msg_t thread2(void *p) {
+
+  if (chPMBPost(&pmb1, (msg_t)p, 0, TIME_INFINITE) == RDY_RESET)
+    test_emit_token('R');
+  return 0;
+}
+
+static void pmbox1_execute(void) {
+  msg_t msg, msgs[9];
+  cnt_t prio, i;
+
+  /* Initial state.*/
+  test_assert_lock(1, chPMBGetLanesI(&pmb1) == PMB_LANES, "wrong lanes");
+  test_assert_lock(2, chPMBGetUsedCountI(&pmb1) == 0, "not empty");
+  test_assert(3, chPMBFetch(&pmb1, &msg, NULL, TIME_IMMEDIATE) == RDY_TIMEOUT,
+              "not empty");
+
+  /* Mixed priority posts, the lowest lane is filled.*/
+  chPMBPost(&pmb1, 'A', 0, TIME_INFINITE);
+  chPMBPost(&pmb1, 'B', 1, TIME_INFINITE);
+  chPMBPost(&pmb1, 'C', 0, TIME_INFINITE);
+  chPMBPost(&pmb1, 'D', 2, TIME_INFINITE);
+  chPMBPost(&pmb1, 'E', 1, TIME_INFINITE);
+  test_assert_lock(4, chPMBGetUsedCountI(&pmb1) == 5, "wrong used count");
+  test_assert_lock(5, chPMBGetLaneFreeCountI(&pmb1, 0) == 0, "lane not full");
+  test_assert_lock(6, chPMBGetLaneUsedCountI(&pmb1, 1) == 2,
+                   "wrong lane count");
+
+  /* The full lane times out, the other lanes are not affected.*/
+  msg = chPMBPost(&pmb1, 'X', 0, TIME_IMMEDIATE);
+  test_assert(7, msg == RDY_TIMEOUT, "wrong wake-up message");
+  msg = chPMBPost(&pmb1, 'X', 0, MS2ST(10));
+  test_assert(8, msg == RDY_TIMEOUT, "wrong wake-up message");
+  chSysLock();
+  msg = chPMBPostI(&pmb1, 'X', 0);
+  chSysUnlock();
+  test_assert(9, msg == RDY_TIMEOUT, "wrong wake-up message");
+  chSysLock();
+  msg = chPMBPostI(&pmb1, 'F', 2);
+  chSysUnlock();
+  test_assert(10, msg == RDY_OK, "wrong wake-up message");
+
+  /* Fetching, priority order then FIFO order within a lane.*/
+  for (i = 0; i < 6; i++) {
+    msg = chPMBFetch(&pmb1, &msgs[i], &prio, TIME_IMMEDIATE);
+    test_assert(11, msg == RDY_OK, "wrong wake-up message");
+    test_emit_token((char)msgs[i]);
+    test_emit_token('0' + (char)prio);
+  }
+  test_assert_sequence(12, "D2F2B1E1A0C0");
+  chSysLock();
+  msg = chPMBFetchI(&pmb1, &msgs[0], NULL);
+  chSysUnlock();
+  test_assert(13, msg == RDY_TIMEOUT, "wrong wake-up message");
+  msg = chPMBFetch(&pmb1, &msgs[0], NULL, MS2ST(10));
+  test_assert(14, msg == RDY_TIMEOUT, "wrong wake-up message");
+  test_assert_lock(15, pmb1.pmb_map == 0, "lanes map not empty");
+
+  /* Filling all the lanes, then fetching with the I-class variant.*/
+  for (i = 0; i < 9; i++)
+    chPMBPost(&pmb1, 'a' + i, i < 2 ? 0 : (i < 5 ? 1 : 2), TIME_IMMEDIATE);
+  test_assert_lock(16, chPMBGetUsedCountI(&pmb1) == 9, "not full");
+  for (i = 0; i < 9; i++) {
+    chSysLock();
+    msg = chPMBFetchI(&pmb1, &msgs[i], NULL);
+    chSysUnlock();
+    test_assert(17, msg == RDY_OK, "wrong wake-up message");
+    test_emit_token((char)msgs[i]);
+  }
+  test_assert_sequence(18, "fghicdeab");
+
+  /* A consumer thread waits on the empty mailbox.*/
+  threads[0] = chThdCreateStatic(wa[0], WA_SIZE, chThdGetPriority()+1,
+                                 thread1, NULL);
+  chPMBPost(&pmb1, 'Z', 1, TIME_INFINITE);
+  test_wait_threads();
+  test_assert_sequence(19, "Z1");
+
+  /* A producer thread waits on the full lane, then the mailbox is reset.*/
+  chPMBPost(&pmb1, 'A', 0, TIME_INFINITE);
+  chPMBPost(&pmb1, 'B', 0, TIME_INFINITE);
+  threads[0] = chThdCreateStatic(wa[0], WA_SIZE, chThdGetPriority()+1,
+                                 thread2, (void *)'C');
+  chPMBReset(&pmb1);
+  test_wait_threads();
+  test_assert_sequence(20, "R");
+  test_assert_lock(21, chPMBGetUsedCountI(&pmb1) == 0, "not empty");
+  test_assert_lock(22, chPMBGetLaneFreeCountI(&pmb1, 0) == 2,
+                   "wrong free count");
+}
+
+ROMCONST struct testcase testpmbox1 = {
+  "Priority mailboxes, lanes ordering and timeouts",
+  pmbox1_setup,
+  NULL,
+  pmbox1_execute
+};
+
+#endif /* CH_USE_PRIO_MAILBOXES */
+
+/**
+ * @brief   Test sequence for priority mailboxes.
+ */
+ROMCONST struct testcase * ROMCONST patternpmbox[] = {
+#if CH_USE_PRIO_MAILBOXES || defined(__DOXYGEN__)
+  &testpmbox1,
+#endif
+  NULL
+};
@@ -35,12 +35,16 @@
  * <h2>Preconditions</h2>
  * The module requires the following kernel options:
  * - @p CH_USE_MEMPOOLS
+ * - @p CH_USE_SEMAPHORES (test case 002 only)
  * .
  * In case some of the required options are not enabled then some or all tests
  * may be skipped.
  *
  * <h2>Test Cases</h2>
  * - @subpage test_pools_001
+ * - @subpage test_pools_002
+ * - @subpage test_pools_003
+ * - @subpage test_pools_004
  * .
  * @file testpools.c
  * @brief Memory Pools test source file
@@ -108,6 +112,269 @@ ROMCONST struct testcase testpools1 = {
   pools1_execute
 };
 
+#if CH_USE_SEMAPHORES || defined(__DOXYGEN__)
+/**
+ * @page test_pools_002 Guarded pool test
+ *
+ * <h2>Description</h2>
+ * Four objects are loaded into a guarded memory pool and allocated, then
+ * a thread is made wait on the empty pool and released by freeing an
+ * object.<br>
+ * The test expects the allocations to time out when the pool is empty, the
+ * waiting thread to be served when an object is returned and the minimum
+ * free objects statistic to be updated.
+ */
+
+static GUARDEDMEMORYPOOL_DECL(gmp1, 16);
+static void *gmp1_objects[4][16 / sizeof(void *)];
+
+static void pools2_setup(void) {
+
+  chGuardedPoolInit(&gmp1, 16);
+}
+
+static msg_t thread1(void *p) {
+  void *objp;
+
+  objp = chGuardedPoolAllocTimeout(&gmp1, MS2ST(500));
+  if (objp != NULL) {
+    test_emit_token(*(char *)p);
+    chGuardedPoolFree(&gmp1, objp);
+  }
+  return 0;
+}
+
+static void pools2_execute(void) {
+  void *objs[4];
+  int i;
+
+  /* Loading the pool.*/
+  chGuardedPoolLoadArray(&gmp1, gmp1_objects, 4);
+  test_assert(1, chGuardedPoolGetMinFree(&gmp1) == 4, "wrong min free");
+
+  /* Emptying the pool.*/
+  for (i = 0; i < 4; i++) {
+    objs[i] = chGuardedPoolAllocTimeout(&gmp1, TIME_IMMEDIATE);
+    test_assert(2, objs[i] != NULL, "list empty");
+  }
+  test_assert(3, chGuardedPoolGetMinFree(&gmp1) == 0, "wrong min free");
+
+  /* Now must be empty, allocations time out.*/
+  test_assert(4, chGuardedPoolAllocTimeout(&gmp1, TIME_IMMEDIATE) == NULL,
+              "list not empty");
+  test_assert(5, chGuardedPoolAllocTimeout(&gmp1, MS2ST(10)) == NULL,
+              "list not empty");
+
+  /* Two threads wait for an object, releasing objects wakes them up in
+     order, the minimum free count does not go below zero while the second
+     thread is still waiting.*/
+  threads[0] = chThdCreateStatic(wa[0], WA_SIZE, chThdGetPriority()+1,
+                                 thread1, "A");
+  threads[1] = chThdCreateStatic(wa[1], WA_SIZE, chThdGetPriority()+1,
+                                 thread1, "B");
+  chGuardedPoolFree(&gmp1, objs[0]);
+  chGuardedPoolFree(&gmp1, objs[1]);
+  test_wait_threads();
+  test_assert_sequence(6, "AB");
+  test_assert(7, chGuardedPoolGetMinFree(&gmp1) == 0, "wrong min free");
+  test_assert_lock(8, chGuardedPoolGetFreeI(&gmp1) == 2, "wrong free count");
+  objs[1] = chGuardedPoolAllocTimeout(&gmp1, TIME_IMMEDIATE);
+
+  /* I-class allocation and free.*/
+  chSysLock();
+  objs[0] = chGuardedPoolAllocI(&gmp1);
+  chSysUnlock();
+  test_assert(9, objs[0] != NULL, "list empty");
+  test_assert_lock(10, chGuardedPoolAllocI(&gmp1) == NULL, "list not empty");
+  chSysLock();
+  chGuardedPoolFreeI(&gmp1, objs[0]);
+  chSysUnlock();
+  test_assert(11, chGuardedPoolGetMinFree(&gmp1) == 0, "wrong min free");
+}
+
+ROMCONST struct testcase testpools2 = {
+  "Memory Pools, guarded pool",
+  pools2_setup,
+  NULL,
+  pools2_execute
+};
+#endif /* CH_USE_SEMAPHORES */
+
+/**
+ * @page test_pools_003 Concurrent access test
+ *
+ * <h2>Description</h2>
+ * Five threads allocate objects from a pool containing fewer objects,
+ * write a signature in the objects, yield and then verify the signature
+ * before freeing the objects back.<br>
+ * The test expects each object to be owned by a single thread at time and
+ * to find all the objects in the pool at the end, the test is meaningful
+ * for the lock-free pools when the threads can be preempted.
+ */
+
+#define POOLS3_OBJECTS  3
+#define POOLS3_CYCLES   1000
+
+static MEMORYPOOL_DECL(mp2, sizeof(uint32_t) * 4, NULL);
+static uint32_t pools3_objects[POOLS3_OBJECTS][4];
+static bool_t pools3_error;
+
+static void pools3_setup(void) {
+
+  chPoolInit(&mp2, sizeof(uint32_t) * 4, NULL);
+  pools3_error = FALSE;
+}
+
+static msg_t thread2(void *p) {
+  uint32_t *objp;
+  unsigned i, j;
+
+  for (i = 0; i < POOLS3_CYCLES; i++) {
+    if ((i & 1) == 0)
+      objp = chPoolAlloc(&mp2);
+    else {
+      chSysLock();
+      objp = chPoolAllocI(&mp2);
+      chSysUnlock();
+    }
+    if (objp != NULL) {
+      for (j = 0; j < 4; j++)
+        objp[j] = (uint32_t)(uintptr_t)p + j;
+      chThdYield();
+      for (j = 0; j < 4; j++)
+        if (objp[j] != (uint32_t)(uintptr_t)p + j)
+          pools3_error = TRUE;
+      chPoolFree(&mp2, objp);
+    }
+    chThdYield();
+  }
+  return 0;
+}
+
+static void pools3_execute(void) {
+  tprio_t prio = chThdGetPriority();
+  int i;
+
+  chPoolLoadArray(&mp2, pools3_objects, POOLS3_OBJECTS);
+
+  threads[0] = chThdCreateStatic(wa[0], WA_SIZE, prio-1, thread2, (void *)1);
+  threads[1] = chThdCreateStatic(wa[1], WA_SIZE, prio-1, thread2, (void *)2);
+  threads[2] = chThdCreateStatic(wa[2], WA_SIZE, prio-1, thread2, (void *)3);
+  threads[3] = chThdCreateStatic(wa[3], WA_SIZE, prio-1, thread2, (void *)4);
+  threads[4] = chThdCreateStatic(wa[4], WA_SIZE, prio-1, thread2, (void *)5);
+  test_wait_threads();
+  test_assert(1, !pools3_error, "object shared between threads");
+
+  /* All the objects must be back in the pool.*/
+  for (i = 0; i < POOLS3_OBJECTS; i++)
+    test_assert(2, chPoolAlloc(&mp2) != NULL, "list empty");
+  test_assert(3, chPoolAlloc(&mp2) == NULL, "list not empty");
+}
+
+ROMCONST struct testcase testpools3 = {
+  "Memory Pools, concurrent access",
+  pools3_setup,
+  NULL,
+  pools3_execute
+};
+
+/**
+ * @page test_pools_004 Interrupt side concurrent access test
+ *
+ * <h2>Description</h2>
+ * Three threads of the same priority allocate objects from a pool, write a
+ * signature in the objects, verify it and free the objects back in a tight
+ * loop while a virtual timer callback does the same from the tick interrupt
+ * on every tick. The threads never yield, they switch only on interrupts
+ * and on the round robin.<br>
+ * The test expects each object to be owned by a single context at time and
+ * to find all the objects in the pool at the end. With the lock-free pools
+ * the interrupt side allocations interleave with the threads fast paths on
+ * the real targets and on the preemptive simulator.
+ */
+
+#define POOLS4_DURATION 200
+
+static VirtualTimer pools4_vt;
+static volatile bool_t pools4_stop;
+
+static bool_t pools4_check(uint32_t *objp, uint32_t sig) {
+  unsigned j;
+
+  for (j = 0; j < 4; j++)
+    objp[j] = sig;
+  for (j = 0; j < 4; j++)
+    if (objp[j] != sig)
+      return FALSE;
+  return TRUE;
+}
+
+static void pools4_cb(void *p) {
+  uint32_t *objp;
+
+  (void)p;
+  chSysLockFromIsr();
+  if ((objp = chPoolAllocI(&mp2)) != NULL) {
+    if (!pools4_check(objp, 0xFFFFFFFF))
+      pools3_error = TRUE;
+    chPoolFreeI(&mp2, objp);
+  }
+  if (!pools4_stop)
+    chVTSetI(&pools4_vt, 1, pools4_cb, NULL);
+  chSysUnlockFromIsr();
+}
+
+static msg_t thread3(void *p) {
+  uint32_t *objp;
+
+  while (!pools4_stop) {
+    if ((objp = chPoolAlloc(&mp2)) != NULL) {
+      if (!pools4_check(objp, (uint32_t)(uintptr_t)p))
+        pools3_error = TRUE;
+      chPoolFree(&mp2, objp);
+    }
+#if defined(SIMULATOR)
+    ChkIntSources();
+#endif
+  }
+  return 0;
+}
+
+static void pools4_execute(void) {
+  tprio_t prio = chThdGetPriority();
+  int i;
+
+  chPoolLoadArray(&mp2, pools3_objects, POOLS3_OBJECTS);
+  pools4_stop = FALSE;
+
+  threads[0] = chThdCreateStatic(wa[0], WA_SIZE, prio-1, thread3, (void *)1);
+  threads[1] = chThdCreateStatic(wa[1], WA_SIZE, prio-1, thread3, (void *)2);
+  threads[2] = chThdCreateStatic(wa[2], WA_SIZE, prio-1, thread3, (void *)3);
+  chSysLock();
+  chVTSetI(&pools4_vt, 1, pools4_cb, NULL);
+  chSysUnlock();
+  chThdSleepMilliseconds(POOLS4_DURATION);
+  chSysLock();
+  pools4_stop = TRUE;
+  if (chVTIsArmedI(&pools4_vt))
+    chVTResetI(&pools4_vt);
+  chSysUnlock();
+  test_wait_threads();
+  test_assert(1, !pools3_error, "object shared between contexts");
+
+  /* All the objects must be back in the pool.*/
+  for (i = 0; i < POOLS3_OBJECTS; i++)
+    test_assert(2, chPoolAlloc(&mp2) != NULL, "list empty");
+  test_assert(3, chPoolAlloc(&mp2) == NULL, "list not empty");
+}
+
+ROMCONST struct testcase testpools4 = {
+  "Memory Pools, interrupt side concurrent access",
+  pools3_setup,
+  NULL,
+  pools4_execute
+};
+
 #endif /* CH_USE_MEMPOOLS */
 
 /*
@@ -116,6 +383,11 @@ ROMCONST struct testcase testpools1 = {
 ROMCONST struct testcase * ROMCONST patternpools[] = {
 #if CH_USE_MEMPOOLS || defined(__DOXYGEN__)
   &testpools1,
+#if CH_USE_SEMAPHORES || defined(__DOXYGEN__)
+  &testpools2,
+#endif
+  &testpools3,
+  &testpools4,
 #endif
   NULL
 };
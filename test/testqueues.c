@@ -47,6 +47,7 @@
  * <h2>Test Cases</h2>
  * - @subpage test_queues_001
  * - @subpage test_queues_002
+ * - @subpage test_queues_003
  * .
  * @file testqueues.c
  * @brief I/O Queues test source file
@@ -234,6 +235,123 @@ ROMCONST struct testcase testqueues2 = {
   NULL,
   queues2_execute
 };
+
+/**
+ * @page test_queues_003 Queues bulk and span APIs
+ *
+ * <h2>Description</h2>
+ * Blocks of data are transferred through an @p InputQueue and an
+ * @p OutputQueue using the bulk and span APIs, the transfers are arranged
+ * in order to wrap around the queue buffers.<br>
+ * The test expects the spans to be limited to the contiguous regions and
+ * the data to be extracted in the correct sequence.
+ */
+
+static void queues3_setup(void) {
+
+  chIQInit(&iq, wa[0], TEST_QUEUES_SIZE, notify, NULL);
+  chOQInit(&oq, wa[1], TEST_QUEUES_SIZE, notify, NULL);
+}
+
+static void queues3_execute(void) {
+  uint8_t buf[TEST_QUEUES_SIZE * 2];
+  uint8_t *bp;
+  size_t i, n;
+
+  /* Input queue, bulk write and read wrapping around the buffer.*/
+  chSysLock();
+  n = chIQWriteI(&iq, (const uint8_t *)"ABC", 3);
+  chSysUnlock();
+  test_assert(1, n == 3, "wrong written size");
+  n = chIQReadTimeout(&iq, buf, 2, TIME_IMMEDIATE);
+  test_assert(2, n == 2, "wrong read size");
+  for (i = 0; i < n; i++)
+    test_emit_token(buf[i]);
+  chSysLock();
+  n = chIQWriteI(&iq, (const uint8_t *)"DEFG", 4);
+  chSysUnlock();
+  test_assert(3, n == 3, "wrong written size");
+  test_assert_lock(4, chIQIsFullI(&iq), "not full");
+
+  /* Input queue, reading in place.*/
+  do {
+    chSysLock();
+    n = chIQGetReadSpanI(&iq, &bp);
+    chSysUnlock();
+    for (i = 0; i < n; i++)
+      test_emit_token(bp[i]);
+    chSysLock();
+    chIQReadCommitS(&iq, n);
+    chSysUnlock();
+    test_assert(5, n <= TEST_QUEUES_SIZE / 2, "span not contiguous");
+  } while (n > 0);
+  test_assert_lock(6, chIQIsEmptyI(&iq), "not empty");
+
+  /* Input queue, writing in place.*/
+  chSysLock();
+  n = chIQGetWriteSpanI(&iq, &bp);
+  chSysUnlock();
+  test_assert(7, n == TEST_QUEUES_SIZE / 2, "wrong span size");
+  bp[0] = 'G';
+  bp[1] = 'H';
+  chSysLock();
+  chIQWriteCommitI(&iq, n);
+  chSysUnlock();
+  n = chIQReadTimeout(&iq, buf, sizeof buf, TIME_IMMEDIATE);
+  test_assert(8, n == 2, "wrong read size");
+  for (i = 0; i < n; i++)
+    test_emit_token(buf[i]);
+  test_assert_sequence(9, "ABCDEFGH");
+
+  /* Output queue, bulk write and read wrapping around the buffer.*/
+  n = chOQWriteTimeout(&oq, (const uint8_t *)"ABC", 3, TIME_IMMEDIATE);
+  test_assert(10, n == 3, "wrong written size");
+  chSysLock();
+  n = chOQReadI(&oq, buf, 2);
+  chSysUnlock();
+  test_assert(11, n == 2, "wrong read size");
+  for (i = 0; i < n; i++)
+    test_emit_token(buf[i]);
+  n = chOQWriteTimeout(&oq, (const uint8_t *)"DEFG", 4, TIME_IMMEDIATE);
+  test_assert(12, n == 3, "wrong written size");
+
+  /* Output queue, reading in place.*/
+  do {
+    chSysLock();
+    n = chOQGetReadSpanI(&oq, &bp);
+    chSysUnlock();
+    for (i = 0; i < n; i++)
+      test_emit_token(bp[i]);
+    chSysLock();
+    chOQReadCommitI(&oq, n);
+    chSysUnlock();
+    test_assert(13, n <= TEST_QUEUES_SIZE / 2, "span not contiguous");
+  } while (n > 0);
+  test_assert_lock(14, chOQIsEmptyI(&oq), "not empty");
+
+  /* Output queue, writing in place.*/
+  chSysLock();
+  n = chOQGetWriteSpanI(&oq, &bp);
+  chSysUnlock();
+  test_assert(15, n == TEST_QUEUES_SIZE / 2, "wrong span size");
+  bp[0] = 'G';
+  bp[1] = 'H';
+  chSysLock();
+  chOQWriteCommitS(&oq, n);
+  n = chOQReadI(&oq, buf, sizeof buf);
+  chSysUnlock();
+  test_assert(16, n == 2, "wrong read size");
+  for (i = 0; i < n; i++)
+    test_emit_token(buf[i]);
+  test_assert_sequence(17, "ABCDEFGH");
+}
+
+ROMCONST struct testcase testqueues3 = {
+  "Queues, bulk and span APIs",
+  queues3_setup,
+  NULL,
+  queues3_execute
+};
 #endif /* CH_USE_QUEUES */
 
 /**
@@ -243,6 +361,7 @@ ROMCONST struct testcase * ROMCONST patternqueues[] = {
 #if CH_USE_QUEUES || defined(__DOXYGEN__)
   &testqueues1,
   &testqueues2,
+  &testqueues3,
 #endif
   NULL
 };
@@ -0,0 +1,251 @@
+/*
+    ChibiOS/RT - Copyright (C) 2006,2007,2008,2009,2010,
+                 2011,2012,2013 Giovanni Di Sirio.
+
+    This file is part of ChibiOS/RT.
+
+    ChibiOS/RT is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    ChibiOS/RT is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "ch.h"
+#include "test.h"
+
+/**
+ * @page test_rings Ring Buffers test
+ *
+ * File: @ref testrings.c
+ *
+ * <h2>Description</h2>
+ * This module implements the test sequence for the @ref rings subsystem.
+ * The tests are performed by inserting and removing data from ring buffers
+ * and by checking both the buffers status and the correct sequence of the
+ * extracted data.
+ *
+ * <h2>Objective</h2>
+ * Objective of the test module is to cover 100% of the @ref rings
+ * subsystem code.<br>
+ * Note that the @ref rings subsystem depends on the @ref binary_semaphores
+ * subsystem that has to met its testing objectives as well.
+ *
+ * <h2>Preconditions</h2>
+ * The module requires the following kernel options:
+ * - @p CH_USE_RINGS (and dependent options)
+ * .
+ * In case some of the required options are not enabled then some or all tests
+ * may be skipped.
+ *
+ * <h2>Test Cases</h2>
+ * - @subpage test_rings_001
+ * - @subpage test_rings_002
+ * .
+ * @file testrings.c
+ * @brief Ring Buffers test source file
+ * @file testrings.h
+ * @brief Ring Buffers test header file
+ */
+
+#if CH_USE_RINGS || defined(__DOXYGEN__)
+
+#define RING_SIZE 4
+
+typedef struct {
+  char                  token;
+  uint32_t              data;
+} record_t;
+
+static uint8_t bytes[RING_SIZE];
+static record_t records[RING_SIZE];
+
+/*
+ * Note, the static initializers are not really required because the
+ * variables are explicitly initialized in each test case. It is done in order
+ * to test the macros.
+ */
+static RINGBUFFER_DECL(rb1, bytes, sizeof (uint8_t), RING_SIZE);
+static RINGBUFFER_DECL(rb2, records, sizeof (record_t), RING_SIZE);
+
+/**
+ * @page test_rings_001 Byte ring buffers
+ *
+ * <h2>Description</h2>
+ * This test case tests the byte APIs of a @p RingBuffer object, a consumer
+ * thread is blocked on the empty buffer and is awakened by a write, by a
+ * reset or by a timeout. The buffer state must remain consistent through
+ * the whole test.
+ */
+
+static void rings1_setup(void) {
+
+  chRingInit(&rb1, bytes, sizeof (uint8_t), RING_SIZE);
+}
+
+static msg_t thread1(void *p) {
+  msg_t msg;
+
+  msg = chRingGetTimeout(&rb1, MS2ST(200));
+  if (msg >= 0)
+    test_emit_token((char)msg);
+  else if (msg == RING_RESET)
+    test_emit_token(*(char *)p);
+  return 0;
+}
+
+static void rings1_execute(void) {
+  unsigned i;
+
+  /* Initial empty state */
+  test_assert(1, chRingGetUsed(&rb1) == 0, "not empty");
+  test_assert(2, chRingGetEmpty(&rb1) == RING_SIZE, "wrong empty count");
+
+  /* Buffer filling */
+  chSysLock();
+  for (i = 0; i < RING_SIZE; i++)
+    chRingPutI(&rb1, 'A' + i);
+  chSysUnlock();
+  test_assert(3, chRingGetUsed(&rb1) == RING_SIZE, "still has space");
+  test_assert_lock(4, chRingPutI(&rb1, 0) == RING_FULL,
+                   "failed to report RING_FULL");
+
+  /* Buffer emptying */
+  for (i = 0; i < RING_SIZE; i++)
+    test_emit_token(chRingGet(&rb1));
+  test_assert(5, chRingGetUsed(&rb1) == 0, "still full");
+  test_assert_sequence(6, "ABCD");
+
+  /* Indexes wrapping around the buffer end */
+  for (i = 0; i < RING_SIZE * 2; i++) {
+    chSysLock();
+    chRingPutI(&rb1, 'A' + i);
+    chRingPutI(&rb1, 'a' + i);
+    chSysUnlock();
+    test_emit_token(chRingGet(&rb1));
+    test_emit_token(chRingGet(&rb1));
+  }
+  test_assert_sequence(7, "AaBbCcDdEeFfGgHh");
+  test_assert(8, chRingGetUsed(&rb1) == 0, "not empty");
+
+  /* Consumer blocked on the empty buffer and awakened by a write */
+  threads[0] = chThdCreateStatic(wa[0], WA_SIZE, chThdGetPriority()+1,
+                                 thread1, "R");
+  chSysLock();
+  chRingPutI(&rb1, 'A');
+  chSchRescheduleS();
+  chSysUnlock();
+  test_wait_threads();
+  test_assert_sequence(9, "A");
+
+  /* Consumer blocked on the empty buffer and awakened by a reset */
+  threads[0] = chThdCreateStatic(wa[0], WA_SIZE, chThdGetPriority()+1,
+                                 thread1, "R");
+  chSysLock();
+  chRingResetI(&rb1);
+  chSchRescheduleS();
+  chSysUnlock();
+  test_wait_threads();
+  test_assert_sequence(10, "R");
+  test_assert(11, chRingGetUsed(&rb1) == 0, "not empty");
+
+  /* Timeouts */
+  test_assert(12, chRingGetTimeout(&rb1, TIME_IMMEDIATE) == RING_TIMEOUT,
+              "wrong timeout return");
+  test_assert(13, chRingGetTimeout(&rb1, 10) == RING_TIMEOUT,
+              "wrong timeout return");
+}
+
+ROMCONST struct testcase testrings1 = {
+  "Rings, byte ring buffers",
+  rings1_setup,
+  NULL,
+  rings1_execute
+};
+
+/**
+ * @page test_rings_002 Record ring buffers
+ *
+ * <h2>Description</h2>
+ * This test case tests the record APIs of a @p RingBuffer object, records
+ * are written and read back checking the content and the sequence of the
+ * extracted records.
+ */
+
+static void rings2_setup(void) {
+
+  chRingInit(&rb2, records, sizeof (record_t), RING_SIZE);
+}
+
+static msg_t thread2(void *p) {
+  record_t r;
+
+  (void)p;
+  if (chRingGetRecordTimeout(&rb2, &r, MS2ST(200)) == RING_OK)
+    test_emit_token(r.token);
+  return 0;
+}
+
+static void rings2_execute(void) {
+  unsigned i;
+  record_t r;
+
+  /* Buffer filling */
+  for (i = 0; i < RING_SIZE; i++) {
+    r.token = 'A' + i;
+    r.data = 0x55AA0000 + i;
+    test_assert_lock(1, chRingPutRecordI(&rb2, &r) == RING_OK, "put failed");
+  }
+  test_assert_lock(2, chRingPutRecordI(&rb2, &r) == RING_FULL,
+                   "failed to report RING_FULL");
+
+  /* Buffer emptying */
+  for (i = 0; i < RING_SIZE; i++) {
+    msg_t msg = chRingGetRecordTimeout(&rb2, &r, TIME_IMMEDIATE);
+    test_assert(3, msg == RING_OK, "get failed");
+    test_assert(4, r.data == 0x55AA0000 + i, "wrong record data");
+    test_emit_token(r.token);
+  }
+  test_assert_sequence(5, "ABCD");
+  test_assert(6,
+              chRingGetRecordTimeout(&rb2, &r, TIME_IMMEDIATE) == RING_TIMEOUT,
+              "wrong timeout return");
+
+  /* Consumer blocked on the empty buffer and awakened by a write */
+  threads[0] = chThdCreateStatic(wa[0], WA_SIZE, chThdGetPriority()+1,
+                                 thread2, NULL);
+  r.token = 'E';
+  chSysLock();
+  chRingPutRecordI(&rb2, &r);
+  chSchRescheduleS();
+  chSysUnlock();
+  test_wait_threads();
+  test_assert_sequence(7, "E");
+}
+
+ROMCONST struct testcase testrings2 = {
+  "Rings, record ring buffers",
+  rings2_setup,
+  NULL,
+  rings2_execute
+};
+
+#endif /* CH_USE_RINGS */
+
+/**
+ * @brief   Test sequence for ring buffers.
+ */
+ROMCONST struct testcase * ROMCONST patternrings[] = {
+#if CH_USE_RINGS || defined(__DOXYGEN__)
+  &testrings1,
+  &testrings2,
+#endif
+  NULL
+};
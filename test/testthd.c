@@ -44,6 +44,7 @@
  * - @subpage test_threads_002
  * - @subpage test_threads_003
  * - @subpage test_threads_004
+ * - @subpage test_threads_005
  * .
  * @file testthd.c
  * @brief Threads and Scheduler test source file
@@ -223,6 +224,50 @@ ROMCONST struct testcase testthd4 = {
   thd4_execute
 };
 
+#if (CH_USE_REGISTRY && CH_DBG_FILL_THREADS) || defined(__DOXYGEN__)
+/**
+ * @page test_threads_005 Threads stack usage
+ *
+ * <h2>Description</h2>
+ * A thread using a known amount of stack is created and its peak stack
+ * usage is measured after termination.<br>
+ * The test expects the reported working area size to match and the peak
+ * usage to be at least the amount of stack used by the thread.
+ */
+
+static msg_t thread5(void *p) {
+  volatile uint8_t buf[128];
+  unsigned i;
+
+  (void)p;
+  for (i = 0; i < sizeof buf; i++)
+    buf[i] = 0;
+  return buf[0];
+}
+
+static void thd5_execute(void) {
+  Thread *tp;
+  size_t size, used;
+
+  tp = threads[0] = chThdCreateStatic(wa[0], WA_SIZE, chThdGetPriority() - 1,
+                                      thread5, NULL);
+  test_wait_threads();
+  used = chRegGetStackUsage(tp, &size);
+  test_assert(1, size == WA_SIZE, "wrong working area size");
+  test_assert(2, (used >= sizeof(Thread) + 128) && (used <= WA_SIZE),
+              "wrong stack usage");
+  used = chRegGetStackUsage(chThdSelf(), &size);
+  test_assert(3, (size >= used), "wrong stack usage");
+}
+
+ROMCONST struct testcase testthd5 = {
+  "Threads, stack usage",
+  NULL,
+  NULL,
+  thd5_execute
+};
+#endif /* CH_USE_REGISTRY && CH_DBG_FILL_THREADS */
+
 /**
  * @brief   Test sequence for threads.
  */
@@ -231,5 +276,8 @@ ROMCONST struct testcase * ROMCONST patternthd[] = {
   &testthd2,
   &testthd3,
   &testthd4,
+#if CH_USE_REGISTRY && CH_DBG_FILL_THREADS
+  &testthd5,
+#endif
   NULL
 };
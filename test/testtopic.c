@@ -0,0 +1,206 @@
+/*
+    ChibiOS/RT - Copyright (C) 2006,2007,2008,2009,2010,
+                 2011,2012,2013 Giovanni Di Sirio.
+
+    This file is part of ChibiOS/RT.
+
+    ChibiOS/RT is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    ChibiOS/RT is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "ch.h"
+#include "test.h"
+
+/**
+ * @page test_topic Topics test
+ *
+ * File: @ref testtopic.c
+ *
+ * <h2>Description</h2>
+ * This module implements the test sequence for the @ref topics subsystem.
+ *
+ * <h2>Objective</h2>
+ * Objective of the test module is to cover 100% of the @ref topics
+ * subsystem code.<br>
+ * Note that the @ref topics subsystem depends on the @ref events subsystem
+ * that has to met its testing objectives as well.
+ *
+ * <h2>Preconditions</h2>
+ * The module requires the following kernel options:
+ * - @p CH_USE_TOPICS
+ * .
+ * In case some of the required options are not enabled then some or all tests
+ * may be skipped.
+ *
+ * <h2>Test Cases</h2>
+ * - @subpage test_topic_001
+ * .
+ * @file testtopic.c
+ * @brief Topics test source file
+ * @file testtopic.h
+ * @brief Topics header file
+ */
+
+#if CH_USE_TOPICS || defined(__DOXYGEN__)
+
+#define TOPIC_DEPTH 4
+
+typedef struct {
+  uint32_t              seq;
+  uint32_t              data[2];
+} sample_t;
+
+static sample_t samples[TOPIC_DEPTH];
+
+/*
+ * Note, the static initializer is not really required because the variable
+ * is explicitly initialized in the test case. It is done in order to test
+ * the macros.
+ */
+static TOPIC_DECL(tp1, samples, sizeof(sample_t), TOPIC_DEPTH);
+
+/**
+ * @page test_topic_001 Latest-value and queued subscriptions
+ *
+ * <h2>Description</h2>
+ * Samples are published on a topic having a latest-value subscriber and
+ * two queued subscribers of different depth, the subscribers are then read
+ * and the received samples and counters are checked, a thread is then
+ * made wait for a sample.<br>
+ * The test expects the latest-value subscriber to only see the most recent
+ * sample, the queued subscribers to see the samples in publishing order
+ * within their depth and the skipped samples to be accounted as dropped.
+ */
+
+static void topic1_setup(void) {
+
+  chTopicInit(&tp1, samples, sizeof(sample_t), TOPIC_DEPTH);
+}
+
+static void publish(uint32_t seq) {
+  sample_t s;
+
+  s.seq = seq;
+  s.data[0] = seq * 2;
+  s.data[1] = ~seq;
+  chTopicPublish(&tp1, &s);
+}
+
+static msg_t thread1(void *p) {
+  TopicSubscriber sub;
+  sample_t s;
+
+  (void)p;
+  chTopicSubscribe(&tp1, &sub, EVENT_MASK(0), TOPIC_LATEST);
+  if (chTopicReceiveTimeout(&sub, &s, MS2ST(500)) == RDY_OK)
+    test_emit_token('A' + (char)s.seq);
+  chTopicUnsubscribe(&sub);
+  return 0;
+}
+
+static void topic1_execute(void) {
+  TopicSubscriber latest, q2, q4;
+  sample_t s;
+  msg_t msg;
+  uint32_t i;
+
+  chTopicSubscribe(&tp1, &latest, EVENT_MASK(0), TOPIC_LATEST);
+  chTopicSubscribe(&tp1, &q2, EVENT_MASK(1), 2);
+  chTopicSubscribe(&tp1, &q4, EVENT_MASK(2), TOPIC_DEPTH);
+  chEvtGetAndClearEvents(ALL_EVENTS);
+
+  /* Nothing published yet.*/
+  test_assert(1, chTopicReceive(&latest, &s) == RDY_TIMEOUT, "not empty");
+  test_assert(2, chTopicReceive(&q4, &s) == RDY_TIMEOUT, "not empty");
+
+  /* Three samples, all the subscribers are notified.*/
+  for (i = 1; i <= 3; i++)
+    publish(i);
+  test_assert(3, chEvtGetAndClearEvents(ALL_EVENTS) ==
+                 (EVENT_MASK(0) | EVENT_MASK(1) | EVENT_MASK(2)),
+              "wrong events");
+  test_assert(4, chEvtGetAndClearFlags(&q2.s_el) == TOPIC_PUBLISHED,
+              "wrong flags");
+  test_assert(5, chTopicGetPublished(&tp1) == 3, "wrong publish counter");
+  test_assert(6, chTopicGetPending(&q4) == 3, "wrong pending counter");
+
+  /* Latest-value subscriber.*/
+  msg = chTopicReceive(&latest, &s);
+  test_assert(7, (msg == RDY_OK) && (s.seq == 3) && (s.data[0] == 6) &&
+                 (s.data[1] == ~(uint32_t)3), "wrong sample");
+  test_assert(8, chTopicReceive(&latest, &s) == RDY_TIMEOUT, "not empty");
+  test_assert(9, (chTopicGetReceived(&latest) == 1) &&
+                 (chTopicGetDropped(&latest) == 2), "wrong counters");
+
+  /* Queued subscriber of depth two, the oldest sample is dropped.*/
+  for (i = 2; i <= 3; i++) {
+    msg = chTopicReceive(&q2, &s);
+    test_assert(10, (msg == RDY_OK) && (s.seq == i), "wrong sample");
+  }
+  test_assert(11, chTopicReceive(&q2, &s) == RDY_TIMEOUT, "not empty");
+  test_assert(12, chTopicGetDropped(&q2) == 1, "wrong drop counter");
+
+  /* Queued subscriber of full depth, reading while publishing.*/
+  msg = chTopicReceive(&q4, &s);
+  test_assert(13, (msg == RDY_OK) && (s.seq == 1), "wrong sample");
+  for (i = 4; i <= 9; i++)
+    publish(i);
+  for (i = 6; i <= 9; i++) {
+    msg = chTopicReceive(&q4, &s);
+    test_assert(14, (msg == RDY_OK) && (s.seq == i), "wrong sample");
+  }
+  test_assert(15, chTopicReceive(&q4, &s) == RDY_TIMEOUT, "not empty");
+  test_assert(16, (chTopicGetReceived(&q4) == 5) &&
+                  (chTopicGetDropped(&q4) == 4), "wrong counters");
+
+  /* I-class publish.*/
+  s.seq = 10;
+  chSysLock();
+  chTopicPublishI(&tp1, &s);
+  chSysUnlock();
+  msg = chTopicReceiveTimeout(&latest, &s, TIME_IMMEDIATE);
+  test_assert(17, (msg == RDY_OK) && (s.seq == 10), "wrong sample");
+  msg = chTopicReceiveTimeout(&latest, &s, MS2ST(10));
+  test_assert(18, msg == RDY_TIMEOUT, "wrong wake-up message");
+
+  chTopicUnsubscribe(&latest);
+  chTopicUnsubscribe(&q2);
+  chTopicUnsubscribe(&q4);
+  chEvtGetAndClearEvents(ALL_EVENTS);
+
+  /* A thread waits for a sample.*/
+  threads[0] = chThdCreateStatic(wa[0], WA_SIZE, chThdGetPriority()+1,
+                                 thread1, NULL);
+  publish(1);
+  test_wait_threads();
+  test_assert_sequence(19, "B");
+}
+
+ROMCONST struct testcase testtopic1 = {
+  "Topics, latest-value and queued subscriptions",
+  topic1_setup,
+  NULL,
+  topic1_execute
+};
+
+#endif /* CH_USE_TOPICS */
+
+/**
+ * @brief   Test sequence for topics.
+ */
+ROMCONST struct testcase * ROMCONST patterntopic[] = {
+#if CH_USE_TOPICS || defined(__DOXYGEN__)
+  &testtopic1,
+#endif
+  NULL
+};
@@ -0,0 +1,158 @@
+#!/usr/bin/env python3
+#
+# ChibiOS/RT benchmarks results comparison.
+#
+# Compares two results files produced by the benchmarks harness, see
+# TestBenchmarks() and the "bench" command of the Posix simulator demo, and
+# flags the scores that regressed beyond a threshold. Both the JSON and the
+# CSV formats are accepted, also mixed. The scores are matched by benchmark
+# name and metric, rates ("/S" units) are expected to grow, sizes to shrink.
+#
+# Differences in the build information and in the kernel configuration of
+# the two files are reported because they usually explain the changes.
+#
+# The exit code is 1 if a score regressed or if a benchmark failed in the
+# new results, 0 otherwise.
+#
+# Usage: chbenchcmp.py [--threshold PCT] [--stat min|median|max] [--all]
+#                      base new
+#
+
+import argparse
+import csv
+import io
+import json
+import sys
+
+STATS = ("min", "median", "max")
+
+
+def load(path):
+    """Returns the build information, the configuration and the scores of
+    a results file, the scores are indexed by (benchmark, metric)."""
+    with open(path, "r", newline="") as f:
+        text = f.read()
+    # Anything preceding the results, like the simulator banner, is skipped.
+    start = text.find("{")
+    header = text.find("index,benchmark,")
+    if start >= 0 and (header < 0 or start < header):
+        return load_json(text[start:])
+    return load_csv(text)
+
+
+def load_json(text):
+    doc = json.loads(text)
+    info = {k: v for k, v in doc.items() if isinstance(v, str)}
+    scores = {}
+    for bmk in doc.get("benchmarks", []):
+        if bmk.get("failed") and not bmk.get("scores"):
+            scores[(bmk["name"], None)] = {"failed": True}
+        for s in bmk.get("scores", []):
+            entry = {k: s[k] for k in STATS}
+            entry["unit"] = s["unit"]
+            entry["failed"] = bool(bmk.get("failed"))
+            scores[(bmk["name"], s["metric"])] = entry
+    return info, doc.get("config", {}), scores
+
+
+def load_csv(text):
+    info, config, scores = {}, {}, {}
+    rows = []
+    for line in text.splitlines():
+        if line.startswith("#"):
+            fields = next(csv.reader([line[1:].strip()]))
+            if fields[0] == "config" and len(fields) == 3:
+                config[fields[1]] = int(fields[2])
+            elif len(fields) == 2 and fields[0] != "repeat":
+                info[fields[0]] = fields[1]
+        elif line.strip():
+            rows.append(line)
+    if not rows or not rows[0].startswith("index,"):
+        raise SystemExit("not a benchmarks results file")
+    for row in csv.DictReader(io.StringIO("\n".join(rows))):
+        failed = row["failed"] == "1"
+        if not row["metric"]:
+            scores[(row["benchmark"], None)] = {"failed": failed}
+            continue
+        entry = {k: int(row[k]) for k in STATS}
+        entry["unit"] = row["unit"]
+        entry["failed"] = failed
+        scores[(row["benchmark"], row["metric"])] = entry
+    return info, config, scores
+
+
+def higher_is_better(unit):
+    return unit.endswith("/S")
+
+
+def main():
+    ap = argparse.ArgumentParser(description="ChibiOS/RT benchmarks "
+                                 "results comparison")
+    ap.add_argument("--threshold", type=float, default=5.0,
+                    help="regression threshold in percent, default 5")
+    ap.add_argument("--stat", choices=STATS, default="median",
+                    help="compared statistic, default median")
+    ap.add_argument("--all", action="store_true",
+                    help="list all the scores, not only the flagged ones")
+    ap.add_argument("base", help="reference results, JSON or CSV")
+    ap.add_argument("new", help="new results, JSON or CSV")
+    args = ap.parse_args()
+
+    binfo, bconfig, bscores = load(args.base)
+    ninfo, nconfig, nscores = load(args.new)
+
+    out = sys.stdout
+    for key in sorted(set(binfo) | set(ninfo)):
+        if key != "compiled" and binfo.get(key) != ninfo.get(key):
+            out.write("build  %-26s %s -> %s\n" %
+                      (key, binfo.get(key, "-"), ninfo.get(key, "-")))
+    for key in sorted(set(bconfig) | set(nconfig)):
+        if bconfig.get(key) != nconfig.get(key):
+            out.write("config %-26s %s -> %s\n" %
+                      (key, bconfig.get(key, "-"), nconfig.get(key, "-")))
+
+    regressions = failures = 0
+    lines = []
+    for key in sorted(set(bscores) | set(nscores),
+                      key=lambda k: (k[0], k[1] or "")):
+        name = key[0] if key[1] is None else "%s / %s" % key
+        base, new = bscores.get(key), nscores.get(key)
+        if new is not None and new["failed"]:
+            failures += 1
+            lines.append(("FAILED", name, "", "", ""))
+            continue
+        if key[1] is None:
+            continue
+        if base is None or new is None:
+            # Scores present in only one of the files, different selections
+            # or configurations.
+            if args.all:
+                    lines.append(("new" if base is None else "missing", name,
+                              "-" if base is None else base[args.stat],
+                              "-" if new is None else new[args.stat], ""))
+            continue
+        b, n = base[args.stat], new[args.stat]
+        change = 100.0 * (n - b) / b if b else 0.0
+        worse = -change if higher_is_better(new["unit"]) else change
+        flag = ""
+        if worse > args.threshold:
+            flag = "REGRESSION"
+            regressions += 1
+        elif -worse > args.threshold:
+            flag = "improved"
+        if flag or args.all:
+            lines.append((flag, name, b, n, "%+.1f%%" % change))
+
+    if lines:
+        out.write("\n%-10s %-56s %10s %10s %8s\n" %
+                  ("", "benchmark / metric", "base", "new", "change"))
+        for flag, name, b, n, change in lines:
+            out.write("%-10s %-56s %10s %10s %8s\n" %
+                      (flag, name, b, n, change))
+    out.write("\n%d regressions beyond %.1f%% (%s), %d failures\n" %
+              (regressions, args.threshold, args.stat, failures))
+    sys.exit(1 if regressions or failures else 0)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,174 @@
+#!/usr/bin/env python3
+#
+# ChibiOS/RT binary log decoder.
+#
+# Decodes a binary log stream produced by the binlog module in BINLOG_BINARY
+# mode. The format strings, and the constant strings passed as %s
+# arguments, are read from the firmware ELF file at the addresses stored in
+# the records.
+#
+# Usage: binlog.py firmware.elf logfile
+#
+
+import argparse
+import re
+import struct
+import sys
+
+MAGIC = 0x474F4C42
+VERSION = 1
+DROPPED = 0xFF
+SHT_NOBITS = 8
+
+SPEC = re.compile(r"%(-?)(\.?)(\d*|\*)(?:\.(\d*|\*))?([lL]?)(.)")
+
+
+class Elf:
+    """Minimal ELF reader, maps addresses to the initialized sections."""
+
+    def __init__(self, path):
+        with open(path, "rb") as f:
+            self.data = f.read()
+        if self.data[:4] != b"\x7fELF":
+            raise SystemExit("%s: not an ELF file" % path)
+        is64 = self.data[4] == 2
+        self.endian = "<" if self.data[5] == 1 else ">"
+        if is64:
+            shoff, = struct.unpack_from(self.endian + "Q", self.data, 0x28)
+            shentsize, shnum = struct.unpack_from(self.endian + "HH",
+                                                  self.data, 0x3A)
+            layout = "IIQQQQIIQQ"
+        else:
+            shoff, = struct.unpack_from(self.endian + "I", self.data, 0x20)
+            shentsize, shnum = struct.unpack_from(self.endian + "HH",
+                                                  self.data, 0x2E)
+            layout = "IIIIIIIIII"
+        self.sections = []
+        for i in range(shnum):
+            f = struct.unpack_from(self.endian + layout, self.data,
+                                   shoff + i * shentsize)
+            stype, addr, offset, size = f[1], f[3], f[4], f[5]
+            if addr != 0 and stype != SHT_NOBITS:
+                self.sections.append((addr, offset, size))
+
+    def string(self, addr):
+        """Returns the C string at the specified address or None."""
+        for base, offset, size in self.sections:
+            if base <= addr < base + size:
+                start = offset + addr - base
+                end = self.data.find(b"\0", start, offset + size)
+                if end < 0:
+                    end = offset + size
+                return self.data[start:end].decode("latin-1")
+        return None
+
+
+def signed(value, bits):
+    if value & (1 << (bits - 1)):
+        value -= 1 << bits
+    return value
+
+
+def format_record(elf, fmt, args, argbits):
+    """Formats a record the same way chprintf() would do."""
+    out = []
+    pos = 0
+    args = list(args)
+    for m in SPEC.finditer(fmt):
+        out.append(fmt[pos:m.start()])
+        pos = m.end()
+        left, zero, width, precision, is_long, conv = m.groups()
+        if width == "*":
+            width = str(args.pop(0) if args else 0)
+        if precision == "*":
+            precision = str(args.pop(0) if args else 0)
+        is_long = is_long != "" or conv.isupper()
+        arg = args.pop(0) if args and conv in "cdDoOuUxXs" else 0
+        bits = argbits if is_long else 32
+        if conv == "c":
+            text = chr(arg & 0xFF)
+        elif conv == "s":
+            text = elf.string(arg) if arg else "(null)"
+            if text is None:
+                text = "<0x%X>" % arg
+            if precision:
+                text = text[:int(precision)]
+        elif conv in "dD":
+            text = str(signed(arg & ((1 << bits) - 1), bits))
+        elif conv in "uU":
+            text = str(arg & ((1 << bits) - 1))
+        elif conv in "xX":
+            text = "%X" % (arg & ((1 << bits) - 1))
+        elif conv in "oO":
+            text = "%o" % (arg & ((1 << bits) - 1))
+        else:
+            text = conv
+        width = int(width) if width else 0
+        if left:
+            text = text.ljust(width)
+        elif zero and conv not in "cs":
+            text = text.rjust(width, "0")
+        else:
+            text = text.rjust(width)
+        out.append(text)
+    out.append(fmt[pos:])
+    return "".join(out)
+
+
+def decode(elf, data, out):
+    """Decodes a log stream, returns the number of dropped records."""
+    if len(data) < 8:
+        raise SystemExit("log too short")
+    for endian in "<>":
+        magic, version, timesize, argsize, maxargs = \
+            struct.unpack_from(endian + "IBBBB", data, 0)
+        if magic == MAGIC:
+            break
+    else:
+        raise SystemExit("bad magic number")
+    if version != VERSION:
+        raise SystemExit("unsupported log version %d" % version)
+    timefmt = {2: "H", 4: "I", 8: "Q"}[timesize]
+    argfmt = {4: "I", 8: "Q"}[argsize]
+    dropped = 0
+    pos = 8
+    while pos < len(data):
+        n = data[pos]
+        cnt = 1 if n == DROPPED else n + 1
+        size = 1 + timesize + cnt * argsize
+        if n != DROPPED and n > maxargs or pos + size > len(data):
+            out.write("*** truncated or corrupted log at offset %d\n" % pos)
+            break
+        time, = struct.unpack_from(endian + timefmt, data, pos + 1)
+        values = struct.unpack_from(endian + argfmt * cnt, data,
+                                    pos + 1 + timesize)
+        pos += size
+        if n == DROPPED:
+            dropped += values[0]
+            out.write("%10u *** %u records dropped\n" % (time, values[0]))
+            continue
+        fmt = elf.string(values[0])
+        if fmt is None:
+            text = "<unknown format 0x%X> %s" % (values[0],
+                                                 " ".join(map(hex,
+                                                              values[1:])))
+        else:
+            text = format_record(elf, fmt, values[1:], argsize * 8)
+        out.write("%10u %s\n" % (time, text.rstrip("\r\n")))
+    return dropped
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Binary log decoder.")
+    parser.add_argument("elf", help="firmware ELF file")
+    parser.add_argument("log", help="binary log stream")
+    args = parser.parse_args()
+    with open(args.log, "rb") as f:
+        data = f.read()
+    dropped = decode(Elf(args.elf), data, sys.stdout)
+    if dropped:
+        sys.stderr.write("%u records dropped\n" % dropped)
+
+
+if __name__ == "__main__":
+    main()
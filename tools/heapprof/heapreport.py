@@ -0,0 +1,137 @@
+#!/usr/bin/env python3
+#
+# ChibiOS/RT heap profile report generator.
+#
+# Decodes a heap profile dump produced by chHeapProfileDump(), either as a
+# raw binary file or as the hex text printed by the "heap dump" shell
+# command, and prints a summary of the heap state, the free blocks size
+# histogram and the call sites sorted by live allocated bytes.
+#
+# Usage: heapreport.py [--elf firmware.elf] [--addr2line tool] dumpfile
+#
+
+import argparse
+import re
+import struct
+import subprocess
+import sys
+
+MAGIC = 0x50414548
+VERSION = 1
+HEADER_SIZE = 16
+SUMMARY_FIELDS = ("used", "peak", "free", "fragments", "largest")
+
+
+def load(path):
+    """Loads a dump, hex text dumps are recognized and converted."""
+    with open(path, "rb") as f:
+        data = f.read()
+    try:
+        text = data.decode("ascii")
+    except UnicodeDecodeError:
+        return data
+    digits = re.sub(r"[^0-9a-fA-F]", "", text)
+    if digits and re.fullmatch(r"[0-9a-fA-F\s]+", text):
+        return bytes.fromhex(digits)
+    return data
+
+
+def decode(data):
+    """Decodes a dump, the byte order is detected from the magic number."""
+    if len(data) < HEADER_SIZE:
+        raise ValueError("dump too short")
+    for endian in ("<", ">"):
+        if struct.unpack_from(endian + "I", data, 0)[0] == MAGIC:
+            break
+    else:
+        raise ValueError("invalid magic number")
+    version, ptrsize, _, nbins, nsites, _ = \
+        struct.unpack_from(endian + "HBBHHI", data, 4)
+    if version != VERSION:
+        raise ValueError("unsupported dump version %d" % version)
+    ptrfmt = {4: "I", 8: "Q"}.get(ptrsize)
+    if ptrfmt is None:
+        raise ValueError("unsupported pointer size %d" % ptrsize)
+    offset = HEADER_SIZE
+    summary = dict(zip(SUMMARY_FIELDS,
+                       struct.unpack_from(endian + "5I", data, offset)))
+    offset += 5 * 4
+    histogram = list(struct.unpack_from(endian + "%dI" % nbins, data, offset))
+    offset += nbins * 4
+    sites = []
+    recfmt = endian + ptrfmt + "3I"
+    for _ in range(nsites):
+        caller, nbytes, count, allocs = struct.unpack_from(recfmt, data,
+                                                           offset)
+        offset += struct.calcsize(recfmt)
+        sites.append({"caller": caller, "bytes": nbytes, "count": count,
+                      "allocs": allocs})
+    return ptrsize, summary, histogram, sites
+
+
+def symbolize(elf, tool, addresses):
+    """Resolves the call site addresses using addr2line."""
+    addresses = [a for a in addresses if a != 0]
+    if not elf or not addresses:
+        return {}
+    try:
+        out = subprocess.run([tool, "-f", "-C", "-s", "-e", elf] +
+                             ["0x%x" % a for a in addresses],
+                             check=True, capture_output=True,
+                             text=True).stdout.splitlines()
+    except (OSError, subprocess.CalledProcessError) as e:
+        print("warning: symbol resolution failed: %s" % e, file=sys.stderr)
+        return {}
+    names = {}
+    for i, a in enumerate(addresses):
+        func, line = out[2 * i], out[2 * i + 1]
+        names[a] = "%s (%s)" % (func, line)
+    return names
+
+
+def main():
+    parser = argparse.ArgumentParser(description="ChibiOS/RT heap profile "
+                                     "report generator")
+    parser.add_argument("dump", help="binary or hex dump file")
+    parser.add_argument("--elf", help="firmware ELF file for symbols")
+    parser.add_argument("--addr2line", default="addr2line",
+                        help="addr2line tool (default: %(default)s)")
+    args = parser.parse_args()
+
+    try:
+        ptrsize, summary, histogram, sites = decode(load(args.dump))
+    except (OSError, ValueError, struct.error) as e:
+        sys.exit("error: %s" % e)
+    names = symbolize(args.elf, args.addr2line, [s["caller"] for s in sites])
+
+    print("Heap summary")
+    print("  used             : %d bytes" % summary["used"])
+    print("  peak             : %d bytes" % summary["peak"])
+    print("  free total       : %d bytes" % summary["free"])
+    print("  fragments        : %d" % summary["fragments"])
+    print("  largest free     : %d bytes" % summary["largest"])
+    if summary["free"] > 0:
+        print("  fragmentation    : %.1f%%" %
+              (100.0 * (1 - summary["largest"] / summary["free"])))
+
+    print()
+    print("Free blocks histogram")
+    for i, n in enumerate(histogram):
+        low = 0 if i == 0 else 16 << i
+        high = "" if i == len(histogram) - 1 else "%d" % ((32 << i) - 1)
+        print("  %6d..%-6s %6d %s" % (low, high, n, "#" * min(n, 50)))
+
+    print()
+    print("Call sites by live bytes")
+    print("  %-*s %10s %7s %7s  %s" % (2 * ptrsize + 2, "address", "bytes",
+                                       "blocks", "allocs", "symbol"))
+    for s in sorted(sites, key=lambda s: s["bytes"], reverse=True):
+        addr = "0x%0*x" % (2 * ptrsize, s["caller"]) if s["caller"] \
+            else "(other)"
+        print("  %-*s %10d %7d %7d  %s" % (2 * ptrsize + 2, addr, s["bytes"],
+                                           s["count"], s["allocs"],
+                                           names.get(s["caller"], "")))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,196 @@
+#!/usr/bin/env python3
+#
+# ChibiOS/RT sampling profiler report.
+#
+# Symbolizes a profiler dump produced by chDbgProfDump() using the functions
+# symbols of the firmware ELF file, the output is either a flat profile or
+# the folded stacks format accepted by flamegraph.pl and speedscope. The
+# folded stacks have two levels, thread and function, because the samples
+# only record the interrupted program counter.
+#
+# The dump can be either the raw binary image or a text file containing it
+# as hexadecimal digits, whitespace is ignored in the latter. The samples
+# are relocated using the address of chDbgProfDump() recorded in the dump,
+# so position independent simulator executables are handled too. Samples
+# outside the functions of the ELF file, in the simulators the host
+# libraries, are reported as [unknown].
+#
+# Usage: chprof.py [--folded] [--threads] [--top N] firmware.elf dumpfile
+#
+
+import argparse
+import bisect
+import string
+import struct
+import sys
+
+MAGIC = 0x46504843
+VERSION = 1
+NAME_SIZE = 16
+REFERENCE = "chDbgProfDump"
+UNKNOWN = "[unknown]"
+
+SHT_SYMTAB = 2
+STT_FUNC = 2
+
+
+def load(path):
+    """Loads a dump file, hexadecimal text dumps are converted to binary."""
+    with open(path, "rb") as f:
+        data = f.read()
+    try:
+        text = "".join(data.decode("ascii").split())
+    except UnicodeDecodeError:
+        return data
+    if text and len(text) % 2 == 0 and all(c in string.hexdigits
+                                           for c in text):
+        return bytes.fromhex(text)
+    return data
+
+
+class Symbols:
+    """Functions symbols of an ELF file, sorted by address."""
+
+    def __init__(self, path):
+        with open(path, "rb") as f:
+            data = f.read()
+        if data[:4] != b"\x7fELF":
+            raise SystemExit("%s: not an ELF file" % path)
+        is64 = data[4] == 2
+        e = "<" if data[5] == 1 else ">"
+        if is64:
+            shoff, = struct.unpack_from(e + "Q", data, 0x28)
+            shentsize, shnum = struct.unpack_from(e + "HH", data, 0x3A)
+            shdr, sym, symsize = "IIQQQQIIQQ", "IBBHQQ", 24
+        else:
+            shoff, = struct.unpack_from(e + "I", data, 0x20)
+            shentsize, shnum = struct.unpack_from(e + "HH", data, 0x2E)
+            shdr, sym, symsize = "IIIIIIIIII", "IIIBBH", 16
+        sections = [struct.unpack_from(e + shdr, data, shoff + i * shentsize)
+                    for i in range(shnum)]
+        funcs = {}
+        for sec in sections:
+            if sec[1] != SHT_SYMTAB:
+                continue
+            strtab = sections[sec[6]]
+            for off in range(sec[4], sec[4] + sec[5], symsize):
+                f = struct.unpack_from(e + sym, data, off)
+                if is64:
+                    name, info, _, _, value, size = f
+                else:
+                    name, value, size, info, _, _ = f
+                if info & 0xF != STT_FUNC or value == 0:
+                    continue
+                start = strtab[4] + name
+                end = data.index(b"\0", start)
+                # Thumb functions have the LSB set.
+                funcs[value & ~1] = (data[start:end].decode("latin-1"),
+                                     size)
+        if not funcs:
+            raise SystemExit("%s: no functions symbols" % path)
+        self.addrs = sorted(funcs)
+        self.funcs = [funcs[a] for a in self.addrs]
+
+    def address(self, name):
+        for addr, (fname, _) in zip(self.addrs, self.funcs):
+            if fname == name:
+                return addr
+        return None
+
+    def lookup(self, addr):
+        """Returns the name of the function containing the address."""
+        i = bisect.bisect_right(self.addrs, addr) - 1
+        if i >= 0:
+            name, size = self.funcs[i]
+            # Functions without size are assumed to extend up to the next
+            # symbol.
+            if size == 0 and i + 1 < len(self.addrs) or \
+               addr < self.addrs[i] + size:
+                return name
+        return UNKNOWN
+
+
+def parse(data):
+    """Returns the header fields, the threads table and the samples."""
+    if len(data) < 8:
+        raise SystemExit("profiler dump too short")
+    e = "<"
+    if struct.unpack_from("<I", data)[0] != MAGIC:
+        e = ">"
+        if struct.unpack_from(">I", data)[0] != MAGIC:
+            raise SystemExit("not a profiler dump, bad magic number")
+    _, version, ptrsize = struct.unpack_from(e + "IBBxx", data, 0)
+    if version != VERSION:
+        raise SystemExit("unsupported profiler dump version %d" % version)
+    p = {4: "I", 8: "Q"}[ptrsize]
+    pos = 8
+    freq, nthreads, nsamples, total, ref = struct.unpack_from(e + "IIII" + p,
+                                                              data, pos)
+    pos += 16 + ptrsize
+    threads = {}
+    for _ in range(nthreads):
+        tp, raw = struct.unpack_from(e + p + "%ds" % NAME_SIZE, data, pos)
+        pos += ptrsize + NAME_SIZE
+        threads[tp] = raw.split(b"\0", 1)[0].decode("ascii", "replace")
+    if pos + nsamples * 2 * ptrsize > len(data):
+        raise SystemExit("truncated profiler dump")
+    samples = [struct.unpack_from(e + p + p, data, pos + i * 2 * ptrsize)
+               for i in range(nsamples)]
+    return freq, total, ref, threads, samples
+
+
+def main():
+    ap = argparse.ArgumentParser(description="ChibiOS/RT profiler report")
+    ap.add_argument("--folded", action="store_true",
+                    help="output folded stacks for flame graphs")
+    ap.add_argument("--threads", action="store_true",
+                    help="split the flat profile by thread")
+    ap.add_argument("--top", type=int, default=0,
+                    help="number of flat profile lines, default all")
+    ap.add_argument("elf", help="firmware ELF file")
+    ap.add_argument("dump", help="profiler dump, binary or hexadecimal text")
+    args = ap.parse_args()
+
+    syms = Symbols(args.elf)
+    freq, total, ref, threads, samples = parse(load(args.dump))
+    base = syms.address(REFERENCE)
+    slide = ref - base if base is not None else 0
+
+    def thread_name(tp):
+        return threads.get(tp) or "0x%x" % tp
+
+    counts = {}
+    for pc, tp in samples:
+        func = syms.lookup(pc - slide)
+        key = (thread_name(tp), func) if args.folded or args.threads \
+            else func
+        counts[key] = counts.get(key, 0) + 1
+
+    if args.folded:
+        for (thread, func), n in sorted(counts.items()):
+            sys.stdout.write("%s;%s %d\n" % (thread, func, n))
+        return
+
+    n = len(samples)
+    sys.stdout.write("%d samples at %d Hz" % (n, freq))
+    if total > n:
+        sys.stdout.write(", %d older samples lost" % (total - n))
+    sys.stdout.write("\n\n")
+    if n == 0:
+        return
+    sys.stdout.write("  samples      %%   cumul%%  %s\n" %
+                     ("thread           function" if args.threads
+                      else "function"))
+    cumul = 0
+    ranked = sorted(counts.items(), key=lambda kv: (-kv[1], kv[0]))
+    if args.top > 0:
+        ranked = ranked[:args.top]
+    for key, cnt in ranked:
+        cumul += cnt
+        label = "%-16s %s" % key if args.threads else key
+        sys.stdout.write("%9d %6.2f %7.2f  %s\n" %
+                         (cnt, 100.0 * cnt / n, 100.0 * cumul / n, label))
+
+
+if __name__ == "__main__":
+    main()
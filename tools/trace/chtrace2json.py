@@ -0,0 +1,206 @@
+#!/usr/bin/env python3
+#
+# ChibiOS/RT trace dump converter.
+#
+# Converts a trace dump produced by chDbgTraceDump() into the Chrome trace
+# event JSON format, the output can be loaded in chrome://tracing or in the
+# Perfetto UI (https://ui.perfetto.dev).
+#
+# The dump can be either the raw binary image or a text file containing it
+# as hexadecimal digits, whitespace is ignored in the latter.
+#
+# Usage: chtrace2json.py [--freq HZ] dumpfile [output.json]
+#
+
+import argparse
+import json
+import string
+import struct
+import sys
+
+MAGIC = 0x52544843
+VERSION = 1
+NAME_SIZE = 16
+
+SWITCH = 1
+ISR_ENTER = 2
+ISR_LEAVE = 3
+SEM_WAIT = 4
+SEM_SIGNAL = 5
+MTX_LOCK = 6
+MTX_UNLOCK = 7
+MSG_SEND = 8
+MSG_RELEASE = 9
+VT_CALLBACK = 10
+USER = 11
+
+EVENT_NAMES = {
+    SEM_WAIT: ("sem wait", "sem"),
+    SEM_SIGNAL: ("sem signal", "sem"),
+    MTX_LOCK: ("mtx lock", "mtx"),
+    MTX_UNLOCK: ("mtx unlock", "mtx"),
+    MSG_SEND: ("msg send", "msg"),
+    MSG_RELEASE: ("msg release", "msg"),
+    VT_CALLBACK: ("timer callback", "vt"),
+}
+
+STATE_NAMES = ["READY", "CURRENT", "SUSPENDED", "WTSEM", "WTMTX", "WTCOND",
+               "SLEEPING", "WTEXIT", "WTOREVT", "WTANDEVT", "SNDMSGQ",
+               "SNDMSG", "WTMSG", "WTQUEUE", "FINAL"]
+
+PID = 1
+ISR_TID = 0
+
+
+def load(path):
+    """Loads a dump file, hexadecimal text dumps are converted to binary."""
+    with open(path, "rb") as f:
+        data = f.read()
+    try:
+        text = "".join(data.decode("ascii").split())
+    except UnicodeDecodeError:
+        return data
+    if text and len(text) % 2 == 0 and all(c in string.hexdigits
+                                           for c in text):
+        return bytes.fromhex(text)
+    return data
+
+
+class Reader:
+    """Sequential reader over the dump image."""
+
+    def __init__(self, data):
+        self.data = data
+        self.pos = 0
+        self.endian = "<"
+        self.ptr = "I"
+
+    def take(self, fmt):
+        fmt = self.endian + fmt.replace("P", self.ptr)
+        size = struct.calcsize(fmt)
+        if self.pos + size > len(self.data):
+            raise SystemExit("truncated trace dump")
+        values = struct.unpack_from(fmt, self.data, self.pos)
+        self.pos += size
+        return values
+
+    def name(self):
+        raw, = self.take("%ds" % NAME_SIZE)
+        return raw.split(b"\0", 1)[0].decode("ascii", "replace")
+
+
+def parse(data):
+    """Returns the frequency, the threads table and the events list."""
+    rd = Reader(data)
+    if struct.unpack_from("<I", data)[0] != MAGIC:
+        rd.endian = ">"
+        if struct.unpack_from(">I", data)[0] != MAGIC:
+            raise SystemExit("not a trace dump, bad magic number")
+    _, version, ptrsize = rd.take("IBBxx")
+    if version != VERSION:
+        raise SystemExit("unsupported trace version %d" % version)
+    rd.ptr = {4: "I", 8: "Q"}[ptrsize]
+    freq, nthreads, nevents = rd.take("III")
+    threads = {}
+    for _ in range(nthreads):
+        tp, = rd.take("P")
+        threads[tp] = rd.name() or "0x%x" % tp
+    events = []
+    for _ in range(nevents):
+        time, etype, state, tp, objp, arg = rd.take("IBBxxPPP")
+        name = rd.name() if etype == USER else None
+        events.append((time, etype, state, tp, objp, arg, name))
+    return freq, threads, events
+
+
+def convert(freq, threads, events):
+    """Builds the list of Chrome trace events."""
+    if freq == 0:
+        raise SystemExit("unknown timestamp frequency, use --freq")
+    # Timestamps are 32 bits counters, wraparounds are unrolled assuming
+    # that consecutive events are less than a full period apart.
+    out = []
+    last = base = None
+    unrolled = []
+    for ev in events:
+        if last is not None and ev[0] < last:
+            base += 1 << 32
+        elif base is None:
+            base = -ev[0]
+        last = ev[0]
+        unrolled.append((ev[0] + base) * 1000000.0 / freq)
+
+    tids = {ISR_TID: "ISRs"}
+
+    def tid(tp):
+        if tp not in tids:
+            tids[tp] = len(tids)
+        return tids[tp]
+
+    running = None
+    start = 0.0
+    for ts, (time, etype, state, tp, objp, arg, name) in zip(unrolled, events):
+        if running is None:
+            running, start = arg if etype == SWITCH else tp, ts
+        if etype == SWITCH:
+            # The record is written by the switched in thread, the switched
+            # out thread is in the argument.
+            otp = arg
+            out.append({"name": threads.get(otp, "0x%x" % otp), "ph": "X",
+                        "pid": PID, "tid": tid(otp), "ts": start,
+                        "dur": ts - start, "cat": "run",
+                        "args": {"state": STATE_NAMES[state]
+                                 if state < len(STATE_NAMES) else state,
+                                 "object": "0x%x" % objp}})
+            running, start = tp, ts
+        elif etype in (ISR_ENTER, ISR_LEAVE):
+            out.append({"name": "ISR", "ph": "B" if etype == ISR_ENTER
+                        else "E", "pid": PID, "tid": ISR_TID, "ts": ts,
+                        "cat": "isr"})
+        elif etype == USER:
+            out.append({"name": name, "ph": "i", "s": "t", "pid": PID,
+                        "tid": tid(tp), "ts": ts, "cat": "user",
+                        "args": {"arg": "0x%x" % arg}})
+        elif etype in EVENT_NAMES:
+            ename, cat = EVENT_NAMES[etype]
+            out.append({"name": ename, "ph": "i", "s": "t", "pid": PID,
+                        "tid": tid(tp), "ts": ts, "cat": cat,
+                        "args": {"object": "0x%x" % objp,
+                                 "arg": "0x%x" % arg}})
+    if running is not None and unrolled:
+        out.append({"name": threads.get(running, "0x%x" % running),
+                    "ph": "X", "pid": PID, "tid": tid(running), "ts": start,
+                    "dur": unrolled[-1] - start, "cat": "run"})
+
+    for tp, n in tids.items():
+        label = "ISRs" if n == ISR_TID else threads.get(tp, "0x%x" % tp)
+        out.append({"name": "thread_name", "ph": "M", "pid": PID, "tid": n,
+                    "args": {"name": label}})
+    out.append({"name": "process_name", "ph": "M", "pid": PID,
+                "args": {"name": "ChibiOS/RT"}})
+    return out
+
+
+def main():
+    ap = argparse.ArgumentParser(description="ChibiOS/RT trace converter")
+    ap.add_argument("--freq", type=int, default=None,
+                    help="timestamp frequency in Hz, overrides the dump")
+    ap.add_argument("dump", help="trace dump, binary or hexadecimal text")
+    ap.add_argument("output", nargs="?", help="output file, default stdout")
+    args = ap.parse_args()
+
+    freq, threads, events = parse(load(args.dump))
+    if args.freq is not None:
+        freq = args.freq
+    doc = {"traceEvents": convert(freq, threads, events),
+           "displayTimeUnit": "ns"}
+    if args.output:
+        with open(args.output, "w") as f:
+            json.dump(doc, f, indent=1)
+    else:
+        json.dump(doc, sys.stdout, indent=1)
+        sys.stdout.write("\n")
+
+
+if __name__ == "__main__":
+    main()